@@ -85,8 +85,9 @@ main(int argc, char **argv)
     double wbar;
 
     std::vector<std::function<std::vector<double>()>> recpols;
-    std::vector<std::function<std::size_t(std::queue<std::size_t> &,
-                                          multiloc_t::mcont_t &)>>
+    std::vector<std::function<std::size_t(
+        fwdpp::traits::recycling_bin_t<multiloc_t::mcont_t> &,
+        multiloc_t::mcont_t &)>>
         mmodels;
     for (unsigned i = 0; i < K; ++i)
         {
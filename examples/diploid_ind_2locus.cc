@@ -102,8 +102,9 @@ main(int argc, char **argv)
                 fwdpp::poisson_xover(r.get(), littler, 1., 2.)
             };
 
-            std::vector<std::function<std::size_t(std::queue<std::size_t> &,
-                                                  multiloc_t::mcont_t &)>>
+            std::vector<std::function<std::size_t(
+                fwdpp::traits::recycling_bin_t<multiloc_t::mcont_t> &,
+                multiloc_t::mcont_t &)>>
                 mmodels{
                     // Locus 0: positions Uniform [0,1)
                     std::bind(fwdpp::infsites(), std::placeholders::_1,
@@ -0,0 +1,218 @@
+/*! \include rec_merge_benchmark.cc
+  Times the merging of parental mutation keys at recombination
+  breakpoints, which is the inner loop of fwdpp::mutate_recombine.
+
+  Three ways of advancing through the keys of a parental gamete are
+  compared: a binary search over all remaining keys (the behavior of
+  fwdpp_internal::rec_update_itr up to fwdpp 0.5.x), a galloping
+  search, and the choice between the two that fwdpp::mutate_recombine
+  makes with fwdpp_internal::gallop_rec_update.  Each is timed for
+  a std::vector of mutations and for a fwdpp::soa_mutation_vector,
+  which keeps positions in a contiguous column.  The merged keys are
+  checked to be identical.
+
+  Usage: rec_merge_benchmark nmuts keys_per_gamete nbreakpoints nreps seed
+*/
+#include <config.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+#include <gsl/gsl_randist.h>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/soa_mutation_vector.hpp>
+#include <fwdpp/sugar/popgenmut.hpp>
+#include <fwdpp/sugar/GSLrng_t.hpp>
+#include <fwdpp/internal/rec_gamete_updater.hpp>
+
+using keys_t = std::vector<fwdpp::uint_t>;
+
+struct binary_search_advance
+{
+    template <typename itr_type, typename mcont_t>
+    itr_type
+    operator()(itr_type first, itr_type last, const mcont_t &mutations,
+               const double val) const
+    {
+        return fwdpp::fwdpp_internal::binary_rec_update_itr(first, last,
+                                                            mutations, val);
+    }
+};
+
+struct galloping_advance
+{
+    template <typename itr_type, typename mcont_t>
+    itr_type
+    operator()(itr_type first, itr_type last, const mcont_t &mutations,
+               const double val) const
+    {
+        return fwdpp::fwdpp_internal::rec_update_itr(first, last, mutations,
+                                                     val);
+    }
+};
+
+struct adaptive_advance
+{
+    bool gallop;
+    template <typename itr_type, typename mcont_t>
+    itr_type
+    operator()(itr_type first, itr_type last, const mcont_t &mutations,
+               const double val) const
+    {
+        return fwdpp::fwdpp_internal::rec_update_itr(first, last, mutations,
+                                                     val, gallop);
+    }
+};
+
+template <typename advance_t>
+inline void
+prepare(advance_t &, const keys_t &, const keys_t &,
+        const std::vector<double> &)
+{
+}
+
+inline void
+prepare(adaptive_advance &advance, const keys_t &k1, const keys_t &k2,
+        const std::vector<double> &breakpoints)
+{
+    advance.gallop = fwdpp::fwdpp_internal::gallop_rec_update(
+        std::max(k1.size(), k2.size()), breakpoints.size());
+}
+
+template <typename mcont_t, typename advance_t>
+void
+merge(const keys_t &k1, const keys_t &k2,
+      const std::vector<double> &breakpoints, const mcont_t &mutations,
+      advance_t advance, keys_t &out)
+// The breakpoint loop of fwdpp::mutate_recombine, for one key container
+{
+    prepare(advance, k1, k2, breakpoints);
+    out.clear();
+    auto itr = k1.cbegin(), itr_e = k1.cend();
+    auto jtr = k2.cbegin(), jtr_e = k2.cend();
+    for (const auto b : breakpoints)
+        {
+            const auto ub = advance(itr, itr_e, mutations, b);
+            out.insert(out.end(), itr, ub);
+            itr = ub;
+            jtr = advance(jtr, jtr_e, mutations, b);
+            std::swap(itr, jtr);
+            std::swap(itr_e, jtr_e);
+        }
+}
+
+template <typename mcont_t, typename advance_t>
+double
+time_merges(const std::vector<keys_t> &gametes,
+            const std::vector<std::vector<double>> &breakpoints,
+            const mcont_t &mutations, const advance_t &advance,
+            std::vector<keys_t> &results)
+// Nanoseconds per merge
+{
+    results.resize(breakpoints.size());
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < breakpoints.size(); ++i)
+        {
+            merge(gametes[i % gametes.size()],
+                  gametes[(i + 1) % gametes.size()], breakpoints[i],
+                  mutations, advance, results[i]);
+        }
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count()
+           / static_cast<double>(breakpoints.size());
+}
+
+int
+main(int argc, char **argv)
+{
+    if (argc != 6)
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " nmuts keys_per_gamete nbreakpoints nreps seed\n";
+            std::exit(0);
+        }
+    int argument = 1;
+    const unsigned nmuts = atoi(argv[argument++]);
+    const unsigned keys_per_gamete = atoi(argv[argument++]);
+    const double nbreakpoints = atof(argv[argument++]);
+    const unsigned nreps = atoi(argv[argument++]);
+    const unsigned seed = atoi(argv[argument++]);
+
+    fwdpp::GSLrng_t<fwdpp::GSL_RNG_MT19937> r(seed);
+
+    std::vector<fwdpp::popgenmut> mutations;
+    for (unsigned i = 0; i < nmuts; ++i)
+        {
+            mutations.emplace_back(gsl_rng_uniform(r.get()), 0., 1., 0, 1);
+        }
+    fwdpp::soa_mutation_vector<fwdpp::popgenmut> soa_mutations(mutations);
+
+    // Gametes carry random subsets of the mutations, sorted by position
+    const double p = std::min(1., double(keys_per_gamete) / double(nmuts));
+    std::vector<keys_t> gametes(100);
+    for (auto &g : gametes)
+        {
+            for (fwdpp::uint_t k = 0; k < nmuts; ++k)
+                {
+                    if (gsl_rng_uniform(r.get()) < p)
+                        {
+                            g.push_back(k);
+                        }
+                }
+            std::sort(g.begin(), g.end(),
+                      [&mutations](const fwdpp::uint_t a,
+                                   const fwdpp::uint_t b) {
+                          return mutations[a].pos < mutations[b].pos;
+                      });
+        }
+
+    std::vector<std::vector<double>> breakpoints(nreps);
+    for (auto &b : breakpoints)
+        {
+            const unsigned n = gsl_ran_poisson(r.get(), nbreakpoints);
+            for (unsigned i = 0; i < n; ++i)
+                {
+                    b.push_back(gsl_rng_uniform(r.get()));
+                }
+            std::sort(b.begin(), b.end());
+            b.push_back(std::numeric_limits<double>::max());
+        }
+
+    std::vector<keys_t> expected, results;
+    // Warm up, and allocate the merged keys
+    time_merges(gametes, breakpoints, mutations, binary_search_advance(),
+                results);
+    time_merges(gametes, breakpoints, mutations, binary_search_advance(),
+                expected);
+    const auto t_binary = time_merges(gametes, breakpoints, mutations,
+                                      binary_search_advance(), expected);
+    const auto t_gallop = time_merges(gametes, breakpoints, mutations,
+                                      galloping_advance(), results);
+    const bool same = (results == expected);
+    const auto t_adaptive = time_merges(gametes, breakpoints, mutations,
+                                        adaptive_advance(), results);
+    const bool same_adaptive = (results == expected);
+    const auto t_binary_soa = time_merges(gametes, breakpoints, soa_mutations,
+                                          binary_search_advance(), results);
+    const auto t_gallop_soa = time_merges(gametes, breakpoints, soa_mutations,
+                                          galloping_advance(), results);
+    const auto t_adaptive_soa = time_merges(
+        gametes, breakpoints, soa_mutations, adaptive_advance(), results);
+
+    std::cout << "container\tsearch\tns_per_merge\n"
+              << "vector\tbinary\t" << t_binary << '\n'
+              << "vector\tgalloping\t" << t_gallop << '\n'
+              << "vector\tadaptive\t" << t_adaptive << '\n'
+              << "soa_mutation_vector\tbinary\t" << t_binary_soa << '\n'
+              << "soa_mutation_vector\tgalloping\t" << t_gallop_soa << '\n'
+              << "soa_mutation_vector\tadaptive\t" << t_adaptive_soa
+              << '\n';
+    if (!same || !same_adaptive || results != expected)
+        {
+            std::cerr << "Error: the merged keys differ\n";
+            return 1;
+        }
+    return 0;
+}
@@ -0,0 +1,206 @@
+/*!
+  \file cached_value_gamete.hpp
+
+  \brief Gametes carrying a cached haplotype-level value.
+*/
+#ifndef FWDPP_CACHED_VALUE_GAMETE_HPP__
+#define FWDPP_CACHED_VALUE_GAMETE_HPP__
+
+#include <tuple>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/tags/tags.hpp>
+
+namespace fwdpp
+{
+    /*!
+      \defgroup haplotype_value Policies for cached haplotype values
+
+      A haplotype value policy describes how the value of a gamete is
+      built up from its selected mutations.  A policy must define
+      value_type, a static function initial_value() returning the value
+      of a gamete with no selected mutations, and a static function
+      update(value_type &, const mutation_t &) that adds the effect of
+      one mutation.  The result must not depend on the order in which
+      mutations are added, up to rounding.
+
+      These policies are used by fwdpp::cached_value_gamete.
+    */
+
+    struct additive_haplotype_value
+    /*!
+      \brief Sum of h*s over selected mutations.
+
+      This is the heterozygous part of fwdpp::additive_diploid.
+      \ingroup haplotype_value
+    */
+    {
+        using value_type = double;
+        static inline value_type
+        initial_value() noexcept
+        {
+            return 0.;
+        }
+        template <typename mutation_t>
+        static inline void
+        update(value_type &v, const mutation_t &m) noexcept
+        {
+            v += m.h * m.s;
+        }
+    };
+
+    struct multiplicative_haplotype_value
+    /*!
+      \brief Product of 1 + h*s over selected mutations.
+
+      This is the heterozygous part of fwdpp::multiplicative_diploid.
+      \ingroup haplotype_value
+    */
+    {
+        using value_type = double;
+        static inline value_type
+        initial_value() noexcept
+        {
+            return 1.;
+        }
+        template <typename mutation_t>
+        static inline void
+        update(value_type &v, const mutation_t &m) noexcept
+        {
+            v *= (1. + m.h * m.s);
+        }
+    };
+
+    struct effect_size_sum_haplotype_value
+    /*!
+      \brief Sum of s over selected mutations.
+
+      This is the haplotype value of the house-of-cards model
+      in examples/HOC_ind.cc, and may be used with
+      fwdpp::haplotype_dependent_trait_value.
+      \ingroup haplotype_value
+    */
+    {
+        using value_type = double;
+        static inline value_type
+        initial_value() noexcept
+        {
+            return 0.;
+        }
+        template <typename mutation_t>
+        static inline void
+        update(value_type &v, const mutation_t &m) noexcept
+        {
+            v += m.s;
+        }
+    };
+
+    /*!
+      \brief A gamete that caches a haplotype value
+
+      The value of a gamete is defined by haplotype_value_policy (see
+      @ref haplotype_value).  It is calculated by
+      fwdpp::mutate_recombine when the gamete is created.  If the
+      offspring gamete did not recombine, its value is derived from that
+      of the parental gamete and the new mutations, without visiting
+      the parental mutations.
+
+      fwdpp::additive_diploid and fwdpp::multiplicative_diploid use the
+      cached values when the policy is fwdpp::additive_haplotype_value
+      or fwdpp::multiplicative_haplotype_value, respectively.  Diploid
+      genetic values are then calculated from the two cached values plus
+      a correction for homozygous sites, which is skipped when either
+      gamete carries no selected mutations.
+      fwdpp::haplotype_dependent_trait_value has an overload taking no
+      haplotype policy, which uses the cached values directly.
+
+      The cache is invalidated when the gamete is recycled, and updated
+      when fixations are removed or fwdpp::change_neutral is called.
+      Code that otherwise modifies gamete::smutations, or the effect
+      sizes of existing mutations, must call invalidate_cached_value()
+      or update_cached_value().  A gamete whose cache is not valid
+      calculates its value on demand.
+
+      \note The cached value is a sum or product accumulated in a
+      different order than the site-by-site calculation, and
+      genetic values may therefore differ from those calculated using
+      fwdpp::gamete in the last few bits.
+
+      \ingroup basicTypes
+    */
+    template <typename haplotype_value_policy,
+              typename TAG = tags::standard_gamete>
+    struct cached_value_gamete : public gamete_base<TAG>
+    {
+        using base_t = gamete_base<TAG>;
+        using typename base_t::mutation_container;
+        using typename base_t::constructor_tuple;
+        //! Policy defining the haplotype value
+        using value_policy = haplotype_value_policy;
+        //! Type of the haplotype value
+        using value_type = typename haplotype_value_policy::value_type;
+        //! The cached value.  Only meaningful if cache_valid is true
+        value_type cached_value;
+        //! True if cached_value is up to date
+        bool cache_valid;
+
+        cached_value_gamete(const uint_t &icount) noexcept
+            : base_t(icount),
+              cached_value(haplotype_value_policy::initial_value()),
+              cache_valid(true)
+        {
+        }
+
+        template <typename T>
+        cached_value_gamete(const uint_t &icount, T &&n, T &&s) noexcept
+            : base_t(icount, std::forward<T>(n), std::forward<T>(s)),
+              cached_value(haplotype_value_policy::initial_value()),
+              cache_valid(this->smutations.empty())
+        /// The cache is valid only if \a s is empty.
+        {
+        }
+
+        cached_value_gamete(constructor_tuple t)
+            : base_t(std::move(t)),
+              cached_value(haplotype_value_policy::initial_value()),
+              cache_valid(this->smutations.empty())
+        {
+        }
+
+        template <typename mcont_t>
+        value_type
+        calculate_value(const mcont_t &mutations) const noexcept
+        /// Calculate the haplotype value from the selected mutations
+        {
+            auto v = haplotype_value_policy::initial_value();
+            for (auto k : this->smutations)
+                {
+                    haplotype_value_policy::update(v, mutations[k]);
+                }
+            return v;
+        }
+
+        template <typename mcont_t>
+        value_type
+        haplotype_value(const mcont_t &mutations) const noexcept
+        /// Return the cached value if valid, else calculate it
+        {
+            return (cache_valid) ? cached_value : calculate_value(mutations);
+        }
+
+        template <typename mcont_t>
+        void
+        update_cached_value(const mcont_t &mutations) noexcept
+        {
+            cached_value = calculate_value(mutations);
+            cache_valid = true;
+        }
+
+        void
+        invalidate_cached_value() noexcept
+        {
+            cache_valid = false;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,318 @@
+/*!
+  \file chunked_key_container.hpp
+
+  \brief Mutation keys stored in shared, immutable blocks.
+*/
+#ifndef FWDPP_CHUNKED_KEY_CONTAINER_HPP__
+#define FWDPP_CHUNKED_KEY_CONTAINER_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <initializer_list>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/tags/tags.hpp>
+
+namespace fwdpp
+{
+    template <std::size_t chunk_size = 128> class chunked_key_container
+    /*!
+      \brief A sorted sequence of mutation keys that shares storage
+      with other sequences.
+
+      Keys are stored in blocks of at most \a chunk_size keys.  A block
+      is never modified once it is referred to by more than one
+      container, meaning that copying a container, or building a
+      recombinant gamete from the blocks of its parents, only copies
+      pointers.  fwdpp::mutate_recombine re-uses every block of a
+      parental gamete that lies between two breakpoints or new
+      mutations, and copies only the keys of the blocks that straddle
+      them.  The cost of recombination then scales with the number of
+      breakpoints and blocks, rather than with the number of keys.
+
+      Adjacent blocks hold more than \a chunk_size keys in total,
+      meaning that, on average, blocks are more than half full.
+
+      This type may be used as the mutation_container of a
+      fwdpp::gamete_base.  See fwdpp::chunked_gamete.  Iterators are
+      forward iterators and do not allow keys to be modified.  Keys are
+      appended with push_back or insert at end(), and removed with
+      remove_if.
+
+      \note The reference counts of blocks are atomic, so containers
+      sharing blocks may be read and copied from several threads.
+      \ingroup basicTypes
+    */
+    {
+      public:
+        using value_type = std::uint32_t;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = const value_type &;
+        using const_reference = const value_type &;
+        //! Storage for the keys of one block
+        using block_type = std::vector<value_type>;
+        using block_pointer = std::shared_ptr<block_type>;
+
+        class const_iterator
+        {
+          private:
+            const block_pointer *block;
+            std::size_t offset;
+
+          public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = chunked_key_container::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const value_type *;
+            using reference = const value_type &;
+
+            const_iterator() noexcept : block(nullptr), offset(0) {}
+            const_iterator(const block_pointer *b, std::size_t o) noexcept
+                : block(b), offset(o)
+            {
+            }
+            reference operator*() const noexcept
+            {
+                return (**block)[offset];
+            }
+            pointer operator->() const noexcept
+            {
+                return &(**block)[offset];
+            }
+            const_iterator &operator++() noexcept
+            {
+                if (++offset == (*block)->size())
+                    {
+                        ++block;
+                        offset = 0;
+                    }
+                return *this;
+            }
+            const_iterator operator++(int) noexcept
+            {
+                auto rv = *this;
+                ++(*this);
+                return rv;
+            }
+            bool
+            operator==(const const_iterator &rhs) const noexcept
+            {
+                return block == rhs.block && offset == rhs.offset;
+            }
+            bool
+            operator!=(const const_iterator &rhs) const noexcept
+            {
+                return !(*this == rhs);
+            }
+        };
+        using iterator = const_iterator;
+
+      private:
+        std::vector<block_pointer> blocks_;
+        size_type size_;
+
+        block_type &
+        writable_last_block()
+        // The last block, copied first if it is shared or full.
+        {
+            if (blocks_.empty() || blocks_.back()->size() == chunk_size)
+                {
+                    blocks_.emplace_back(std::make_shared<block_type>());
+                    blocks_.back()->reserve(chunk_size);
+                }
+            else if (blocks_.back().use_count() > 1)
+                {
+                    auto copy = std::make_shared<block_type>();
+                    copy->reserve(chunk_size);
+                    copy->assign(blocks_.back()->begin(),
+                                 blocks_.back()->end());
+                    blocks_.back() = std::move(copy);
+                }
+            return *blocks_.back();
+        }
+
+      public:
+        chunked_key_container() : blocks_{}, size_(0) {}
+
+        chunked_key_container(std::initializer_list<value_type> keys)
+            : blocks_{}, size_(0)
+        {
+            insert(end(), keys.begin(), keys.end());
+        }
+
+        const_iterator
+        begin() const noexcept
+        {
+            return const_iterator(blocks_.data(), 0);
+        }
+        const_iterator
+        end() const noexcept
+        {
+            return const_iterator(blocks_.data() + blocks_.size(), 0);
+        }
+        const_iterator
+        cbegin() const noexcept
+        {
+            return begin();
+        }
+        const_iterator
+        cend() const noexcept
+        {
+            return end();
+        }
+
+        size_type
+        size() const noexcept
+        {
+            return size_;
+        }
+        bool
+        empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        const std::vector<block_pointer> &
+        blocks() const noexcept
+        /// The blocks, in order.  Blocks are never empty.
+        {
+            return blocks_;
+        }
+
+        void
+        reserve(const size_type n)
+        {
+            blocks_.reserve(n / chunk_size + 1);
+        }
+
+        void
+        clear() noexcept
+        /// Release all blocks, keeping the capacity of the block list
+        {
+            blocks_.clear();
+            size_ = 0;
+        }
+
+        void
+        swap(chunked_key_container &rhs) noexcept
+        {
+            blocks_.swap(rhs.blocks_);
+            std::swap(size_, rhs.size_);
+        }
+
+        void
+        push_back(const value_type key)
+        {
+            writable_last_block().push_back(key);
+            ++size_;
+        }
+
+        template <typename input_iterator>
+        const_iterator
+        insert(const_iterator pos, input_iterator first, input_iterator last)
+        /// Append keys.  \a pos must be end().
+        {
+            assert(pos == end());
+            static_cast<void>(pos);
+            for (; first != last; ++first)
+                {
+                    push_back(*first);
+                }
+            return end();
+        }
+
+        void
+        append_block(const block_pointer &block)
+        /*!
+          Append all keys of \a block, sharing it if that keeps
+          adjacent blocks more than \a chunk_size keys in total.
+        */
+        {
+            assert(!block->empty());
+            if (!blocks_.empty()
+                && blocks_.back()->size() + block->size() <= chunk_size)
+                {
+                    insert(end(), block->begin(), block->end());
+                    return;
+                }
+            blocks_.push_back(block);
+            size_ += block->size();
+        }
+
+        template <typename predicate>
+        void
+        remove_if(const predicate &p)
+        /*!
+          Remove the keys for which p(key) is true.  Blocks without
+          such keys remain shared.
+        */
+        {
+            chunked_key_container rv;
+            rv.reserve(size_);
+            for (const auto &b : blocks_)
+                {
+                    auto first = std::find_if(b->begin(), b->end(), p);
+                    if (first == b->end())
+                        {
+                            rv.append_block(b);
+                            continue;
+                        }
+                    rv.insert(rv.end(), b->begin(), first);
+                    for (; first != b->end(); ++first)
+                        {
+                            if (!p(*first))
+                                {
+                                    rv.push_back(*first);
+                                }
+                        }
+                }
+            swap(rv);
+        }
+
+        bool
+        operator==(const chunked_key_container &rhs) const
+        {
+            if (size_ != rhs.size_)
+                {
+                    return false;
+                }
+            if (blocks_ == rhs.blocks_)
+                {
+                    return true;
+                }
+            return std::equal(begin(), end(), rhs.begin());
+        }
+
+        bool
+        operator!=(const chunked_key_container &rhs) const
+        {
+            return !(*this == rhs);
+        }
+    };
+
+    /*!
+      \brief A gamete whose keys are stored in a
+      fwdpp::chunked_key_container.
+
+      This type is intended for simulations of long genomic regions,
+      where gametes carry many thousands of mutations and most of
+      the keys of a recombinant gamete are copied from its parents.
+      It may be used with fwdpp::sample_diploid, the fitness models,
+      and the sugar population types.  Functions that modify the keys
+      of extant gametes in place, such as fwdpp::add_mutation,
+      fwdpp::change_neutral, and serialization, require
+      fwdpp::gamete_base with its default container.
+      \ingroup basicTypes
+    */
+    template <std::size_t chunk_size = 128,
+              typename TAG = tags::standard_gamete>
+    using chunked_gamete
+        = gamete_base<TAG, chunked_key_container<chunk_size>>;
+}
+
+#endif
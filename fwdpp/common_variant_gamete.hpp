@@ -0,0 +1,536 @@
+/*!
+  \file common_variant_gamete.hpp
+
+  \brief Gametes storing high-frequency neutral mutations as bits.
+*/
+#ifndef FWDPP_COMMON_VARIANT_GAMETE_HPP__
+#define FWDPP_COMMON_VARIANT_GAMETE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/tags/tags.hpp>
+#include <fwdpp/internal/common_variant_bits.hpp>
+#include <fwdpp/internal/mutation_columns.hpp>
+
+namespace fwdpp
+{
+    namespace fwdpp_internal
+    {
+        inline unsigned
+        popcount64(std::uint64_t w) noexcept
+        {
+#if defined(__GNUC__)
+            return static_cast<unsigned>(__builtin_popcountll(w));
+#else
+            unsigned n = 0;
+            for (; w; w &= w - 1)
+                {
+                    ++n;
+                }
+            return n;
+#endif
+        }
+
+        template <typename function>
+        inline void
+        for_each_set_bit(std::uint64_t w, const std::size_t offset,
+                         const function &f)
+        /// Call f(offset + i) for each set bit i of w, in increasing order
+        {
+            while (w)
+                {
+#if defined(__GNUC__)
+                    const auto i = static_cast<std::size_t>(__builtin_ctzll(w));
+#else
+                    std::size_t i = 0;
+                    while (!((w >> i) & 1u))
+                        {
+                            ++i;
+                        }
+#endif
+                    f(offset + i);
+                    w &= w - 1;
+                }
+        }
+
+        inline void
+        transpose_bits(std::uint64_t (&a)[64]) noexcept
+        /// Afterwards, bit i of a[j] is the bit j of a[i] before
+        {
+            std::uint64_t m = 0x00000000FFFFFFFFULL;
+            for (unsigned j = 32; j != 0; j >>= 1, m ^= (m << j))
+                {
+                    for (unsigned k = 0; k < 64; k = ((k | j) + 1) & ~j)
+                        {
+                            const auto t = ((a[k] >> j) ^ a[k | j]) & m;
+                            a[k | j] ^= t;
+                            a[k] ^= (t << j);
+                        }
+                }
+        }
+
+        template <typename key_container, typename mcont_t,
+                  typename function>
+        inline void
+        merge_by_position(const key_container &a, const std::vector<uint_t> &b,
+                          const mcont_t &mutations, const function &f)
+        /// Call f(key) for the keys of a and b, in order of position
+        {
+            auto i = a.cbegin();
+            const auto ie = a.cend();
+            auto j = b.cbegin();
+            while (i != ie && j != b.cend())
+                {
+                    if (mutation_position(mutations, *j)
+                        < mutation_position(mutations, *i))
+                        {
+                            f(*j++);
+                        }
+                    else
+                        {
+                            f(*i++);
+                        }
+                }
+            for (; i != ie; ++i)
+                {
+                    f(*i);
+                }
+            for (; j != b.cend(); ++j)
+                {
+                    f(*j);
+                }
+        }
+    }
+
+    struct common_variant_table
+    /*!
+      \brief The columns of the bitsets of fwdpp::common_variant_gamete.
+
+      Column i refers to the neutral mutation keys[i], at position
+      positions[i].  Columns are sorted by position.  A table is built
+      by fwdpp::update_common_variants and is never modified
+      afterwards, so that it may be shared by all gametes.
+      \ingroup basicTypes
+    */
+    {
+        //! Type of the words holding the bits of a gamete
+        using word_type = std::uint64_t;
+        //! Mutation key of each column
+        std::vector<uint_t> keys;
+        //! Mutation position of each column
+        std::vector<double> positions;
+
+        std::size_t
+        size() const noexcept
+        /// Number of columns
+        {
+            return keys.size();
+        }
+
+        std::size_t
+        nwords() const noexcept
+        /// Number of words needed to hold one bit per column
+        {
+            return (keys.size() + fwdpp_internal::common_variant_word_bits - 1)
+                   / fwdpp_internal::common_variant_word_bits;
+        }
+    };
+
+    /*!
+      \brief A gamete storing common neutral mutations as bits.
+
+      Neutral mutations at high frequency are carried by most gametes,
+      and so are stored, and counted, many times over.  This gamete
+      type instead stores the neutral mutations listed in a
+      population-wide fwdpp::common_variant_table as one bit per
+      mutation.  All other mutations, which are rare or selected, are
+      stored in gamete::mutations and gamete::smutations as usual.
+      Those containers then hold far fewer keys.
+
+      The columns are chosen by fwdpp::update_common_variants, which may
+      be called periodically by fwdpp::sample_diploid.  See
+      generation_workspace::common_variants_interval.  New mutations are
+      always stored as keys.
+
+      fwdpp::mutate_recombine combines the bits of two parental gametes
+      using one masked word operation per breakpoint and word, and
+      fwdpp_internal::process_gametes counts common mutations one
+      column at a time, as popcounts weighted by the gamete counts.
+      Fixations are removed from the bits by
+      fwdpp_internal::gamete_cleaner, and the keys of columns are
+      updated by fwdpp::renumber_mutations.  Equality and
+      fwdpp::gamete_hash_index take the bits into account.  The outcome
+      of a simulation is the same as for fwdpp::gamete.
+
+      Fitness models only read selected mutations, and so are not
+      affected.  Functions reading gamete::mutations directly, such as
+      the sampling functions, serialization, fwdpp::add_mutation and
+      fwdpp::change_neutral, do not see common mutations.  Call
+      fwdpp::expand_common_variants before using them.
+      \ingroup basicTypes
+    */
+    template <typename TAG = tags::standard_gamete>
+    struct common_variant_gamete : public gamete_base<TAG>
+    {
+        using base_t = gamete_base<TAG>;
+        using typename base_t::mutation_container;
+        using typename base_t::constructor_tuple;
+        using common_variant_table_type = common_variant_table;
+        using word_type = common_variant_table::word_type;
+        //! The columns of common.  Null until
+        //! fwdpp::update_common_variants is first called.
+        std::shared_ptr<const common_variant_table> common_variants;
+        //! Bit i is set if the gamete carries common_variants->keys[i]
+        std::vector<word_type> common;
+
+        common_variant_gamete(const uint_t &icount) noexcept
+            : base_t(icount), common_variants{}, common{}
+        {
+        }
+
+        template <typename T>
+        common_variant_gamete(const uint_t &icount, T &&n, T &&s) noexcept
+            : base_t(icount, std::forward<T>(n), std::forward<T>(s)),
+              common_variants{}, common{}
+        {
+        }
+
+        common_variant_gamete(constructor_tuple t)
+            : base_t(std::move(t)), common_variants{}, common{}
+        {
+        }
+
+        std::size_t
+        common_variant_count() const noexcept
+        /// Number of common mutations carried
+        {
+            std::size_t n = 0;
+            for (const auto w : common)
+                {
+                    n += fwdpp_internal::popcount64(w);
+                }
+            return n;
+        }
+
+        template <typename function>
+        void
+        for_each_common_variant(const function &f) const
+        /// Call f(key) for each common mutation carried, in order of
+        /// position
+        {
+            for (std::size_t i = 0; i < common.size(); ++i)
+                {
+                    fwdpp_internal::for_each_set_bit(
+                        common[i], i * fwdpp_internal::common_variant_word_bits,
+                        [this, &f](const std::size_t c) {
+                            f(common_variants->keys[c]);
+                        });
+                }
+        }
+
+        void
+        add_common_variant_counts(const uint_t n, uint_t *counts) const
+            noexcept
+        /// Add n to counts[k] for each common mutation k carried
+        {
+            for_each_common_variant([n, counts](const uint_t k) {
+                counts[k] += n;
+            });
+        }
+
+        template <typename gamete_itr>
+        static void
+        add_common_variant_counts(gamete_itr begin, const gamete_itr end,
+                                  uint_t *counts) noexcept
+        /*!
+          Add g.n to counts[k] for each common mutation k carried by
+          each gamete g in [begin, end).
+
+          The count of a column is taken for 64 gametes at a time.  The
+          words of a block of 64 gametes sharing the table are
+          transposed, so that one word holds the bits of a column for
+          all of them.  The count of the column is then the sum over
+          the bits j of the gamete counts of popcount(column & mask_j)
+          << j, where mask_j holds the gametes whose count has bit j
+          set.  Gametes referring to another table, which only happens
+          if the caller mixes populations, are counted one at a time.
+        */
+        {
+            constexpr auto word_bits
+                = fwdpp_internal::common_variant_word_bits;
+            const common_variant_table *table = nullptr;
+            for (auto i = begin; i != end && table == nullptr; ++i)
+                {
+                    if (i->n && i->common_variants)
+                        {
+                            table = i->common_variants.get();
+                        }
+                }
+            if (table == nullptr)
+                {
+                    return;
+                }
+            const auto ncolumns = table->size();
+            const auto nwords = table->nwords();
+            const common_variant_gamete *rows[word_bits];
+            word_type planes[std::numeric_limits<uint_t>::digits];
+            word_type bits[word_bits];
+            while (begin != end)
+                {
+                    std::size_t nrows = 0;
+                    uint_t all_n = 0;
+                    for (; begin != end && nrows < word_bits; ++begin)
+                        {
+                            if (!begin->n || !begin->common_variants)
+                                {
+                                    continue;
+                                }
+                            if (begin->common_variants.get() != table)
+                                {
+                                    begin->add_common_variant_counts(
+                                        begin->n, counts);
+                                    continue;
+                                }
+                            rows[nrows++] = &*begin;
+                            all_n |= begin->n;
+                        }
+                    unsigned nplanes = 0;
+                    for (; nplanes < std::numeric_limits<uint_t>::digits
+                           && (all_n >> nplanes);
+                         ++nplanes)
+                        {
+                            planes[nplanes] = 0;
+                            for (std::size_t r = 0; r < nrows; ++r)
+                                {
+                                    planes[nplanes]
+                                        |= word_type((rows[r]->n >> nplanes)
+                                                     & 1u)
+                                           << r;
+                                }
+                        }
+                    for (std::size_t w = 0; w < nwords; ++w)
+                        {
+                            word_type any = 0;
+                            for (std::size_t r = 0; r < word_bits; ++r)
+                                {
+                                    bits[r] = (r < nrows
+                                               && w < rows[r]->common.size())
+                                                  ? rows[r]->common[w]
+                                                  : 0;
+                                    any |= bits[r];
+                                }
+                            if (!any)
+                                {
+                                    continue;
+                                }
+                            fwdpp_internal::transpose_bits(bits);
+                            const auto first = w * word_bits;
+                            const auto last
+                                = std::min(first + word_bits, ncolumns);
+                            for (std::size_t c = first; c < last; ++c)
+                                {
+                                    const auto column = bits[c - first];
+                                    if (!column)
+                                        {
+                                            continue;
+                                        }
+                                    uint_t sum = 0;
+                                    for (unsigned j = 0; j < nplanes; ++j)
+                                        {
+                                            const uint_t k
+                                                = fwdpp_internal::popcount64(
+                                                    column & planes[j]);
+                                            sum += k << j;
+                                        }
+                                    counts[table->keys[c]] += sum;
+                                }
+                        }
+                }
+        }
+
+        void
+        recombine_common_variants(const common_variant_gamete &g1,
+                                  const common_variant_gamete &g2,
+                                  const std::vector<double> &breakpoints)
+        /*!
+          Take the bits of columns up to the first breakpoint from g1,
+          those up to the second breakpoint from g2, and so on.  As in
+          fwdpp::mutate_recombine, a mutation at a breakpoint comes from
+          the gamete preceding it, and columns after the last breakpoint
+          are not copied.  Without breakpoints, the bits of g1 are
+          copied.
+        */
+        {
+            common_variants = (g1.common_variants) ? g1.common_variants
+                                                   : g2.common_variants;
+            if (breakpoints.empty())
+                {
+                    common = g1.common;
+                    return;
+                }
+            const std::size_t ncolumns
+                = (common_variants) ? common_variants->size() : 0;
+            common.assign((common_variants) ? common_variants->nwords() : 0,
+                          0);
+            const common_variant_gamete *from = &g1, *other = &g2;
+            std::size_t begin = 0;
+            for (auto b = breakpoints.cbegin();
+                 b != breakpoints.cend() && begin < ncolumns; ++b)
+                {
+                    const auto &pos = common_variants->positions;
+                    const std::size_t end
+                        = static_cast<std::size_t>(
+                              std::upper_bound(pos.begin() + begin, pos.end(),
+                                               *b)
+                              - pos.begin());
+                    fwdpp_internal::copy_common_variant_bits(
+                        from->common, begin, end, common);
+                    begin = end;
+                    std::swap(from, other);
+                }
+        }
+
+        inline bool
+        operator==(const common_variant_gamete &rhs) const
+        /// Same keys and same common mutations
+        {
+            return base_t::operator==(rhs)
+                   && fwdpp_internal::same_common_variant_bits(common,
+                                                               rhs.common);
+        }
+    };
+
+    template <typename gcont_t, typename mcont_t>
+    std::size_t
+    update_common_variants(gcont_t &gametes, const mcont_t &mutations,
+                           const std::vector<uint_t> &mcounts,
+                           const uint_t min_count)
+    /*!
+      \brief Store the neutral mutations whose count is at least
+      \a min_count as bits of fwdpp::common_variant_gamete.
+
+      A new fwdpp::common_variant_table is made from the neutral
+      mutations whose count is not zero and is at least \a min_count.
+      Every extant gamete then refers to that table, with its other
+      neutral mutations, including those that are no longer common,
+      in gamete::mutations.  The mutations carried by each gamete do
+      not change.  Extinct gametes are not modified.
+
+      \a mcounts must be the current counts, as after
+      fwdpp::sample_diploid.
+
+      \return The number of columns
+    */
+    {
+        using gamete_t = typename gcont_t::value_type;
+        using word_type = typename gamete_t::word_type;
+        static_assert(fwdpp_internal::has_common_variants<gamete_t>::value,
+                      "gamete type must be a fwdpp::common_variant_gamete");
+        auto table = std::make_shared<common_variant_table>();
+        const auto nkeys = std::min(mcounts.size(), mutations.size());
+        for (std::size_t k = 0; k < nkeys; ++k)
+            {
+                if (mcounts[k] && mcounts[k] >= min_count
+                    && fwdpp_internal::mutation_is_neutral(mutations, k))
+                    {
+                        table->keys.push_back(static_cast<uint_t>(k));
+                    }
+            }
+        std::stable_sort(table->keys.begin(), table->keys.end(),
+                         [&mutations](const uint_t a, const uint_t b) {
+                             return fwdpp_internal::mutation_position(
+                                        mutations, a)
+                                    < fwdpp_internal::mutation_position(
+                                          mutations, b);
+                         });
+        const auto none = std::numeric_limits<std::size_t>::max();
+        std::vector<std::size_t> column(mutations.size(), none);
+        for (std::size_t i = 0; i < table->keys.size(); ++i)
+            {
+                table->positions.push_back(fwdpp_internal::mutation_position(
+                    mutations, table->keys[i]));
+                column[table->keys[i]] = i;
+            }
+        const auto nwords = table->nwords();
+        const std::shared_ptr<const common_variant_table> shared(
+            std::move(table));
+
+        std::vector<uint_t> old_common;
+        typename gamete_t::mutation_container rare;
+        for (auto &g : gametes)
+            {
+                if (!g.n)
+                    {
+                        continue;
+                    }
+                old_common.clear();
+                g.for_each_common_variant(
+                    [&old_common](const uint_t k) { old_common.push_back(k); });
+                g.common.assign(nwords, 0);
+                rare.clear();
+                fwdpp_internal::merge_by_position(
+                    g.mutations, old_common, mutations,
+                    [&](const uint_t k) {
+                        const auto c = column[k];
+                        if (c == none)
+                            {
+                                rare.push_back(k);
+                            }
+                        else
+                            {
+                                g.common[c / fwdpp_internal::
+                                                 common_variant_word_bits]
+                                    |= word_type(1)
+                                       << (c % fwdpp_internal::
+                                                   common_variant_word_bits);
+                            }
+                    });
+                g.mutations.swap(rare);
+                g.common_variants = shared;
+            }
+        return shared->size();
+    }
+
+    template <typename gcont_t, typename mcont_t>
+    void
+    expand_common_variants(gcont_t &gametes, const mcont_t &mutations)
+    /*!
+      \brief Move the common mutations of every
+      fwdpp::common_variant_gamete back into gamete::mutations.
+
+      Afterwards, the gametes store all of their mutations as keys, as
+      fwdpp::gamete does.  Extinct gametes are left without common
+      mutations.
+    */
+    {
+        using gamete_t = typename gcont_t::value_type;
+        static_assert(fwdpp_internal::has_common_variants<gamete_t>::value,
+                      "gamete type must be a fwdpp::common_variant_gamete");
+        std::vector<uint_t> old_common;
+        typename gamete_t::mutation_container all;
+        for (auto &g : gametes)
+            {
+                if (g.n && g.common_variant_count())
+                    {
+                        old_common.clear();
+                        g.for_each_common_variant([&old_common](
+                            const uint_t k) { old_common.push_back(k); });
+                        all.clear();
+                        fwdpp_internal::merge_by_position(
+                            g.mutations, old_common, mutations,
+                            [&all](const uint_t k) { all.push_back(k); });
+                        g.mutations.swap(all);
+                    }
+                g.common_variants.reset();
+                g.common.clear();
+            }
+    }
+}
+
+#endif
@@ -0,0 +1,306 @@
+/*!
+  \file compressed_key_container.hpp
+
+  \brief Mutation keys stored as variable-length differences.
+*/
+#ifndef FWDPP_COMPRESSED_KEY_CONTAINER_HPP__
+#define FWDPP_COMPRESSED_KEY_CONTAINER_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <initializer_list>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/tags/tags.hpp>
+
+namespace fwdpp
+{
+    class compressed_key_container
+    /*!
+      \brief A sequence of mutation keys stored in a compact encoding.
+
+      Each key is stored as its difference from the previous key,
+      zigzag-encoded so that negative differences are small, and
+      written in as few 7-bit groups as possible (a "varint").  The
+      keys of a gamete are sorted by mutation position.  After
+      fwdpp::renumber_mutations, key order is position order, and
+      most differences fit in one or two bytes instead of four.  See
+      generation_workspace::renumber_mutations_interval.  Without
+      renumbering, keys are still stored correctly, but differences
+      are larger and memory is not reduced as much.
+
+      This type may be used as the mutation_container of a
+      fwdpp::gamete_base.  See fwdpp::compressed_gamete.  Keys are
+      decoded in order by a forward iterator, which suffices for
+      fwdpp::mutate_recombine, fwdpp_internal::process_gametes,
+      fwdpp_internal::gamete_cleaner, the fitness models, and
+      serialization.  Keys are appended with push_back or insert at
+      end(), and removed with remove_if.
+      \ingroup basicTypes
+    */
+    {
+      public:
+        using value_type = std::uint32_t;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = const value_type &;
+        using const_reference = const value_type &;
+
+        static inline const std::uint8_t *
+        decode(const std::uint8_t *p, value_type &value) noexcept
+        /// Add the difference encoded at p to value, returning the
+        /// start of the next difference
+        {
+            std::uint32_t z = 0;
+            unsigned shift = 0;
+            std::uint8_t b;
+            do
+                {
+                    b = *p++;
+                    z |= std::uint32_t(b & 0x7f) << shift;
+                    shift += 7;
+                }
+            while (b & 0x80);
+            value += (z >> 1) ^ (0u - (z & 1u));
+            return p;
+        }
+
+        class const_iterator
+        {
+          private:
+            const std::uint8_t *current, *next, *last;
+            std::uint32_t value;
+
+          public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = compressed_key_container::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const value_type *;
+            using reference = const value_type &;
+
+            const_iterator() noexcept
+                : current(nullptr), next(nullptr), last(nullptr), value(0)
+            {
+            }
+            const_iterator(const std::uint8_t *p,
+                           const std::uint8_t *l) noexcept
+                : current(p), next(p), last(l), value(0)
+            {
+                if (p != last)
+                    {
+                        next = decode(p, value);
+                    }
+            }
+            reference operator*() const noexcept { return value; }
+            pointer operator->() const noexcept { return &value; }
+            const_iterator &operator++() noexcept
+            {
+                current = next;
+                if (next != last)
+                    {
+                        next = decode(next, value);
+                    }
+                return *this;
+            }
+            const_iterator operator++(int) noexcept
+            {
+                auto rv = *this;
+                ++(*this);
+                return rv;
+            }
+            bool
+            operator==(const const_iterator &rhs) const noexcept
+            {
+                return current == rhs.current;
+            }
+            bool
+            operator!=(const const_iterator &rhs) const noexcept
+            {
+                return current != rhs.current;
+            }
+        };
+        using iterator = const_iterator;
+
+      private:
+        // The encoded differences
+        std::vector<std::uint8_t> bytes;
+        size_type size_;
+        // The last key
+        value_type last_;
+
+        const std::uint8_t *
+        last_byte() const noexcept
+        {
+            return bytes.data() + bytes.size();
+        }
+
+      public:
+        compressed_key_container() : bytes{}, size_(0), last_(0) {}
+
+        compressed_key_container(std::initializer_list<value_type> keys)
+            : bytes{}, size_(0), last_(0)
+        {
+            insert(end(), keys.begin(), keys.end());
+        }
+
+        compressed_key_container(const compressed_key_container &) = default;
+        compressed_key_container &
+        operator=(const compressed_key_container &)
+            = default;
+
+        compressed_key_container(compressed_key_container &&rhs) noexcept
+            : bytes(std::move(rhs.bytes)), size_(rhs.size_), last_(rhs.last_)
+        /// Leaves \a rhs empty
+        {
+            rhs.clear();
+        }
+
+        compressed_key_container &
+        operator=(compressed_key_container &&rhs) noexcept
+        /// Leaves \a rhs empty
+        {
+            swap(rhs);
+            rhs.clear();
+            return *this;
+        }
+
+        const_iterator
+        begin() const noexcept
+        {
+            return const_iterator(bytes.data(), last_byte());
+        }
+        const_iterator
+        end() const noexcept
+        {
+            return const_iterator(last_byte(), last_byte());
+        }
+        const_iterator
+        cbegin() const noexcept
+        {
+            return begin();
+        }
+        const_iterator
+        cend() const noexcept
+        {
+            return end();
+        }
+
+        size_type
+        size() const noexcept
+        {
+            return size_;
+        }
+        bool
+        empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        size_type
+        encoded_size() const noexcept
+        /// Number of bytes used to store the keys
+        {
+            return bytes.size();
+        }
+
+        void
+        reserve(const size_type n)
+        /// Reserve one byte per key
+        {
+            bytes.reserve(n);
+        }
+
+        void
+        clear() noexcept
+        {
+            bytes.clear();
+            size_ = 0;
+            last_ = 0;
+        }
+
+        void
+        swap(compressed_key_container &rhs) noexcept
+        {
+            bytes.swap(rhs.bytes);
+            std::swap(size_, rhs.size_);
+            std::swap(last_, rhs.last_);
+        }
+
+        void
+        push_back(const value_type key)
+        {
+            const value_type d = key - last_;
+            // zigzag encoding of d as a signed difference
+            std::uint32_t z = (d << 1) ^ (0u - (d >> 31));
+            while (z >= 0x80)
+                {
+                    bytes.push_back(std::uint8_t(z | 0x80));
+                    z >>= 7;
+                }
+            bytes.push_back(std::uint8_t(z));
+            last_ = key;
+            ++size_;
+        }
+
+        template <typename input_iterator>
+        const_iterator
+        insert(const_iterator pos, input_iterator first, input_iterator last)
+        /// Append keys.  \a pos must be end().
+        {
+            assert(pos == end());
+            static_cast<void>(pos);
+            for (; first != last; ++first)
+                {
+                    push_back(*first);
+                }
+            return end();
+        }
+
+        template <typename predicate>
+        void
+        remove_if(const predicate &p)
+        /// Remove the keys for which p(key) is true
+        {
+            compressed_key_container rv;
+            rv.reserve(size_);
+            for (const auto k : *this)
+                {
+                    if (!p(k))
+                        {
+                            rv.push_back(k);
+                        }
+                }
+            swap(rv);
+        }
+
+        bool
+        operator==(const compressed_key_container &rhs) const
+        // The encoding of a sequence of keys is unique
+        {
+            return size_ == rhs.size_ && bytes == rhs.bytes;
+        }
+
+        bool
+        operator!=(const compressed_key_container &rhs) const
+        {
+            return !(*this == rhs);
+        }
+    };
+
+    /*!
+      \brief A gamete whose keys are stored in a
+      fwdpp::compressed_key_container.
+
+      Functions that modify the keys of extant gametes in place, such
+      as fwdpp::add_mutation and fwdpp::change_neutral, require
+      fwdpp::gamete_base with its default container.
+      \ingroup basicTypes
+    */
+    template <typename TAG = tags::standard_gamete>
+    using compressed_gamete = gamete_base<TAG, compressed_key_container>;
+}
+
+#endif
@@ -337,14 +337,26 @@ namespace fwdpp
             */
             inline result_type
             operator()() const
+            {
+                result_type rv;
+                (*this)(rv);
+                return rv;
+            }
+
+            inline void
+            operator()(result_type &rv) const
+            /*!
+              Same as operator()(), but writes the breakpoints into \a
+              rv, which is cleared first.
+            */
             {
                 assert(!(data->recrate == 0.
                          && (data->beg.empty() || data->end.empty())));
+                rv.clear();
                 auto nbreaks = gsl_ran_poisson(data->r, data->recrate);
                 if (!nbreaks)
-                    return {};
+                    return;
 
-                result_type rv;
                 for (unsigned i = 0; i < nbreaks; ++i)
                     {
                         size_t region
@@ -354,7 +366,6 @@ namespace fwdpp
                     }
                 std::sort(rv.begin(), rv.end());
                 rv.push_back(std::numeric_limits<double>::max());
-                return rv;
             }
         };
     }
@@ -0,0 +1,125 @@
+/*!
+  \file fingerprinted_gamete.hpp
+
+  \brief Gametes carrying a 64-bit fingerprint of their mutation keys.
+*/
+#ifndef FWDPP_FINGERPRINTED_GAMETE_HPP__
+#define FWDPP_FINGERPRINTED_GAMETE_HPP__
+
+#include <cstdint>
+#include <tuple>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/tags/tags.hpp>
+#include <fwdpp/internal/gamete_fingerprint.hpp>
+
+namespace fwdpp
+{
+    /*!
+      \brief A gamete that stores a fingerprint of its keys
+
+      The fingerprint is the exclusive or of a pseudo-random 64-bit tag
+      for each key in gamete::mutations and gamete::smutations.  It
+      does not depend on the order of the keys.  Gametes with the same
+      keys have the same fingerprint, so that operator== rejects
+      gametes with different fingerprints without comparing their
+      keys.  fwdpp::mutate_recombine uses operator== to skip
+      recombination between identical parental gametes.
+
+      The fingerprint is set on construction and maintained by
+      fwdpp::mutate_recombine, which derives the fingerprint of a
+      non-recombinant offspring gamete from that of its parent and the
+      new mutations.  It is updated when fixations are removed, when
+      mutations are renumbered, and by fwdpp::add_mutation.  Code that
+      otherwise modifies the keys of a gamete must call
+      update_fingerprint().
+
+      See fwdpp::population_checksum for a checksum of a population
+      built from gamete fingerprints.
+
+      \ingroup basicTypes
+    */
+    template <typename TAG = tags::standard_gamete>
+    struct fingerprinted_gamete : public gamete_base<TAG>
+    {
+        using base_t = gamete_base<TAG>;
+        using typename base_t::mutation_container;
+        using typename base_t::constructor_tuple;
+        //! Type of the fingerprint
+        using fingerprint_type = std::uint64_t;
+        //! Fingerprint of the keys
+        fingerprint_type fingerprint;
+
+        fingerprinted_gamete(const uint_t &icount) noexcept
+            : base_t(icount), fingerprint(0)
+        {
+        }
+
+        template <typename T>
+        fingerprinted_gamete(const uint_t &icount, T &&n, T &&s) noexcept
+            : base_t(icount, std::forward<T>(n), std::forward<T>(s)),
+              fingerprint(calculate_fingerprint())
+        {
+        }
+
+        fingerprinted_gamete(constructor_tuple t)
+            : base_t(std::move(t)), fingerprint(calculate_fingerprint())
+        {
+        }
+
+        fingerprint_type
+        calculate_fingerprint() const noexcept
+        /// Calculate the fingerprint from the keys
+        {
+            return fwdpp_internal::key_fingerprint(this->mutations)
+                   ^ fwdpp_internal::key_fingerprint(this->smutations);
+        }
+
+        void
+        update_fingerprint() noexcept
+        {
+            fingerprint = calculate_fingerprint();
+        }
+
+        inline bool
+        operator==(const fingerprinted_gamete &rhs) const
+        {
+            return this->fingerprint == rhs.fingerprint
+                   && this->mutations == rhs.mutations
+                   && this->smutations == rhs.smutations;
+        }
+    };
+
+    template <typename gcont_t>
+    inline std::uint64_t
+    population_checksum(const gcont_t &gametes)
+    /*!
+      \brief A checksum of the extant gametes of a population.
+
+      The checksum is the sum over extant gametes of gamete::n times
+      the fingerprint of the gamete's keys, modulo 2^64.  It does not
+      depend on the order in which gametes are stored, and so may be
+      used to check that a population written to a checkpoint was read
+      back intact.  It does not depend on how gametes are paired in
+      diploids, or on the mutations that the keys refer to.
+
+      For fwdpp::fingerprinted_gamete, this takes time linear in the
+      number of gametes.  Fingerprints of other gamete types are
+      calculated from their keys.
+
+      \ingroup basicTypes
+    */
+    {
+        std::uint64_t rv = 0;
+        for (const auto &g : gametes)
+            {
+                if (g.n)
+                    {
+                        rv += static_cast<std::uint64_t>(g.n)
+                              * fwdpp_internal::gamete_fingerprint(g);
+                    }
+            }
+        return rv;
+    }
+}
+
+#endif
@@ -0,0 +1,323 @@
+#ifndef FWDPP_FITNESS_CACHE_HPP__
+#define FWDPP_FITNESS_CACHE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <utility>
+#include <vector>
+#include <unordered_map>
+#include <fwdpp/internal/parallel_for.hpp>
+
+namespace fwdpp
+{
+    class fitness_cache
+    /*!
+      \brief Memoize diploid fitnesses by the pair of gametes carried.
+
+      When many diploids carry the same two gametes, as happens when
+      recombination is rare or selection is strong, fitnesses may be
+      looked up rather than recalculated.  The cache is keyed by the
+      unordered pair of gamete indexes.  In addition, the fitness of
+      diploids whose two gametes carry no selected mutations is
+      calculated once per generation.
+
+      The cache is used by the versions of fwdpp::sample_diploid that
+      take a fwdpp::generation_workspace, for single-deme simulations
+      where each diploid is a pair of gamete indexes.
+
+      An entry is invalidated when either of its gametes is recycled,
+      or when the number of selected mutations in either gamete
+      changes, which happens when fixations are removed.  Because only
+      extinct gametes may be recycled, the entries of a gamete are
+      invalidated at the start of each generation in which that
+      gamete is extinct.
+
+      \note The cache assumes that the fitness of a diploid only depends
+      on the selected mutations carried by its two gametes, and that
+      the fitness function does not change between generations.  Call
+      clear() if mutation effect sizes or the fitness function change.
+    */
+    {
+      private:
+        struct entry
+        {
+            double w;
+            unsigned version1, version2;
+            std::size_t nselected1, nselected2;
+            std::uint64_t last_used;
+            // Index of a calculation pending in the current generation,
+            // or none.
+            std::size_t pending;
+        };
+        enum : std::size_t
+        {
+            none = std::size_t(-1)
+        };
+
+        struct key_hash
+        {
+            std::size_t
+            operator()(const std::pair<std::size_t, std::size_t> &k) const
+            {
+                return std::size_t(std::uint64_t(k.first)
+                                       * 0x9E3779B97F4A7C15ULL
+                                   ^ std::uint64_t(k.second));
+            }
+        };
+
+        using key_type = std::pair<std::size_t, std::size_t>;
+        std::unordered_map<key_type, entry, key_hash> entries;
+        // Incremented each time a gamete slot may be recycled
+        std::vector<unsigned> versions;
+        std::uint64_t generation, nhits, nmisses, nskipped;
+        // Used by fill, and kept to avoid reallocation
+        std::vector<std::size_t> miss_diploids, miss_of;
+        std::vector<double> miss_fitnesses;
+        std::vector<key_type> miss_keys;
+
+        static key_type
+        make_key(const std::size_t a, const std::size_t b)
+        {
+            return (a < b) ? key_type(a, b) : key_type(b, a);
+        }
+
+        template <typename gcont_t>
+        bool
+        is_valid(const key_type &k, const entry &e,
+                 const gcont_t &gametes) const
+        {
+            return versions[k.first] == e.version1
+                   && versions[k.second] == e.version2
+                   && gametes[k.first].smutations.size() == e.nselected1
+                   && gametes[k.second].smutations.size() == e.nselected2;
+        }
+
+        void
+        purge(const std::size_t max_entries)
+        // Remove entries not used in this generation
+        {
+            if (entries.size() <= max_entries)
+                {
+                    return;
+                }
+            for (auto i = entries.begin(); i != entries.end();)
+                {
+                    if (i->second.last_used != generation)
+                        {
+                            i = entries.erase(i);
+                        }
+                    else
+                        {
+                            ++i;
+                        }
+                }
+        }
+
+      public:
+        fitness_cache()
+            : entries{}, versions{}, generation(0), nhits(0), nmisses(0),
+              nskipped(0), miss_diploids{}, miss_of{}, miss_fitnesses{},
+              miss_keys{}
+        {
+        }
+
+        template <typename gcont_t>
+        void
+        invalidate_extinct(const gcont_t &gametes)
+        /*!
+          Invalidate the entries of all extinct gametes.  Must be called
+          before the gamete counts are reset, which fwdpp::sample_diploid
+          takes care of.
+        */
+        {
+            versions.resize(gametes.size(), 0);
+            for (std::size_t i = 0; i < gametes.size(); ++i)
+                {
+                    if (!gametes[i].n)
+                        {
+                            ++versions[i];
+                        }
+                }
+        }
+
+        void
+        invalidate(const std::size_t gamete_index)
+        /// Invalidate all entries involving a gamete.
+        {
+            if (gamete_index < versions.size())
+                {
+                    ++versions[gamete_index];
+                }
+        }
+
+        void
+        clear()
+        /// Remove all entries.  Statistics are not reset.
+        {
+            entries.clear();
+        }
+
+        std::size_t
+        size() const
+        /// Number of entries
+        {
+            return entries.size();
+        }
+
+        std::uint64_t
+        hits() const
+        /// Number of fitnesses looked up, including those of diploids
+        /// carrying no selected mutations
+        {
+            return nhits;
+        }
+
+        std::uint64_t
+        misses() const
+        /// Number of fitnesses calculated by calling the fitness function
+        {
+            return nmisses;
+        }
+
+        std::uint64_t
+        skipped() const
+        /// Number of diploids whose fitness was not calculated because
+        /// neither gamete carries selected mutations
+        {
+            return nskipped;
+        }
+
+        double
+        hit_rate() const
+        /// hits()/(hits() + misses()), or 0 if the cache is unused
+        {
+            const auto total = nhits + nmisses;
+            return (total == 0) ? 0. : double(nhits) / double(total);
+        }
+
+        void
+        reset_statistics()
+        {
+            nhits = nmisses = nskipped = 0;
+        }
+
+        template <typename dipvector_t, typename gcont_t, typename mcont_t,
+                  typename fitness_function>
+        double
+        fill(const dipvector_t &diploids, const gcont_t &gametes,
+             const mcont_t &mutations, const fitness_function &ff,
+             double *fitnesses, const unsigned nthreads)
+        /*!
+          Same as fwdpp::fwdpp_internal::fill_fitnesses, except that \a ff
+          is only called for pairs of gametes not in the cache.  Those
+          calls are made on \a nthreads threads.  The sum of fitnesses
+          is accumulated in order, and is identical to the
+          single-threaded value of fill_fitnesses.
+        */
+        {
+            ++generation;
+            versions.resize(gametes.size(), 0);
+            miss_diploids.clear();
+            miss_keys.clear();
+            miss_of.assign(diploids.size(), none);
+            // Index of the calculation for diploids carrying no
+            // selected mutations
+            std::size_t neutral_miss = none;
+
+            // Pass 1: look up each diploid.  Each pair of gametes not in
+            // the cache is recorded once in miss_diploids.
+            for (std::size_t i = 0; i < diploids.size(); ++i)
+                {
+                    const auto a = diploids[i].first, b = diploids[i].second;
+                    assert(a < gametes.size() && b < gametes.size());
+                    if (gametes[a].smutations.empty()
+                        && gametes[b].smutations.empty())
+                        {
+                            if (neutral_miss == none)
+                                {
+                                    neutral_miss = miss_diploids.size();
+                                    miss_keys.emplace_back(make_key(a, b));
+                                    miss_diploids.push_back(i);
+                                    ++nmisses;
+                                }
+                            else
+                                {
+                                    ++nhits;
+                                    ++nskipped;
+                                }
+                            miss_of[i] = neutral_miss;
+                            continue;
+                        }
+                    const auto key = make_key(a, b);
+                    auto itr = entries.find(key);
+                    if (itr != entries.end()
+                        && is_valid(itr->first, itr->second, gametes))
+                        {
+                            itr->second.last_used = generation;
+                            if (itr->second.pending != none)
+                                {
+                                    miss_of[i] = itr->second.pending;
+                                }
+                            else
+                                {
+                                    fitnesses[i] = itr->second.w;
+                                }
+                            ++nhits;
+                            continue;
+                        }
+                    entry e;
+                    e.w = 0.;
+                    e.version1 = versions[key.first];
+                    e.version2 = versions[key.second];
+                    e.nselected1 = gametes[key.first].smutations.size();
+                    e.nselected2 = gametes[key.second].smutations.size();
+                    e.last_used = generation;
+                    e.pending = miss_diploids.size();
+                    entries[key] = e;
+                    miss_of[i] = miss_diploids.size();
+                    miss_keys.push_back(key);
+                    miss_diploids.push_back(i);
+                    ++nmisses;
+                }
+
+            // Pass 2: calculate the fitnesses that were not in the cache
+            miss_fitnesses.resize(miss_diploids.size());
+            fwdpp_internal::parallel_for(
+                nthreads, miss_diploids.size(),
+                [this, &diploids, &gametes, &mutations, &ff](
+                    const std::size_t, const std::size_t begin,
+                    const std::size_t end) {
+                    for (auto m = begin; m < end; ++m)
+                        {
+                            miss_fitnesses[m] = ff(diploids[miss_diploids[m]],
+                                                   gametes, mutations);
+                        }
+                });
+
+            // Pass 3: store the new entries and fill in the fitnesses
+            for (std::size_t m = 0; m < miss_diploids.size(); ++m)
+                {
+                    if (m != neutral_miss)
+                        {
+                            auto &e = entries[miss_keys[m]];
+                            e.w = miss_fitnesses[m];
+                            e.pending = none;
+                        }
+                }
+            double sum = 0.;
+            for (std::size_t i = 0; i < diploids.size(); ++i)
+                {
+                    if (miss_of[i] != none)
+                        {
+                            fitnesses[i] = miss_fitnesses[miss_of[i]];
+                        }
+                    sum += fitnesses[i];
+                }
+            purge(4 * diploids.size());
+            return sum;
+        }
+    };
+}
+
+#endif
@@ -4,6 +4,9 @@
 #include <fwdpp/forward_types.hpp>
 #include <fwdpp/fwd_functional.hpp>
 #include <fwdpp/type_traits.hpp>
+#include <fwdpp/cached_value_gamete.hpp>
+#include <fwdpp/internal/haplotype_value_cache.hpp>
+#include <fwdpp/internal/mutation_columns.hpp>
 #include <cassert>
 #include <type_traits>
 #include <algorithm>
@@ -62,6 +65,10 @@
 
   Finally, fwdpp::no_selection is provided to force all diploid fitnesses to be
   equal to 1.
+
+  When gametes are of type fwdpp::cached_value_gamete, the additive and
+  multiplicative models, and fwdpp::haplotype_dependent_trait_value, may
+  use the haplotype values cached by each gamete.
 */
 namespace fwdpp
 {
@@ -183,37 +190,11 @@ namespace fwdpp
                         fpol_het(w, mutations[*first1]);
                     return w;
                 }
-            for (; first1 != last1; ++first1)
-                {
-                    for (;
-                         first2 != last2 && *first1 != *first2
-                         && !(mutations[*first2].pos > mutations[*first1].pos);
-                         ++first2)
-                        // All mutations in this range are Aa
-                        {
-                            assert(mutations[*first2].pos
-                                   < mutations[*first1].pos);
-                            fpol_het(w, mutations[*first2]);
-                        }
-                    if (first2 < last2 && *first1 == *first2) // mutation with
-                        // index first1
-                        // is homozygous
-                        {
-                            assert(mutations[*first2].pos
-                                   == mutations[*first1].pos);
-                            fpol_hom(w, mutations[*first1]);
-                            ++first2; // increment so that we don't re-process
-                            // this site as a het next time 'round
-                        }
-                    else // mutation first1 is heterozygous
-                        {
-                            fpol_het(w, mutations[*first1]);
-                        }
-                }
-            for (; first2 != last2; ++first2)
-                {
-                    fpol_het(w, mutations[*first2]);
-                }
+            using __mtype = typename mcont_t::value_type;
+            fwdpp_internal::for_each_diploid_site(
+                first1, last1, first2, last2, mutations,
+                [&w, &fpol_hom](const __mtype &mut) { fpol_hom(w, mut); },
+                [&w, &fpol_het](const __mtype &mut) { fpol_het(w, mut); });
             return w;
         }
 
@@ -356,6 +337,45 @@ namespace fwdpp
                                     gametes[diploid.second], mutations, hpol,
                                     dpol);
         }
+        template <typename gamete_type, typename mcont_t,
+                  typename diploid_policy>
+        inline result_type
+        operator()(const gamete_type &g1, const gamete_type &g2,
+                   const mcont_t &mutations, const diploid_policy &dpol) const
+            noexcept
+        ///\param g1 A gamete
+        ///\param g2 A gamete
+        ///\param mutation Container of mutations
+        ///\param dpol As above
+        ///\return dpol( g1.haplotype_value(mutations),
+        /// g2.haplotype_value(mutations) )
+        ///
+        ///\note For gametes caching their haplotype values.
+        /// See fwdpp::cached_value_gamete.
+        {
+            static_assert(fwdpp_internal::has_cached_value<gamete_type>::value,
+                          "gamete_type must cache haplotype values");
+            return dpol(g1.haplotype_value(mutations),
+                        g2.haplotype_value(mutations));
+        }
+        template <typename diploid_t, typename gcont_t, typename mcont_t,
+                  typename diploid_policy>
+        inline result_type
+        operator()(const diploid_t &diploid, const gcont_t &gametes,
+                   const mcont_t &mutations, const diploid_policy &dpol) const
+            noexcept
+        ///\param diploid a diploid
+        ///\param gametes Container of gametes
+        ///\param mutation Container of mutations
+        ///\param dpol As above
+        ///\note For gametes caching their haplotype values.
+        /// See fwdpp::cached_value_gamete.
+        {
+            static_assert(traits::is_diploid<diploid_t>::value,
+                          "diploid_t must represent a diploid");
+            return this->operator()(gametes[diploid.first],
+                                    gametes[diploid.second], mutations, dpol);
+        }
     };
 
     /// Typedef for backwards API compatibility.
@@ -455,9 +475,21 @@ namespace fwdpp
         ///  simulation is on the same scale as various formula in the
         ///  literature
         ///  \return Multiplicative genetic value across sites.
+        {
+            return make_return_value(genetic_value(
+                g1, g2, mutations,
+                fwdpp_internal::uses_haplotype_value_policy<
+                    gamete_type, multiplicative_haplotype_value>()));
+        }
+
+        template <typename gamete_type, typename mcont_t>
+        inline double
+        genetic_value(const gamete_type &g1, const gamete_type &g2,
+                      const mcont_t &mutations, std::false_type) const
+            noexcept
         {
             using __mtype = typename mcont_t::value_type;
-            return make_return_value(site_dependent_genetic_value()(
+            return site_dependent_genetic_value()(
                 g1, g2, mutations,
                 [this](double &value, const __mtype &mut) noexcept {
                     value *= (1. + scaling * mut.s);
@@ -465,7 +497,41 @@ namespace fwdpp
                 [](double &value, const __mtype &mut) noexcept {
                     value *= (1. + mut.h * mut.s);
                 },
-                1.));
+                1.);
+        }
+
+        template <typename gamete_type, typename mcont_t>
+        inline double
+        genetic_value(const gamete_type &g1, const gamete_type &g2,
+                      const mcont_t &mutations, std::true_type) const
+            noexcept
+        /// Overload for gametes caching the product of 1+hs.
+        /// Each homozygous site replaces (1+hs)^2 with 1+scaling*s.
+        {
+            double w = g1.haplotype_value(mutations)
+                       * g2.haplotype_value(mutations);
+            if (g1.smutations.empty() || g2.smutations.empty())
+                {
+                    return w;
+                }
+            bool singular = false;
+            using __mtype = typename mcont_t::value_type;
+            fwdpp_internal::for_each_homozygous_site(
+                g1.smutations.cbegin(), g1.smutations.cend(),
+                g2.smutations.cbegin(), g2.smutations.cend(), mutations,
+                [this, &w, &singular](const __mtype &mut) noexcept {
+                    const double het = 1. + mut.h * mut.s;
+                    if (het == 0.)
+                        {
+                            singular = true;
+                            return;
+                        }
+                    w *= (1. + scaling * mut.s) / (het * het);
+                });
+            // A factor of zero cannot be divided out
+            return (singular) ? genetic_value(g1, g2, mutations,
+                                              std::false_type())
+                              : w;
         }
 
         template <typename diploid, typename gcont_t, typename mcont_t>
@@ -592,9 +658,21 @@ namespace fwdpp
         ///  literature
         ///  \return Additive genetic value across sites.
         ///  \note g1 and g2 must be part of the gamete_base hierarchy
+        {
+            return make_return_value(genetic_value(
+                g1, g2, mutations,
+                fwdpp_internal::uses_haplotype_value_policy<
+                    gamete_type, additive_haplotype_value>()));
+        }
+
+        template <typename gamete_type, typename mcont_t>
+        inline double
+        genetic_value(const gamete_type &g1, const gamete_type &g2,
+                      const mcont_t &mutations, std::false_type) const
+            noexcept
         {
             using __mtype = typename mcont_t::value_type;
-            return make_return_value(site_dependent_genetic_value()(
+            return site_dependent_genetic_value()(
                 g1, g2, mutations,
                 [this](double &value, const __mtype &mut) noexcept {
                     value += (scaling * mut.s);
@@ -602,7 +680,31 @@ namespace fwdpp
                 [](double &value, const __mtype &mut) noexcept {
                     value += (mut.h * mut.s);
                 },
-                0.));
+                0.);
+        }
+
+        template <typename gamete_type, typename mcont_t>
+        inline double
+        genetic_value(const gamete_type &g1, const gamete_type &g2,
+                      const mcont_t &mutations, std::true_type) const
+            noexcept
+        /// Overload for gametes caching the sum of hs.
+        /// Each homozygous site replaces 2hs with scaling*s.
+        {
+            double w = g1.haplotype_value(mutations)
+                       + g2.haplotype_value(mutations);
+            if (g1.smutations.empty() || g2.smutations.empty())
+                {
+                    return w;
+                }
+            using __mtype = typename mcont_t::value_type;
+            fwdpp_internal::for_each_homozygous_site(
+                g1.smutations.cbegin(), g1.smutations.cend(),
+                g2.smutations.cbegin(), g2.smutations.cend(), mutations,
+                [this, &w](const __mtype &mut) noexcept {
+                    w += (scaling - 2. * mut.h) * mut.s;
+                });
+            return w;
         }
 
         ///  \brief Overload for diploids.  This is what a programmer's
@@ -88,6 +88,67 @@ namespace fwdpp
         }
     };
 
+    struct compact_mutation_base
+    /*!
+      \brief Base class for mutations without virtual functions.
+
+      Holds the same data as fwdpp::mutation_base, but has no virtual
+      destructor.  Thus, mutation objects have no virtual table
+      pointer, are trivially copyable if the derived type's members
+      are, and containers of them are copied and grown using memcpy.
+      A derived type should not be destroyed through a pointer to
+      this type.
+
+      Library functions accept mutations derived from either base.  See
+      fwdpp::traits::is_mutation.
+      \ingroup basicTypes
+    */
+    {
+        /// Mutation position
+        double pos;
+        /// 16 bits of extra data.  See mutation_base::xtra.
+        std::uint16_t xtra;
+        /// Is the mutation neutral or not?
+        bool neutral;
+        compact_mutation_base(const double &position,
+                              const bool &isneutral = true,
+                              const std::uint16_t x = 0) noexcept
+            : pos(position), xtra(x), neutral(isneutral)
+        {
+        }
+
+        inline bool
+        is_equal(const compact_mutation_base &rhs) const
+        {
+            return this->pos == rhs.pos && this->xtra == rhs.xtra
+                   && this->neutral == rhs.neutral;
+        }
+    };
+
+    struct compact_mutation : public compact_mutation_base
+    /*!
+      \brief Same as fwdpp::mutation, without a virtual table pointer.
+      \ingroup basicTypes
+    */
+    {
+        /// selection coefficient
+        double s;
+        /// dominance coefficient
+        double h;
+        compact_mutation(const double &position, const double &sel_coeff,
+                         const double &dominance = 0.5) noexcept
+            : compact_mutation_base(position, (sel_coeff == 0)),
+              s(sel_coeff), h(dominance)
+        {
+        }
+        bool
+        operator==(const compact_mutation &rhs) const
+        {
+            return std::tie(this->s, this->h) == std::tie(rhs.s, rhs.h)
+                   && is_equal(rhs);
+        }
+    };
+
     /*! \brief Base class for gametes.
 
       A gamete contains one container of keys to neutral mutations, and another
@@ -98,6 +159,8 @@ namespace fwdpp
       tag_type = A type that can be used as a "dispatch tag".  Currently, these
       are not used elsewhere in the library, but they may
       be in the future, or this may disappear in future library releases.
+      key_container = The container of mutation keys.  See
+      fwdpp::chunked_gamete for an alternative to the default.
 
       \note The typical use of this class is simply to define your mutation
       type (see @ref md_md_policies)
@@ -108,14 +171,16 @@ namespace fwdpp
       See @ref md_md_policies for examples of this.
       \ingroup basicTypes
     */
-    template <typename TAG = tags::standard_gamete> struct gamete_base
+    template <typename TAG = tags::standard_gamete,
+              typename key_container = std::vector<std::uint32_t>>
+    struct gamete_base
     {
         //! Count in population
         uint_t n;
         //! Dispatch tag type
         using gamete_tag = TAG;
         using index_t = std::uint32_t;
-        using mutation_container = std::vector<index_t>;
+        using mutation_container = key_container;
         //! Container of mutations not affecting trait value/fitness ("neutral
         //! mutations")
         mutation_container mutations;
@@ -175,7 +240,7 @@ namespace fwdpp
         /*! \brief Equality operation
         */
         inline bool
-        operator==(const gamete_base<TAG> &rhs) const
+        operator==(const gamete_base &rhs) const
         {
             return (this->mutations == rhs.mutations
                     && this->smutations == rhs.smutations);
@@ -190,9 +255,73 @@ namespace fwdpp
                       "Typename gamete_tag must refer to a type that is "
                       "default- and nothrow-constructible");
 #endif
+        static_assert(std::is_same<typename key_container::value_type,
+                                   index_t>::value,
+                      "key_container must contain values of type index_t");
     };
 
     /// Default gamete type
     using gamete = gamete_base<tags::standard_gamete>;
+
+    /*! \brief Base class for gametes without virtual functions.
+
+      Has the same members and constructors as fwdpp::gamete_base, and
+      may be used wherever that type is, but has no virtual destructor.
+      Each gamete is then one pointer smaller.  See
+      fwdpp::compact_selected_gamete for a gamete whose key containers
+      are each the size of one pointer.
+      \ingroup basicTypes
+    */
+    template <typename TAG = tags::standard_gamete,
+              typename key_container = std::vector<std::uint32_t>>
+    struct compact_gamete_base
+    {
+        //! Count in population
+        uint_t n;
+        //! Dispatch tag type
+        using gamete_tag = TAG;
+        using index_t = std::uint32_t;
+        using mutation_container = key_container;
+        //! Container of neutral mutations
+        mutation_container mutations;
+        //! Container of selected mutations
+        mutation_container smutations;
+
+        //! Tuple type usable for construction
+        using constructor_tuple
+            = std::tuple<uint_t, mutation_container, mutation_container>;
+
+        compact_gamete_base(const uint_t &icount) noexcept
+            : n(icount), mutations(mutation_container()),
+              smutations(mutation_container())
+        {
+        }
+
+        template <typename T>
+        compact_gamete_base(const uint_t &icount, T &&n, T &&s) noexcept
+            : n(icount), mutations(std::forward<T>(n)),
+              smutations(std::forward<T>(s))
+        {
+        }
+
+        compact_gamete_base(constructor_tuple t)
+            : n(std::get<0>(t)), mutations(std::move(std::get<1>(t))),
+              smutations(std::move(std::get<2>(t)))
+        {
+        }
+
+        inline bool
+        operator==(const compact_gamete_base &rhs) const
+        {
+            return (this->mutations == rhs.mutations
+                    && this->smutations == rhs.smutations);
+        }
+        static_assert(std::is_same<typename key_container::value_type,
+                                   index_t>::value,
+                      "key_container must contain values of type index_t");
+    };
+
+    /// Compact gamete type.  See fwdpp::compact_gamete_base.
+    using compact_gamete = compact_gamete_base<tags::standard_gamete>;
 }
 #endif /* _FORWARD_TYPES_HPP_ */
@@ -0,0 +1,314 @@
+#ifndef FWDPP_GAMETE_HASH_INDEX_HPP__
+#define FWDPP_GAMETE_HASH_INDEX_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <type_traits>
+#include <unordered_map>
+#include <fwdpp/internal/void_t.hpp>
+#include <fwdpp/internal/common_variant_bits.hpp>
+
+namespace fwdpp
+{
+    namespace fwdpp_internal
+    {
+        inline std::uint64_t
+        hash_combine(const std::uint64_t seed,
+                     const std::uint64_t value) noexcept
+        {
+            return seed
+                   ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6)
+                      + (seed >> 2));
+        }
+
+        template <typename key_container>
+        inline std::uint64_t
+        hash_keys(std::uint64_t seed, const key_container &keys) noexcept
+        {
+            seed = hash_combine(seed, keys.size());
+            for (const auto k : keys)
+                {
+                    seed = hash_combine(seed, k);
+                }
+            return seed;
+        }
+
+        template <typename gamete_t>
+        inline std::uint64_t
+        hash_common_variants(const std::uint64_t seed, const gamete_t &,
+                             std::false_type) noexcept
+        {
+            return seed;
+        }
+
+        template <typename gamete_t>
+        inline std::uint64_t
+        hash_common_variants(std::uint64_t seed, const gamete_t &g,
+                             std::true_type) noexcept
+        {
+            // Trailing zero words do not affect equality
+            auto n = g.common.size();
+            while (n && !g.common[n - 1])
+                {
+                    --n;
+                }
+            for (std::size_t i = 0; i < n; ++i)
+                {
+                    seed = hash_combine(seed, g.common[i]);
+                }
+            return seed;
+        }
+
+        template <typename T, typename = void>
+        struct has_gamete_keys : std::false_type
+        /// True for diploids and other pairs of gamete keys
+        {
+        };
+
+        template <typename T>
+        struct has_gamete_keys<T, typename traits::internal::void_t<
+                                      typename T::first_type,
+                                      typename T::second_type>::type>
+            : std::true_type
+        {
+        };
+
+        template <typename diploid_t>
+        inline typename std::enable_if<
+            has_gamete_keys<diploid_t>::value>::type
+        remap_gamete_keys(diploid_t &dip,
+                          const std::vector<std::size_t> &new_keys) noexcept
+        {
+            dip.first = new_keys[dip.first];
+            dip.second = new_keys[dip.second];
+        }
+
+        template <typename container>
+        inline typename std::enable_if<
+            !has_gamete_keys<container>::value>::type
+        remap_gamete_keys(container &c,
+                          const std::vector<std::size_t> &new_keys) noexcept
+        /// Containers of diploids, demes, or loci
+        {
+            // auto && binds the rows of fwdpp::multilocus_genotype_matrix
+            for (auto &&i : c)
+                {
+                    remap_gamete_keys(i, new_keys);
+                }
+        }
+    }
+
+    class gamete_hash_index
+    /*!
+      \brief Look up gametes by their mutation keys.
+
+      In recombining populations, the same haplotype is often formed
+      many times in one generation, and each copy is stored as a
+      separate gamete.  Duplicated gametes cost memory and make
+      fwdpp_internal::process_gametes and
+      fwdpp_internal::gamete_cleaner do redundant work.
+
+      This class maps a hash of the neutral and selected keys of a
+      gamete to the gamete's index.  When
+      generation_workspace::hash_cons_gametes is true,
+      fwdpp::sample_diploid indexes the extant gametes at the start of
+      a generation.  A new offspring gamete that matches an indexed
+      gamete then refers to that gamete instead of being stored again.
+      See fwdpp::merge_duplicate_gametes for removing duplicates that
+      already exist.
+    */
+    {
+      private:
+        std::unordered_multimap<std::uint64_t, std::size_t> index;
+        std::uint64_t nmerged;
+
+      public:
+        gamete_hash_index() : index{}, nmerged(0) {}
+
+        template <typename key_container>
+        static std::uint64_t
+        hash(const key_container &neutral,
+             const key_container &selected) noexcept
+        /// Hash of the keys of a gamete
+        {
+            return fwdpp_internal::hash_keys(
+                fwdpp_internal::hash_keys(0, neutral), selected);
+        }
+
+        template <typename gamete_t>
+        static std::uint64_t
+        hash(const gamete_t &g) noexcept
+        /// Hash of a gamete, including its common variants.  See
+        /// fwdpp::common_variant_gamete.
+        {
+            return fwdpp_internal::hash_common_variants(
+                hash(g.mutations, g.smutations), g,
+                fwdpp_internal::has_common_variants<gamete_t>());
+        }
+
+        void
+        clear()
+        /// Empty the index, keeping its buckets
+        {
+            index.clear();
+        }
+
+        std::size_t
+        size() const
+        /// Number of indexed gametes
+        {
+            return index.size();
+        }
+
+        template <typename gcont_t>
+        void
+        rebuild(const gcont_t &gametes)
+        /// Index all extant gametes
+        {
+            index.clear();
+            for (std::size_t i = 0; i < gametes.size(); ++i)
+                {
+                    if (gametes[i].n)
+                        {
+                            insert(hash(gametes[i]), i);
+                        }
+                }
+        }
+
+        void
+        insert(const std::uint64_t h, const std::size_t i)
+        {
+            index.emplace(h, i);
+        }
+
+        template <typename gcont_t, typename key_container>
+        std::pair<bool, std::size_t>
+        find(const gcont_t &gametes, const std::uint64_t h,
+             const key_container &neutral,
+             const key_container &selected) const
+        /*!
+          Find a gamete with keys \a neutral and \a selected, whose
+          hash is \a h.  Returns (true, index) if one is found, and
+          (false, 0) otherwise.
+        */
+        {
+            auto r = index.equal_range(h);
+            for (; r.first != r.second; ++r.first)
+                {
+                    const auto &g = gametes[r.first->second];
+                    if (g.mutations == neutral && g.smutations == selected)
+                        {
+                            return std::make_pair(true, r.first->second);
+                        }
+                }
+            return std::make_pair(false, std::size_t(0));
+        }
+
+        template <typename gcont_t>
+        std::pair<bool, std::size_t>
+        find(const gcont_t &gametes, const std::uint64_t h,
+             const typename gcont_t::value_type &g) const
+        /*!
+          Find a gamete equal to \a g, whose hash is \a h.  Returns
+          (true, index) if one is found, and (false, 0) otherwise.
+        */
+        {
+            auto r = index.equal_range(h);
+            for (; r.first != r.second; ++r.first)
+                {
+                    if (gametes[r.first->second] == g)
+                        {
+                            return std::make_pair(true, r.first->second);
+                        }
+                }
+            return std::make_pair(false, std::size_t(0));
+        }
+
+        void
+        record_merge()
+        {
+            ++nmerged;
+        }
+
+        std::uint64_t
+        merged() const
+        /// Number of gametes that were not stored because a copy existed
+        {
+            return nmerged;
+        }
+    };
+
+    template <typename gcont_t, typename dipvector_t>
+    std::size_t
+    merge_duplicate_gametes(gcont_t &gametes, dipvector_t &diploids,
+                            gamete_hash_index &index)
+    /*!
+      \brief Make all diploids refer to a single copy of each distinct
+      extant gamete.
+
+      For each set of equal extant gametes, meaning gametes with the
+      same neutral and selected keys (and common variants, see
+      fwdpp::common_variant_gamete), the one with the smallest index is
+      kept.  The counts of the
+      others are added to it, they are marked as extinct, and the
+      diploids referring to them are updated.  Duplicates may arise
+      when fixations are removed from gametes, or from offspring
+      generated without a fwdpp::gamete_hash_index.
+
+      \a diploids may be the diploids of a single deme, of a
+      metapopulation, or of a multi-locus simulation.  On return,
+      \a index contains the remaining extant gametes.
+
+      \return The number of gametes marked as extinct.
+    */
+    {
+        index.clear();
+        std::vector<std::size_t> new_keys(gametes.size());
+        std::size_t nmerged = 0;
+        for (std::size_t i = 0; i < gametes.size(); ++i)
+            {
+                new_keys[i] = i;
+                if (!gametes[i].n)
+                    {
+                        continue;
+                    }
+                const auto h = gamete_hash_index::hash(gametes[i]);
+                const auto f = index.find(gametes, h, gametes[i]);
+                if (f.first)
+                    {
+                        new_keys[i] = f.second;
+                        gametes[f.second].n += gametes[i].n;
+                        gametes[i].n = 0;
+                        index.record_merge();
+                        ++nmerged;
+                    }
+                else
+                    {
+                        index.insert(h, i);
+                    }
+            }
+        if (nmerged)
+            {
+                fwdpp_internal::remap_gamete_keys(diploids, new_keys);
+            }
+        return nmerged;
+    }
+
+    template <typename gcont_t, typename dipvector_t>
+    std::size_t
+    merge_duplicate_gametes(gcont_t &gametes, dipvector_t &diploids)
+    /*!
+      \brief Make all diploids refer to a single copy of each distinct
+      extant gamete.
+
+      See the other overload for details.
+    */
+    {
+        gamete_hash_index index;
+        return merge_duplicate_gametes(gametes, diploids, index);
+    }
+}
+
+#endif
@@ -135,16 +135,27 @@ namespace fwdpp
         {
         }
 
-        inline std::vector<double>
-        operator()() const
+        inline void
+        operator()(std::vector<double>& breakpoints) const
+        /*!
+          Write the breakpoints into \a breakpoints, which is cleared
+          first.
+        */
         {
-            std::vector<double> breakpoints;
+            breakpoints.clear();
             for (const auto& f : recmap)
                 {
                     f(breakpoints);
                 }
             std::sort(breakpoints.begin(), breakpoints.end());
             breakpoints.push_back(std::numeric_limits<double>::max());
+        }
+
+        inline std::vector<double>
+        operator()() const
+        {
+            std::vector<double> breakpoints;
+            (*this)(breakpoints);
             return breakpoints;
         }
     };
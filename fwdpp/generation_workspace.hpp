@@ -0,0 +1,232 @@
+#ifndef FWDPP_GENERATION_WORKSPACE_HPP__
+#define FWDPP_GENERATION_WORKSPACE_HPP__
+
+#include <cstddef>
+#include <vector>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/parent_sampler.hpp>
+#include <fwdpp/fitness_cache.hpp>
+#include <fwdpp/mutation_count_tracker.hpp>
+#include <fwdpp/gamete_hash_index.hpp>
+#include <fwdpp/internal/parallel_for.hpp>
+#include <fwdpp/internal/recycling.hpp>
+#include <fwdpp/internal/threaded_offspring.hpp>
+
+namespace fwdpp
+{
+    template <typename dipvector_t,
+              typename mutation_container = std::vector<uint_t>>
+    struct generation_workspace
+    /*!
+      \brief Storage reused by fwdpp::sample_diploid from one generation
+      to the next.
+
+      Each call to the versions of fwdpp::sample_diploid that do not take
+      a workspace allocates a copy of the parents, a vector of
+      fitnesses, a lookup table for sampling parents, and the recycling
+      bins.  When a generation_workspace is passed instead, all of those
+      objects live here and keep their capacity between generations:
+
+      1. Offspring are written into generation_workspace::offspring,
+      which is then swapped with the parents.  The parents are never
+      copied.
+      2. Fitnesses are written into generation_workspace::fitnesses.
+      3. Parents are sampled using generation_workspace::samplers, which
+      holds one fwdpp::parent_sampler per deme.
+      4. The recycling bins are stacks kept here.  The extinct gametes
+      are collected while gamete counts are reset, and the extinct
+      mutations by fwdpp::update_mutations when it is passed the
+      workspace, rather than by separate passes over all gametes and
+      mutations.
+
+      The workspace also holds the temporary containers used by
+      fwdpp::mutate_recombine, meaning that a workspace replaces the
+      "neutral" and "selected" arguments to fwdpp::sample_diploid.
+
+      \note A workspace has no effect on the outcome of a simulation
+      except via generation_workspace::use_parent_sampler.  Some options
+      change where gametes and mutations are stored, but not the
+      haplotypes of the diploids.  A workspace should not be shared by
+      simulations running concurrently.
+    */
+    {
+        /// Type of the container of diploids
+        using diploid_container = dipvector_t;
+        /// Type of the recycling bins
+        using recycling_bin_t = fwdpp_internal::recycling_bin_t<std::size_t>;
+
+        /// Number of threads passed on to fwdpp::sample_diploid
+        unsigned nthreads;
+        /*!
+          If true (the default), parents are sampled using
+          generation_workspace::samplers.  If false, a gsl_ran_discrete_t
+          is built each generation, which gives the same random number
+          stream as the versions of fwdpp::sample_diploid that do not take
+          a workspace.
+        */
+        bool use_parent_sampler;
+        /*!
+          If true, single-deme simulations generate offspring in two
+          passes.  The first pass samples parents and draws all random
+          numbers, in the same order as the default, and records the
+          events for each offspring.  The second pass assembles the
+          offspring gametes in order of their parental gametes, writing
+          each result to its original offspring slot.  This improves
+          memory locality in large populations and does not change the
+          outcome of a simulation.  The default is false.
+        */
+        bool sort_offspring;
+        /*!
+          If true, single-deme simulations look up fitnesses in
+          generation_workspace::cache before calling the fitness
+          function.  The default is false.  See fwdpp::fitness_cache for
+          the assumptions made about the fitness function.
+        */
+        bool use_fitness_cache;
+        /// Fitnesses of pairs of gametes, used if use_fitness_cache is true
+        fitness_cache cache;
+        /*!
+          If true, mutation counts are updated from the changes in gamete
+          counts using generation_workspace::mutation_counts, rather than
+          recalculated from all gametes.  The default is false.  See
+          fwdpp::mutation_count_tracker for the conditions under which the
+          counts remain correct.
+        */
+        bool incremental_mutation_counts;
+        /// Used if incremental_mutation_counts is true
+        mutation_count_tracker mutation_counts;
+        /*!
+          If greater than zero, fwdpp::renumber_mutations is called at
+          the start of every renumber_mutations_interval-th generation,
+          so that mutation keys follow mutation positions.  Keys held
+          outside of the population, by the caller, are then
+          invalidated.  The default is zero, meaning never.
+        */
+        unsigned renumber_mutations_interval;
+        /// Generations since mutations were last renumbered
+        unsigned generations_since_renumbering;
+        /*!
+          Old key to new key, as filled by the last call to
+          fwdpp::renumber_mutations made by fwdpp::sample_diploid
+        */
+        std::vector<std::size_t> new_mutation_keys;
+        /*!
+          If true, a new offspring gamete that is identical to a gamete
+          already in the population refers to that gamete rather than
+          being stored again.  See fwdpp::gamete_hash_index.  When
+          offspring gametes are generated in batches (nthreads > 1 or
+          sort_offspring in a single deme), or are
+          fwdpp::common_variant_gamete, duplicates are instead merged by
+          fwdpp::merge_duplicate_gametes once all offspring are
+          generated.  The default is false.
+        */
+        bool hash_cons_gametes;
+        /*!
+          If greater than zero, fwdpp::merge_duplicate_gametes is called
+          after fixations are removed, every
+          merge_duplicate_gametes_interval-th generation.  Removing
+          fixations may make distinct gametes identical.  The default
+          is zero, meaning never.
+        */
+        unsigned merge_duplicate_gametes_interval;
+        /// Generations since duplicate gametes were last merged
+        unsigned generations_since_merge;
+        /// Used if hash_cons_gametes is true or
+        /// merge_duplicate_gametes_interval > 0
+        gamete_hash_index gamete_index;
+        /*!
+          If greater than zero, and the gametes are
+          fwdpp::common_variant_gamete, fwdpp::update_common_variants is
+          called at the start of every common_variants_interval-th
+          generation.  The default is zero, meaning never.
+        */
+        unsigned common_variants_interval;
+        /*!
+          Neutral mutations whose frequency is at least
+          common_variant_frequency are stored as bits when
+          common_variants_interval > 0.  The default is 0.5.
+        */
+        double common_variant_frequency;
+        /// Generations since common variants were last updated
+        unsigned generations_since_common_variants;
+        /// Used to count mutations when nthreads > 1.  See
+        /// fwdpp_internal::process_gametes
+        std::vector<std::vector<uint_t>> partial_mutation_counts;
+        /// Offspring are written here, and then swapped with the parents
+        dipvector_t offspring;
+        /// Parental fitnesses
+        std::vector<double> fitnesses;
+        /// One sampler per deme
+        std::vector<parent_sampler> samplers;
+        /// Recycling bins
+        recycling_bin_t mutation_recycling_bin, gamete_recycling_bin;
+        /*!
+          True if fwdpp::update_mutations has filled
+          mutation_recycling_bin since the last generation.  Otherwise,
+          fwdpp::sample_diploid refills it from the mutation counts.
+          fwdpp::add_mutation and fwdpp::add_mutations reset it.
+        */
+        bool mutation_recycling_bin_filled;
+        /// Temporary containers for fwdpp::mutate_recombine
+        mutation_container neutral, selected;
+        /// Breakpoints and new mutations of one offspring
+        reproduction_buffers buffers;
+        /// Used when nthreads > 1.  See
+        /// fwdpp/internal/threaded_offspring.hpp
+        fwdpp_internal::offspring_batch batch;
+        /// Used when nthreads > 1.  One element per thread.
+        std::vector<fwdpp_internal::offspring_scratch<mutation_container>>
+            scratch;
+        /// Threads reused by every parallel step of fwdpp::sample_diploid
+        /// when nthreads > 1, rather than started at each step.  Copying
+        /// a workspace does not copy the threads.
+        fwdpp_internal::worker_pool workers;
+
+        explicit generation_workspace(const unsigned nthreads_ = 1)
+            : nthreads(nthreads_), use_parent_sampler(true),
+              sort_offspring(false), use_fitness_cache(false), cache{},
+              incremental_mutation_counts(false), mutation_counts{},
+              renumber_mutations_interval(0),
+              generations_since_renumbering(0), new_mutation_keys{},
+              hash_cons_gametes(false), merge_duplicate_gametes_interval(0),
+              generations_since_merge(0), gamete_index{},
+              common_variants_interval(0), common_variant_frequency(0.5),
+              generations_since_common_variants(0),
+              partial_mutation_counts{},
+              offspring{},
+              fitnesses{}, samplers{}, mutation_recycling_bin{},
+              gamete_recycling_bin{}, mutation_recycling_bin_filled(false),
+              neutral{}, selected{}, buffers{}, batch{},
+              scratch{}, workers{}
+        {
+        }
+
+        void
+        clear()
+        /// Free all memory held by the workspace
+        {
+            cache = fitness_cache();
+            mutation_counts = mutation_count_tracker();
+            generations_since_renumbering = 0;
+            std::vector<std::size_t>().swap(new_mutation_keys);
+            generations_since_merge = 0;
+            gamete_index = gamete_hash_index();
+            generations_since_common_variants = 0;
+            std::vector<std::vector<uint_t>>().swap(partial_mutation_counts);
+            dipvector_t().swap(offspring);
+            std::vector<double>().swap(fitnesses);
+            std::vector<parent_sampler>().swap(samplers);
+            recycling_bin_t().swap(mutation_recycling_bin);
+            recycling_bin_t().swap(gamete_recycling_bin);
+            mutation_recycling_bin_filled = false;
+            mutation_container().swap(neutral);
+            mutation_container().swap(selected);
+            buffers = reproduction_buffers();
+            batch = fwdpp_internal::offspring_batch();
+            scratch.clear();
+            workers.stop();
+        }
+    };
+}
+
+#endif
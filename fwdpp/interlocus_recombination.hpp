@@ -24,9 +24,14 @@
 #ifndef FWDPP_INTERLOCUS_RECOMBINATION_HPP__
 #define FWDPP_INTERLOCUS_RECOMBINATION_HPP__
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <cstdint>
+#include <limits>
 #include <vector>
 #include <functional>
+#include <gsl/gsl_randist.h>
 #include <fwdpp/fwd_functional.hpp>
 
 namespace fwdpp
@@ -80,6 +85,140 @@ namespace fwdpp
             }
         return rv;
     }
+
+    class interlocus_map
+    /*!
+      \brief Crossovers between loci, for all locus boundaries at once.
+
+      An alternative to the vectors of callbacks returned by
+      fwdpp::make_poisson_interlocus_rec and
+      fwdpp::make_binomial_interlocus_rec.  Those make two calls
+      through a std::function, each drawing a random number, per locus
+      boundary per offspring.  This object draws the total number of
+      crossovers in a meiosis from a single Poisson distribution, then
+      assigns each one to a boundary by binary search in a table of
+      cumulative rates.  The cost of a meiosis thus depends on the
+      number of crossovers, not on the number of loci.
+
+      Construct with fwdpp::make_poisson_interlocus_map or
+      fwdpp::make_binomial_interlocus_map, and pass to
+      fwdpp::sample_diploid in place of the vector of callbacks.  The
+      distribution of crossovers is the same, but the random number
+      stream is not, so results differ from those obtained with the
+      callbacks for the same seed.
+
+      \ingroup mlocus
+    */
+    {
+      private:
+        std::vector<double> cumulative_rates;
+        //! Boundaries where a crossover always happens
+        std::vector<std::size_t> certain;
+        //! If true, at most one crossover is reported per boundary
+        bool binomial;
+
+      public:
+        interlocus_map(const double* rates, const std::size_t n,
+                       const bool binomial_)
+            /*!
+              \param rates Mean number of crossovers at each boundary.
+              Infinite values mean that a crossover always happens.
+              \param n Number of boundaries, which is the number of loci
+              minus one.
+              \param binomial_ If true, a boundary with at least one
+              crossover is reported once.
+            */
+            : cumulative_rates{}, certain{}, binomial(binomial_)
+        {
+            cumulative_rates.reserve(n);
+            double total = 0.;
+            for (std::size_t i = 0; i < n; ++i)
+                {
+                    assert(rates[i] >= 0.);
+                    if (std::isinf(rates[i]))
+                        {
+                            certain.push_back(i);
+                        }
+                    else
+                        {
+                            total += rates[i];
+                        }
+                    cumulative_rates.push_back(total);
+                }
+        }
+
+        std::size_t
+        nboundaries() const noexcept
+        {
+            return cumulative_rates.size();
+        }
+
+        void
+        operator()(const gsl_rng* r,
+                   std::vector<std::size_t>& boundaries) const
+        /// Fill \a boundaries with the sorted indexes of the locus
+        /// boundaries that have a crossover in one meiosis.  Under the
+        /// Poisson model, a boundary appears once per crossover.
+        {
+            boundaries.assign(certain.begin(), certain.end());
+            const double total
+                = cumulative_rates.empty() ? 0. : cumulative_rates.back();
+            if (total > 0.)
+                {
+                    for (auto k = gsl_ran_poisson(r, total); k > 0; --k)
+                        {
+                            // Boundaries with rate 0 have the same
+                            // cumulative rate as the one before them,
+                            // so upper_bound never returns them.
+                            boundaries.push_back(static_cast<std::size_t>(
+                                std::upper_bound(cumulative_rates.begin(),
+                                                 cumulative_rates.end(),
+                                                 total * gsl_rng_uniform(r))
+                                - cumulative_rates.begin()));
+                        }
+                }
+            std::sort(boundaries.begin(), boundaries.end());
+            if (binomial)
+                {
+                    boundaries.erase(
+                        std::unique(boundaries.begin(), boundaries.end()),
+                        boundaries.end());
+                }
+        }
+    };
+
+    inline interlocus_map
+    make_poisson_interlocus_map(const double* means, const std::size_t n)
+    /// \brief The same model as fwdpp::make_poisson_interlocus_rec, as an
+    /// fwdpp::interlocus_map
+    ///
+    /// \ingroup mlocus
+    {
+        return interlocus_map(means, n, false);
+    }
+
+    inline interlocus_map
+    make_binomial_interlocus_map(const double* distances, const std::size_t n)
+    /// \brief The same model as fwdpp::make_binomial_interlocus_rec, as an
+    /// fwdpp::interlocus_map
+    ///
+    /// A boundary with recombination probability p has a crossover if
+    /// at least one event of a Poisson process with mean -log(1-p)
+    /// falls on it, which happens with probability p.
+    ///
+    /// \ingroup mlocus
+    {
+        std::vector<double> rates;
+        rates.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+            {
+                assert(distances[i] >= 0. && distances[i] <= 1.);
+                rates.push_back(distances[i] < 1.
+                                    ? -std::log1p(-distances[i])
+                                    : std::numeric_limits<double>::infinity());
+            }
+        return interlocus_map(rates.data(), n, true);
+    }
 }
 
 #endif
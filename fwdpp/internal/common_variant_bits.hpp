@@ -0,0 +1,356 @@
+#ifndef FWDPP_INTERNAL_COMMON_VARIANT_BITS_HPP
+#define FWDPP_INTERNAL_COMMON_VARIANT_BITS_HPP
+
+/*
+  Maintenance of the common-variant bits of
+  fwdpp::common_variant_gamete.  Each function taking a gamete or a
+  container of gametes is a no-op for gamete types without common
+  variants, so that library code may call them unconditionally.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/internal/void_t.hpp>
+
+namespace fwdpp
+{
+    namespace fwdpp_internal
+    {
+        //! Number of columns held by one word of a gamete's bits
+        constexpr std::size_t common_variant_word_bits = 64;
+
+        template <typename gamete_t, typename = void>
+        struct has_common_variants : std::false_type
+        {
+        };
+
+        template <typename gamete_t>
+        struct has_common_variants<
+            gamete_t, typename traits::internal::void_t<
+                          typename gamete_t::common_variant_table_type>::type>
+            : std::true_type
+        {
+        };
+
+        inline void
+        copy_common_variant_bits(const std::vector<std::uint64_t> &from,
+                                 std::size_t begin, const std::size_t end,
+                                 std::vector<std::uint64_t> &to) noexcept
+        /// Copy the bits of columns [begin, end) from \a from to \a to.
+        /// Missing words of \a from are zero.
+        {
+            while (begin < end)
+                {
+                    const auto w = begin / common_variant_word_bits;
+                    const auto offset = begin % common_variant_word_bits;
+                    const auto nbits = std::min(
+                        common_variant_word_bits - offset, end - begin);
+                    const std::uint64_t mask
+                        = ((nbits == common_variant_word_bits)
+                               ? ~std::uint64_t(0)
+                               : ((std::uint64_t(1) << nbits) - 1))
+                          << offset;
+                    const auto bits = (w < from.size()) ? from[w] : 0;
+                    to[w] = (to[w] & ~mask) | (bits & mask);
+                    begin += nbits;
+                }
+        }
+
+        inline bool
+        same_common_variant_bits(const std::vector<std::uint64_t> &a,
+                                 const std::vector<std::uint64_t> &b) noexcept
+        /// Missing words are zero
+        {
+            const auto n = std::min(a.size(), b.size());
+            if (!std::equal(a.begin(), a.begin() + n, b.begin()))
+                {
+                    return false;
+                }
+            const auto &longer = (a.size() > b.size()) ? a : b;
+            return std::all_of(longer.begin() + n, longer.end(),
+                               [](const std::uint64_t w) { return !w; });
+        }
+
+        template <typename gamete_t>
+        inline void
+        recombine_common_variants(gamete_t &, const gamete_t &,
+                                  const gamete_t &,
+                                  const std::vector<double> &,
+                                  std::false_type) noexcept
+        {
+        }
+
+        template <typename gamete_t>
+        inline void
+        recombine_common_variants(gamete_t &offspring, const gamete_t &g1,
+                                  const gamete_t &g2,
+                                  const std::vector<double> &breakpoints,
+                                  std::true_type)
+        {
+            offspring.recombine_common_variants(g1, g2, breakpoints);
+        }
+
+        template <typename gamete_t>
+        inline void
+        recombine_common_variants(gamete_t &offspring, const gamete_t &g1,
+                                  const gamete_t &g2,
+                                  const std::vector<double> &breakpoints)
+        /// Set the common variants of offspring from those of g1 and g2
+        {
+            recombine_common_variants(offspring, g1, g2, breakpoints,
+                                      has_common_variants<gamete_t>());
+        }
+
+        template <typename gamete_t>
+        inline std::size_t
+        common_variant_count(const gamete_t &, std::false_type) noexcept
+        {
+            return 0;
+        }
+
+        template <typename gamete_t>
+        inline std::size_t
+        common_variant_count(const gamete_t &g, std::true_type) noexcept
+        {
+            return g.common_variant_count();
+        }
+
+        template <typename gamete_t>
+        inline std::size_t
+        common_variant_count(const gamete_t &g) noexcept
+        /// Number of mutations that g stores as bits
+        {
+            return common_variant_count(g, has_common_variants<gamete_t>());
+        }
+
+        template <typename gamete_t>
+        inline void
+        add_common_variant_counts(const gamete_t &, const uint_t, uint_t *,
+                                  std::false_type) noexcept
+        {
+        }
+
+        template <typename gamete_t>
+        inline void
+        add_common_variant_counts(const gamete_t &g, const uint_t n,
+                                  uint_t *counts, std::true_type) noexcept
+        {
+            g.add_common_variant_counts(n, counts);
+        }
+
+        template <typename gamete_t>
+        inline void
+        add_common_variant_counts(const gamete_t &g, const uint_t n,
+                                  uint_t *counts) noexcept
+        /// Add n to the counts of the mutations that g stores as bits
+        {
+            add_common_variant_counts(g, n, counts,
+                                      has_common_variants<gamete_t>());
+        }
+
+        template <typename gamete_itr>
+        inline void
+        add_common_variant_column_counts(gamete_itr, const gamete_itr,
+                                         uint_t *, std::false_type) noexcept
+        {
+        }
+
+        template <typename gamete_itr>
+        inline void
+        add_common_variant_column_counts(gamete_itr begin,
+                                         const gamete_itr end,
+                                         uint_t *counts,
+                                         std::true_type) noexcept
+        {
+            using gamete_t =
+                typename std::iterator_traits<gamete_itr>::value_type;
+            gamete_t::add_common_variant_counts(begin, end, counts);
+        }
+
+        template <typename gamete_itr>
+        inline void
+        add_common_variant_column_counts(gamete_itr begin,
+                                         const gamete_itr end,
+                                         uint_t *counts) noexcept
+        /// Same as calling add_common_variant_counts(g, g.n, counts) for
+        /// each gamete in [begin, end), counting one column at a time
+        {
+            add_common_variant_column_counts(
+                begin, end, counts,
+                has_common_variants<typename std::iterator_traits<
+                    gamete_itr>::value_type>());
+        }
+
+        template <typename gcont_t>
+        inline std::shared_ptr<const typename gcont_t::value_type::
+                                   common_variant_table_type>
+        extant_common_variant_table(const gcont_t &gametes)
+        /// The table shared by all extant gametes, which may be null
+        {
+            for (const auto &g : gametes)
+                {
+                    if (g.n && g.common_variants)
+                        {
+                            return g.common_variants;
+                        }
+                }
+            return nullptr;
+        }
+
+        template <typename gcont_t, typename predicate>
+        inline void
+        remove_common_fixations(gcont_t &, const predicate &,
+                                std::false_type) noexcept
+        {
+        }
+
+        template <typename gcont_t, typename predicate>
+        inline void
+        remove_common_fixations(gcont_t &gametes, const predicate &p,
+                                std::true_type)
+        {
+            const auto table = extant_common_variant_table(gametes);
+            if (!table)
+                {
+                    return;
+                }
+            std::vector<std::uint64_t> keep(table->nwords(),
+                                            ~std::uint64_t(0));
+            bool removed = false;
+            for (std::size_t i = 0; i < table->keys.size(); ++i)
+                {
+                    if (p(table->keys[i]))
+                        {
+                            keep[i / common_variant_word_bits]
+                                &= ~(std::uint64_t(1)
+                                     << (i % common_variant_word_bits));
+                            removed = true;
+                        }
+                }
+            if (!removed)
+                {
+                    return;
+                }
+            for (auto &g : gametes)
+                {
+                    if (g.n)
+                        {
+                            const auto n
+                                = std::min(g.common.size(), keep.size());
+                            for (std::size_t w = 0; w < n; ++w)
+                                {
+                                    g.common[w] &= keep[w];
+                                }
+                        }
+                }
+        }
+
+        template <typename gcont_t, typename predicate>
+        inline void
+        remove_common_fixations(gcont_t &gametes, const predicate &p)
+        /*!
+          Clear the bits of the columns whose key k has p(k) true, in
+          all extant gametes.  Used by gamete_cleaner.
+        */
+        {
+            remove_common_fixations(
+                gametes, p,
+                has_common_variants<typename gcont_t::value_type>());
+        }
+
+        template <typename gcont_t>
+        inline void
+        mark_common_variant_keys(const gcont_t &, std::vector<std::size_t> &,
+                                 std::false_type) noexcept
+        {
+        }
+
+        template <typename gcont_t>
+        inline void
+        mark_common_variant_keys(const gcont_t &gametes,
+                                 std::vector<std::size_t> &new_keys,
+                                 std::true_type)
+        {
+            const auto table = extant_common_variant_table(gametes);
+            if (table)
+                {
+                    for (const auto k : table->keys)
+                        {
+                            new_keys[k] = 0;
+                        }
+                }
+        }
+
+        template <typename gcont_t>
+        inline void
+        mark_common_variant_keys(const gcont_t &gametes,
+                                 std::vector<std::size_t> &new_keys)
+        /// Set new_keys[k] to zero for each column key k.  Used by
+        /// fwdpp::renumber_mutations
+        {
+            mark_common_variant_keys(
+                gametes, new_keys,
+                has_common_variants<typename gcont_t::value_type>());
+        }
+
+        template <typename gcont_t>
+        inline void
+        remap_common_variant_keys(gcont_t &,
+                                  const std::vector<std::size_t> &,
+                                  std::false_type) noexcept
+        {
+        }
+
+        template <typename gcont_t>
+        inline void
+        remap_common_variant_keys(gcont_t &gametes,
+                                  const std::vector<std::size_t> &new_keys,
+                                  std::true_type)
+        {
+            using table_t =
+                typename gcont_t::value_type::common_variant_table_type;
+            const auto table = extant_common_variant_table(gametes);
+            std::shared_ptr<table_t> remapped;
+            if (table)
+                {
+                    remapped = std::make_shared<table_t>(*table);
+                    for (auto &k : remapped->keys)
+                        {
+                            k = static_cast<uint_t>(new_keys[k]);
+                        }
+                }
+            for (auto &g : gametes)
+                {
+                    if (g.n)
+                        {
+                            g.common_variants = remapped;
+                        }
+                    else
+                        {
+                            g.common_variants.reset();
+                            g.common.clear();
+                        }
+                }
+        }
+
+        template <typename gcont_t>
+        inline void
+        remap_common_variant_keys(gcont_t &gametes,
+                                  const std::vector<std::size_t> &new_keys)
+        /// Replace each column key k by new_keys[k].  Used by
+        /// fwdpp::renumber_mutations
+        {
+            remap_common_variant_keys(
+                gametes, new_keys,
+                has_common_variants<typename gcont_t::value_type>());
+        }
+    }
+}
+
+#endif
@@ -7,7 +7,14 @@
 #include <utility>
 #include <type_traits>
 #include <fwdpp/forward_types.hpp>
+#include <fwdpp/chunked_key_container.hpp>
+#include <fwdpp/compressed_key_container.hpp>
 #include <fwdpp/fwd_functional.hpp>
+#include <fwdpp/internal/haplotype_value_cache.hpp>
+#include <fwdpp/internal/gamete_fingerprint.hpp>
+#include <fwdpp/internal/common_variant_bits.hpp>
+#include <fwdpp/internal/parallel_for.hpp>
+#include <fwdpp/internal/prefetch.hpp>
 
 /*!
   \file gamete_cleaner.hpp
@@ -44,6 +51,17 @@
   way avoids cache misses that
   are unavoidable when we do out-of-order lookups in "mcounts" for the
   remaining fixations.
+
+  Common variants stored as bits by fwdpp::common_variant_gamete are
+  removed by fwdpp_internal::remove_common_fixations.
+
+  Each overload of gamete_cleaner takes an optional number of threads.
+  When it is greater than one, disjoint ranges of gametes are cleaned
+  by different threads, and the result is the same as for one thread.
+  A custom mutation_removal_policy is then called concurrently and
+  must be safe to call from several threads.  When
+  FWDPP_ENABLE_PREFETCH is defined, the look-ups in "mcounts" are
+  prefetched.  See fwdpp/internal/prefetch.hpp.
 */
 
 namespace fwdpp
@@ -95,6 +113,39 @@ namespace fwdpp
             }
         };
 
+        template <typename mut_index_cont, typename mcounts_t,
+                  typename predicate>
+        inline void
+        erase_keys_if(mut_index_cont &mc,
+                      typename mut_index_cont::iterator first,
+                      const mcounts_t &mcounts, const predicate &p) noexcept
+        //! Erase the keys in [first, mc.end()) for which p is true
+        {
+            mc.erase(remove_if_prefetched(first, mc.end(), mcounts, p),
+                     mc.end());
+        }
+
+        template <std::size_t chunk_size, typename mcounts_t,
+                  typename predicate>
+        inline void
+        erase_keys_if(chunked_key_container<chunk_size> &mc,
+                      typename chunked_key_container<chunk_size>::iterator,
+                      const mcounts_t &, const predicate &p)
+        //! Blocks without fixations remain shared
+        {
+            mc.remove_if(p);
+        }
+
+        template <typename mcounts_t, typename predicate>
+        inline void
+        erase_keys_if(compressed_key_container &mc,
+                      compressed_key_container::iterator,
+                      const mcounts_t &, const predicate &p)
+        //! Re-encodes the remaining keys
+        {
+            mc.remove_if(p);
+        }
+
         struct gamete_cleaner_erase_remove_idiom_wrapper
         //! Wrapper for erase/remove idiom.
         {
@@ -116,14 +167,13 @@ namespace fwdpp
                   expression, which experiences cache-misses because mcounts is
                   NOT sorted according to mutation position.
                 */
-                mc.erase(
-                    std::remove_if(
-                        std::find(mc.begin(), mc.end(), first_fixation),
-                        mc.end(),
-                        [&mcounts, &twoN ](
-                            const typename mut_index_cont::value_type
-                                &i) noexcept { return mcounts[i] == twoN; }),
-                    mc.end());
+                erase_keys_if(
+                    mc, std::find(mc.begin(), mc.end(), first_fixation),
+                    mcounts,
+                    [&mcounts, &twoN ](
+                        const typename mut_index_cont::value_type &i) noexcept {
+                        return mcounts[i] == twoN;
+                    });
             }
 
             template <typename mut_index_cont, typename mcont_t,
@@ -146,15 +196,14 @@ namespace fwdpp
                   expression, which experiences cache-misses because mcounts is
                   NOT sorted according to mutation position.
                 */
-                mc.erase(std::remove_if(
-                             std::find(mc.begin(), mc.end(), first_fixation),
-                             mc.end(),
-                             [&mcounts, &mutations, &twoN,
-                              &mp ](const typename mut_index_cont::value_type
-                                        &i) noexcept {
-                                 return mcounts[i] == twoN && mp(mutations[i]);
-                             }),
-                         mc.end());
+                erase_keys_if(
+                    mc, std::find(mc.begin(), mc.end(), first_fixation),
+                    mcounts,
+                    [&mcounts, &mutations, &twoN,
+                     &mp ](const typename mut_index_cont::value_type
+                               &i) noexcept {
+                        return mcounts[i] == twoN && mp(mutations[i]);
+                    });
             }
 
             template <typename mut_index_cont, typename mcounts_t>
@@ -166,13 +215,12 @@ namespace fwdpp
                 /*
                   \note Added in 0.5.0 to address Issue #41
                 */
-                mc.erase(
-                    std::remove_if(
-                        mc.begin(), mc.end(),
-                        [&mcounts, &twoN ](
-                            const typename mut_index_cont::value_type
-                                &i) noexcept { return mcounts[i] == twoN; }),
-                    mc.end());
+                erase_keys_if(
+                    mc, mc.begin(), mcounts,
+                    [&mcounts, &twoN ](
+                        const typename mut_index_cont::value_type &i) noexcept {
+                        return mcounts[i] == twoN;
+                    });
             }
 
             template <typename mut_index_cont, typename mcont_t,
@@ -186,14 +234,13 @@ namespace fwdpp
                 /*
                   \note Added in 0.5.0 to address Issue #41
                 */
-                mc.erase(std::remove_if(
-                             mc.begin(), mc.end(),
-                             [&mcounts, &mutations, &twoN,
-                              &mp ](const typename mut_index_cont::value_type
-                                        &i) noexcept {
-                                 return mcounts[i] == twoN && mp(mutations[i]);
-                             }),
-                         mc.end());
+                erase_keys_if(
+                    mc, mc.begin(), mcounts,
+                    [&mcounts, &mutations, &twoN,
+                     &mp ](const typename mut_index_cont::value_type
+                               &i) noexcept {
+                        return mcounts[i] == twoN && mp(mutations[i]);
+                    });
             }
         };
 
@@ -210,16 +257,59 @@ namespace fwdpp
                                    fwdpp::remove_nothing>::value>::type
             gamete_cleaner(gcont_t &, const mcont_t &,
                            const std::vector<uint_t> &, const uint_t,
-                           const mutation_removal_policy &)
+                           const mutation_removal_policy &,
+                           const unsigned = 1)
+        {
+            return;
+        }
+
+        /*! \brief Handles removal of indexes to mutations from gametes after
+          sampling
+          Multi-locus version of the above.
+        */
+        template <typename gcont_t, typename mcont_t,
+                  typename mutation_removal_policy>
+        inline typename std::
+            enable_if<std::is_same<mutation_removal_policy,
+                                   fwdpp::remove_nothing>::value>::type
+            gamete_cleaner(gcont_t &, const mcont_t &,
+                           const std::vector<uint_t> &, const uint_t,
+                           const mutation_removal_policy &, std::true_type,
+                           const unsigned = 1)
         {
             return;
         }
 
-        template <typename gcont_t, typename fixation_finder,
+        template <typename gcont_t, typename function>
+        inline void
+        for_each_extant_gamete(gcont_t &gametes, const unsigned nthreads,
+                               const function &f)
+        /*!
+          Call f(g) for each extant gamete.  When nthreads > 1, disjoint
+          ranges of gametes are processed by different threads.
+        */
+        {
+            parallel_for(nthreads, gametes.size(),
+                         [&gametes, &f](const std::size_t, const std::size_t b,
+                                        const std::size_t e) {
+                             const auto last = gametes.begin() + e;
+                             for (auto g = next_extant_gamete(
+                                      gametes.begin() + b, last);
+                                  g < last;
+                                  g = next_extant_gamete(g + 1, last))
+                                 {
+                                     f(*g);
+                                 }
+                         });
+        }
+
+        template <typename gcont_t, typename mcont_t, typename fixation_finder,
                   typename idiom_wrapper>
         inline void
-        gamete_cleaner_details(gcont_t &gametes, const fixation_finder &ff,
-                               const idiom_wrapper &iw) noexcept
+        gamete_cleaner_details(gcont_t &gametes, const mcont_t &mutations,
+                               const fixation_finder &ff,
+                               const idiom_wrapper &iw,
+                               const unsigned nthreads)
         /*!
           The two overloads of gamete_cleaner dispatch the above policies into
           this function.
@@ -236,29 +326,31 @@ namespace fwdpp
             if (!neutral_fixations_exist && !selected_fixations_exist)
                 return;
 
-            const auto gend = gametes.end();
             // Assign values to avoid tons of de-referencing later
+            using key_type = typename gcont_t::value_type::mutation_container::
+                value_type;
             const auto fixation_n_value
                 = (fixation_n == extant_gamete->mutations.cend())
-                      ? typename decltype(fixation_n)::value_type()
+                      ? key_type()
                       : *fixation_n;
             const auto fixation_s_value
                 = (fixation_s == extant_gamete->smutations.cend())
-                      ? typename decltype(fixation_s)::value_type()
+                      ? key_type()
                       : *fixation_s;
-            while (extant_gamete < gend)
-                {
+            for_each_extant_gamete(
+                gametes, nthreads,
+                [&](typename gcont_t::value_type &g) {
                     if (neutral_fixations_exist)
                         {
-                            iw(extant_gamete->mutations, fixation_n_value);
+                            iw(g.mutations, fixation_n_value);
                         }
                     if (selected_fixations_exist)
                         {
-                            iw(extant_gamete->smutations, fixation_s_value);
+                            iw(g.smutations, fixation_s_value);
+                            update_cached_value(g, mutations);
                         }
-                    extant_gamete
-                        = next_extant_gamete(extant_gamete + 1, gend);
-                }
+                    update_fingerprint(g);
+                });
         }
 
         template <typename gcont_t, typename fixation_finder>
@@ -294,12 +386,13 @@ namespace fwdpp
             return std::make_pair(neutral, selected);
         }
 
-        template <typename gcont_t, typename fixation_finder,
+        template <typename gcont_t, typename mcont_t, typename fixation_finder,
                   typename idiom_wrapper>
         inline void
-        gamete_cleaner_details(gcont_t &gametes, const fixation_finder &ff,
-                               const idiom_wrapper &iw,
-                               std::true_type) noexcept
+        gamete_cleaner_details(gcont_t &gametes, const mcont_t &mutations,
+                               const fixation_finder &ff,
+                               const idiom_wrapper &iw, std::true_type,
+                               const unsigned nthreads)
         /*!
           The two overloads of gamete_cleaner dispatch the above policies into
           this function.
@@ -317,22 +410,20 @@ namespace fwdpp
             if (!neutral_fixations_exist && !selected_fixations_exist)
                 return;
 
-            auto extant_gamete
-                = next_extant_gamete(gametes.begin(), gametes.end());
-            const auto gend = gametes.end();
-            while (extant_gamete < gend)
-                {
+            for_each_extant_gamete(
+                gametes, nthreads,
+                [&](typename gcont_t::value_type &g) {
                     if (neutral_fixations_exist)
                         {
-                            iw(extant_gamete->mutations);
+                            iw(g.mutations);
                         }
                     if (selected_fixations_exist)
                         {
-                            iw(extant_gamete->smutations);
+                            iw(g.smutations);
+                            update_cached_value(g, mutations);
                         }
-                    extant_gamete
-                        = next_extant_gamete(extant_gamete + 1, gend);
-                }
+                    update_fingerprint(g);
+                });
         }
 
         /*
@@ -352,16 +443,22 @@ namespace fwdpp
         inline
             typename std::enable_if<std::is_same<mutation_removal_policy,
                                                  std::true_type>::value>::type
-            gamete_cleaner(gcont_t &gametes, const mcont_t &,
+            gamete_cleaner(gcont_t &gametes, const mcont_t &mutations,
                            const std::vector<uint_t> &mcounts,
-                           const uint_t twoN, const mutation_removal_policy &)
+                           const uint_t twoN, const mutation_removal_policy &,
+                           const unsigned nthreads = 1)
         {
+            remove_common_fixations(gametes, [&mcounts, twoN](const uint_t k) {
+                return mcounts[k] == twoN;
+            });
             gamete_cleaner_details(
-                gametes, std::bind(find_fixation(), std::placeholders::_1,
-                                   std::cref(mcounts), twoN),
+                gametes, mutations,
+                std::bind(find_fixation(), std::placeholders::_1,
+                          std::cref(mcounts), twoN),
                 std::bind(gamete_cleaner_erase_remove_idiom_wrapper(),
                           std::placeholders::_1, std::cref(mcounts),
-                          std::placeholders::_2, twoN));
+                          std::placeholders::_2, twoN),
+                nthreads);
         }
 
         /*! \brief Handles removal of indexes to mutations from gametes after
@@ -380,16 +477,23 @@ namespace fwdpp
             gamete_cleaner(gcont_t &gametes, const mcont_t &mutations,
                            const std::vector<uint_t> &mcounts,
                            const uint_t twoN,
-                           const mutation_removal_policy &mp)
+                           const mutation_removal_policy &mp,
+                           const unsigned nthreads = 1)
         {
+            remove_common_fixations(
+                gametes, [&mutations, &mcounts, twoN, &mp](const uint_t k) {
+                    return mcounts[k] == twoN && mp(mutations[k]);
+                });
             gamete_cleaner_details(
-                gametes, std::bind(find_fixation(), std::placeholders::_1,
-                                   std::cref(mutations), std::cref(mcounts),
-                                   twoN, std::forward<decltype(mp)>(mp)),
+                gametes, mutations,
+                std::bind(find_fixation(), std::placeholders::_1,
+                          std::cref(mutations), std::cref(mcounts), twoN,
+                          std::forward<decltype(mp)>(mp)),
                 std::bind(gamete_cleaner_erase_remove_idiom_wrapper(),
                           std::placeholders::_1, std::cref(mutations),
                           std::cref(mcounts), std::placeholders::_2, twoN,
-                          std::forward<decltype(mp)>(mp)));
+                          std::forward<decltype(mp)>(mp)),
+                nthreads);
         }
 
         /*! \brief Handles removal of indexes to mutations from gametes after
@@ -406,17 +510,21 @@ namespace fwdpp
         inline
             typename std::enable_if<std::is_same<mutation_removal_policy,
                                                  std::true_type>::value>::type
-            gamete_cleaner(gcont_t &gametes, const mcont_t &,
+            gamete_cleaner(gcont_t &gametes, const mcont_t &mutations,
                            const std::vector<uint_t> &mcounts,
                            const uint_t twoN, const mutation_removal_policy &,
-                           std::true_type)
+                           std::true_type, const unsigned nthreads = 1)
         {
+            remove_common_fixations(gametes, [&mcounts, twoN](const uint_t k) {
+                return mcounts[k] == twoN;
+            });
             gamete_cleaner_details(
-                gametes, std::bind(find_fixation(), std::placeholders::_1,
-                                   std::cref(mcounts), twoN),
+                gametes, mutations,
+                std::bind(find_fixation(), std::placeholders::_1,
+                          std::cref(mcounts), twoN),
                 std::bind(gamete_cleaner_erase_remove_idiom_wrapper(),
                           std::placeholders::_1, std::cref(mcounts), twoN),
-                std::true_type());
+                std::true_type(), nthreads);
         }
 
         /*! \brief Handles removal of indexes to mutations from gametes after
@@ -438,17 +546,23 @@ namespace fwdpp
             gamete_cleaner(gcont_t &gametes, const mcont_t &mutations,
                            const std::vector<uint_t> &mcounts,
                            const uint_t twoN,
-                           const mutation_removal_policy &mp, std::true_type)
+                           const mutation_removal_policy &mp, std::true_type,
+                           const unsigned nthreads = 1)
         {
+            remove_common_fixations(
+                gametes, [&mutations, &mcounts, twoN, &mp](const uint_t k) {
+                    return mcounts[k] == twoN && mp(mutations[k]);
+                });
             gamete_cleaner_details(
-                gametes, std::bind(find_fixation(), std::placeholders::_1,
-                                   std::cref(mutations), std::cref(mcounts),
-                                   twoN, std::forward<decltype(mp)>(mp)),
+                gametes, mutations,
+                std::bind(find_fixation(), std::placeholders::_1,
+                          std::cref(mutations), std::cref(mcounts), twoN,
+                          std::forward<decltype(mp)>(mp)),
                 std::bind(gamete_cleaner_erase_remove_idiom_wrapper(),
                           std::placeholders::_1, std::cref(mutations),
                           std::cref(mcounts), twoN,
                           std::forward<decltype(mp)>(mp)),
-                std::true_type());
+                std::true_type(), nthreads);
         }
     }
 }
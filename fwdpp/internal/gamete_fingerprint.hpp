@@ -0,0 +1,131 @@
+#ifndef FWDPP_INTERNAL_GAMETE_FINGERPRINT_HPP
+#define FWDPP_INTERNAL_GAMETE_FINGERPRINT_HPP
+
+/*
+  Maintenance of the fingerprints stored by fwdpp::fingerprinted_gamete.
+  Each function here is a no-op for gamete types without a fingerprint,
+  so that library code may call them unconditionally.
+*/
+
+#include <cstdint>
+#include <type_traits>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/internal/void_t.hpp>
+
+namespace fwdpp
+{
+    namespace fwdpp_internal
+    {
+        inline std::uint64_t
+        mutation_fingerprint(const uint_t key) noexcept
+        /// A pseudo-random 64-bit tag for a mutation key (the
+        /// finalizer of splitmix64)
+        {
+            std::uint64_t z = static_cast<std::uint64_t>(key)
+                              + UINT64_C(0x9e3779b97f4a7c15);
+            z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+            z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+            return z ^ (z >> 31);
+        }
+
+        template <typename key_container>
+        inline std::uint64_t
+        key_fingerprint(const key_container &keys) noexcept
+        /// Exclusive or of the tags of all keys
+        {
+            std::uint64_t rv = 0;
+            for (auto k : keys)
+                {
+                    rv ^= mutation_fingerprint(k);
+                }
+            return rv;
+        }
+
+        template <typename gamete_t, typename = void>
+        struct has_fingerprint : std::false_type
+        {
+        };
+
+        template <typename gamete_t>
+        struct has_fingerprint<gamete_t,
+                               typename traits::internal::void_t<
+                                   typename gamete_t::fingerprint_type>::type>
+            : std::true_type
+        {
+        };
+
+        template <typename gamete_t>
+        inline std::uint64_t
+        gamete_fingerprint(const gamete_t &g, std::false_type) noexcept
+        {
+            return key_fingerprint(g.mutations) ^ key_fingerprint(g.smutations);
+        }
+
+        template <typename gamete_t>
+        inline std::uint64_t
+        gamete_fingerprint(const gamete_t &g, std::true_type) noexcept
+        {
+            return g.fingerprint;
+        }
+
+        template <typename gamete_t>
+        inline std::uint64_t
+        gamete_fingerprint(const gamete_t &g) noexcept
+        /// The stored fingerprint of g, or one calculated from its keys
+        {
+            return gamete_fingerprint(
+                g, typename has_fingerprint<gamete_t>::type());
+        }
+
+        template <typename gamete_t>
+        inline void
+        update_fingerprint(gamete_t &, std::false_type) noexcept
+        {
+        }
+
+        template <typename gamete_t>
+        inline void
+        update_fingerprint(gamete_t &g, std::true_type) noexcept
+        {
+            g.update_fingerprint();
+        }
+
+        template <typename gamete_t>
+        inline void
+        update_fingerprint(gamete_t &g) noexcept
+        /// Recalculate the fingerprint of g from its keys
+        {
+            update_fingerprint(g, typename has_fingerprint<gamete_t>::type());
+        }
+
+        template <typename gamete_t, typename key_container>
+        inline void
+        derive_fingerprint(gamete_t &, const gamete_t &,
+                           const key_container &, std::false_type) noexcept
+        {
+        }
+
+        template <typename gamete_t, typename key_container>
+        inline void
+        derive_fingerprint(gamete_t &offspring, const gamete_t &parent,
+                           const key_container &new_mutations,
+                           std::true_type) noexcept
+        {
+            offspring.fingerprint
+                = parent.fingerprint ^ key_fingerprint(new_mutations);
+        }
+
+        template <typename gamete_t, typename key_container>
+        inline void
+        derive_fingerprint(gamete_t &offspring, const gamete_t &parent,
+                           const key_container &new_mutations) noexcept
+        /// Set the fingerprint of offspring, which is parent plus
+        /// new_mutations with no recombination
+        {
+            derive_fingerprint(offspring, parent, new_mutations,
+                               typename has_fingerprint<gamete_t>::type());
+        }
+    }
+}
+
+#endif
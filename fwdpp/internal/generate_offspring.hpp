@@ -0,0 +1,270 @@
+#ifndef FWDPP_INTERNAL_GENERATE_OFFSPRING_HPP
+#define FWDPP_INTERNAL_GENERATE_OFFSPRING_HPP
+
+/*
+  The offspring loops of fwdpp::sample_diploid.
+
+  Parents are read from one container and offspring are written to
+  another.  The versions of sample_diploid that do not take a
+  fwdpp::generation_workspace copy the parents before calling these
+  functions.  The versions that do take a workspace write offspring
+  into a buffer kept by the workspace and then swap it with the
+  parents.
+*/
+
+#include <cassert>
+#include <tuple>
+#include <vector>
+#include <gsl/gsl_rng.h>
+#include <fwdpp/mutate_recombine.hpp>
+#include <fwdpp/internal/multilocus_rec.hpp>
+#include <fwdpp/internal/threaded_offspring.hpp>
+
+namespace fwdpp
+{
+    namespace fwdpp_internal
+    {
+        template <typename dipvector_t, typename lookup_t, typename gcont_t,
+                  typename mcont_t, typename mutation_model,
+                  typename recombination_policy, typename gqueue_t,
+                  typename mqueue_t, typename scratch_t>
+        void
+        generate_offspring(
+            const gsl_rng *r, const dipvector_t &parents,
+            dipvector_t &offspring, const lookup_t &lookup, const double f,
+            gcont_t &gametes, mcont_t &mutations, const double mu,
+            const mutation_model &mmodel, const recombination_policy &rec_pol,
+            gqueue_t &gam_recycling_bin, mqueue_t &mut_recycling_bin,
+            typename gcont_t::value_type::mutation_container &neutral,
+            typename gcont_t::value_type::mutation_container &selected,
+            reproduction_buffers &buffers, offspring_batch &batch,
+            std::vector<scratch_t> &scratch, const unsigned nthreads,
+            const bool sort_offspring)
+        /*!
+          Single deme.  Each element of \a offspring is generated from
+          parents sampled from \a parents using \a lookup.  \a buffers
+          holds the events of one offspring, and keeps its capacity from
+          one call to the next.
+
+          When \a nthreads > 1 or \a sort_offspring is true, \a batch and
+          \a scratch are used as described in
+          fwdpp/internal/threaded_offspring.hpp.  If \a sort_offspring is
+          true, offspring gametes are assembled in order of their
+          parental gametes.  Neither option changes the random number
+          stream or the offspring.
+        */
+        {
+            const bool use_batch = (nthreads > 1 || sort_offspring);
+            // Offspring events are recorded here when use_batch is true
+            if (use_batch)
+                {
+                    batch.clear();
+                    batch.events.reserve(2 * offspring.size());
+                }
+
+            // Fill in the next generation!
+            for (auto &dip : offspring)
+                {
+                    // Choose parent 1 based on fitness
+                    auto p1 = lookup(r);
+                    // If inbred (w/probability f2), parent2 = parent1, else
+                    // choose again based on fitness
+                    auto p2 = (f == 1. || (f > 0. && gsl_rng_uniform(r) < f))
+                                  ? p1
+                                  : lookup(r);
+                    assert(p1 < parents.size());
+                    assert(p2 < parents.size());
+                    /*
+                      These are the gametes from each parent.
+                      This is a trivial assignment if keys.
+                    */
+                    auto p1g1 = parents[p1].first;
+                    auto p1g2 = parents[p1].second;
+                    auto p2g1 = parents[p2].first;
+                    auto p2g2 = parents[p2].second;
+
+                    /*
+                      The offspring will inherit some manipulation of p1g1 and
+                      p1g2.
+                      The next two lines do "Mendel".
+                    */
+                    if (gsl_rng_uniform(r) < 0.5)
+                        std::swap(p1g1, p1g2);
+                    if (gsl_rng_uniform(r) < 0.5)
+                        std::swap(p2g1, p2g2);
+
+                    if (use_batch)
+                        {
+                            record_offspring_events(
+                                r, gametes, mutations,
+                                std::make_tuple(p1g1, p1g2, p2g1, p2g2),
+                                rec_pol, mmodel, mu, mut_recycling_bin, dip,
+                                batch, buffers);
+                        }
+                    else
+                        {
+                            mutate_recombine_update(
+                                r, gametes, mutations,
+                                std::make_tuple(p1g1, p1g2, p2g1, p2g2),
+                                rec_pol, mmodel, mu, gam_recycling_bin,
+                                mut_recycling_bin, dip, neutral, selected,
+                                buffers);
+                        }
+                }
+            if (use_batch)
+                {
+                    /*
+                      All random numbers have been drawn above, in the same
+                      order as the single-threaded loop.  Now, the offspring
+                      gametes are assembled by nthreads threads, possibly
+                      sorted by parental gamete.  The details are in
+                      fwdpp/internal/threaded_offspring.hpp.
+                    */
+                    if (sort_offspring)
+                        {
+                            sort_offspring_events(batch);
+                        }
+                    if (scratch.empty())
+                        {
+                            scratch.resize(1);
+                        }
+                    scratch[0].neutral.swap(neutral);
+                    scratch[0].selected.swap(selected);
+                    apply_offspring_events(batch, offspring, gametes,
+                                           mutations, gam_recycling_bin,
+                                           scratch, nthreads);
+                    scratch[0].neutral.swap(neutral);
+                    scratch[0].selected.swap(selected);
+                }
+        }
+
+        template <typename vdipvector_t, typename lookup_t,
+                  typename migration_policy, typename gcont_t,
+                  typename mcont_t, typename mutation_model,
+                  typename recombination_policy, typename gqueue_t,
+                  typename mqueue_t>
+        void
+        generate_metapop_offspring(
+            const gsl_rng *r, const vdipvector_t &parents,
+            vdipvector_t &offspring, const std::vector<lookup_t> &lookups,
+            const migration_policy &mig, const double *f, gcont_t &gametes,
+            mcont_t &mutations, const double mu, const mutation_model &mmodel,
+            const recombination_policy &rec_pol,
+            gqueue_t &gamete_recycling_bin, mqueue_t &mut_recycling_bin,
+            typename gcont_t::value_type::mutation_container &neutral,
+            typename gcont_t::value_type::mutation_container &selected,
+            reproduction_buffers &buffers)
+        /*!
+          Metapopulation.  The demes of \a offspring must already have
+          their new sizes.
+        */
+        {
+            assert(lookups.size() == parents.size());
+            assert(offspring.size() == parents.size());
+            // Update the diploids, one deme at a time
+            for (std::size_t popi = 0; popi < offspring.size(); ++popi)
+                {
+                    for (auto &dip : offspring[popi])
+                        {
+                            /* Figure out if parent 1 is migrant or not.
+
+                               A migration policy takes the current deme
+                               (popindex)
+                               as
+                               an argument.  It returns popindex if there is no
+                               migration,
+                               else it returns the index of the deme of a
+                               migrant
+                               parent
+                            */
+                            auto deme_p1 = mig(popi);
+                            decltype(deme_p1) deme_p2 = popi;
+
+                            // Figure out who the parents are
+                            auto p1 = lookups[deme_p1](r), p2 = p1;
+
+                            /*
+                              If the individual is not inbred, then we pick a
+                              deme from the migration policy for parent 2
+                            */
+                            if (f != nullptr
+                                && (*(f + popi) == 1.
+                                    || (*(f + popi) > 0.
+                                        && gsl_rng_uniform(r)
+                                               < *(f + popi)))) // individual
+                                                                // is inbred
+                                {
+                                    p2 = p1;
+                                }
+                            else
+                                {
+                                    // apply migration policy to figure out
+                                    // parental deme for parent #2
+                                    deme_p2 = mig(popi);
+                                    p2 = lookups[deme_p2](r);
+                                }
+
+                            auto p1g1 = parents[deme_p1][p1].first;
+                            auto p1g2 = parents[deme_p1][p1].second;
+                            auto p2g1 = parents[deme_p2][p2].first;
+                            auto p2g2 = parents[deme_p2][p2].second;
+
+                            if (gsl_rng_uniform(r) < 0.5)
+                                std::swap(p1g1, p1g2);
+                            if (gsl_rng_uniform(r) < 0.5)
+                                std::swap(p2g1, p2g2);
+
+                            mutate_recombine_update(
+                                r, gametes, mutations,
+                                std::make_tuple(p1g1, p1g2, p2g1, p2g2),
+                                rec_pol, mmodel, mu, gamete_recycling_bin,
+                                mut_recycling_bin, dip, neutral, selected,
+                                buffers);
+                        }
+                }
+        }
+
+        template <typename dipvector_t, typename lookup_t, typename gcont_t,
+                  typename mcont_t, typename mutation_model_container,
+                  typename recombination_policy_container,
+                  typename interlocus_recombination, typename gqueue_t,
+                  typename mqueue_t>
+        void
+        generate_multilocus_offspring(
+            const gsl_rng *r, const dipvector_t &parents,
+            dipvector_t &offspring, const lookup_t &lookup, const double f,
+            gcont_t &gametes, mcont_t &mutations, const double *mu,
+            const mutation_model_container &mmodel,
+            const recombination_policy_container &rec_policies,
+            const interlocus_recombination &interlocus_rec,
+            gqueue_t &gamete_recycling_bin, mqueue_t &mut_recycling_bin,
+            typename gcont_t::value_type::mutation_container &neutral,
+            typename gcont_t::value_type::mutation_container &selected,
+            reproduction_buffers &buffers)
+        /*!
+          Multiple loci, single deme.
+        */
+        {
+            // The elements of a fwdpp::multilocus_genotype_matrix are rows
+            // returned by value.
+            for (auto &&dip : offspring)
+                {
+                    auto p1 = lookup(r);
+                    assert(p1 < parents.size());
+                    auto p2 = (f == 1. || (f > 0. && gsl_rng_uniform(r) < f))
+                                  ? p1
+                                  : lookup(r);
+                    assert(p2 < parents.size());
+                    multilocus_rec_mut(
+                        r, parents[p1], parents[p2], mut_recycling_bin,
+                        gamete_recycling_bin, rec_policies, interlocus_rec,
+                        ((gsl_rng_uniform(r) < 0.5) ? 1 : 0),
+                        ((gsl_rng_uniform(r) < 0.5) ? 1 : 0), gametes,
+                        mutations, neutral, selected, mu, mmodel, dip,
+                        buffers);
+                }
+        }
+    }
+}
+
+#endif
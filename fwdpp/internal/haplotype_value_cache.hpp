@@ -0,0 +1,233 @@
+#ifndef FWDPP_INTERNAL_HAPLOTYPE_VALUE_CACHE_HPP
+#define FWDPP_INTERNAL_HAPLOTYPE_VALUE_CACHE_HPP
+
+/*
+  Maintenance of the haplotype values cached by
+  fwdpp::cached_value_gamete.  Each function here is a no-op for
+  gamete types without a cache, so that library code may call them
+  unconditionally.
+*/
+
+#include <algorithm>
+#include <type_traits>
+#include <fwdpp/internal/void_t.hpp>
+#include <fwdpp/internal/mutation_columns.hpp>
+
+namespace fwdpp
+{
+    namespace fwdpp_internal
+    {
+        template <typename gamete_t, typename = void>
+        struct has_cached_value : std::false_type
+        {
+        };
+
+        template <typename gamete_t>
+        struct has_cached_value<gamete_t,
+                                typename traits::internal::void_t<
+                                    typename gamete_t::value_policy>::type>
+            : std::true_type
+        {
+        };
+
+        template <typename gamete_t, typename policy, typename = void>
+        struct uses_haplotype_value_policy : std::false_type
+        /// True if gamete_t caches a value defined by policy
+        {
+        };
+
+        template <typename gamete_t, typename policy>
+        struct uses_haplotype_value_policy<
+            gamete_t, policy, typename traits::internal::void_t<
+                                  typename gamete_t::value_policy>::type>
+            : std::is_same<typename gamete_t::value_policy, policy>
+        {
+        };
+
+        template <typename gamete_t>
+        inline void
+        invalidate_cached_value(gamete_t &, std::false_type) noexcept
+        {
+        }
+
+        template <typename gamete_t>
+        inline void
+        invalidate_cached_value(gamete_t &g, std::true_type) noexcept
+        {
+            g.invalidate_cached_value();
+        }
+
+        template <typename gamete_t>
+        inline void
+        invalidate_cached_value(gamete_t &g) noexcept
+        {
+            invalidate_cached_value(g, has_cached_value<gamete_t>());
+        }
+
+        template <typename gamete_t, typename mcont_t>
+        inline void
+        update_cached_value(gamete_t &, const mcont_t &,
+                            std::false_type) noexcept
+        {
+        }
+
+        template <typename gamete_t, typename mcont_t>
+        inline void
+        update_cached_value(gamete_t &g, const mcont_t &mutations,
+                            std::true_type) noexcept
+        {
+            g.update_cached_value(mutations);
+        }
+
+        template <typename gamete_t, typename mcont_t>
+        inline void
+        update_cached_value(gamete_t &g, const mcont_t &mutations) noexcept
+        /// Recalculate the cached value of g from its selected mutations
+        {
+            update_cached_value(g, mutations, has_cached_value<gamete_t>());
+        }
+
+        template <typename gamete_t, typename key_container, typename mcont_t>
+        inline void
+        derive_cached_value(gamete_t &, const gamete_t &,
+                            const key_container &, const mcont_t &,
+                            std::false_type) noexcept
+        {
+        }
+
+        template <typename gamete_t, typename key_container, typename mcont_t>
+        inline void
+        derive_cached_value(gamete_t &offspring, const gamete_t &parent,
+                            const key_container &new_mutations,
+                            const mcont_t &mutations, std::true_type) noexcept
+        {
+            if (!parent.cache_valid)
+                {
+                    offspring.update_cached_value(mutations);
+                    return;
+                }
+            auto v = parent.cached_value;
+            for (auto k : new_mutations)
+                {
+                    if (!mutation_is_neutral(mutations, k))
+                        {
+                            gamete_t::value_policy::update(v, mutations[k]);
+                        }
+                }
+            offspring.cached_value = v;
+            offspring.cache_valid = true;
+        }
+
+        template <typename gamete_t, typename key_container, typename mcont_t>
+        inline void
+        derive_cached_value(gamete_t &offspring, const gamete_t &parent,
+                            const key_container &new_mutations,
+                            const mcont_t &mutations) noexcept
+        /// Set the cached value of offspring, which is parent plus
+        /// new_mutations with no recombination
+        {
+            derive_cached_value(offspring, parent, new_mutations, mutations,
+                                has_cached_value<gamete_t>());
+        }
+
+        template <typename iterator_t, typename mcont_t,
+                  typename hom_function, typename het_function>
+        inline void
+        for_each_diploid_site(iterator_t first1, iterator_t last1,
+                              iterator_t first2, iterator_t last2,
+                              const mcont_t &mutations,
+                              const hom_function &hom,
+                              const het_function &het)
+        /*!
+          Call hom(mutation) for each key present in both ranges, and
+          het(mutation) for each key present in one of them, in order of
+          position.  The ranges are sorted by mutation position.
+
+          Different keys may share a position under finite-sites or
+          custom mutation models, in any order within each range.  The
+          keys at such a position are therefore compared as a group.
+        */
+        {
+            while (first1 != last1 && first2 != last2)
+                {
+                    if (*first1 == *first2)
+                        {
+                            hom(mutations[*first1]);
+                            ++first1;
+                            ++first2;
+                            continue;
+                        }
+                    const auto p1 = mutation_position(mutations, *first1);
+                    const auto p2 = mutation_position(mutations, *first2);
+                    if (p1 < p2)
+                        {
+                            het(mutations[*first1]);
+                            ++first1;
+                        }
+                    else if (p2 < p1)
+                        {
+                            het(mutations[*first2]);
+                            ++first2;
+                        }
+                    else
+                        {
+                            auto end1 = first1, end2 = first2;
+                            for (; end1 != last1
+                                   && !(p1 < mutation_position(mutations,
+                                                               *end1));
+                                 ++end1)
+                                ;
+                            for (; end2 != last2
+                                   && !(p2 < mutation_position(mutations,
+                                                               *end2));
+                                 ++end2)
+                                ;
+                            for (auto i = first2; i != end2; ++i)
+                                {
+                                    if (std::find(first1, end1, *i) == end1)
+                                        {
+                                            het(mutations[*i]);
+                                        }
+                                }
+                            for (; first1 != end1; ++first1)
+                                {
+                                    if (std::find(first2, end2, *first1)
+                                        == end2)
+                                        {
+                                            het(mutations[*first1]);
+                                        }
+                                    else
+                                        {
+                                            hom(mutations[*first1]);
+                                        }
+                                }
+                            first2 = end2;
+                        }
+                }
+            for (; first1 != last1; ++first1)
+                {
+                    het(mutations[*first1]);
+                }
+            for (; first2 != last2; ++first2)
+                {
+                    het(mutations[*first2]);
+                }
+        }
+
+        template <typename iterator_t, typename mcont_t, typename function_t>
+        inline void
+        for_each_homozygous_site(iterator_t first1, iterator_t last1,
+                                 iterator_t first2, iterator_t last2,
+                                 const mcont_t &mutations,
+                                 const function_t &f) noexcept
+        /// Call f(mutation) for each key present in both ranges, as
+        /// for_each_diploid_site does
+        {
+            for_each_diploid_site(
+                first1, last1, first2, last2, mutations, f,
+                [](const typename mcont_t::value_type &) noexcept {});
+        }
+    }
+}
+
+#endif
@@ -7,34 +7,101 @@
  */
 #include <gsl/gsl_rng.h>
 #include <fwdpp/mutate_recombine.hpp>
+#include <fwdpp/multilocus_genotype_matrix.hpp>
+#include <fwdpp/interlocus_recombination.hpp>
 
 namespace fwdpp
 {
     namespace fwdpp_internal
     {
+        template <typename interlocus_recombination>
+        class interlocus_crossovers
+        /// Number of crossovers at each locus boundary of one meiosis.
+        /// This version calls one callback per boundary.
+        {
+          private:
+            const interlocus_recombination &interlocus_rec;
+
+          public:
+            interlocus_crossovers(const gsl_rng *,
+                                  const interlocus_recombination &ilr,
+                                  std::vector<std::size_t> &)
+                : interlocus_rec(ilr)
+            {
+            }
+
+            unsigned
+            operator()(const std::size_t boundary) const
+            {
+                return static_cast<unsigned>(interlocus_rec[boundary]());
+            }
+        };
+
+        template <> class interlocus_crossovers<interlocus_map>
+        /// Draws the crossovers at all boundaries on construction, into
+        /// \a buffer.  Boundaries must then be visited in order.
+        {
+          private:
+            std::vector<std::size_t>::const_iterator next, end;
+
+          public:
+            interlocus_crossovers(const gsl_rng *r, const interlocus_map &m,
+                                  std::vector<std::size_t> &buffer)
+                : next{}, end{}
+            {
+                m(r, buffer);
+                next = buffer.cbegin();
+                end = buffer.cend();
+            }
+
+            unsigned
+            operator()(const std::size_t boundary)
+            {
+                assert(next == end || *next >= boundary);
+                unsigned n = 0;
+                for (; next != end && *next == boundary; ++next)
+                    {
+                        ++n;
+                    }
+                return n;
+            }
+        };
 
         /*!
           Mechanics of segregation, recombination, and mutation for multi-locus
-          API
+          API.
+
+          This version writes the offspring into \a offspring, which is
+          resized to the number of loci if needed, or into a row of a
+          fwdpp::multilocus_genotype_matrix.  The breakpoints and new
+          mutations of each locus are written into \a buffers.
+
+          \a interlocus_rec is a vector of callbacks, one per locus
+          boundary, or a fwdpp::interlocus_map.
 */
-        template <typename diploid_type,
-                  typename recombination_policy_container, typename mqueue_t,
+        template <typename diploid_type, typename offspring_type,
+                  typename recombination_policy_container,
+                  typename interlocus_recombination, typename mqueue_t,
                   typename gqueue_t, typename mcont_t, typename gcont_t,
                   typename mutation_model_container>
-        diploid_type
+        void
         multilocus_rec_mut(
             const gsl_rng *r, const diploid_type &parent1,
             const diploid_type &parent2, mqueue_t &mutation_recycling_bin,
             gqueue_t &gamete_recycling_bin,
             const recombination_policy_container &rec_pols,
-            const std::vector<std::function<unsigned(void)>> &interlocus_rec,
+            const interlocus_recombination &interlocus_rec,
             const int iswitch1, const int iswitch2, gcont_t &gametes,
             mcont_t &mutations,
             typename gcont_t::value_type::mutation_container &neutral,
             typename gcont_t::value_type::mutation_container &selected,
-            const double *mu, const mutation_model_container &mmodel)
+            const double *mu, const mutation_model_container &mmodel,
+            offspring_type &&offspring, reproduction_buffers &buffers)
         {
-            diploid_type offspring(parent1.size());
+            resize_loci(offspring, parent1.size());
+            interlocus_crossovers<interlocus_recombination> xovers1(
+                r, interlocus_rec, buffers.interlocus_breakpoints),
+                xovers2(r, interlocus_rec, buffers.interlocus_breakpoints2);
             unsigned s1 = iswitch1, s2 = iswitch2;
             auto NLOOPS = parent1.size();
             auto p1 = parent1.data();
@@ -46,9 +113,9 @@ namespace fwdpp
                     if (i)
                         {
                             // between-locus rec, parent 1
-                            s1 += interlocus_rec[i - 1]();
+                            s1 += xovers1(i - 1);
                             // between-locus rec, parent 2
-                            s2 += interlocus_rec[i - 1]();
+                            s2 += xovers2(i - 1);
                         }
                     auto p1g1 = p1->first;
                     auto p1g2 = p1->second;
@@ -64,7 +131,8 @@ namespace fwdpp
                         r, gametes, mutations,
                         std::make_tuple(p1g1, p1g2, p2g1, p2g2), rec_pols[i],
                         mmodel[i], mu[i], gamete_recycling_bin,
-                        mutation_recycling_bin, *o, neutral, selected);
+                        mutation_recycling_bin, *o, neutral, selected,
+                        buffers);
                     s1 += std::get<0>(rm);
                     s2 += std::get<1>(rm);
 // mechanics of recombination
@@ -93,6 +161,36 @@ namespace fwdpp
                     ++p2;
                     ++o;
                 }
+        }
+
+        /*!
+          Mechanics of segregation, recombination, and mutation for multi-locus
+          API
+*/
+        template <typename diploid_type,
+                  typename recombination_policy_container,
+                  typename interlocus_recombination, typename mqueue_t,
+                  typename gqueue_t, typename mcont_t, typename gcont_t,
+                  typename mutation_model_container>
+        diploid_type
+        multilocus_rec_mut(
+            const gsl_rng *r, const diploid_type &parent1,
+            const diploid_type &parent2, mqueue_t &mutation_recycling_bin,
+            gqueue_t &gamete_recycling_bin,
+            const recombination_policy_container &rec_pols,
+            const interlocus_recombination &interlocus_rec,
+            const int iswitch1, const int iswitch2, gcont_t &gametes,
+            mcont_t &mutations,
+            typename gcont_t::value_type::mutation_container &neutral,
+            typename gcont_t::value_type::mutation_container &selected,
+            const double *mu, const mutation_model_container &mmodel)
+        {
+            diploid_type offspring(parent1.size());
+            reproduction_buffers buffers;
+            multilocus_rec_mut(r, parent1, parent2, mutation_recycling_bin,
+                               gamete_recycling_bin, rec_pols, interlocus_rec,
+                               iswitch1, iswitch2, gametes, mutations, neutral,
+                               selected, mu, mmodel, offspring, buffers);
             return offspring;
         }
     }
@@ -0,0 +1,113 @@
+#ifndef FWDPP_INTERNAL_MUTATION_COLUMNS_HPP
+#define FWDPP_INTERNAL_MUTATION_COLUMNS_HPP
+
+/*
+  Access to the position and neutrality of a mutation by key.
+  Containers holding those fields in separate columns, such as
+  fwdpp::soa_mutation_vector, are read from the columns.  Any other
+  container is read from its records, so that library code may use
+  these functions for all containers of mutations.
+*/
+
+#include <cstddef>
+#include <type_traits>
+#include <fwdpp/internal/void_t.hpp>
+
+namespace fwdpp
+{
+    namespace fwdpp_internal
+    {
+        template <typename mcont_t, typename = void>
+        struct has_mutation_columns : std::false_type
+        {
+        };
+
+        template <typename mcont_t>
+        struct has_mutation_columns<
+            mcont_t, typename traits::internal::void_t<
+                         typename mcont_t::position_column_type>::type>
+            : std::true_type
+        {
+        };
+
+        template <typename mcont_t>
+        inline double
+        mutation_position(const mcont_t &mutations, const std::size_t key,
+                          std::false_type) noexcept
+        {
+            return mutations[key].pos;
+        }
+
+        template <typename mcont_t>
+        inline double
+        mutation_position(const mcont_t &mutations, const std::size_t key,
+                          std::true_type) noexcept
+        {
+            return mutations.position(key);
+        }
+
+        template <typename mcont_t>
+        inline double
+        mutation_position(const mcont_t &mutations,
+                          const std::size_t key) noexcept
+        /// Position of mutations[key]
+        {
+            return mutation_position(mutations, key,
+                                     has_mutation_columns<mcont_t>());
+        }
+
+        template <typename mcont_t>
+        inline bool
+        mutation_is_neutral(const mcont_t &mutations, const std::size_t key,
+                            std::false_type) noexcept
+        {
+            return mutations[key].neutral;
+        }
+
+        template <typename mcont_t>
+        inline bool
+        mutation_is_neutral(const mcont_t &mutations, const std::size_t key,
+                            std::true_type) noexcept
+        {
+            return mutations.is_neutral(key);
+        }
+
+        template <typename mcont_t>
+        inline bool
+        mutation_is_neutral(const mcont_t &mutations,
+                            const std::size_t key) noexcept
+        /// Value of mutations[key].neutral
+        {
+            return mutation_is_neutral(mutations, key,
+                                       has_mutation_columns<mcont_t>());
+        }
+
+        template <typename mcont_t>
+        inline void
+        assign_mutation(mcont_t &mutations, const std::size_t key,
+                        typename mcont_t::value_type &&m, std::false_type)
+        {
+            mutations[key] = std::move(m);
+        }
+
+        template <typename mcont_t>
+        inline void
+        assign_mutation(mcont_t &mutations, const std::size_t key,
+                        typename mcont_t::value_type &&m, std::true_type)
+        {
+            mutations.set(key, std::move(m));
+        }
+
+        template <typename mcont_t>
+        inline void
+        assign_mutation(mcont_t &mutations, const std::size_t key,
+                        typename mcont_t::value_type &&m)
+        /// Replace mutations[key] by m
+        {
+            assign_mutation(mutations, key, std::move(m),
+                            has_mutation_columns<mcont_t>());
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef FWDPP_INTERNAL_PARALLEL_FOR_HPP
+#define FWDPP_INTERNAL_PARALLEL_FOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fwdpp
+{
+    namespace fwdpp_internal
+    {
+        inline std::size_t
+        parallel_for_nchunks(const unsigned nthreads, const std::size_t n)
+        /// Number of chunks that parallel_for will split [0,n) into.
+        {
+            return std::max(std::size_t(1),
+                            std::min(std::size_t(nthreads), n));
+        }
+
+        inline std::size_t
+        parallel_for_chunk_begin(const std::size_t chunk,
+                                 const std::size_t nchunks,
+                                 const std::size_t n)
+        /// First index of a chunk.  Chunks are contiguous and their
+        /// sizes differ by at most one.
+        {
+            return chunk * (n / nchunks) + std::min(chunk, n % nchunks);
+        }
+
+        class worker_pool
+        /*!
+          Threads kept alive between calls to parallel_for.  While a
+          worker_pool_scope is installed on the calling thread,
+          parallel_for hands chunks 1 and up to these workers instead of
+          starting and joining new threads, so that the cost of creating
+          threads is paid once per pool rather than once per call.
+          Workers are started when first needed and stopped by stop() or
+          by the destructor.
+
+          A pool runs one parallel_for at a time.  A nested call from
+          inside a chunk falls back to new threads.  Copying a pool gives
+          an empty pool.
+        */
+        {
+          private:
+            std::vector<std::thread> workers;
+            std::mutex mutex;
+            std::condition_variable work_ready, work_done;
+            const std::function<void(std::size_t)> *task;
+            std::size_t ntasks, npending;
+            unsigned long round;
+            bool busy, stopping;
+
+            void
+            work(const std::size_t index, unsigned long seen)
+            /// Worker \a index runs chunk index + 1 of each round that
+            /// has more than index + 1 chunks
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                for (;;)
+                    {
+                        work_ready.wait(lock, [this, &seen]() {
+                            return stopping || round != seen;
+                        });
+                        if (stopping)
+                            {
+                                return;
+                            }
+                        seen = round;
+                        if (index < ntasks)
+                            {
+                                const auto t = task;
+                                lock.unlock();
+                                (*t)(index + 1);
+                                lock.lock();
+                                if (--npending == 0)
+                                    {
+                                        work_done.notify_one();
+                                    }
+                            }
+                    }
+            }
+
+          public:
+            worker_pool()
+                : workers{}, mutex{}, work_ready{}, work_done{},
+                  task(nullptr), ntasks(0), npending(0), round(0),
+                  busy(false), stopping(false)
+            {
+            }
+
+            worker_pool(const worker_pool &) : worker_pool() {}
+
+            worker_pool &
+            operator=(const worker_pool &)
+            {
+                return *this;
+            }
+
+            ~worker_pool() { stop(); }
+
+            std::size_t
+            size() const
+            /// Number of worker threads currently running
+            {
+                return workers.size();
+            }
+
+            void
+            stop()
+            /// Stop and join all workers
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                }
+                work_ready.notify_all();
+                for (auto &w : workers)
+                    {
+                        w.join();
+                    }
+                workers.clear();
+                stopping = false;
+            }
+
+            bool
+            try_run(const std::size_t nchunks,
+                    const std::function<void(std::size_t)> &f)
+            /*!
+              Call f(chunk) for each chunk in [0,nchunks), chunk 0 on
+              the calling thread and the rest on workers, and return
+              true once all calls have returned.  \a f must not throw.
+              Returns false without calling \a f if the pool is already
+              running a call to try_run.
+            */
+            {
+                if (busy)
+                    {
+                        return false;
+                    }
+                busy = true;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    while (workers.size() < nchunks - 1)
+                        {
+                            workers.emplace_back(&worker_pool::work, this,
+                                                 workers.size(), round);
+                        }
+                    task = &f;
+                    ntasks = nchunks - 1;
+                    npending = ntasks;
+                    ++round;
+                }
+                work_ready.notify_all();
+                f(0);
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    work_done.wait(lock,
+                                   [this]() { return npending == 0; });
+                    task = nullptr;
+                }
+                busy = false;
+                return true;
+            }
+        };
+
+        inline worker_pool *&
+        current_worker_pool()
+        /// The pool used by parallel_for on the calling thread, if any
+        {
+            static thread_local worker_pool *pool = nullptr;
+            return pool;
+        }
+
+        class worker_pool_scope
+        /// Makes parallel_for use \a pool on the calling thread until the
+        /// scope ends
+        {
+          private:
+            worker_pool *previous;
+
+          public:
+            explicit worker_pool_scope(worker_pool &pool)
+                : previous(current_worker_pool())
+            {
+                current_worker_pool() = &pool;
+            }
+            worker_pool_scope(const worker_pool_scope &) = delete;
+            worker_pool_scope &operator=(const worker_pool_scope &) = delete;
+            ~worker_pool_scope() { current_worker_pool() = previous; }
+        };
+
+        template <typename function>
+        void
+        parallel_for(const unsigned nthreads, const std::size_t n,
+                     const function &f)
+        /*!
+          Split the range [0,n) into at most \a nthreads contiguous chunks
+          and call f(chunk, begin, end) once per chunk.  Chunk 0 is
+          processed by the calling thread and the rest by worker threads.
+          The workers come from the current worker_pool if a
+          worker_pool_scope is installed on the calling thread, and are
+          started for this call otherwise.  The function returns once all
+          chunks are processed.
+
+          The chunk boundaries only depend on \a nthreads and \a n, which
+          allows callers to combine per-chunk results in a deterministic
+          order.
+
+          If any call to \a f throws, the first exception (in chunk order)
+          is rethrown after all threads have been joined.
+        */
+        {
+            const auto nchunks = parallel_for_nchunks(nthreads, n);
+            std::vector<std::exception_ptr> errors(nchunks);
+            auto run = [&f, &errors, nchunks, n](const std::size_t chunk) {
+                try
+                    {
+                        f(chunk,
+                          parallel_for_chunk_begin(chunk, nchunks, n),
+                          parallel_for_chunk_begin(chunk + 1, nchunks, n));
+                    }
+                catch (...)
+                    {
+                        errors[chunk] = std::current_exception();
+                    }
+            };
+            auto pool = current_worker_pool();
+            if (nchunks == 1 || pool == nullptr
+                || !pool->try_run(nchunks,
+                                  std::function<void(std::size_t)>(run)))
+                {
+                    std::vector<std::thread> workers;
+                    workers.reserve(nchunks - 1);
+                    for (std::size_t chunk = 1; chunk < nchunks; ++chunk)
+                        {
+                            workers.emplace_back(run, chunk);
+                        }
+                    run(0);
+                    for (auto &w : workers)
+                        {
+                            w.join();
+                        }
+                }
+            for (auto &e : errors)
+                {
+                    if (e)
+                        {
+                            std::rethrow_exception(e);
+                        }
+                }
+        }
+    }
+}
+
+#endif
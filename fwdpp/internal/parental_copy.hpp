@@ -0,0 +1,400 @@
+#ifndef FWDPP_INTERNAL_PARENTAL_COPY_HPP
+#define FWDPP_INTERNAL_PARENTAL_COPY_HPP
+
+/*
+  Detection of recombination events whose offspring gamete is a copy
+  of one of its parents.
+
+  Keys carried by both parental gametes are inherited whichever parent
+  a segment comes from.  Only keys carried by one parent depend on the
+  breakpoints.  Those keys are found between the end of the longest
+  common prefix and the start of the longest common suffix of the two
+  (sorted) key containers.  If no breakpoint separates the positions
+  of the first and last of those keys, they all come from the same
+  parent, and the offspring gamete has the same keys as that parent.
+
+  The comparison of the parents, a differing_span, is made once per
+  recombination by compare_parental_keys.  It also records the lengths
+  of the common prefixes and suffixes, which
+  fwdpp_internal::recombine_symmetric_difference uses.  For a
+  fwdpp::chunked_key_container, blocks shared by both parents are
+  skipped by comparing pointers, so that the cost of the comparison
+  scales with the number of blocks rather than with the number of keys.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include <fwdpp/chunked_key_container.hpp>
+#include <fwdpp/internal/mutation_columns.hpp>
+#include <fwdpp/internal/common_variant_bits.hpp>
+
+namespace fwdpp
+{
+    namespace fwdpp_internal
+    {
+        inline std::atomic<std::uint64_t> &
+        parental_copy_counter()
+        /// Number of times parental_copy found a copy.  See
+        /// fwdpp::recombination_statistics.
+        {
+            static std::atomic<std::uint64_t> n(0);
+            return n;
+        }
+
+        struct differing_span
+        /// Smallest and largest positions of keys carried by one gamete
+        /// only, and the number of keys in the common prefixes and
+        /// suffixes of the key containers
+        {
+            double first, last;
+            std::size_t nshared;
+            /// False if the key containers were not compared
+            bool compared;
+            differing_span()
+                : first(std::numeric_limits<double>::max()),
+                  last(std::numeric_limits<double>::lowest()), nshared(0),
+                  compared(false)
+            {
+            }
+        };
+
+        template <typename itr_type, typename mcont_t>
+        inline void
+        update_differing_span(itr_type b1, itr_type e1, itr_type b2,
+                              itr_type e2, const mcont_t &mutations,
+                              differing_span &span,
+                              std::bidirectional_iterator_tag)
+        {
+            for (; b1 != e1 && b2 != e2 && *b1 == *b2;
+                 ++b1, ++b2, ++span.nshared)
+                ;
+            for (; e1 != b1 && e2 != b2
+                   && *std::prev(e1) == *std::prev(e2);
+                 --e1, --e2, ++span.nshared)
+                ;
+            if (b1 != e1)
+                {
+                    span.first = std::min(span.first,
+                                          mutation_position(mutations, *b1));
+                    span.last = std::max(
+                        span.last,
+                        mutation_position(mutations, *std::prev(e1)));
+                }
+            if (b2 != e2)
+                {
+                    span.first = std::min(span.first,
+                                          mutation_position(mutations, *b2));
+                    span.last = std::max(
+                        span.last,
+                        mutation_position(mutations, *std::prev(e2)));
+                }
+        }
+
+        template <typename itr_type, typename mcont_t>
+        inline void
+        update_differing_span(itr_type b1, std::size_t n1, itr_type b2,
+                              std::size_t n2, const mcont_t &mutations,
+                              differing_span &span)
+        // Single pass version, for containers with forward iterators.
+        // The common suffix is found by aligning the ends of the
+        // remaining ranges.
+        {
+            for (; n1 && n2 && *b1 == *b2;
+                 ++b1, ++b2, --n1, --n2, ++span.nshared)
+                ;
+            if (!n1 && !n2)
+                {
+                    return;
+                }
+            if (n1)
+                {
+                    span.first = std::min(span.first,
+                                          mutation_position(mutations, *b1));
+                }
+            if (n2)
+                {
+                    span.first = std::min(span.first,
+                                          mutation_position(mutations, *b2));
+                }
+            // Skip the unaligned keys of the longer range
+            const bool first_longer = n1 > n2;
+            auto &longer = first_longer ? b1 : b2;
+            std::size_t skip = first_longer ? n1 - n2 : n2 - n1;
+            const std::size_t n = std::min(n1, n2);
+            bool skipped = skip > 0;
+            using key_type =
+                typename std::iterator_traits<itr_type>::value_type;
+            key_type last_skipped = 0;
+            for (; skip; --skip, ++longer)
+                {
+                    last_skipped = *longer;
+                }
+            // The last position at which the aligned keys differ
+            bool mismatch = false;
+            key_type last1 = 0, last2 = 0;
+            std::size_t suffix = n;
+            for (std::size_t i = 0; i < n; ++i, ++b1, ++b2)
+                {
+                    if (*b1 != *b2)
+                        {
+                            mismatch = true;
+                            last1 = *b1;
+                            last2 = *b2;
+                            suffix = n - i - 1;
+                        }
+                }
+            span.nshared += suffix;
+            if (mismatch)
+                {
+                    span.last = std::max(
+                        span.last,
+                        std::max(mutation_position(mutations, last1),
+                                 mutation_position(mutations, last2)));
+                }
+            else if (skipped)
+                {
+                    span.last = std::max(
+                        span.last, mutation_position(mutations, last_skipped));
+                }
+        }
+
+        template <typename key_container, typename mcont_t>
+        inline void
+        update_differing_span(const key_container &k1,
+                              const key_container &k2,
+                              const mcont_t &mutations, differing_span &span,
+                              std::bidirectional_iterator_tag)
+        {
+            update_differing_span(k1.cbegin(), k1.cend(), k2.cbegin(),
+                                  k2.cend(), mutations, span,
+                                  std::bidirectional_iterator_tag());
+        }
+
+        template <typename key_container, typename mcont_t>
+        inline void
+        update_differing_span(const key_container &k1,
+                              const key_container &k2,
+                              const mcont_t &mutations, differing_span &span,
+                              std::forward_iterator_tag)
+        {
+            update_differing_span(k1.cbegin(), k1.size(), k2.cbegin(),
+                                  k2.size(), mutations, span);
+        }
+
+        template <typename key_container, typename mcont_t>
+        inline void
+        update_differing_span(const key_container &k1,
+                              const key_container &k2,
+                              const mcont_t &mutations, differing_span &span)
+        /// Update \a span with the positions of keys in only one of \a k1
+        /// and \a k2.
+        {
+            update_differing_span(
+                k1, k2, mutations, span,
+                typename std::iterator_traits<
+                    typename key_container::const_iterator>::
+                    iterator_category());
+        }
+
+        template <typename mcont_t, std::size_t chunk_size>
+        inline void
+        update_differing_span(const chunked_key_container<chunk_size> &k1,
+                              const chunked_key_container<chunk_size> &k2,
+                              const mcont_t &mutations, differing_span &span)
+        // Same result as for other containers, but blocks shared by k1
+        // and k2 are skipped without reading their keys.  Keys are
+        // located by block and offset.
+        {
+            const auto &blocks1 = k1.blocks();
+            const auto &blocks2 = k2.blocks();
+            // Common prefix
+            std::size_t b1 = 0, o1 = 0, b2 = 0, o2 = 0, prefix = 0;
+            while (b1 < blocks1.size() && b2 < blocks2.size())
+                {
+                    if (o1 == 0 && o2 == 0 && blocks1[b1] == blocks2[b2])
+                        {
+                            prefix += blocks1[b1]->size();
+                            ++b1;
+                            ++b2;
+                            continue;
+                        }
+                    if ((*blocks1[b1])[o1] != (*blocks2[b2])[o2])
+                        {
+                            break;
+                        }
+                    ++prefix;
+                    if (++o1 == blocks1[b1]->size())
+                        {
+                            ++b1;
+                            o1 = 0;
+                        }
+                    if (++o2 == blocks2[b2]->size())
+                        {
+                            ++b2;
+                            o2 = 0;
+                        }
+                }
+            const std::size_t n1 = k1.size() - prefix,
+                              n2 = k2.size() - prefix;
+            span.nshared += prefix;
+            if (!n1 && !n2)
+                {
+                    return;
+                }
+            // Common suffix of the remaining keys.  The last key not yet
+            // in the suffix is at offset q of block r - 1, counting from
+            // the end of the block.
+            const std::size_t n = std::min(n1, n2);
+            std::size_t r1 = blocks1.size(), q1 = 0, r2 = blocks2.size(),
+                        q2 = 0, suffix = 0;
+            while (suffix < n)
+                {
+                    const auto &last1 = *blocks1[r1 - 1];
+                    const auto &last2 = *blocks2[r2 - 1];
+                    if (q1 == 0 && q2 == 0 && &last1 == &last2
+                        && last1.size() <= n - suffix)
+                        {
+                            suffix += last1.size();
+                            --r1;
+                            --r2;
+                            continue;
+                        }
+                    if (last1[last1.size() - 1 - q1]
+                        != last2[last2.size() - 1 - q2])
+                        {
+                            break;
+                        }
+                    ++suffix;
+                    if (++q1 == last1.size())
+                        {
+                            --r1;
+                            q1 = 0;
+                        }
+                    if (++q2 == last2.size())
+                        {
+                            --r2;
+                            q2 = 0;
+                        }
+                }
+            span.nshared += suffix;
+            if (n1 > suffix)
+                {
+                    const auto &last1 = *blocks1[r1 - 1];
+                    span.first = std::min(
+                        span.first,
+                        mutation_position(mutations, (*blocks1[b1])[o1]));
+                    span.last = std::max(
+                        span.last,
+                        mutation_position(mutations,
+                                          last1[last1.size() - 1 - q1]));
+                }
+            if (n2 > suffix)
+                {
+                    const auto &last2 = *blocks2[r2 - 1];
+                    span.first = std::min(
+                        span.first,
+                        mutation_position(mutations, (*blocks2[b2])[o2]));
+                    span.last = std::max(
+                        span.last,
+                        mutation_position(mutations,
+                                          last2[last2.size() - 1 - q2]));
+                }
+        }
+
+        template <typename gamete_t, typename mcont_t>
+        inline differing_span
+        compare_parental_keys(const gamete_t &gamete1,
+                              const gamete_t &gamete2,
+                              const mcont_t &mutations, std::false_type)
+        {
+            differing_span span;
+            span.compared = true;
+            update_differing_span(gamete1.mutations, gamete2.mutations,
+                                  mutations, span);
+            update_differing_span(gamete1.smutations, gamete2.smutations,
+                                  mutations, span);
+            return span;
+        }
+
+        template <typename gamete_t, typename mcont_t>
+        inline differing_span
+        compare_parental_keys(const gamete_t &, const gamete_t &,
+                              const mcont_t &, std::true_type)
+        // Common variants are recombined by fwdpp::mutate_recombine
+        {
+            return differing_span();
+        }
+
+        template <typename gamete_t, typename mcont_t>
+        inline differing_span
+        compare_parental_keys(const gamete_t &gamete1,
+                              const gamete_t &gamete2,
+                              const mcont_t &mutations)
+        /*!
+          Compare the keys of two parental gametes.  The result is passed
+          to parental_copy and to recombine_symmetric_difference.
+        */
+        {
+            return compare_parental_keys(gamete1, gamete2, mutations,
+                                         has_common_variants<gamete_t>());
+        }
+
+        template <typename bp_itr>
+        inline std::size_t
+        parental_copy(const bp_itr breakpoints_begin,
+                      const bp_itr breakpoints_end, const std::size_t g1,
+                      const std::size_t g2, const differing_span &span)
+        /*!
+          If recombination between gametes g1 and g2 at the breakpoints
+          in [breakpoints_begin, breakpoints_end), without new mutations,
+          gives a copy of one of them, return its index.  Otherwise,
+          return std::numeric_limits<std::size_t>::max().  \a span is
+          the result of compare_parental_keys.
+        */
+        {
+            if (!span.compared)
+                {
+                    return std::numeric_limits<std::size_t>::max();
+                }
+            if (span.first > span.last)
+                {
+                    // The parents carry the same keys
+                    parental_copy_counter().fetch_add(
+                        1, std::memory_order_relaxed);
+                    return g1;
+                }
+            // A key at position x comes from g2 if the number of
+            // breakpoints < x is odd.
+            const auto before_first = std::lower_bound(
+                breakpoints_begin, breakpoints_end, span.first);
+            const auto before_last
+                = std::lower_bound(before_first, breakpoints_end, span.last);
+            if (before_first != before_last)
+                {
+                    return std::numeric_limits<std::size_t>::max();
+                }
+            parental_copy_counter().fetch_add(1, std::memory_order_relaxed);
+            return ((before_first - breakpoints_begin) % 2 == 0) ? g1 : g2;
+        }
+
+        template <typename gcont_t, typename mcont_t>
+        inline std::size_t
+        parental_copy(const std::vector<double> &breakpoints,
+                      const std::size_t g1, const std::size_t g2,
+                      const gcont_t &gametes, const mcont_t &mutations)
+        /// As above, comparing gametes[g1] and gametes[g2]
+        {
+            return parental_copy(
+                breakpoints.cbegin(), breakpoints.cend(), g1, g2,
+                compare_parental_keys(gametes[g1], gametes[g2], mutations));
+        }
+    }
+}
+
+#endif
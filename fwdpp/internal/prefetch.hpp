@@ -0,0 +1,123 @@
+#ifndef FWDPP_INTERNAL_PREFETCH_HPP
+#define FWDPP_INTERNAL_PREFETCH_HPP
+
+/*
+  Software prefetching for the look-ups of mutation counts made by
+  fwdpp_internal::process_gametes and fwdpp_internal::gamete_cleaner.
+  Mutation keys in a gamete are sorted by position, but the counts
+  are stored in the order in which mutations were added, meaning
+  that mcounts[m] is usually a cache miss in large simulations.
+
+  Prefetching is only enabled if FWDPP_ENABLE_PREFETCH is defined
+  (see the --enable-prefetch option to configure), because its
+  benefit depends on the hardware and on the size of a simulation.
+  The number of keys looked ahead is FWDPP_PREFETCH_DISTANCE.
+*/
+
+#include <cstddef>
+#include <algorithm>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/chunked_key_container.hpp>
+#include <fwdpp/compressed_key_container.hpp>
+
+#ifndef FWDPP_PREFETCH_DISTANCE
+#define FWDPP_PREFETCH_DISTANCE 8
+#endif
+
+#if defined(FWDPP_ENABLE_PREFETCH) && defined(__GNUC__)
+#define FWDPP_PREFETCH_READ(addr) __builtin_prefetch((addr), 0, 1)
+#define FWDPP_PREFETCH_WRITE(addr) __builtin_prefetch((addr), 1, 1)
+#else
+#define FWDPP_PREFETCH_READ(addr) static_cast<void>(addr)
+#define FWDPP_PREFETCH_WRITE(addr) static_cast<void>(addr)
+#endif
+
+namespace fwdpp
+{
+    namespace fwdpp_internal
+    {
+        template <typename key_container>
+        inline void
+        add_to_counts(const key_container &keys, const uint_t n,
+                      uint_t *counts) noexcept
+        /// Add n to counts[k] for each key k
+        {
+#ifdef FWDPP_ENABLE_PREFETCH
+            const std::size_t nkeys = keys.size();
+            std::size_t i = 0;
+            for (; i + FWDPP_PREFETCH_DISTANCE < nkeys; ++i)
+                {
+                    FWDPP_PREFETCH_WRITE(counts
+                                         + keys[i + FWDPP_PREFETCH_DISTANCE]);
+                    counts[keys[i]] += n;
+                }
+            for (; i < nkeys; ++i)
+                {
+                    counts[keys[i]] += n;
+                }
+#else
+            for (const auto &k : keys)
+                {
+                    counts[k] += n;
+                }
+#endif
+        }
+
+        template <std::size_t chunk_size>
+        inline void
+        add_to_counts(const chunked_key_container<chunk_size> &keys,
+                      const uint_t n, uint_t *counts) noexcept
+        /// Add n to counts[k] for each key k, one block at a time
+        {
+            for (const auto &b : keys.blocks())
+                {
+                    add_to_counts(*b, n, counts);
+                }
+        }
+
+        inline void
+        add_to_counts(const compressed_key_container &keys, const uint_t n,
+                      uint_t *counts) noexcept
+        /// Add n to counts[k] for each key k, decoding keys in order
+        {
+            for (const auto k : keys)
+                {
+                    counts[k] += n;
+                }
+        }
+
+        template <typename iterator_t, typename mcounts_t,
+                  typename predicate>
+        inline iterator_t
+        remove_if_prefetched(iterator_t first, iterator_t last,
+                             const mcounts_t &mcounts,
+                             const predicate &p) noexcept
+        /*!
+          Same as std::remove_if(first, last, p), where p looks up
+          mcounts[*first].
+        */
+        {
+#ifdef FWDPP_ENABLE_PREFETCH
+            auto out = first;
+            for (; first != last; ++first)
+                {
+                    if (last - first > FWDPP_PREFETCH_DISTANCE)
+                        {
+                            FWDPP_PREFETCH_READ(
+                                &mcounts[*(first + FWDPP_PREFETCH_DISTANCE)]);
+                        }
+                    if (!p(*first))
+                        {
+                            *out++ = *first;
+                        }
+                }
+            return out;
+#else
+            static_cast<void>(mcounts);
+            return std::remove_if(first, last, p);
+#endif
+        }
+    }
+}
+
+#endif
@@ -2,16 +2,108 @@
 #define __FWDPP_INTERNAL_REC_GAMETE_UPDATER_HPP__
 
 #include <algorithm>
+#include <cstddef>
 #include <functional>
+#include <iterator>
+#include <type_traits>
 #include <cassert>
+#include <fwdpp/internal/mutation_columns.hpp>
+
+/*
+  Merging of parental mutation keys at recombination breakpoints.
+
+  For each breakpoint or new mutation, fwdpp::mutate_recombine moves
+  four iterators past all keys at positions <= some value.  When there
+  are many breakpoints, most of those moves are short, and
+  rec_update_itr gallops instead of doing a binary search over the
+  remaining keys: it checks the next key, then the keys 1, 3, 7, ...
+  ahead of it, until it passes the value.  The cost is O(log d) for an
+  advance of d keys.  With few breakpoints, the moves are long and a
+  galloping search does about twice the comparisons of a binary
+  search.  gallop_rec_update chooses between the two from the number
+  of breakpoints and the number of keys per breakpoint.
+
+  The last, short, interval is searched by counting the keys at
+  positions <= the value, which has no branches that depend on the
+  positions.  When the mutations keep positions in a contiguous column
+  (see fwdpp::soa_mutation_vector), the count reads that column
+  directly, which compilers can vectorize.
+
+  Key containers without random access iterators, such as
+  fwdpp::compressed_key_container, use std::upper_bound.
+*/
+
 namespace fwdpp
 {
     namespace fwdpp_internal
     {
+        // Intervals at most this long are searched by counting
+        constexpr std::ptrdiff_t rec_update_linear_search_length = 8;
+
+        // Galloping is used when there are at least this many
+        // breakpoints and new mutations, counting the terminal
+        // breakpoint, and at most this many keys per breakpoint or
+        // new mutation
+        constexpr std::size_t rec_update_gallop_min_positions = 4;
+        constexpr std::size_t rec_update_gallop_keys_per_position = 256;
+
+        inline bool
+        gallop_rec_update(const std::size_t nkeys,
+                          const std::size_t npositions) noexcept
+        /// True if merging nkeys keys at npositions breakpoints and
+        /// new mutations should use a galloping search
+        {
+            return npositions >= rec_update_gallop_min_positions
+                   && nkeys
+                          <= npositions * rec_update_gallop_keys_per_position;
+        }
+
         template <typename itr_type, typename mcont_t>
         inline itr_type
-        rec_update_itr(itr_type __first, itr_type __last,
-                       const mcont_t &mutations, const double &val)
+        count_upper_bound(itr_type first, const std::ptrdiff_t n,
+                          const mcont_t &mutations, const double val,
+                          std::false_type) noexcept
+        {
+            std::ptrdiff_t c = 0;
+            for (std::ptrdiff_t i = 0; i < n; ++i)
+                {
+                    c += (mutation_position(mutations, first[i]) <= val);
+                }
+            return first + c;
+        }
+
+        template <typename itr_type, typename mcont_t>
+        inline itr_type
+        count_upper_bound(itr_type first, const std::ptrdiff_t n,
+                          const mcont_t &mutations, const double val,
+                          std::true_type) noexcept
+        {
+            const double *const pos = mutations.positions().data();
+            std::ptrdiff_t c = 0;
+            for (std::ptrdiff_t i = 0; i < n; ++i)
+                {
+                    c += (pos[first[i]] <= val);
+                }
+            return first + c;
+        }
+
+        template <typename itr_type, typename mcont_t>
+        inline itr_type
+        count_upper_bound(itr_type first, const std::ptrdiff_t n,
+                          const mcont_t &mutations, const double val) noexcept
+        /// Same as std::upper_bound over [first, first + n), for keys
+        /// sorted by position
+        {
+            return count_upper_bound(first, n, mutations, val,
+                                     has_mutation_columns<mcont_t>());
+        }
+
+        template <typename itr_type, typename mcont_t>
+        inline itr_type
+        binary_rec_update_itr(itr_type __first, itr_type __last,
+                              const mcont_t &mutations, const double &val)
+        /// First key in [__first, __last) at a position > val, found
+        /// by binary search
         {
             if (__first == __last)
                 return __first;
@@ -20,20 +112,90 @@ namespace fwdpp
                 [&mutations](const double __val,
                              const std::size_t __mut) noexcept {
                     assert(__mut < mutations.size());
-                    return __val < mutations[__mut].pos;
+                    return __val < mutation_position(mutations, __mut);
                 });
         }
 
+        template <typename itr_type, typename mcont_t>
+        inline itr_type
+        gallop_rec_update_itr(itr_type __first, itr_type __last,
+                              const mcont_t &mutations, const double &val,
+                              std::random_access_iterator_tag)
+        {
+            const std::ptrdiff_t n = __last - __first;
+            if (n == 0 || val < mutation_position(mutations, *__first))
+                {
+                    return __first;
+                }
+            // The key at lo is at a position <= val.  The key at
+            // lo + step, if any, is at a position > val when the
+            // loop ends.
+            std::ptrdiff_t lo = 0, step = 1;
+            while (step < n - lo
+                   && !(val < mutation_position(mutations,
+                                                __first[lo + step])))
+                {
+                    lo += step;
+                    step *= 2;
+                }
+            const std::ptrdiff_t hi = (step < n - lo) ? lo + step : n;
+            if (hi - lo - 1 <= rec_update_linear_search_length)
+                {
+                    return count_upper_bound(__first + lo + 1, hi - lo - 1,
+                                             mutations, val);
+                }
+            return binary_rec_update_itr(__first + lo + 1, __first + hi,
+                                         mutations, val);
+        }
+
+        template <typename itr_type, typename mcont_t>
+        inline itr_type
+        gallop_rec_update_itr(itr_type __first, itr_type __last,
+                              const mcont_t &mutations, const double &val,
+                              std::forward_iterator_tag)
+        {
+            return binary_rec_update_itr(__first, __last, mutations, val);
+        }
+
+        template <typename itr_type, typename mcont_t>
+        inline itr_type
+        rec_update_itr(itr_type __first, itr_type __last,
+                       const mcont_t &mutations, const double &val)
+        /// First key in [__first, __last) at a position > val.  The
+        /// keys must be sorted by position.
+        {
+            return gallop_rec_update_itr(
+                __first, __last, mutations, val,
+                typename std::iterator_traits<itr_type>::iterator_category());
+        }
+
+        template <typename itr_type, typename mcont_t>
+        inline itr_type
+        rec_update_itr(itr_type __first, itr_type __last,
+                       const mcont_t &mutations, const double &val,
+                       const bool gallop)
+        /// As above, with a binary search unless gallop is true.  See
+        /// gallop_rec_update.
+        {
+            if (gallop)
+                {
+                    return rec_update_itr(__first, __last, mutations, val);
+                }
+            return binary_rec_update_itr(__first, __last, mutations, val);
+        }
+
         template <typename itr_type, typename mcont_t,
                   typename mutation_index_cont_t>
         itr_type
         rec_gam_updater(itr_type __first, itr_type __last,
                         const mcont_t &mutations, mutation_index_cont_t &muts,
-                        const double &val)
+                        const double &val, const bool gallop = true)
         {
-            // O(log_2) comparisons of double plus at most __last - __first
-            // copies
-            itr_type __ub = rec_update_itr(__first, __last, mutations, val);
+            // O(log_2 d) comparisons of double for an advance of d keys
+            // if gallop is true, O(log_2 n) for n remaining keys if not,
+            // plus d copies
+            itr_type __ub
+                = rec_update_itr(__first, __last, mutations, val, gallop);
             /*
               NOTE: the use of insert here
               instead of std::copy(__first,__ub,std::back_inserter(muts));
@@ -3,6 +3,7 @@
 
 #include <fwdpp/debug.hpp>
 #include <fwdpp/internal/rec_gamete_updater.hpp>
+#include <algorithm>
 #include <cassert>
 namespace fwdpp
 {
@@ -30,16 +31,20 @@ namespace fwdpp
             auto jtr_e = gametes[jbeg].mutations.cend();
             auto jtr_s_e = gametes[jbeg].smutations.cend();
 
+            const bool gallop = gallop_rec_update(
+                std::max(gametes[ibeg].mutations.size(),
+                         gametes[jbeg].mutations.size()),
+                pos.size());
             for (auto &&p : pos)
                 {
                     itr = fwdpp_internal::rec_gam_updater(
-                        itr, itr_e, mutations, neutral, p);
+                        itr, itr_e, mutations, neutral, p, gallop);
                     itr_s = fwdpp_internal::rec_gam_updater(
-                        itr_s, itr_s_e, mutations, selected, p);
+                        itr_s, itr_s_e, mutations, selected, p, gallop);
                     jtr = fwdpp_internal::rec_update_itr(jtr, jtr_e, mutations,
-                                                         p);
-                    jtr_s = fwdpp_internal::rec_update_itr(jtr_s, jtr_s_e,
-                                                           mutations, p);
+                                                         p, gallop);
+                    jtr_s = fwdpp_internal::rec_update_itr(
+                        jtr_s, jtr_s_e, mutations, p, gallop);
                     std::swap(itr, jtr);
                     std::swap(itr_s, jtr_s);
                     std::swap(itr_e, jtr_e);
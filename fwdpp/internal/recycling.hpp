@@ -1,43 +1,158 @@
 #ifndef FWDPP_INTERNAL_RECYCLING
 #define FWDPP_INTERNAL_RECYCLING
 
+#include <algorithm>
 #include <cassert>
-#include <queue>
-#include <cassert>
+#include <vector>
 #include <type_traits>
+#include <fwdpp/internal/haplotype_value_cache.hpp>
+#include <fwdpp/internal/mutation_columns.hpp>
+#include <fwdpp/gamete_hash_index.hpp>
 
 namespace fwdpp
 {
     namespace fwdpp_internal
     {
+        template <typename T> class recycling_bin
+        /*!
+          The indexes of extinct mutations or gametes, which are reused
+          before the containers are allowed to grow.
 
-		template <class T> using recycling_bin_t = typename std::conditional<std::is_unsigned<T>::value,std::queue<T>,void>::type;
+          The indexes are held in a std::vector used as a stack, meaning
+          that the most recently added index is reused first, and that
+          refilling a bin does not allocate once its capacity suffices.
+          front() is the same as top(), for code written against the
+          std::queue used by earlier versions of fwdpp.
+        */
+        {
+          private:
+            std::vector<T> indexes;
 
-        template <typename mcount_vec>
-        recycling_bin_t<typename mcount_vec::size_type>
-        make_mut_queue(const mcount_vec &mcounts)
+          public:
+            using value_type = T;
+            using size_type = typename std::vector<T>::size_type;
+            using const_iterator = typename std::vector<T>::const_iterator;
+
+            recycling_bin() : indexes{} {}
+
+            bool
+            empty() const noexcept
+            {
+                return indexes.empty();
+            }
+            size_type
+            size() const noexcept
+            {
+                return indexes.size();
+            }
+            void
+            push(const T i)
+            {
+                indexes.push_back(i);
+            }
+            void
+            pop() noexcept
+            {
+                assert(!indexes.empty());
+                indexes.pop_back();
+            }
+            T
+            top() const noexcept
+            /// The next index to be reused
+            {
+                assert(!indexes.empty());
+                return indexes.back();
+            }
+            T
+            front() const noexcept
+            {
+                return top();
+            }
+            void
+            clear() noexcept
+            /// Empty the bin, keeping its capacity
+            {
+                indexes.clear();
+            }
+            template <typename predicate>
+            void
+            remove_if(const predicate &p)
+            /// Remove the indexes for which \a p is true
+            {
+                indexes.erase(
+                    std::remove_if(indexes.begin(), indexes.end(), p),
+                    indexes.end());
+            }
+            void
+            reserve(const size_type n)
+            {
+                indexes.reserve(n);
+            }
+            void
+            swap(recycling_bin &rhs) noexcept
+            {
+                indexes.swap(rhs.indexes);
+            }
+            const_iterator
+            begin() const noexcept
+            {
+                return indexes.begin();
+            }
+            const_iterator
+            end() const noexcept
+            {
+                return indexes.end();
+            }
+        };
+
+        template <class T>
+        using recycling_bin_t =
+            typename std::conditional<std::is_unsigned<T>::value,
+                                      recycling_bin<T>, void>::type;
+
+        template <typename mcount_vec, typename queue_t>
+        void
+        fill_mut_queue(const mcount_vec &mcounts, queue_t &rv)
+        // Refill an existing bin with the indexes of extinct mutations
         {
-            recycling_bin_t<typename mcount_vec::size_type> rv;
+            rv.clear();
             const auto msize = mcounts.size();
             for (typename mcount_vec::size_type i = 0; i < msize; ++i)
                 {
                     if (!mcounts[i])
                         rv.push(i);
                 }
-            return rv;
         }
 
-        template <typename gvec_t>
-        recycling_bin_t<typename gvec_t::size_type>
-        make_gamete_queue(const gvec_t &gametes)
+        template <typename gvec_t, typename queue_t>
+        void
+        fill_gamete_queue(const gvec_t &gametes, queue_t &rv)
+        // Refill an existing bin with the indexes of extinct gametes
         {
-            recycling_bin_t<typename gvec_t::size_type> rv;
+            rv.clear();
             const auto gsize = gametes.size();
             for (typename gvec_t::size_type i = 0; i < gsize; ++i)
                 {
                     if (!gametes[i].n)
                         rv.push(i);
                 }
+        }
+
+        template <typename mcount_vec>
+        recycling_bin_t<typename mcount_vec::size_type>
+        make_mut_queue(const mcount_vec &mcounts)
+        {
+            recycling_bin_t<typename mcount_vec::size_type> rv;
+            fill_mut_queue(mcounts, rv);
+            return rv;
+        }
+
+        template <typename gvec_t>
+        recycling_bin_t<typename gvec_t::size_type>
+        make_gamete_queue(const gvec_t &gametes)
+        {
+            recycling_bin_t<typename gvec_t::size_type> rv;
+            fill_gamete_queue(gametes, rv);
             return rv;
         }
 
@@ -56,12 +171,77 @@ namespace fwdpp
                     assert(!gametes[idx].n);
                     gametes[idx].mutations.swap(neutral);
                     gametes[idx].smutations.swap(selected);
+                    invalidate_cached_value(gametes[idx]);
                     return idx;
                 }
             gametes.emplace_back(0u, std::move(neutral), std::move(selected));
             return (gametes.size() - 1);
         }
 
+        template <typename queue_t> struct hash_consing_recycling_bin
+        /*!
+          A gamete recycling bin that also looks up new gametes in a
+          fwdpp::gamete_hash_index.  See the overload of recycle_gamete
+          below.  If index is nullptr, this type behaves like queue_t.
+        */
+        {
+            using value_type = typename queue_t::value_type;
+            queue_t &bin;
+            gamete_hash_index *index;
+            hash_consing_recycling_bin(queue_t &bin_,
+                                       gamete_hash_index *index_)
+                : bin(bin_), index(index_)
+            {
+            }
+            bool
+            empty() const
+            {
+                return bin.empty();
+            }
+            value_type
+            front() const
+            {
+                return bin.front();
+            }
+            void
+            pop()
+            {
+                bin.pop();
+            }
+        };
+
+        template <typename gcont_t, typename queue_t>
+        inline typename queue_t::value_type
+        recycle_gamete(
+            gcont_t &gametes,
+            hash_consing_recycling_bin<queue_t> &gamete_recycling_bin,
+            typename gcont_t::value_type::mutation_container &neutral,
+            typename gcont_t::value_type::mutation_container &selected)
+        /*!
+          If a gamete with the same keys as \a neutral and \a selected
+          is indexed, return its index.  Otherwise, store a new gamete
+          and index it.
+        */
+        {
+            auto index = gamete_recycling_bin.index;
+            if (index == nullptr)
+                {
+                    return recycle_gamete(gametes, gamete_recycling_bin.bin,
+                                          neutral, selected);
+                }
+            const auto h = gamete_hash_index::hash(neutral, selected);
+            const auto f = index->find(gametes, h, neutral, selected);
+            if (f.first)
+                {
+                    index->record_merge();
+                    return f.second;
+                }
+            auto idx = recycle_gamete(gametes, gamete_recycling_bin.bin,
+                                      neutral, selected);
+            index->insert(h, idx);
+            return idx;
+        }
+
         /*!
           \brief Helper function for mutation policies
 
@@ -69,8 +249,8 @@ namespace fwdpp
           models.  It abstracts
           the operations needed to recycle an extinct mutation.
 
-          \param mutation_recycling_bin  A FIFO queue of iterators pointing to
-          extinct mutations.
+          \param mutation_recycling_bin  A fwdpp_internal::recycling_bin of
+          the indexes of extinct mutations.
           \param mutations A list of mutation objects
           \param args Parameter pack to be passed to constructor of an
           mcont_t::value_type
@@ -84,7 +264,9 @@ namespace fwdpp
                 {
                     auto rv = mutation_recycling_bin.front();
                     mutation_recycling_bin.pop();
-                    mutations[rv] = typename mcont_t::value_type(std::forward<Args>(args)...);
+                    assign_mutation(mutations, rv,
+                                    typename mcont_t::value_type(
+                                        std::forward<Args>(args)...));
                     return rv;
                 }
             mutations.emplace_back(std::forward<Args>(args)...);
@@ -1,12 +1,180 @@
 #ifndef FWDPP_INTERNAL_SAMPLE_DIPLOID_HELPERS
 #define FWDPP_INTERNAL_SAMPLE_DIPLOID_HELPERS
 
+#include <cmath>
 #include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cassert>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include <fwdpp/internal/gsl_discrete.hpp>
+#include <fwdpp/internal/parallel_for.hpp>
+#include <fwdpp/internal/prefetch.hpp>
+#include <fwdpp/renumber_mutations.hpp>
+#include <fwdpp/gamete_hash_index.hpp>
+#include <fwdpp/common_variant_gamete.hpp>
+#include <fwdpp/internal/recycling.hpp>
 
 namespace fwdpp
 {
     namespace fwdpp_internal
     {
+        template <typename gcont_t>
+        inline void
+        zero_gamete_counts(gcont_t &gametes)
+        /*!
+          Set the count of every gamete to zero in one linear sweep.
+
+          Extinct gametes already have a count of zero, so this is
+          equivalent to resetting the gametes of every parent, but
+          it visits memory in order and is independent of the
+          fitness calculations.
+        */
+        {
+            for (auto &g : gametes)
+                {
+                    g.n = 0;
+                }
+        }
+
+        template <typename gcont_t, typename queue_t>
+        inline void
+        zero_gamete_counts(gcont_t &gametes, queue_t &gamete_recycling_bin)
+        /*!
+          Same as above, and refill gamete_recycling_bin with the
+          extinct gametes in the same sweep, which replaces a call to
+          fill_gamete_queue.
+        */
+        {
+            gamete_recycling_bin.clear();
+            const auto gsize = gametes.size();
+            for (typename gcont_t::size_type i = 0; i < gsize; ++i)
+                {
+                    if (gametes[i].n)
+                        {
+                            gametes[i].n = 0;
+                        }
+                    else
+                        {
+                            gamete_recycling_bin.push(i);
+                        }
+                }
+        }
+
+        template <typename workspace_t>
+        inline void
+        fill_mutation_recycling_bin(workspace_t &workspace,
+                                    const std::vector<uint_t> &mcounts)
+        /*!
+          Used by the versions of sample_diploid taking a
+          fwdpp::generation_workspace.  If the workspace was passed to
+          fwdpp::update_mutations since the last generation,
+          workspace.mutation_recycling_bin already holds the extinct
+          mutations.  Otherwise, it is refilled from \a mcounts.
+
+          The population may have been changed since update_mutations,
+          for example by fwdpp::add_mutation, which reuses extinct
+          slots, or by fwdpp::renumber_mutations.  Keys that are no
+          longer extinct are therefore dropped from a filled bin, so that
+          a mutation in use is never overwritten.
+        */
+        {
+            if (!workspace.mutation_recycling_bin_filled)
+                {
+                    fill_mut_queue(mcounts, workspace.mutation_recycling_bin);
+                }
+            else
+                {
+                    workspace.mutation_recycling_bin.remove_if(
+                        [&mcounts](const std::size_t i) {
+                            return i >= mcounts.size() || mcounts[i];
+                        });
+                }
+            workspace.mutation_recycling_bin_filled = false;
+        }
+
+        template <typename dipvector_t, typename gcont_t, typename mcont_t,
+                  typename fitness_function>
+        inline double
+        fill_fitnesses(const dipvector_t &diploids, const gcont_t &gametes,
+                       const mcont_t &mutations, const fitness_function &ff,
+                       double *fitnesses, const unsigned nthreads)
+        /*!
+          Assign fitnesses[i] = ff(diploids[i],gametes,mutations) and
+          return the sum of all fitnesses.
+
+          When \a nthreads > 1, the diploids are split into contiguous
+          chunks evaluated by different threads, and \a ff must be safe
+          to call concurrently.  The sum is then the sum of per-chunk
+          sums, added in chunk order.  The fitnesses themselves do not
+          depend on \a nthreads, but the sum may differ in the last bits
+          from the single-threaded value.
+        */
+        {
+            if (nthreads < 2)
+                {
+                    double sum = 0.;
+                    for (std::size_t i = 0; i < diploids.size(); ++i)
+                        {
+                            fitnesses[i] = ff(diploids[i], gametes, mutations);
+                            sum += fitnesses[i];
+                        }
+                    return sum;
+                }
+            std::vector<double> partial_sums(
+                parallel_for_nchunks(nthreads, diploids.size()), 0.);
+            parallel_for(nthreads, diploids.size(),
+                         [&](const std::size_t chunk, const std::size_t begin,
+                             const std::size_t end) {
+                             double sum = 0.;
+                             for (auto i = begin; i < end; ++i)
+                                 {
+                                     fitnesses[i] = ff(diploids[i], gametes,
+                                                       mutations);
+                                     sum += fitnesses[i];
+                                 }
+                             partial_sums[chunk] = sum;
+                         });
+            return std::accumulate(partial_sums.begin(), partial_sums.end(),
+                                   0.);
+        }
+
+        template <typename parent_sampler_t> class parent_lookup
+        /*!
+          Draws parents proportional to their fitnesses.  If no sampler
+          is given, a gsl_ran_discrete_t is built for the current
+          generation, which is the behavior of fwdpp 0.5.x.  Otherwise,
+          the sampler is updated with the new fitnesses.
+        */
+        {
+          private:
+            parent_sampler_t *sampler;
+            gsl_ran_discrete_t_ptr lookup;
+
+          public:
+            parent_lookup(parent_sampler_t *s, const double *fitnesses,
+                          const std::size_t n)
+                : sampler(s), lookup(nullptr)
+            {
+                if (sampler == nullptr)
+                    {
+                        lookup.reset(gsl_ran_discrete_preproc(n, fitnesses));
+                    }
+                else
+                    {
+                        sampler->update(fitnesses, n);
+                    }
+            }
+
+            std::size_t
+            operator()(const gsl_rng *r) const
+            {
+                return (sampler == nullptr) ? gsl_ran_discrete(r, lookup.get())
+                                            : (*sampler)(r);
+            }
+        };
+
         template <typename gcont_t, typename mcont_t>
         inline void
         process_gametes(const gcont_t &gametes, const mcont_t &mutations,
@@ -31,12 +199,304 @@ namespace fwdpp
                     const auto n = g.n;
                     if (n) // only do this for extant gametes
                         {
-                            for (const auto &m : g.mutations)
-                                mcounts[m] += n;
-                            for (const auto &m : g.smutations)
-                                mcounts[m] += n;
+                            add_to_counts(g.mutations, n, mcounts.data());
+                            add_to_counts(g.smutations, n, mcounts.data());
                         }
                 }
+            add_common_variant_column_counts(gametes.begin(), gametes.end(),
+                                             mcounts.data());
+        }
+
+        template <typename gcont_t, typename mcont_t>
+        inline void
+        process_gametes(const gcont_t &gametes, const mcont_t &mutations,
+                        std::vector<uint_t> &mcounts, const unsigned nthreads,
+                        std::vector<std::vector<uint_t>> &partial_counts)
+        /*!
+          Threaded version of process_gametes.  The gametes are split into
+          contiguous ranges, one per thread.  The first range is counted
+          into mcounts and range i > 0 into partial_counts[i-1].  The
+          partial counts are then added to mcounts, with each thread
+          summing a range of mutations.  The result does not depend on
+          the number of threads.
+
+          partial_counts is resized as needed and may be reused from one
+          call to the next.
+        */
+        {
+            const auto nchunks = parallel_for_nchunks(nthreads, gametes.size());
+            if (nchunks < 2)
+                {
+                    process_gametes(gametes, mutations, mcounts);
+                    return;
+                }
+            std::fill(mcounts.begin(), mcounts.end(), 0);
+            if (mutations.size() > mcounts.size())
+                {
+                    mcounts.resize(mutations.size(), 0);
+                }
+            partial_counts.resize(nchunks - 1);
+            const auto nmutations = mutations.size();
+            parallel_for(
+                nthreads, gametes.size(),
+                [&gametes, &mcounts, &partial_counts, nmutations](
+                    const std::size_t chunk, const std::size_t b,
+                    const std::size_t e) {
+                    uint_t *counts = mcounts.data();
+                    if (chunk)
+                        {
+                            partial_counts[chunk - 1].assign(nmutations, 0);
+                            counts = partial_counts[chunk - 1].data();
+                        }
+                    for (std::size_t i = b; i < e; ++i)
+                        {
+                            const auto n = gametes[i].n;
+                            if (n)
+                                {
+                                    add_to_counts(gametes[i].mutations, n,
+                                                  counts);
+                                    add_to_counts(gametes[i].smutations, n,
+                                                  counts);
+                                }
+                        }
+                    add_common_variant_column_counts(gametes.begin() + b,
+                                                     gametes.begin() + e,
+                                                     counts);
+                });
+            // The reduction is a sum of contiguous arrays, which the
+            // compiler can vectorize.
+            parallel_for(
+                nthreads, nmutations,
+                [&mcounts, &partial_counts, nchunks](
+                    const std::size_t, const std::size_t b,
+                    const std::size_t e) {
+                    uint_t *out = mcounts.data();
+                    for (std::size_t c = 0; c < nchunks - 1; ++c)
+                        {
+                            const uint_t *in = partial_counts[c].data();
+                            for (std::size_t i = b; i < e; ++i)
+                                {
+                                    out[i] += in[i];
+                                }
+                        }
+                });
+        }
+
+        template <typename gcont_t, typename mcont_t>
+        inline void
+        process_gametes(const gcont_t &gametes, const mcont_t &mutations,
+                        std::vector<uint_t> &mcounts, const unsigned nthreads)
+        /// Threaded version of process_gametes that allocates its
+        /// partial counts.
+        {
+            std::vector<std::vector<uint_t>> partial_counts;
+            process_gametes(gametes, mutations, mcounts, nthreads,
+                            partial_counts);
+        }
+
+        template <typename workspace_t, typename gcont_t, typename mcont_t>
+        inline void
+        renumber_mutations_periodically(workspace_t &workspace,
+                                        gcont_t &gametes, mcont_t &mutations,
+                                        std::vector<uint_t> &mcounts)
+        /*!
+          Used by the versions of sample_diploid taking a
+          fwdpp::generation_workspace.  Calls fwdpp::renumber_mutations
+          every workspace.renumber_mutations_interval generations.
+        */
+        {
+            if (!workspace.renumber_mutations_interval
+                || ++workspace.generations_since_renumbering
+                       < workspace.renumber_mutations_interval)
+                {
+                    return;
+                }
+            workspace.generations_since_renumbering = 0;
+            renumber_mutations(gametes, mutations, mcounts,
+                               workspace.new_mutation_keys);
+            // The tracked counts and the recycling bin are indexed by
+            // the old keys.
+            workspace.mutation_counts.reset();
+            workspace.mutation_recycling_bin_filled = false;
+        }
+
+        template <typename workspace_t, typename gcont_t, typename mcont_t>
+        inline void
+        update_common_variants_periodically(workspace_t &, gcont_t &,
+                                            const mcont_t &,
+                                            const std::vector<uint_t> &,
+                                            const uint_t, std::false_type)
+        {
+        }
+
+        template <typename workspace_t, typename gcont_t, typename mcont_t>
+        inline void
+        update_common_variants_periodically(
+            workspace_t &workspace, gcont_t &gametes,
+            const mcont_t &mutations, const std::vector<uint_t> &mcounts,
+            const uint_t twoN, std::true_type)
+        {
+            if (!workspace.common_variants_interval
+                || ++workspace.generations_since_common_variants
+                       < workspace.common_variants_interval)
+                {
+                    return;
+                }
+            workspace.generations_since_common_variants = 0;
+            const auto min_count = static_cast<uint_t>(
+                std::ceil(workspace.common_variant_frequency * double(twoN)));
+            update_common_variants(gametes, mutations, mcounts,
+                                   std::max(min_count, uint_t(1)));
+        }
+
+        template <typename workspace_t, typename gcont_t, typename mcont_t>
+        inline void
+        update_common_variants_periodically(workspace_t &workspace,
+                                            gcont_t &gametes,
+                                            const mcont_t &mutations,
+                                            const std::vector<uint_t> &mcounts,
+                                            const uint_t twoN)
+        /*!
+          Used by the versions of sample_diploid taking a
+          fwdpp::generation_workspace.  Calls fwdpp::update_common_variants
+          every workspace.common_variants_interval generations, if the
+          gametes are fwdpp::common_variant_gamete.  \a twoN is the
+          number of gametes per locus in the parental generation.
+        */
+        {
+            update_common_variants_periodically(
+                workspace, gametes, mutations, mcounts, twoN,
+                has_common_variants<typename gcont_t::value_type>());
+        }
+
+        /*
+          The next three functions implement
+          generation_workspace::hash_cons_gametes and
+          generation_workspace::merge_duplicate_gametes_interval.
+        */
+
+        template <typename workspace_t, typename gcont_t>
+        inline hash_consing_recycling_bin<
+            typename workspace_t::recycling_bin_t>
+        make_gamete_recycling_bin(workspace_t &workspace,
+                                  const gcont_t &gametes, const bool batched)
+        /*!
+          Call after retire_extinct_gametes and before
+          zero_gamete_counts.  The returned bin holds a reference to
+          workspace.gamete_recycling_bin, which zero_gamete_counts then
+          fills, so it must be used only after that call.  The index of
+          gametes is rebuilt here, while the counts still reflect the
+          previous generation.  \a batched is true if offspring are
+          generated in batches, in which case the gametes are not
+          indexed.  Nor are they if the gametes store common variants as
+          bits, because those are set after a gamete is stored.
+        */
+        {
+            if (workspace.hash_cons_gametes && !batched
+                && !has_common_variants<typename gcont_t::value_type>::value)
+                {
+                    workspace.gamete_index.rebuild(gametes);
+                    return hash_consing_recycling_bin<
+                        typename workspace_t::recycling_bin_t>(
+                        workspace.gamete_recycling_bin,
+                        &workspace.gamete_index);
+                }
+            return hash_consing_recycling_bin<
+                typename workspace_t::recycling_bin_t>(
+                workspace.gamete_recycling_bin, nullptr);
+        }
+
+        template <typename workspace_t, typename gcont_t,
+                  typename dipvector_t>
+        inline void
+        merge_batched_offspring_gametes(workspace_t &workspace,
+                                        gcont_t &gametes,
+                                        dipvector_t &diploids,
+                                        const bool batched)
+        /// Call after offspring generated in batches, or gametes
+        /// storing common variants as bits, are assigned
+        {
+            if (workspace.hash_cons_gametes
+                && (batched
+                    || has_common_variants<
+                           typename gcont_t::value_type>::value))
+                {
+                    merge_duplicate_gametes(gametes, diploids,
+                                            workspace.gamete_index);
+                }
+        }
+
+        template <typename workspace_t, typename gcont_t,
+                  typename dipvector_t>
+        inline void
+        merge_duplicate_gametes_periodically(workspace_t &workspace,
+                                             gcont_t &gametes,
+                                             dipvector_t &diploids)
+        /// Call after fixations are removed from gametes
+        {
+            if (!workspace.merge_duplicate_gametes_interval
+                || ++workspace.generations_since_merge
+                       < workspace.merge_duplicate_gametes_interval)
+                {
+                    return;
+                }
+            workspace.generations_since_merge = 0;
+            merge_duplicate_gametes(gametes, diploids, workspace.gamete_index);
+        }
+
+        /*
+          The next three functions are used by the versions of
+          sample_diploid taking a fwdpp::generation_workspace.  When
+          workspace.incremental_mutation_counts is true, mutation counts
+          are maintained by workspace.mutation_counts.  Otherwise, they
+          are recalculated by process_gametes.
+        */
+
+        template <typename workspace_t, typename gcont_t>
+        inline void
+        retire_extinct_gametes(workspace_t &workspace, const gcont_t &gametes)
+        /// Call before extinct gametes may be recycled
+        {
+            if (workspace.incremental_mutation_counts)
+                {
+                    workspace.mutation_counts.retire_extinct(gametes);
+                }
+        }
+
+        template <typename workspace_t, typename gcont_t, typename mcont_t>
+        inline void
+        count_mutations(workspace_t &workspace, const gcont_t &gametes,
+                        const mcont_t &mutations, std::vector<uint_t> &mcounts)
+        {
+            if (workspace.incremental_mutation_counts)
+                {
+                    workspace.mutation_counts.update(gametes, mutations,
+                                                     mcounts);
+                }
+            else
+                {
+                    // Counts must be recalculated if the incremental mode
+                    // is turned on again.
+                    workspace.mutation_counts.reset();
+                    process_gametes(gametes, mutations, mcounts,
+                                    workspace.nthreads,
+                                    workspace.partial_mutation_counts);
+                }
+        }
+
+        template <typename workspace_t, typename mcont_t,
+                  typename mutation_removal_policy>
+        inline void
+        remove_fixation_counts(workspace_t &workspace,
+                               const mcont_t &mutations, const uint_t twoN,
+                               const mutation_removal_policy &mp)
+        /// Call after gamete_cleaner
+        {
+            if (workspace.incremental_mutation_counts)
+                {
+                    workspace.mutation_counts.remove_fixations(mutations,
+                                                               twoN, mp);
+                }
         }
     }
 }
@@ -0,0 +1,257 @@
+#ifndef FWDPP_INTERNAL_SYMMETRIC_DIFFERENCE_HPP
+#define FWDPP_INTERNAL_SYMMETRIC_DIFFERENCE_HPP
+
+/*
+  Recombination over the symmetric difference of two parental gametes.
+
+  When two parents share most of their keys, the breakpoint loop of
+  fwdpp::mutate_recombine searches and copies every shared key on both
+  sides of every breakpoint.  The functions here walk the two key
+  containers once, in step.  A key carried by both parents is written
+  once.  A key carried by one parent is written if the number of
+  breakpoints before its position selects that parent.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/internal/mutation_columns.hpp>
+#include <fwdpp/internal/common_variant_bits.hpp>
+#include <fwdpp/internal/parental_copy.hpp>
+
+namespace fwdpp
+{
+    namespace fwdpp_internal
+    {
+        inline std::atomic<std::uint64_t> &
+        symmetric_difference_counter()
+        /// Number of gametes made by recombine_symmetric_difference.
+        /// See fwdpp::recombination_statistics.
+        {
+            static std::atomic<std::uint64_t> n(0);
+            return n;
+        }
+
+        template <typename mcont_t, typename key_container>
+        inline void
+        write_inherited_key(const uint_t key, const double pos,
+                            std::vector<uint_t>::const_iterator &next_mutation,
+                            const std::vector<uint_t>::const_iterator
+                                &new_mutations_end,
+                            const mcont_t &mutations, const bool neutral,
+                            key_container &out)
+        // New mutations go after parental keys at the same position,
+        // as in fwdpp::mutate_recombine.
+        {
+            for (; next_mutation != new_mutations_end
+                   && mutation_position(mutations, *next_mutation) < pos;
+                 ++next_mutation)
+                {
+                    if (mutation_is_neutral(mutations, *next_mutation)
+                        == neutral)
+                        {
+                            out.push_back(*next_mutation);
+                        }
+                }
+            out.push_back(key);
+        }
+
+        template <typename itr_type, typename mcont_t, typename key_container>
+        inline bool
+        merge_symmetric_difference(
+            itr_type b1, const itr_type e1, itr_type b2, const itr_type e2,
+            const std::vector<double> &breakpoints,
+            const std::vector<uint_t> &new_mutations, const mcont_t &mutations,
+            const bool neutral, key_container &out)
+        /*!
+          Write the keys of the recombinant of [b1, e1) and [b2, e2),
+          plus the new mutations of the same kind, to \a out.
+
+          Returns false if two different parental keys have the same
+          position, because their order in the recombinant then depends
+          on the parent of the segment.
+        */
+        {
+            auto next_mutation = new_mutations.cbegin();
+            const auto new_mutations_end = new_mutations.cend();
+            auto next_breakpoint = breakpoints.cbegin();
+            bool from_g2 = false;
+            while (b1 != e1 || b2 != e2)
+                {
+                    if (b1 != e1 && b2 != e2 && *b1 == *b2)
+                        {
+                            write_inherited_key(
+                                *b1, mutation_position(mutations, *b1),
+                                next_mutation, new_mutations_end, mutations,
+                                neutral, out);
+                            ++b1;
+                            ++b2;
+                            continue;
+                        }
+                    bool in_g2;
+                    if (b1 == e1)
+                        {
+                            in_g2 = true;
+                        }
+                    else if (b2 == e2)
+                        {
+                            in_g2 = false;
+                        }
+                    else
+                        {
+                            const double p1
+                                = mutation_position(mutations, *b1),
+                                p2 = mutation_position(mutations, *b2);
+                            if (p1 == p2)
+                                {
+                                    return false;
+                                }
+                            in_g2 = p2 < p1;
+                        }
+                    auto &itr = in_g2 ? b2 : b1;
+                    const double pos = mutation_position(mutations, *itr);
+                    // A key at pos comes from the second parent if the
+                    // number of breakpoints < pos is odd.
+                    for (; next_breakpoint != breakpoints.cend()
+                           && *next_breakpoint < pos;
+                         ++next_breakpoint)
+                        {
+                            from_g2 = !from_g2;
+                        }
+                    if (in_g2 == from_g2)
+                        {
+                            write_inherited_key(*itr, pos, next_mutation,
+                                                new_mutations_end, mutations,
+                                                neutral, out);
+                        }
+                    ++itr;
+                }
+            for (; next_mutation != new_mutations_end; ++next_mutation)
+                {
+                    if (mutation_is_neutral(mutations, *next_mutation)
+                        == neutral)
+                        {
+                            out.push_back(*next_mutation);
+                        }
+                }
+            return true;
+        }
+
+        template <typename gamete_t, typename mcont_t>
+        inline bool
+        recombine_symmetric_difference(
+            const std::vector<uint_t> &new_mutations,
+            const std::vector<double> &breakpoints, const gamete_t &g1,
+            const gamete_t &g2, const mcont_t &mutations,
+            const differing_span &span,
+            typename gamete_t::mutation_container &neutral,
+            typename gamete_t::mutation_container &selected,
+            std::random_access_iterator_tag, std::false_type)
+        {
+            assert(span.compared);
+            const std::size_t nkeys = g1.mutations.size() + g2.mutations.size()
+                                      + g1.smutations.size()
+                                      + g2.smutations.size();
+            // Keys in the common prefixes and suffixes are counted once
+            // in span.nshared and twice in nkeys.  Shared keys dominate
+            // if those keys alone are more than half of nkeys.
+            if (nkeys == 0 || 4 * span.nshared <= nkeys)
+                {
+                    return false;
+                }
+            if (!std::is_sorted(new_mutations.cbegin(), new_mutations.cend(),
+                                [&mutations](const uint_t a, const uint_t b) {
+                                    return mutation_position(mutations, a)
+                                           < mutation_position(mutations, b);
+                                }))
+                {
+                    return false;
+                }
+            neutral.clear();
+            selected.clear();
+            if (!merge_symmetric_difference(
+                    g1.mutations.cbegin(), g1.mutations.cend(),
+                    g2.mutations.cbegin(), g2.mutations.cend(), breakpoints,
+                    new_mutations, mutations, true, neutral)
+                || !merge_symmetric_difference(
+                       g1.smutations.cbegin(), g1.smutations.cend(),
+                       g2.smutations.cbegin(), g2.smutations.cend(),
+                       breakpoints, new_mutations, mutations, false,
+                       selected))
+                {
+                    return false;
+                }
+            symmetric_difference_counter().fetch_add(
+                1, std::memory_order_relaxed);
+            return true;
+        }
+
+        template <typename gamete_t, typename mcont_t,
+                  typename iterator_category, typename common_variants>
+        inline bool
+        recombine_symmetric_difference(
+            const std::vector<uint_t> &, const std::vector<double> &,
+            const gamete_t &, const gamete_t &, const mcont_t &,
+            const differing_span &, typename gamete_t::mutation_container &,
+            typename gamete_t::mutation_container &, iterator_category,
+            common_variants)
+        // Containers with forward iterators, and gametes storing common
+        // variants as bits, are recombined by fwdpp::mutate_recombine
+        {
+            return false;
+        }
+
+        template <typename gamete_t, typename mcont_t>
+        inline bool
+        recombine_symmetric_difference(
+            const std::vector<uint_t> &new_mutations,
+            const std::vector<double> &breakpoints, const gamete_t &g1,
+            const gamete_t &g2, const mcont_t &mutations,
+            const differing_span &span,
+            typename gamete_t::mutation_container &neutral,
+            typename gamete_t::mutation_container &selected)
+        /*!
+          If most keys of \a g1 and \a g2 are carried by both, write the
+          keys of their recombinant at \a breakpoints, with \a
+          new_mutations, to \a neutral and \a selected, and return true.
+          \a span is the result of compare_parental_keys for \a g1 and
+          \a g2, which gives the number of shared keys.
+
+          Otherwise, or if the merge cannot be done this way, return
+          false.  The contents of \a neutral and \a selected are then
+          unspecified.
+        */
+        {
+            return recombine_symmetric_difference(
+                new_mutations, breakpoints, g1, g2, mutations, span, neutral,
+                selected,
+                typename std::iterator_traits<
+                    typename gamete_t::mutation_container::const_iterator>::
+                    iterator_category(),
+                typename has_common_variants<gamete_t>::type());
+        }
+
+        template <typename gamete_t, typename mcont_t>
+        inline bool
+        recombine_symmetric_difference(
+            const std::vector<uint_t> &new_mutations,
+            const std::vector<double> &breakpoints, const gamete_t &g1,
+            const gamete_t &g2, const mcont_t &mutations,
+            typename gamete_t::mutation_container &neutral,
+            typename gamete_t::mutation_container &selected)
+        /// As above, comparing the keys of \a g1 and \a g2 first
+        {
+            return recombine_symmetric_difference(
+                new_mutations, breakpoints, g1, g2, mutations,
+                compare_parental_keys(g1, g2, mutations), neutral, selected);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,375 @@
+#ifndef FWDPP_INTERNAL_THREADED_OFFSPRING_HPP
+#define FWDPP_INTERNAL_THREADED_OFFSPRING_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <vector>
+#include <gsl/gsl_rng.h>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/mutate_recombine.hpp>
+#include <fwdpp/internal/parallel_for.hpp>
+
+/*
+  Support for generating offspring gametes on more than one thread.
+
+  The work done per offspring is split into two phases:
+
+  1. A serial phase, which makes every call to the random number generator
+  and to the user's mutation and recombination policies, in the same order
+  as fwdpp::mutate_recombine_update.  The breakpoints and new mutation
+  keys of each offspring gamete are recorded in an offspring_batch.
+
+  2. A mostly parallel phase, in three steps.  First, threads compare
+  the keys of the parental gametes of each recombinant (see
+  fwdpp_internal::compare_parental_keys), which finds the offspring
+  gametes that are copies of a parent.  Second, a serial loop gives
+  every other new offspring gamete its destination.  Destinations are
+  taken from the gamete recycling bin in the same order as the serial
+  code would take them, and any extra gametes are appended to the end of
+  the gamete container.  Third, contiguous ranges of offspring are
+  assigned to threads.  Each thread splices offspring gametes together
+  using its own scratch containers, writing each result into its
+  destination.  Threads only read parental gametes and mutations and
+  only write into distinct recycled/appended slots, so no locking is
+  needed.
+
+  Because phase 1 reproduces the serial order of operations exactly, the
+  resulting population is identical to the one generated by a single
+  thread, regardless of how many threads are used.
+
+  Optionally, phase 2 may process the offspring gametes sorted by the
+  index of their first parental gamete (see sort_offspring_events),
+  so that parental gametes and their mutation keys are read in order.
+  The random number stream is not affected, because all random numbers
+  are drawn in phase 1.  The order of phase 2 does not affect the
+  result, because each offspring gamete is written to the slot assigned
+  in its second step.
+*/
+
+namespace fwdpp
+{
+    namespace fwdpp_internal
+    {
+        struct offspring_gamete_events
+        /// Everything needed to generate one offspring gamete
+        {
+            /// Parental gametes.  The offspring gamete starts with g1.
+            std::size_t g1, g2;
+            /// Range of breakpoints in offspring_batch::breakpoints
+            std::size_t bp_begin, bp_end;
+            /// Range of keys in offspring_batch::new_mutations
+            std::size_t mut_begin, mut_end;
+            /// Index of the offspring gamete in the gamete container.
+            /// Equal to g1 when there are no breakpoints or new mutations,
+            /// and to g1 or g2 when the offspring gamete is a copy of
+            /// that parent (see fwdpp_internal::parental_copy).
+            /// Unassigned, std::numeric_limits<std::size_t>::max(),
+            /// until phase 2.
+            std::size_t dest;
+            /// Comparison of the keys of g1 and g2, made in phase 2 if
+            /// there are breakpoints
+            differing_span span;
+        };
+
+        struct offspring_batch
+        /// Recombination and mutation events for a generation, stored
+        /// in flat containers.  Two records are stored per offspring.
+        {
+            std::vector<offspring_gamete_events> events;
+            std::vector<double> breakpoints;
+            std::vector<uint_t> new_mutations;
+            /// Number of new gametes that must be appended to the
+            /// gamete container.  Set in phase 2.
+            std::size_t nappended;
+            /// If not empty, phase 2 processes events[order[i]] for
+            /// i = 0 to events.size()-1.
+            std::vector<std::size_t> order;
+
+            offspring_batch() : events{}, breakpoints{}, new_mutations{},
+                                nappended(0), order{}
+            {
+            }
+
+            void
+            clear()
+            {
+                events.clear();
+                breakpoints.clear();
+                new_mutations.clear();
+                nappended = 0;
+                order.clear();
+            }
+        };
+
+        template <typename mutation_container> struct offspring_scratch
+        /// Per-thread temporary containers used in phase 2
+        {
+            mutation_container neutral, selected;
+            std::vector<double> breakpoints;
+            std::vector<uint_t> new_mutations;
+        };
+
+        template <typename T> struct preassigned_gamete_slot
+        /*!
+          A "recycling bin" holding a single slot.  Passing it to
+          fwdpp::mutate_recombine writes the new gamete into that slot.
+        */
+        {
+            using value_type = T;
+            T slot;
+            bool used;
+            explicit preassigned_gamete_slot(const T s) : slot(s), used(false)
+            {
+            }
+            bool
+            empty() const
+            {
+                return used;
+            }
+            T
+            front() const
+            {
+                return slot;
+            }
+            void
+            pop()
+            {
+                used = true;
+            }
+        };
+
+        inline void
+        record_offspring_gamete(offspring_batch &batch, const std::size_t g1,
+                                const std::size_t g2,
+                                const std::vector<double> &breakpoints,
+                                const std::vector<uint_t> &new_mutations)
+        {
+            offspring_gamete_events e;
+            e.g1 = g1;
+            e.g2 = g2;
+            e.bp_begin = batch.breakpoints.size();
+            batch.breakpoints.insert(batch.breakpoints.end(),
+                                     breakpoints.begin(), breakpoints.end());
+            e.bp_end = batch.breakpoints.size();
+            e.mut_begin = batch.new_mutations.size();
+            batch.new_mutations.insert(batch.new_mutations.end(),
+                                       new_mutations.begin(),
+                                       new_mutations.end());
+            e.mut_end = batch.new_mutations.size();
+            e.dest = (breakpoints.empty() && new_mutations.empty())
+                         ? g1
+                         : std::numeric_limits<std::size_t>::max();
+            batch.events.push_back(e);
+        }
+
+        template <typename gcont_t, typename mcont_t>
+        inline void
+        find_parental_copy(const offspring_batch &batch,
+                           offspring_gamete_events &e, const gcont_t &gametes,
+                           const mcont_t &mutations)
+        /// Phase 2, first step, for one offspring gamete.  Same rule as
+        /// fwdpp::mutate_recombine.
+        {
+            if (e.bp_begin == e.bp_end)
+                {
+                    return;
+                }
+            e.span = compare_parental_keys(gametes[e.g1], gametes[e.g2],
+                                           mutations);
+            if (e.mut_begin == e.mut_end)
+                {
+                    e.dest = parental_copy(
+                        batch.breakpoints.cbegin() + e.bp_begin,
+                        batch.breakpoints.cbegin() + e.bp_end, e.g1, e.g2,
+                        e.span);
+                }
+        }
+
+        template <typename gcont_t, typename queue_t>
+        void
+        assign_offspring_gametes(offspring_batch &batch,
+                                 const gcont_t &gametes,
+                                 queue_t &gamete_recycling_bin)
+        /// Phase 2, second step.  Same rule as fwdpp::recycle_gamete.
+        {
+            batch.nappended = 0;
+            for (auto &e : batch.events)
+                {
+                    if (e.dest != std::numeric_limits<std::size_t>::max())
+                        {
+                            continue;
+                        }
+                    if (!gamete_recycling_bin.empty())
+                        {
+                            e.dest = gamete_recycling_bin.front();
+                            gamete_recycling_bin.pop();
+                        }
+                    else
+                        {
+                            e.dest = gametes.size() + batch.nappended++;
+                        }
+                }
+        }
+
+        template <typename diploid_t, typename gcont_t, typename mcont_t,
+                  typename recmodel, typename mutmodel, typename mqueue_t>
+        void
+        record_offspring_events(
+            const gsl_rng *r, gcont_t &gametes, mcont_t &mutations,
+            std::tuple<std::size_t, std::size_t, std::size_t, std::size_t>
+                parental_gametes,
+            const recmodel &rec_pol, const mutmodel &mmodel, const double mu,
+            mqueue_t &mutation_recycling_bin, const diploid_t &dip,
+            offspring_batch &batch, reproduction_buffers &b)
+        /*!
+          Phase 1 for one offspring.  The order of operations is the same
+          as in fwdpp::mutate_recombine_update.  The events are copied
+          from \a b into \a batch.
+        */
+        {
+            auto p1g1 = std::get<0>(parental_gametes);
+            auto p1g2 = std::get<1>(parental_gametes);
+            auto p2g1 = std::get<2>(parental_gametes);
+            auto p2g2 = std::get<3>(parental_gametes);
+            generate_breakpoints(dip, p1g1, p1g2, gametes, mutations, rec_pol,
+                                 b.breakpoints);
+            generate_breakpoints(dip, p2g1, p2g2, gametes, mutations, rec_pol,
+                                 b.breakpoints2);
+            generate_new_mutations(mutation_recycling_bin, r, mu, dip,
+                                   gametes, mutations, p1g1, mmodel,
+                                   b.new_mutations);
+            generate_new_mutations(mutation_recycling_bin, r, mu, dip,
+                                   gametes, mutations, p2g1, mmodel,
+                                   b.new_mutations2);
+            record_offspring_gamete(batch, p1g1, p1g2, b.breakpoints,
+                                    b.new_mutations);
+            record_offspring_gamete(batch, p2g1, p2g2, b.breakpoints2,
+                                    b.new_mutations2);
+        }
+
+        template <typename gcont_t, typename mcont_t, typename scratch_t>
+        std::size_t
+        apply_offspring_gamete(const offspring_batch &batch,
+                               const offspring_gamete_events &e,
+                               gcont_t &gametes, const mcont_t &mutations,
+                               scratch_t &scratch)
+        {
+            if (e.dest == e.g1 || e.dest == e.g2)
+                {
+                    return e.dest;
+                }
+            scratch.breakpoints.assign(
+                batch.breakpoints.begin() + e.bp_begin,
+                batch.breakpoints.begin() + e.bp_end);
+            scratch.new_mutations.assign(
+                batch.new_mutations.begin() + e.mut_begin,
+                batch.new_mutations.begin() + e.mut_end);
+            preassigned_gamete_slot<std::size_t> slot(e.dest);
+            // The check for a parental copy was made in phase 2
+            auto rv = recombine_parental_gametes(
+                scratch.new_mutations, scratch.breakpoints, e.g1, e.g2,
+                gametes, mutations, e.span, slot, scratch.neutral,
+                scratch.selected);
+            assert(rv == e.dest);
+            return rv;
+        }
+
+        inline void
+        sort_offspring_events(offspring_batch &batch)
+        /*!
+          Fill batch.order so that phase 2 processes offspring gametes
+          sorted by the indexes of their parental gametes.
+        */
+        {
+            batch.order.resize(batch.events.size());
+            std::iota(batch.order.begin(), batch.order.end(), std::size_t(0));
+            std::sort(batch.order.begin(), batch.order.end(),
+                      [&batch](const std::size_t a, const std::size_t b) {
+                          const auto &ea = batch.events[a];
+                          const auto &eb = batch.events[b];
+                          return std::tie(ea.g1, ea.g2, a)
+                                 < std::tie(eb.g1, eb.g2, b);
+                      });
+        }
+
+        template <typename dipvector_t, typename gcont_t, typename mcont_t,
+                  typename queue_t, typename scratch_t>
+        void
+        apply_offspring_events(offspring_batch &batch, dipvector_t &diploids,
+                               gcont_t &gametes, const mcont_t &mutations,
+                               queue_t &gamete_recycling_bin,
+                               std::vector<scratch_t> &scratch,
+                               const unsigned nthreads)
+        /*!
+          Phase 2.  Offspring i is described by batch.events[2*i] and
+          batch.events[2*i+1].  The offspring gametes are assembled in
+          the order given by batch.order, if it is not empty.  On
+          return, the gamete indexes of the offspring are assigned and
+          the gamete counts are updated.
+        */
+        {
+            assert(batch.events.size() == 2 * diploids.size());
+            assert(batch.order.empty()
+                   || batch.order.size() == batch.events.size());
+            const auto nevents = batch.events.size();
+            parallel_for(
+                nthreads, nevents,
+                [&batch, &gametes, &mutations](const std::size_t,
+                                               const std::size_t begin,
+                                               const std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i)
+                        {
+                            find_parental_copy(batch, batch.events[i],
+                                               gametes, mutations);
+                        }
+                });
+            assign_offspring_gametes(batch, gametes, gamete_recycling_bin);
+            for (std::size_t i = 0; i < batch.nappended; ++i)
+                {
+                    gametes.emplace_back(
+                        0u, typename gcont_t::value_type::mutation_container(),
+                        typename gcont_t::value_type::mutation_container());
+                }
+            const auto nchunks = parallel_for_nchunks(nthreads, nevents);
+            if (scratch.size() < nchunks)
+                {
+                    scratch.resize(nchunks);
+                }
+            parallel_for(
+                nthreads, nevents,
+                [&batch, &diploids, &gametes, &mutations, &scratch](
+                    const std::size_t chunk, const std::size_t begin,
+                    const std::size_t end) {
+                    const bool sorted = !batch.order.empty();
+                    for (std::size_t i = begin; i < end; ++i)
+                        {
+                            const auto e = sorted ? batch.order[i] : i;
+                            const auto g = apply_offspring_gamete(
+                                batch, batch.events[e], gametes, mutations,
+                                scratch[chunk]);
+                            // Threads write to distinct members of
+                            // the diploids
+                            if (e % 2 == 0)
+                                {
+                                    diploids[e / 2].first = g;
+                                }
+                            else
+                                {
+                                    diploids[e / 2].second = g;
+                                }
+                        }
+                });
+            for (const auto &dip : diploids)
+                {
+                    gametes[dip.first].n++;
+                    gametes[dip.second].n++;
+                }
+        }
+    }
+}
+
+#endif
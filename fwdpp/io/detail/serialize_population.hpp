@@ -5,6 +5,7 @@
 #include <fwdpp/io/mutation.hpp>
 #include <fwdpp/io/gamete.hpp>
 #include <fwdpp/io/diploid.hpp>
+#include <fwdpp/multilocus_genotype_matrix.hpp>
 #include <fwdpp/sugar/poptypes/tags.hpp>
 #include <fwdpp/internal/sample_diploid_helpers.hpp>
 
@@ -153,12 +154,12 @@ namespace fwdpp
                 io::read_gametes(buffer, pop.gametes);
                 unsigned ndips;
                 reader(buffer, &ndips);
-                pop.diploids.resize(
-                    ndips, typename poptype::dipvector_t::value_type(nloci));
+                fwdpp_internal::resize_multilocus_diploids(pop.diploids,
+                                                           ndips, nloci);
                 io::deserialize_diploid<
                     typename poptype::dipvector_t::value_type::value_type>
                     dipreader;
-                for (auto &dip : pop.diploids)
+                for (auto &&dip : pop.diploids)
                     {
                         assert(dip.size() == nloci);
                         for (auto &genotype : dip)
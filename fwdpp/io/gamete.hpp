@@ -2,6 +2,9 @@
 #define FWDPP_IO_GAMETE_HPP__
 
 #include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
 #include <fwdpp/type_traits.hpp>
 #include "scalar_serialization.hpp"
 
@@ -9,13 +12,88 @@ namespace fwdpp
 {
     namespace io
     {
+        namespace detail
+        {
+            template <typename streamtype, typename index_t>
+            inline void
+            write_keys(const scalar_writer& writer, streamtype& buffer,
+                       const std::vector<index_t>& keys)
+            {
+                std::size_t nm = keys.size();
+                writer(buffer, &nm);
+                if (nm)
+                    {
+                        writer(buffer, keys.data(), nm);
+                    }
+            }
+
+            template <typename streamtype, typename key_container>
+            inline void
+            write_keys(const scalar_writer& writer, streamtype& buffer,
+                       const key_container& keys)
+            /// Containers that are not contiguous are written through a
+            /// buffer.  The output is the same as for std::vector.
+            {
+                std::size_t nm = keys.size();
+                writer(buffer, &nm);
+                std::vector<typename key_container::value_type> temp;
+                temp.reserve(std::min(nm, std::size_t(1024)));
+                for (const auto k : keys)
+                    {
+                        temp.push_back(k);
+                        if (temp.size() == 1024)
+                            {
+                                writer(buffer, temp.data(), temp.size());
+                                temp.clear();
+                            }
+                    }
+                if (!temp.empty())
+                    {
+                        writer(buffer, temp.data(), temp.size());
+                    }
+            }
+
+            template <typename streamtype, typename index_t>
+            inline void
+            read_keys(const scalar_reader& reader, streamtype& buffer,
+                      std::vector<index_t>& keys)
+            {
+                std::size_t nm;
+                reader(buffer, &nm);
+                if (nm)
+                    {
+                        keys.resize(nm);
+                        reader(buffer, keys.data(), nm);
+                    }
+            }
+
+            template <typename streamtype, typename key_container>
+            inline void
+            read_keys(const scalar_reader& reader, streamtype& buffer,
+                      key_container& keys)
+            {
+                std::size_t nm;
+                reader(buffer, &nm);
+                std::vector<typename key_container::value_type> temp;
+                temp.reserve(std::min(nm, std::size_t(1024)));
+                while (nm)
+                    {
+                        temp.resize(std::min(nm, std::size_t(1024)));
+                        reader(buffer, temp.data(), temp.size());
+                        keys.insert(keys.end(), temp.begin(), temp.end());
+                        nm -= temp.size();
+                    }
+            }
+        }
+
         template <typename T> struct serialize_gamete
         /// \brief Serialize a gamete
         ///
         /// Serialize a gamete. The implementation
-        /// assumes fwdpp::gamete.  If you have derived
-        /// a gamete from this type, then you must specialize
-        /// this struct.
+        /// assumes fwdpp::gamete_base, with any key container.
+        /// The output does not depend on the key container.
+        /// If you have derived a gamete from this type, then
+        /// you must specialize this struct.
         {
             scalar_writer writer;
             serialize_gamete() : writer{} {}
@@ -24,18 +102,8 @@ namespace fwdpp
             operator()(streamtype& buffer, const T& g) const
             {
                 writer(buffer, &g.n);
-                std::size_t nm = g.mutations.size();
-                writer(buffer, &nm);
-                if (nm)
-                    {
-                        writer(buffer, g.mutations.data(), nm);
-                    }
-                nm = g.smutations.size();
-                writer(buffer, &nm);
-                if (nm)
-                    {
-                        writer(buffer, g.smutations.data(), nm);
-                    }
+                detail::write_keys(writer, buffer, g.mutations);
+                detail::write_keys(writer, buffer, g.smutations);
             }
         };
 
@@ -43,7 +111,7 @@ namespace fwdpp
         /// \brief Deserialize a gamete
         ///
         /// Deserialize a gamete. The implementation
-        /// assumes fwdpp::gamete.  If you have derived
+        /// assumes fwdpp::gamete_base.  If you have derived
         /// a gamete from this type, then you must specialize
         /// this struct.
         {
@@ -54,21 +122,10 @@ namespace fwdpp
             operator()(streamtype& buffer) const
             {
                 decltype(T::n) n;
-                std::size_t nm;
                 decltype(T::mutations) mutations, smutations;
                 reader(buffer, &n);
-                reader(buffer, &nm);
-                if (nm)
-                    {
-                        mutations.resize(nm);
-                        reader(buffer, mutations.data(), nm);
-                    }
-                reader(buffer, &nm);
-                if (nm)
-                    {
-                        smutations.resize(nm);
-                        reader(buffer, smutations.data(), nm);
-                    }
+                detail::read_keys(reader, buffer, mutations);
+                detail::read_keys(reader, buffer, smutations);
                 return T(n, std::move(mutations), std::move(smutations));
             }
         };
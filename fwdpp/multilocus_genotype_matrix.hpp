@@ -0,0 +1,479 @@
+/*!
+  \file multilocus_genotype_matrix.hpp
+
+  \brief Contiguous storage of the genotypes of a multi-locus population.
+*/
+#ifndef FWDPP_MULTILOCUS_GENOTYPE_MATRIX_HPP__
+#define FWDPP_MULTILOCUS_GENOTYPE_MATRIX_HPP__
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fwdpp
+{
+    template <typename genotype_t> class multilocus_genotype_row
+    /*!
+      \brief The genotypes of one diploid, at every locus, in a
+      fwdpp::multilocus_genotype_matrix.
+
+      A view, holding a pointer to the first genotype and the number of
+      loci.  It has the interface of a std::vector of genotypes of fixed
+      size, so that it may be passed to the same fitness functions and
+      mutation and recombination policies as the diploids of the
+      multi-locus API.  Copying a row copies the view, not the
+      genotypes.  If genotype_t is const, the row is read-only.
+
+      \ingroup basicTypes
+    */
+    {
+      private:
+        genotype_t *first_;
+        std::size_t size_;
+
+      public:
+        using value_type = typename std::remove_const<genotype_t>::type;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = genotype_t &;
+        using const_reference = const value_type &;
+        using pointer = genotype_t *;
+        using iterator = genotype_t *;
+        using const_iterator = const value_type *;
+
+        multilocus_genotype_row(genotype_t *first, const std::size_t size)
+            : first_(first), size_(size)
+        {
+        }
+
+        operator multilocus_genotype_row<const value_type>() const
+        /// Conversion to a read-only row
+        {
+            return multilocus_genotype_row<const value_type>(first_, size_);
+        }
+
+        size_type
+        size() const noexcept
+        /// Number of loci
+        {
+            return size_;
+        }
+
+        bool
+        empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        pointer
+        data() const noexcept
+        {
+            return first_;
+        }
+
+        reference operator[](const size_type i) const
+        {
+            assert(i < size_);
+            return first_[i];
+        }
+
+        iterator
+        begin() const noexcept
+        {
+            return first_;
+        }
+
+        iterator
+        end() const noexcept
+        {
+            return first_ + size_;
+        }
+
+        const_iterator
+        cbegin() const noexcept
+        {
+            return first_;
+        }
+
+        const_iterator
+        cend() const noexcept
+        {
+            return first_ + size_;
+        }
+
+        template <typename other_genotype_t>
+        bool
+        operator==(
+            const multilocus_genotype_row<other_genotype_t> &rhs) const
+        /// Compare the genotypes
+        {
+            return size_ == rhs.size()
+                   && std::equal(cbegin(), cend(), rhs.cbegin());
+        }
+
+        template <typename other_genotype_t>
+        bool
+        operator!=(
+            const multilocus_genotype_row<other_genotype_t> &rhs) const
+        {
+            return !(*this == rhs);
+        }
+    };
+
+    template <typename genotype_t = std::pair<std::size_t, std::size_t>>
+    class multilocus_genotype_matrix
+    /*!
+      \brief The genotypes of N diploids at L loci, stored row-major in
+      one contiguous array.
+
+      This is an alternative to std::vector<std::vector<genotype_t>>
+      for the diploids of the multi-locus API, with one allocation for
+      the whole population instead of one per diploid.  Element i is a
+      fwdpp::multilocus_genotype_row referring to the genotypes of
+      diploid i.  Rows are returned by value, so loops over diploids
+      must use auto && or const auto &, not auto &.
+
+      fwdpp::sample_diploid, the sampling functions of the sugar layer,
+      and the serialization functions accept either layout.  See
+      fwdpp::flat_multiloc.
+
+      \ingroup basicTypes
+    */
+    {
+      public:
+        using genotype_type = genotype_t;
+        using value_type = multilocus_genotype_row<genotype_t>;
+        using reference = value_type;
+        using const_reference = multilocus_genotype_row<const genotype_t>;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+
+        template <typename row_t> class row_iterator
+        /// Random-access iterator over rows.  Dereferencing returns a row
+        /// by value.
+        {
+          private:
+            typename row_t::pointer p;
+            std::size_t nloci;
+
+          public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = row_t;
+            using difference_type = std::ptrdiff_t;
+            using reference = row_t;
+            using pointer = void;
+
+            row_iterator(typename row_t::pointer p_, const std::size_t nloci_)
+                : p(p_), nloci(nloci_)
+            {
+            }
+            reference operator*() const { return row_t(p, nloci); }
+            reference operator[](const difference_type i) const
+            {
+                return row_t(p + i * difference_type(nloci), nloci);
+            }
+            row_iterator &operator++()
+            {
+                p += nloci;
+                return *this;
+            }
+            row_iterator operator++(int)
+            {
+                auto rv = *this;
+                p += nloci;
+                return rv;
+            }
+            row_iterator &operator--()
+            {
+                p -= nloci;
+                return *this;
+            }
+            row_iterator operator--(int)
+            {
+                auto rv = *this;
+                p -= nloci;
+                return rv;
+            }
+            row_iterator &
+            operator+=(const difference_type i)
+            {
+                p += i * difference_type(nloci);
+                return *this;
+            }
+            row_iterator &
+            operator-=(const difference_type i)
+            {
+                p -= i * difference_type(nloci);
+                return *this;
+            }
+            row_iterator
+            operator+(const difference_type i) const
+            {
+                return row_iterator(p + i * difference_type(nloci), nloci);
+            }
+            row_iterator
+            operator-(const difference_type i) const
+            {
+                return row_iterator(p - i * difference_type(nloci), nloci);
+            }
+            difference_type
+            operator-(const row_iterator &rhs) const
+            {
+                return nloci ? (p - rhs.p) / difference_type(nloci) : 0;
+            }
+            bool
+            operator==(const row_iterator &rhs) const
+            {
+                return p == rhs.p;
+            }
+            bool
+            operator!=(const row_iterator &rhs) const
+            {
+                return p != rhs.p;
+            }
+            bool
+            operator<(const row_iterator &rhs) const
+            {
+                return p < rhs.p;
+            }
+            bool
+            operator>(const row_iterator &rhs) const
+            {
+                return p > rhs.p;
+            }
+            bool
+            operator<=(const row_iterator &rhs) const
+            {
+                return p <= rhs.p;
+            }
+            bool
+            operator>=(const row_iterator &rhs) const
+            {
+                return p >= rhs.p;
+            }
+            friend row_iterator
+            operator+(const difference_type i, const row_iterator &it)
+            {
+                return it + i;
+            }
+        };
+
+        using iterator = row_iterator<value_type>;
+        using const_iterator = row_iterator<const_reference>;
+
+      private:
+        std::vector<genotype_t> genotypes;
+        std::size_t nrows, ncols;
+
+      public:
+        multilocus_genotype_matrix() : genotypes{}, nrows(0), ncols(0) {}
+
+        multilocus_genotype_matrix(const std::size_t N,
+                                   const std::size_t nloci,
+                                   const genotype_t &g = genotype_t())
+            : genotypes(N * nloci, g), nrows(N), ncols(nloci)
+        {
+        }
+
+        template <typename diploids_input>
+        explicit multilocus_genotype_matrix(const diploids_input &diploids)
+            : genotypes{}, nrows(diploids.size()),
+              ncols(diploids.empty() ? 0 : diploids.begin()->size())
+        /// Copy the genotypes of a container of diploids, each of which
+        /// is a container of genotypes at ncols loci
+        {
+            genotypes.reserve(nrows * ncols);
+            for (const auto &dip : diploids)
+                {
+                    assert(dip.size() == ncols);
+                    genotypes.insert(genotypes.end(), dip.begin(), dip.end());
+                }
+        }
+
+        size_type
+        size() const noexcept
+        /// Number of diploids
+        {
+            return nrows;
+        }
+
+        bool
+        empty() const noexcept
+        {
+            return nrows == 0;
+        }
+
+        size_type
+        nloci() const noexcept
+        {
+            return ncols;
+        }
+
+        reference operator[](const size_type i)
+        {
+            assert(i < nrows);
+            return value_type(genotypes.data() + i * ncols, ncols);
+        }
+
+        const_reference operator[](const size_type i) const
+        {
+            assert(i < nrows);
+            return const_reference(genotypes.data() + i * ncols, ncols);
+        }
+
+        iterator
+        begin() noexcept
+        {
+            return iterator(genotypes.data(), ncols);
+        }
+
+        iterator
+        end() noexcept
+        {
+            return iterator(genotypes.data() + nrows * ncols, ncols);
+        }
+
+        const_iterator
+        begin() const noexcept
+        {
+            return const_iterator(genotypes.data(), ncols);
+        }
+
+        const_iterator
+        end() const noexcept
+        {
+            return const_iterator(genotypes.data() + nrows * ncols, ncols);
+        }
+
+        const_iterator
+        cbegin() const noexcept
+        {
+            return begin();
+        }
+
+        const_iterator
+        cend() const noexcept
+        {
+            return end();
+        }
+
+        genotype_t *
+        data() noexcept
+        /// The genotypes, row-major
+        {
+            return genotypes.data();
+        }
+
+        const genotype_t *
+        data() const noexcept
+        {
+            return genotypes.data();
+        }
+
+        void
+        resize(const size_type N)
+        /// Change the number of diploids, keeping the number of loci
+        {
+            genotypes.resize(N * ncols);
+            nrows = N;
+        }
+
+        void
+        resize(const size_type N, const size_type nloci)
+        /*!
+          Change the number of diploids and of loci.  If the number of
+          loci changes, the genotypes are unspecified afterwards.
+        */
+        {
+            genotypes.resize(N * nloci);
+            nrows = N;
+            ncols = nloci;
+        }
+
+        void
+        reserve(const size_type N)
+        {
+            genotypes.reserve(N * ncols);
+        }
+
+        void
+        clear() noexcept
+        /// Remove all diploids.  The number of loci is kept.
+        {
+            genotypes.clear();
+            nrows = 0;
+        }
+
+        void
+        swap(multilocus_genotype_matrix &rhs) noexcept
+        {
+            genotypes.swap(rhs.genotypes);
+            std::swap(nrows, rhs.nrows);
+            std::swap(ncols, rhs.ncols);
+        }
+
+        bool
+        operator==(const multilocus_genotype_matrix &rhs) const
+        {
+            return nrows == rhs.nrows && ncols == rhs.ncols
+                   && genotypes == rhs.genotypes;
+        }
+    };
+
+    template <typename genotype_t>
+    inline void
+    swap(multilocus_genotype_matrix<genotype_t> &a,
+         multilocus_genotype_matrix<genotype_t> &b) noexcept
+    {
+        a.swap(b);
+    }
+
+    namespace fwdpp_internal
+    {
+        template <typename dipvector_t>
+        inline void
+        resize_multilocus_diploids(dipvector_t &diploids, const std::size_t N,
+                                   const std::size_t nloci)
+        /// Resize a container of containers of genotypes
+        {
+            diploids.resize(N, typename dipvector_t::value_type(nloci));
+        }
+
+        template <typename genotype_t>
+        inline void
+        resize_multilocus_diploids(
+            multilocus_genotype_matrix<genotype_t> &diploids,
+            const std::size_t N, const std::size_t nloci)
+        {
+            diploids.resize(N, nloci);
+        }
+
+        template <typename diploid_t>
+        inline void
+        resize_loci(diploid_t &diploid, const std::size_t nloci)
+        /// Make a multi-locus diploid hold nloci genotypes
+        {
+            if (diploid.size() != nloci)
+                {
+                    diploid.resize(nloci);
+                }
+        }
+
+        template <typename genotype_t>
+        inline void
+        resize_loci(multilocus_genotype_row<genotype_t> &diploid,
+                    const std::size_t nloci)
+        // Rows of a matrix always have the right size
+        {
+            assert(diploid.size() == nloci);
+            (void)diploid;
+            (void)nloci;
+        }
+    }
+}
+
+#endif
@@ -12,15 +12,61 @@
 #include <algorithm>
 #include <cassert>
 #include <tuple>
+#include <limits>
+#include <cstdint>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
 #include <fwdpp/type_traits.hpp>
 #include <fwdpp/forward_types.hpp>
+#include <fwdpp/chunked_key_container.hpp>
 #include <fwdpp/internal/mutation_internal.hpp>
+#include <fwdpp/internal/void_t.hpp>
+#include <fwdpp/internal/mutation_columns.hpp>
 #include <fwdpp/internal/rec_gamete_updater.hpp>
+#include <fwdpp/internal/haplotype_value_cache.hpp>
+#include <fwdpp/internal/gamete_fingerprint.hpp>
+#include <fwdpp/internal/common_variant_bits.hpp>
+#include <fwdpp/internal/parental_copy.hpp>
+#include <fwdpp/internal/symmetric_difference.hpp>
 
 namespace fwdpp
 {
+    struct recombination_stats
+    /*!
+      \brief Statistics of fwdpp::mutate_recombine
+
+      \ingroup basicTypes
+    */
+    {
+        //! Number of offspring gametes with recombination breakpoints
+        //! and no new mutations that were copies of a parental gamete,
+        //! so that the parental gamete was re-used.
+        std::uint64_t parental_copies;
+        //! Number of offspring gametes whose parents shared most of
+        //! their keys, so that the keys were merged over the symmetric
+        //! difference of the parents.
+        std::uint64_t symmetric_difference_merges;
+    };
+
+    inline recombination_stats
+    recombination_statistics()
+    /// Counts since the start of the program or the last call to
+    /// fwdpp::reset_recombination_statistics, for all threads
+    {
+        recombination_stats rv;
+        rv.parental_copies = fwdpp_internal::parental_copy_counter().load();
+        rv.symmetric_difference_merges
+            = fwdpp_internal::symmetric_difference_counter().load();
+        return rv;
+    }
+
+    inline void
+    reset_recombination_statistics()
+    {
+        fwdpp_internal::parental_copy_counter().store(0);
+        fwdpp_internal::symmetric_difference_counter().store(0);
+    }
+
     template <typename recombination_policy, typename diploid_t,
               typename gamete_t, typename mcont_t>
     inline typename std::result_of<recombination_policy()>::type
@@ -57,6 +103,108 @@ namespace fwdpp
                        std::forward<mcont_t>(mutations));
     }
 
+    namespace fwdpp_internal
+    {
+        template <typename recombination_policy, typename = void>
+        struct writes_breakpoints : std::false_type
+        /// Is recombination_policy callable as void(std::vector<double>&)?
+        {
+        };
+
+        template <typename recombination_policy>
+        struct writes_breakpoints<
+            recombination_policy,
+            typename traits::internal::void_t<decltype(
+                std::declval<const recombination_policy &>()(
+                    std::declval<std::vector<double> &>()))>::type>
+            : std::is_void<decltype(
+                  std::declval<const recombination_policy &>()(
+                      std::declval<std::vector<double> &>()))>
+        // The result must be void, because objects returned by std::bind
+        // accept and ignore extra arguments.
+        {
+        };
+
+        template <typename recombination_policy, typename diploid_t,
+                  typename gamete_t, typename mcont_t>
+        inline void
+        dispatch_recombination_policy(const recombination_policy &rec_pol,
+                                      diploid_t &&, gamete_t &&, gamete_t &&,
+                                      mcont_t &&,
+                                      std::vector<double> &breakpoints,
+                                      std::true_type)
+        {
+            rec_pol(breakpoints);
+        }
+
+        template <typename recombination_policy, typename diploid_t,
+                  typename gamete_t, typename mcont_t>
+        inline void
+        dispatch_recombination_policy(const recombination_policy &rec_pol,
+                                      diploid_t &&diploid, gamete_t &&g1,
+                                      gamete_t &&g2, mcont_t &&mutations,
+                                      std::vector<double> &breakpoints,
+                                      std::false_type)
+        {
+            breakpoints = fwdpp::dispatch_recombination_policy(
+                rec_pol, std::forward<diploid_t>(diploid),
+                std::forward<gamete_t>(g1), std::forward<gamete_t>(g2),
+                std::forward<mcont_t>(mutations));
+        }
+    }
+
+    template <typename recombination_policy, typename diploid_t,
+              typename gamete_t, typename mcont_t>
+    inline void
+    dispatch_recombination_policy(const recombination_policy &rec_pol,
+                                  diploid_t &&diploid, gamete_t &&g1,
+                                  gamete_t &&g2, mcont_t &&mutations,
+                                  std::vector<double> &breakpoints)
+    /*!
+      Write the breakpoints generated by \a rec_pol into \a breakpoints.
+
+      Policies callable as void(std::vector<double> &) are expected to
+      clear the vector and then write into it, so that its capacity is
+      reused.  Any other policy is called via the overloads above and
+      its return value is moved into \a breakpoints.
+    */
+    {
+        fwdpp_internal::dispatch_recombination_policy(
+            rec_pol, std::forward<diploid_t>(diploid),
+            std::forward<gamete_t>(g1), std::forward<gamete_t>(g2),
+            std::forward<mcont_t>(mutations), breakpoints,
+            fwdpp_internal::writes_breakpoints<recombination_policy>());
+    }
+
+    template <typename recombination_policy, typename diploid_t,
+              typename gcont_t, typename mcont_t>
+    void
+    generate_breakpoints(const diploid_t &diploid, const std::size_t g1,
+                         const std::size_t g2, const gcont_t &gametes,
+                         const mcont_t &mutations,
+                         const recombination_policy &rec_pol,
+                         std::vector<double> &breakpoints)
+    /// Same as the version returning std::vector<double>, but writes
+    /// the breakpoints into \a breakpoints, which is cleared first.
+    {
+        breakpoints.clear();
+        auto nm1 = gametes[g1].mutations.size()
+                   + gametes[g1].smutations.size()
+                   + fwdpp_internal::common_variant_count(gametes[g1]);
+        auto nm2 = gametes[g2].mutations.size()
+                   + gametes[g2].smutations.size()
+                   + fwdpp_internal::common_variant_count(gametes[g2]);
+        if ((std::min(nm1, nm2) == 0 && std::max(nm1, nm2) == 1)
+            || gametes[g1] == gametes[g2])
+            {
+                return;
+            }
+        dispatch_recombination_policy(rec_pol, std::cref(diploid),
+                                      std::cref(gametes[g1]),
+                                      std::cref(gametes[g2]),
+                                      std::cref(mutations), breakpoints);
+    }
+
     template <typename recombination_policy, typename diploid_t,
               typename gcont_t, typename mcont_t>
     std::vector<double>
@@ -78,18 +226,10 @@ namespace fwdpp
     /// the breakpoints are returned and are terminated by
     /// std::numeric_limits<double>::max()
     {
-        auto nm1
-            = gametes[g1].mutations.size() + gametes[g1].smutations.size();
-        auto nm2
-            = gametes[g2].mutations.size() + gametes[g2].smutations.size();
-        if ((std::min(nm1, nm2) == 0 && std::max(nm1, nm2) == 1)
-            || gametes[g1] == gametes[g2])
-            {
-                return {};
-            }
-        return dispatch_recombination_policy(
-            std::cref(rec_pol), std::cref(diploid), std::cref(gametes[g1]),
-            std::cref(gametes[g2]), std::cref(mutations));
+        std::vector<double> breakpoints;
+        generate_breakpoints(diploid, g1, g2, gametes, mutations, rec_pol,
+                             breakpoints);
+        return breakpoints;
     }
 
     template <typename queue_type, typename mutation_model, typename diploid_t,
@@ -114,19 +254,36 @@ namespace fwdpp
     /// \return Vector of mutation keys, sorted according to position
     ///
     {
-        unsigned nm = gsl_ran_poisson(r, mu);
         std::vector<uint_t> rv;
-        rv.reserve(nm);
+        generate_new_mutations(recycling_bin, r, mu, dip, gametes, mutations,
+                               g, mmodel, rv);
+        return rv;
+    }
+
+    template <typename queue_type, typename mutation_model, typename diploid_t,
+              typename gcont_t, typename mcont_t>
+    void
+    generate_new_mutations(queue_type &recycling_bin, const gsl_rng *r,
+                           const double &mu, const diploid_t &dip,
+                           gcont_t &gametes, mcont_t &mutations,
+                           const std::size_t g, const mutation_model &mmodel,
+                           std::vector<uint_t> &keys)
+    /// Same as the version returning std::vector<uint_t>, but writes
+    /// the keys into \a keys, which is cleared first.
+    {
+        keys.clear();
+        unsigned nm = gsl_ran_poisson(r, mu);
+        keys.reserve(nm);
         for (unsigned i = 0; i < nm; ++i)
             {
-                rv.emplace_back(fwdpp_internal::mmodel_dispatcher(
+                keys.emplace_back(fwdpp_internal::mmodel_dispatcher(
                     mmodel, dip, gametes[g], mutations, recycling_bin));
             }
-        std::sort(rv.begin(), rv.end(),
+        std::sort(keys.begin(), keys.end(),
                   [&mutations](const uint_t a, const uint_t b) {
-                      return mutations[a].pos < mutations[b].pos;
+                      return fwdpp_internal::mutation_position(mutations, a)
+                             < fwdpp_internal::mutation_position(mutations, b);
                   });
-        return rv;
     }
 
     namespace fwdpp_internal
@@ -139,11 +296,8 @@ namespace fwdpp
                             const mcont_t &mutations, container &c)
         // Inserts mutation key into c such that sort order is maintained
         {
-            auto t = std::upper_bound(
-                beg, end, mutations[mut_key].pos,
-                [&mutations](const double &v, const uint_t mut) noexcept {
-                    return v < mutations[mut].pos;
-                });
+            auto t = rec_update_itr(beg, end, mutations,
+                                    mutation_position(mutations, mut_key));
             c.insert(c.end(), beg, t);
             c.push_back(mut_key);
             return t;
@@ -163,6 +317,300 @@ namespace fwdpp
             selected.reserve(std::max(gametes[g1].smutations.size(),
                                       gametes[g2].smutations.size()));
         }
+
+        template <std::size_t chunk_size> struct chunked_key_cursor
+        // Position in the blocks of a parental chunked_key_container
+        {
+            const chunked_key_container<chunk_size> &keys;
+            std::size_t block, offset;
+            explicit chunked_key_cursor(
+                const chunked_key_container<chunk_size> &k)
+                : keys(k), block(0), offset(0)
+            {
+            }
+        };
+
+        template <std::size_t chunk_size, typename mcont_t>
+        void
+        advance_chunked_key_cursor(chunked_key_cursor<chunk_size> &c,
+                                   const mcont_t &mutations, const double val,
+                                   chunked_key_container<chunk_size> *out)
+        // Move c past all keys at positions <= val, appending them
+        // to out unless it is nullptr.  Whole blocks are shared.
+        {
+            using container_t = chunked_key_container<chunk_size>;
+            const auto &blocks = c.keys.blocks();
+            const auto pos_less
+                = [&mutations](const double v,
+                               const typename container_t::value_type k) {
+                      return v < mutation_position(mutations, k);
+                  };
+            // First block whose last key is at a position > val
+            const auto last = std::upper_bound(
+                blocks.begin() + c.block, blocks.end(), val,
+                [&pos_less](const double v,
+                            const typename container_t::block_pointer &b) {
+                    return pos_less(v, b->back());
+                });
+            const std::size_t lb = last - blocks.begin();
+            if (out != nullptr)
+                {
+                    for (auto b = c.block; b < lb; ++b)
+                        {
+                            if (c.offset)
+                                {
+                                    out->insert(out->end(),
+                                                blocks[b]->begin() + c.offset,
+                                                blocks[b]->end());
+                                    c.offset = 0;
+                                }
+                            else
+                                {
+                                    out->append_block(blocks[b]);
+                                }
+                        }
+                }
+            if (lb != c.block)
+                {
+                    c.block = lb;
+                    c.offset = 0;
+                }
+            if (lb < blocks.size())
+                {
+                    const auto &b = *blocks[lb];
+                    const auto e = std::upper_bound(b.begin() + c.offset,
+                                                    b.end(), val, pos_less);
+                    if (out != nullptr)
+                        {
+                            out->insert(out->end(), b.begin() + c.offset, e);
+                        }
+                    c.offset = e - b.begin();
+                }
+        }
+
+        template <std::size_t chunk_size, typename mcont_t>
+        void
+        splice_chunked_keys(const std::vector<uint_t> &new_mutations,
+                            const std::vector<double> &breakpoints,
+                            const chunked_key_container<chunk_size> &k1,
+                            const chunked_key_container<chunk_size> &k2,
+                            const mcont_t &mutations, const bool neutral,
+                            chunked_key_container<chunk_size> &out)
+        // Same result as the loop in fwdpp::mutate_recombine, for
+        // the neutral or the selected keys
+        {
+            static const std::vector<double> no_breakpoints(
+                1, std::numeric_limits<double>::max());
+            const auto &bp = (breakpoints.empty()) ? no_breakpoints
+                                                   : breakpoints;
+            out.clear();
+            chunked_key_container<chunk_size> *const skip = nullptr;
+            chunked_key_cursor<chunk_size> c1(k1), c2(k2);
+            auto current = &c1, other = &c2;
+            auto next_mutation = new_mutations.cbegin();
+            for (const auto b : bp)
+                {
+                    for (; next_mutation != new_mutations.cend()
+                           && mutation_position(mutations, *next_mutation) < b;
+                         ++next_mutation)
+                        {
+                            if (mutation_is_neutral(mutations, *next_mutation)
+                                != neutral)
+                                {
+                                    continue;
+                                }
+                            const auto pos
+                                = mutation_position(mutations, *next_mutation);
+                            advance_chunked_key_cursor(*current, mutations,
+                                                       pos, &out);
+                            advance_chunked_key_cursor(*other, mutations, pos,
+                                                       skip);
+                            out.push_back(*next_mutation);
+                        }
+                    advance_chunked_key_cursor(*current, mutations, b, &out);
+                    advance_chunked_key_cursor(*other, mutations, b, skip);
+                    std::swap(current, other);
+                }
+        }
+
+        template <typename gamete_t, typename mcont_t, typename key_container>
+        inline bool
+        splice_shared_keys(const std::vector<uint_t> &,
+                           const std::vector<double> &, const gamete_t &,
+                           const gamete_t &, const mcont_t &, key_container &,
+                           key_container &)
+        // Keys that cannot be shared are handled by mutate_recombine
+        {
+            return false;
+        }
+
+        template <typename gamete_t, typename mcont_t, std::size_t chunk_size>
+        inline bool
+        splice_shared_keys(const std::vector<uint_t> &new_mutations,
+                           const std::vector<double> &breakpoints,
+                           const gamete_t &g1, const gamete_t &g2,
+                           const mcont_t &mutations,
+                           chunked_key_container<chunk_size> &neutral,
+                           chunked_key_container<chunk_size> &selected)
+        {
+            splice_chunked_keys(new_mutations, breakpoints, g1.mutations,
+                                g2.mutations, mutations, true, neutral);
+            splice_chunked_keys(new_mutations, breakpoints, g1.smutations,
+                                g2.smutations, mutations, false, selected);
+            return true;
+        }
+    }
+
+    namespace fwdpp_internal
+    {
+        template <typename gcont_t, typename mcont_t, typename queue_type>
+        uint_t
+        recombine_parental_gametes(
+            const std::vector<uint_t> &new_mutations,
+            const std::vector<double> &breakpoints, const std::size_t g1,
+            const std::size_t g2, gcont_t &gametes, mcont_t &mutations,
+            const differing_span &span, queue_type &gamete_recycling_bin,
+            typename gcont_t::value_type::mutation_container &neutral,
+            typename gcont_t::value_type::mutation_container &selected)
+        /*!
+          fwdpp::mutate_recombine, once the offspring gamete is known not
+          to be a parent.  If there are breakpoints, \a span is the
+          result of compare_parental_keys for gametes[g1] and
+          gametes[g2].
+        */
+        {
+            if (splice_shared_keys(new_mutations, breakpoints, gametes[g1],
+                                   gametes[g2], mutations, neutral,
+                                   selected))
+                {
+                    // The gamete's keys re-use blocks of its parents.
+                    // See fwdpp::chunked_key_container.
+                    auto idx = recycle_gamete(gametes, gamete_recycling_bin,
+                                              neutral, selected);
+                    update_cached_value(gametes[idx], mutations);
+                    update_fingerprint(gametes[idx]);
+                    return idx;
+                }
+            else if (breakpoints.empty()) // only mutations to deal with
+                {
+                    prep_temporary_containers(g1, g2, gametes, neutral,
+                                              selected);
+                    auto nb = gametes[g1].mutations.begin(),
+                         sb = gametes[g1].smutations.begin();
+                    const auto ne = gametes[g1].mutations.end(),
+                               se = gametes[g1].smutations.end();
+                    for (auto &&m : new_mutations)
+                        {
+                            if (mutation_is_neutral(mutations, m))
+                                {
+                                    nb = insert_new_mutation(
+                                        nb, ne, m, mutations, neutral);
+                                }
+                            else
+                                {
+                                    sb = insert_new_mutation(
+                                        sb, se, m, mutations, selected);
+                                }
+                        }
+                    neutral.insert(neutral.end(), nb, ne);
+                    selected.insert(selected.end(), sb, se);
+
+                    auto idx = recycle_gamete(gametes, gamete_recycling_bin,
+                                              neutral, selected);
+                    // No-op unless gametes cache their haplotype values
+                    derive_cached_value(gametes[idx], gametes[g1],
+                                        new_mutations, mutations);
+                    // No-op unless gametes store fingerprints
+                    derive_fingerprint(gametes[idx], gametes[g1],
+                                       new_mutations);
+                    // No-op unless gametes store common variants as bits
+                    recombine_common_variants(gametes[idx], gametes[g1],
+                                              gametes[g2], breakpoints);
+                    return idx;
+                }
+            // If we get here, there are mutations and
+            // recombinations to handle
+            if (recombine_symmetric_difference(
+                    new_mutations, breakpoints, gametes[g1], gametes[g2],
+                    mutations, span, neutral, selected))
+                {
+                    // The parents share most of their keys, which were
+                    // written once each.
+                    auto idx = recycle_gamete(gametes, gamete_recycling_bin,
+                                              neutral, selected);
+                    update_cached_value(gametes[idx], mutations);
+                    update_fingerprint(gametes[idx]);
+                    return idx;
+                }
+            prep_temporary_containers(g1, g2, gametes, neutral, selected);
+
+            auto itr = gametes[g1].mutations.cbegin();
+            auto jtr = gametes[g2].mutations.cbegin();
+            auto itr_s = gametes[g1].smutations.cbegin();
+            auto jtr_s = gametes[g2].smutations.cbegin();
+            auto itr_e = gametes[g1].mutations.cend();
+            auto itr_s_e = gametes[g1].smutations.cend();
+            auto jtr_e = gametes[g2].mutations.cend();
+            auto jtr_s_e = gametes[g2].smutations.cend();
+
+            // Binary searches unless breakpoints are dense along the
+            // parents
+            const bool gallop = gallop_rec_update(
+                std::max(gametes[g1].mutations.size(),
+                         gametes[g2].mutations.size()),
+                breakpoints.size() + new_mutations.size());
+            auto next_mutation = new_mutations.cbegin();
+            for (auto i = breakpoints.cbegin(); i != breakpoints.cend();)
+                {
+                    if (next_mutation != new_mutations.cend()
+                        && mutation_position(mutations, *next_mutation) < *i)
+                        {
+                            const auto pos
+                                = mutation_position(mutations, *next_mutation);
+                            itr = rec_gam_updater(itr, itr_e, mutations,
+                                                  neutral, pos, gallop);
+                            itr_s = rec_gam_updater(itr_s, itr_s_e, mutations,
+                                                    selected, pos, gallop);
+                            jtr = rec_update_itr(jtr, jtr_e, mutations, pos,
+                                                 gallop);
+                            jtr_s = rec_update_itr(jtr_s, jtr_s_e, mutations,
+                                                   pos, gallop);
+                            if (mutation_is_neutral(mutations, *next_mutation))
+                                {
+                                    neutral.push_back(*next_mutation);
+                                }
+                            else
+                                {
+                                    selected.push_back(*next_mutation);
+                                }
+                            ++next_mutation;
+                        }
+                    else
+                        {
+                            itr = rec_gam_updater(itr, itr_e, mutations,
+                                                  neutral, *i, gallop);
+                            itr_s = rec_gam_updater(itr_s, itr_s_e, mutations,
+                                                    selected, *i, gallop);
+                            jtr = rec_update_itr(jtr, jtr_e, mutations, *i,
+                                                 gallop);
+                            jtr_s = rec_update_itr(jtr_s, jtr_s_e, mutations,
+                                                   *i, gallop);
+                            std::swap(itr, jtr);
+                            std::swap(itr_s, jtr_s);
+                            std::swap(itr_e, jtr_e);
+                            std::swap(itr_s_e, jtr_s_e);
+                            ++i;
+                        }
+                }
+            assert(next_mutation == new_mutations.cend());
+            auto idx = recycle_gamete(gametes, gamete_recycling_bin, neutral,
+                                      selected);
+            update_cached_value(gametes[idx], mutations);
+            update_fingerprint(gametes[idx]);
+            recombine_common_variants(gametes[idx], gametes[g1], gametes[g2],
+                                      breakpoints);
+            return idx;
+        }
     }
 
     template <typename gcont_t, typename mcont_t, typename queue_type>
@@ -184,11 +632,16 @@ namespace fwdpp
     /// \param g2 Parental gamete 2
     /// \param gametes The vector of gametes in the population
     /// \param mutation The vector of mutations in the population
-    /// \param gamete_recycling_bin FIFO queue for gamete recycling
+    /// \param gamete_recycling_bin Recycling bin for gametes
     /// \param neutral Temporary container for updating neutral mutations
     /// \param selected Temporary container for updatng selected positions
     ///
     /// \return The index of the new offspring gamete in \a gametes.
+    /// This is \a g1 if there are neither breakpoints nor new mutations.
+    /// Without new mutations, it is \a g1 or \a g2 if the breakpoints
+    /// fall outside of the range of positions at which the two gametes
+    /// differ, so that the offspring gamete would be a copy of that
+    /// parent.  See fwdpp::recombination_statistics.
     ///
     /// \note For efficiency, it is helpful if \a new_mutations is sorted
     /// by mutation position.  fwdpp::generate_new_mutations exists to help in
@@ -204,107 +657,70 @@ namespace fwdpp
             {
                 return g1;
             }
-        else if (breakpoints.empty()) // only mutations to deal with
-            {
-                fwdpp_internal::prep_temporary_containers(g1, g2, gametes,
-                                                          neutral, selected);
-                auto nb = gametes[g1].mutations.begin(),
-                     sb = gametes[g1].smutations.begin();
-                const auto ne = gametes[g1].mutations.end(),
-                           se = gametes[g1].smutations.end();
-                for (auto &&m : new_mutations)
-                    {
-                        if (mutations[m].neutral)
-                            {
-                                nb = fwdpp_internal::insert_new_mutation(
-                                    nb, ne, m, mutations, neutral);
-                            }
-                        else
-                            {
-                                sb = fwdpp_internal::insert_new_mutation(
-                                    sb, se, m, mutations, selected);
-                            }
-                    }
-                neutral.insert(neutral.end(), nb, ne);
-                selected.insert(selected.end(), sb, se);
-
-                return fwdpp_internal::recycle_gamete(
-                    gametes, gamete_recycling_bin, neutral, selected);
-            }
-        // If we get here, there are mutations and
-        // recombinations to handle
-        fwdpp_internal::prep_temporary_containers(g1, g2, gametes, neutral,
-                                                  selected);
-
-        auto itr = gametes[g1].mutations.cbegin();
-        auto jtr = gametes[g2].mutations.cbegin();
-        auto itr_s = gametes[g1].smutations.cbegin();
-        auto jtr_s = gametes[g2].smutations.cbegin();
-        auto itr_e = gametes[g1].mutations.cend();
-        auto itr_s_e = gametes[g1].smutations.cend();
-        auto jtr_e = gametes[g2].mutations.cend();
-        auto jtr_s_e = gametes[g2].smutations.cend();
-
-        auto next_mutation = new_mutations.cbegin();
-        for (auto i = breakpoints.cbegin(); i != breakpoints.cend();)
+        fwdpp_internal::differing_span span;
+        if (!breakpoints.empty())
             {
-                if (next_mutation != new_mutations.cend()
-                    && mutations[*next_mutation].pos < *i)
+                // The keys of the parents are compared once, for the
+                // check below and for the merge.
+                span = fwdpp_internal::compare_parental_keys(
+                    gametes[g1], gametes[g2], mutations);
+                if (new_mutations.empty())
                     {
-                        const auto mut = &mutations[*next_mutation];
-                        itr = fwdpp_internal::rec_gam_updater(
-                            itr, itr_e, mutations, neutral, mut->pos);
-                        itr_s = fwdpp_internal::rec_gam_updater(
-                            itr_s, itr_s_e, mutations, selected, mut->pos);
-                        jtr = fwdpp_internal::rec_update_itr(
-                            jtr, jtr_e, mutations, mut->pos);
-                        jtr_s = fwdpp_internal::rec_update_itr(
-                            jtr_s, jtr_s_e, mutations, mut->pos);
-                        if (mut->neutral)
-                            {
-                                neutral.push_back(*next_mutation);
-                            }
-                        else
+                        // Breakpoints outside of the range of positions
+                        // at which the parents differ give a copy of a
+                        // parent.
+                        const auto p = fwdpp_internal::parental_copy(
+                            breakpoints.cbegin(), breakpoints.cend(), g1, g2,
+                            span);
+                        if (p != std::numeric_limits<std::size_t>::max())
                             {
-                                selected.push_back(*next_mutation);
+                                return p;
                             }
-                        ++next_mutation;
-                    }
-                else
-                    {
-                        itr = fwdpp_internal::rec_gam_updater(
-                            itr, itr_e, mutations, neutral, *i);
-                        itr_s = fwdpp_internal::rec_gam_updater(
-                            itr_s, itr_s_e, mutations, selected, *i);
-                        jtr = fwdpp_internal::rec_update_itr(jtr, jtr_e,
-                                                             mutations, *i);
-                        jtr_s = fwdpp_internal::rec_update_itr(jtr_s, jtr_s_e,
-                                                               mutations, *i);
-                        std::swap(itr, jtr);
-                        std::swap(itr_s, jtr_s);
-                        std::swap(itr_e, jtr_e);
-                        std::swap(itr_s_e, jtr_s_e);
-                        ++i;
                     }
             }
-        assert(next_mutation == new_mutations.cend());
-        return fwdpp_internal::recycle_gamete(gametes, gamete_recycling_bin,
-                                              neutral, selected);
+        return fwdpp_internal::recombine_parental_gametes(
+            new_mutations, breakpoints, g1, g2, gametes, mutations, span,
+            gamete_recycling_bin, neutral, selected);
     }
 
+    struct reproduction_buffers
+    /*!
+      \brief Containers for the breakpoints and new mutation keys of one
+      offspring.
+
+      Keeping one of these for the lifetime of a loop over offspring,
+      and passing it to fwdpp::mutate_recombine_update, lets the
+      containers keep their capacity, so that generating an offspring
+      does not allocate memory once the capacity is large enough.
+    */
+    {
+        std::vector<double> breakpoints, breakpoints2;
+        std::vector<uint_t> new_mutations, new_mutations2;
+        //! Locus boundaries with crossovers, for fwdpp::interlocus_map
+        std::vector<std::size_t> interlocus_breakpoints,
+            interlocus_breakpoints2;
+        reproduction_buffers()
+            : breakpoints{}, breakpoints2{}, new_mutations{},
+              new_mutations2{}, interlocus_breakpoints{},
+              interlocus_breakpoints2{}
+        {
+        }
+    };
+
     template <typename diploid_t, typename gcont_t, typename mcont_t,
-              typename recmodel, typename mutmodel>
+              typename recmodel, typename mutmodel, typename gqueue_t>
     std::tuple<std::size_t, std::size_t, std::size_t, std::size_t>
     mutate_recombine_update(
         const gsl_rng *r, gcont_t &gametes, mcont_t &mutations,
         std::tuple<std::size_t, std::size_t, std::size_t, std::size_t>
             parental_gametes,
         const recmodel &rec_pol, const mutmodel &mmodel, const double mu,
-        typename traits::recycling_bin_t<gcont_t> &gamete_recycling_bin,
+        gqueue_t &gamete_recycling_bin,
         typename traits::recycling_bin_t<mcont_t> &mutation_recycling_bin,
         diploid_t &dip,
         typename gcont_t::value_type::mutation_container &neutral,
-        typename gcont_t::value_type::mutation_container &selected)
+        typename gcont_t::value_type::mutation_container &selected,
+        reproduction_buffers &buffers)
     ///
     /// "Convenience" function for generating offspring gametes.
     ///
@@ -318,11 +734,12 @@ namespace fwdpp
     /// \param parental_gametes Tuple of gamete keys for each parent
     /// \param rec_pol Policy to generate recombination breakpoints
     /// \param mmodel Policy to generate new mutations
-    /// \param gamete_recycling_bin FIFO queue for gamete recycling
-    /// \param mutation_recycling_bin FIFO queue for mutation recycling
+    /// \param gamete_recycling_bin Recycling bin for gametes
+    /// \param mutation_recycling_bin Recycling bin for mutations
     /// \param dip The offspring
     /// \param neutral Temporary container for updating neutral mutations
     /// \param selected Temporary container for updating selected mutations
+    /// \param buffers Temporary containers for breakpoints and new mutations
     ///
     /// \return Number of recombination breakpoints and mutations for each
     /// gamete.
@@ -347,18 +764,21 @@ namespace fwdpp
         // The breakpoints are of type std::vector<double>, and
         // the new_mutations are std::vector<fwdpp::uint_t>, with
         // the integers representing the locations of the new mutations
-        // in "mutations".
-
-        auto breakpoints = generate_breakpoints(dip, p1g1, p1g2, gametes,
-                                                mutations, rec_pol);
-        auto breakpoints2 = generate_breakpoints(dip, p2g1, p2g2, gametes,
-                                                 mutations, rec_pol);
-        auto new_mutations
-            = generate_new_mutations(mutation_recycling_bin, r, mu, dip,
-                                     gametes, mutations, p1g1, mmodel);
-        auto new_mutations2
-            = generate_new_mutations(mutation_recycling_bin, r, mu, dip,
-                                     gametes, mutations, p2g1, mmodel);
+        // in "mutations".  They are written into the containers
+        // held by "buffers", so that their capacity is reused.
+
+        auto &breakpoints = buffers.breakpoints;
+        auto &breakpoints2 = buffers.breakpoints2;
+        auto &new_mutations = buffers.new_mutations;
+        auto &new_mutations2 = buffers.new_mutations2;
+        generate_breakpoints(dip, p1g1, p1g2, gametes, mutations, rec_pol,
+                             breakpoints);
+        generate_breakpoints(dip, p2g1, p2g2, gametes, mutations, rec_pol,
+                             breakpoints2);
+        generate_new_mutations(mutation_recycling_bin, r, mu, dip, gametes,
+                               mutations, p1g1, mmodel, new_mutations);
+        generate_new_mutations(mutation_recycling_bin, r, mu, dip, gametes,
+                               mutations, p2g1, mmodel, new_mutations2);
 
         // Pass the breakpoints and new mutation keys on to
         // fwdpp::mutate_recombine (defined in
@@ -386,6 +806,29 @@ namespace fwdpp
         return std::make_tuple(nrec, nrec2, new_mutations.size(),
                                new_mutations2.size());
     }
+
+    template <typename diploid_t, typename gcont_t, typename mcont_t,
+              typename recmodel, typename mutmodel, typename gqueue_t>
+    std::tuple<std::size_t, std::size_t, std::size_t, std::size_t>
+    mutate_recombine_update(
+        const gsl_rng *r, gcont_t &gametes, mcont_t &mutations,
+        std::tuple<std::size_t, std::size_t, std::size_t, std::size_t>
+            parental_gametes,
+        const recmodel &rec_pol, const mutmodel &mmodel, const double mu,
+        gqueue_t &gamete_recycling_bin,
+        typename traits::recycling_bin_t<mcont_t> &mutation_recycling_bin,
+        diploid_t &dip,
+        typename gcont_t::value_type::mutation_container &neutral,
+        typename gcont_t::value_type::mutation_container &selected)
+    /// Same as the version taking fwdpp::reproduction_buffers, using
+    /// temporary containers that are freed on return.
+    {
+        reproduction_buffers buffers;
+        return mutate_recombine_update(
+            r, gametes, mutations, parental_gametes, rec_pol, mmodel, mu,
+            gamete_recycling_bin, mutation_recycling_bin, dip, neutral,
+            selected, buffers);
+    }
 }
 
 #endif
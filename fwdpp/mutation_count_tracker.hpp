@@ -0,0 +1,266 @@
+#ifndef FWDPP_MUTATION_COUNT_TRACKER_HPP__
+#define FWDPP_MUTATION_COUNT_TRACKER_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/fwd_functional.hpp>
+#include <fwdpp/internal/common_variant_bits.hpp>
+
+namespace fwdpp
+{
+    class mutation_count_tracker
+    /*!
+      \brief Maintain mutation counts from changes in gamete counts.
+
+      fwdpp_internal::process_gametes recalculates the count of every
+      mutation from every extant gamete each generation.  Most gametes
+      are carried over from one generation to the next with unchanged
+      mutations, and only their counts change.  This class instead
+      keeps the gamete counts seen at the previous update, and adds
+      new n - old n to the count of each mutation in each gamete whose
+      count changed.  Recycled and newly-created gametes have an old
+      count of zero, meaning that their mutations are added in full.
+
+      The cost is proportional to the number of mutations in gametes
+      whose counts changed, plus a pass over the gametes and mutations
+      that touches no mutation keys.
+
+      This class is used by the versions of fwdpp::sample_diploid that
+      take a fwdpp::generation_workspace when
+      generation_workspace::incremental_mutation_counts is true.  The
+      results are identical to those of process_gametes.
+
+      The counts are correct provided that the mutations carried by a
+      gamete only change when that gamete is extinct, which is the case
+      for fwdpp::sample_diploid (including the removal of fixations),
+      fwdpp::add_mutation and fwdpp::change_neutral.  If a population
+      is modified in any other way, call reset() to force a complete
+      recount at the next update.
+    */
+    {
+      private:
+        // Mutation counts maintained by this object.  The user's
+        // counts are a copy, because fwdpp::update_mutations and
+        // friends set the counts of fixations to zero.
+        std::vector<uint_t> counts;
+        // Gamete counts at the last update.
+        std::vector<uint_t> previous_n;
+        bool initialized;
+        std::uint64_t nrescans, ngametes_updated, nkeys_updated;
+
+        template <typename key_container>
+        void
+        add_keys(const key_container &keys, const uint_t delta)
+        // delta may "wrap", which subtracts
+        {
+            for (auto k : keys)
+                {
+                    counts[k] += delta;
+                }
+            nkeys_updated += keys.size();
+        }
+
+        template <typename gamete_t>
+        void
+        add_gamete(const gamete_t &g, const uint_t delta)
+        {
+            add_keys(g.mutations, delta);
+            add_keys(g.smutations, delta);
+            fwdpp_internal::add_common_variant_counts(g, delta,
+                                                      counts.data());
+        }
+
+        template <typename gcont_t, typename mcont_t>
+        void
+        rescan(const gcont_t &gametes, const mcont_t &mutations)
+        {
+            counts.assign(mutations.size(), 0);
+            previous_n.resize(gametes.size());
+            for (std::size_t i = 0; i < gametes.size(); ++i)
+                {
+                    const auto n = gametes[i].n;
+                    previous_n[i] = n;
+                    if (n)
+                        {
+                            add_keys(gametes[i].mutations, n);
+                            add_keys(gametes[i].smutations, n);
+                        }
+                }
+            fwdpp_internal::add_common_variant_column_counts(
+                gametes.begin(), gametes.end(), counts.data());
+            initialized = true;
+            ++nrescans;
+        }
+
+        template <typename mcont_t>
+        bool
+        is_removed(const mcont_t &, const std::size_t, const uint_t,
+                   const fwdpp::remove_nothing &) const
+        {
+            return false;
+        }
+
+        template <typename mcont_t>
+        bool
+        is_removed(const mcont_t &, const std::size_t i, const uint_t twoN,
+                   const std::true_type &) const
+        {
+            return counts[i] == twoN;
+        }
+
+        template <typename mcont_t, typename mutation_removal_policy>
+        bool
+        is_removed(const mcont_t &mutations, const std::size_t i,
+                   const uint_t twoN, const mutation_removal_policy &mp) const
+        {
+            return counts[i] == twoN && mp(mutations[i]);
+        }
+
+      public:
+        mutation_count_tracker()
+            : counts{}, previous_n{}, initialized(false), nrescans(0),
+              ngametes_updated(0), nkeys_updated(0)
+        {
+        }
+
+        void
+        reset()
+        /// The next update will recount all mutations.
+        {
+            initialized = false;
+        }
+
+        bool
+        is_initialized() const
+        {
+            return initialized;
+        }
+
+        template <typename gcont_t>
+        void
+        retire_extinct(const gcont_t &gametes)
+        /*!
+          Remove the contributions of extinct gametes.  Must be called
+          before extinct gametes are recycled, which
+          fwdpp::sample_diploid takes care of.  This handles gametes
+          made extinct by other means since the last update, such as
+          fwdpp::add_mutation.
+        */
+        {
+            if (!initialized)
+                {
+                    return;
+                }
+            const auto ng = std::min(gametes.size(), previous_n.size());
+            for (std::size_t i = 0; i < ng; ++i)
+                {
+                    if (!gametes[i].n && previous_n[i])
+                        {
+                            // Subtract, via unsigned wrapping
+                            add_gamete(gametes[i], uint_t(0) - previous_n[i]);
+                            previous_n[i] = 0;
+                            ++ngametes_updated;
+                        }
+                }
+        }
+
+        template <typename gcont_t, typename mcont_t>
+        void
+        update(const gcont_t &gametes, const mcont_t &mutations,
+               std::vector<uint_t> &mcounts)
+        /*!
+          Update the counts and copy them into \a mcounts.  Same result as
+          fwdpp_internal::process_gametes.
+        */
+        {
+            if (!initialized || gametes.size() < previous_n.size())
+                {
+                    rescan(gametes, mutations);
+                }
+            else
+                {
+                    counts.resize(mutations.size(), 0);
+                    previous_n.resize(gametes.size(), 0);
+                    for (std::size_t i = 0; i < gametes.size(); ++i)
+                        {
+                            const auto n = gametes[i].n;
+                            if (n != previous_n[i])
+                                {
+                                    const uint_t delta = n - previous_n[i];
+                                    add_gamete(gametes[i], delta);
+                                    previous_n[i] = n;
+                                    ++ngametes_updated;
+                                }
+                        }
+                }
+            if (mcounts.size() < counts.size())
+                {
+                    mcounts.resize(counts.size());
+                }
+            std::copy(counts.begin(), counts.end(), mcounts.begin());
+            std::fill(mcounts.begin() + counts.size(), mcounts.end(), 0);
+        }
+
+        template <typename mcont_t, typename mutation_removal_policy>
+        void
+        remove_fixations(const mcont_t &mutations, const uint_t twoN,
+                         const mutation_removal_policy &mp)
+        /*!
+          Set the counts of the mutations that
+          fwdpp_internal::gamete_cleaner has just removed from all
+          gametes to zero.  \a twoN and \a mp must be the same as passed
+          to gamete_cleaner.
+
+          The user's mutation counts are not changed, meaning that the
+          fixations are still seen by fwdpp::update_mutations.
+        */
+        {
+            if (std::is_same<mutation_removal_policy,
+                             fwdpp::remove_nothing>::value)
+                {
+                    return;
+                }
+            for (std::size_t i = 0; i < counts.size(); ++i)
+                {
+                    if (is_removed(mutations, i, twoN, mp))
+                        {
+                            counts[i] = 0;
+                        }
+                }
+        }
+
+        const std::vector<uint_t> &
+        mutation_counts() const
+        /// The counts maintained by this object
+        {
+            return counts;
+        }
+
+        std::uint64_t
+        rescans() const
+        /// Number of complete recounts
+        {
+            return nrescans;
+        }
+
+        std::uint64_t
+        gametes_updated() const
+        /// Number of gametes whose counts changed between updates
+        {
+            return ngametes_updated;
+        }
+
+        std::uint64_t
+        keys_updated() const
+        /// Number of mutation keys visited, including complete recounts
+        {
+            return nkeys_updated;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef FWDPP_PARENT_SAMPLER_HPP__
+#define FWDPP_PARENT_SAMPLER_HPP__
+
+#include <vector>
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+#include <gsl/gsl_rng.h>
+
+namespace fwdpp
+{
+    class parent_sampler
+    /*!
+      \brief Sample parents proportional to their fitnesses.
+
+      fwdpp::sample_diploid builds a lookup table from the parental
+      fitnesses each generation and then draws parents from it.  By
+      default, that table is a gsl_ran_discrete_t, which is allocated
+      and freed every generation.  Passing a parent_sampler to
+      fwdpp::sample_diploid replaces the GSL table by one of the
+      following engines:
+
+      1. engine::uniform: all fitnesses are equal, and parents are
+      drawn with gsl_rng_uniform_int.  No preprocessing is needed.
+      2. engine::stochastic_acceptance: a parent i is proposed uniformly
+      and accepted with probability w[i]/max(w).  No preprocessing
+      is needed, and the expected number of proposals per draw is
+      max(w)/mean(w).
+      3. engine::alias: Walker/Vose alias table.  The storage for the
+      table is kept between generations.
+
+      When constructed with engine::automatic (the default), the engine
+      is picked each generation from the mean, minimum and maximum of
+      the fitnesses.  Stochastic acceptance is used when
+      max(w)/mean(w) does not exceed the acceptance threshold.
+
+      \note The random number stream differs from that of
+      gsl_ran_discrete, so results will differ from simulations
+      not using a parent_sampler.
+
+      \note Custom samplers may be passed to fwdpp::sample_diploid
+      instead of this class.  They must provide the same
+      update and operator() member functions.
+    */
+    {
+      public:
+        enum class engine
+        {
+            automatic,
+            uniform,
+            stochastic_acceptance,
+            alias
+        };
+
+      private:
+        engine requested, current;
+        double threshold;
+        const double *weights;
+        std::size_t n;
+        double wmax;
+        // alias table, reused between generations
+        std::vector<double> prob;
+        std::vector<std::size_t> alias, small, large;
+
+        void
+        build_alias_table(const double wsum)
+        {
+            prob.resize(n);
+            alias.resize(n);
+            small.clear();
+            large.clear();
+            for (std::size_t i = 0; i < n; ++i)
+                {
+                    prob[i] = weights[i] * double(n) / wsum;
+                    alias[i] = i;
+                    if (prob[i] < 1.)
+                        small.push_back(i);
+                    else
+                        large.push_back(i);
+                }
+            while (!small.empty() && !large.empty())
+                {
+                    auto s = small.back(), l = large.back();
+                    small.pop_back();
+                    alias[s] = l;
+                    prob[l] = (prob[l] + prob[s]) - 1.;
+                    if (prob[l] < 1.)
+                        {
+                            large.pop_back();
+                            small.push_back(l);
+                        }
+                }
+            // Anything left over is 1 up to rounding error
+            for (auto i : large)
+                prob[i] = 1.;
+            for (auto i : small)
+                prob[i] = 1.;
+        }
+
+      public:
+        explicit parent_sampler(const engine e = engine::automatic,
+                                const double acceptance_threshold = 2.)
+            /*!
+              \param e The engine to use.
+              \param acceptance_threshold When \a e is engine::automatic,
+              stochastic acceptance is used if max(w)/mean(w) is at most this
+              value.
+            */
+            : requested(e),
+              current(e),
+              threshold(acceptance_threshold),
+              weights(nullptr),
+              n(0),
+              wmax(0.),
+              prob{},
+              alias{},
+              small{},
+              large{}
+        {
+        }
+
+        void
+        update(const double *w, const std::size_t nw)
+        /*!
+          Prepare to sample from the weights \a w[0] to \a w[nw-1].
+
+          \note The stochastic acceptance engine reads \a w when sampling,
+          meaning that \a w must not change or be freed until the last
+          draw from this object.
+        */
+        {
+            assert(nw > 0);
+            weights = w;
+            n = nw;
+            double wsum = 0., wmin = w[0];
+            wmax = w[0];
+            for (std::size_t i = 0; i < n; ++i)
+                {
+                    assert(w[i] >= 0.);
+                    wsum += w[i];
+                    wmin = std::min(wmin, w[i]);
+                    wmax = std::max(wmax, w[i]);
+                }
+            current = requested;
+            if (current == engine::automatic)
+                {
+                    if (wmin == wmax)
+                        current = engine::uniform;
+                    else if (wmax * double(n) <= threshold * wsum)
+                        current = engine::stochastic_acceptance;
+                    else
+                        current = engine::alias;
+                }
+            if (current != engine::uniform && !(wsum > 0.))
+                {
+                    // No information in the weights
+                    current = engine::uniform;
+                }
+            if (current == engine::alias)
+                {
+                    build_alias_table(wsum);
+                }
+        }
+
+        engine
+        current_engine() const
+        /// The engine chosen by the last call to update
+        {
+            return current;
+        }
+
+        std::size_t
+        operator()(const gsl_rng *r) const
+        /// Return the index of a parent
+        {
+            assert(n > 0);
+            switch (current)
+                {
+                case engine::stochastic_acceptance:
+                    for (;;)
+                        {
+                            auto i = gsl_rng_uniform_int(r, n);
+                            if (gsl_rng_uniform(r) * wmax < weights[i])
+                                return i;
+                        }
+                case engine::alias:
+                    {
+                        double u = gsl_rng_uniform(r) * double(n);
+                        auto i = std::min(static_cast<std::size_t>(u), n - 1);
+                        return (u - double(i) < prob[i]) ? i : alias[i];
+                    }
+                default:
+                    return gsl_rng_uniform_int(r, n);
+                }
+        }
+    };
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <algorithm>
+#include <limits>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
 
@@ -36,15 +37,19 @@ namespace fwdpp
         poisson_xover(const poisson_xover &) = default;
         poisson_xover(poisson_xover &&) = default;
 
-        std::vector<double>
-        operator()() const
+        void
+        operator()(std::vector<double> &pos) const
+        /*!
+          Write the breakpoints into \a pos, which is cleared first.
+          Reusing \a pos avoids allocating a vector for every meiosis.
+        */
         {
+            pos.clear();
             unsigned nbreaks
                 = (recrate > 0) ? gsl_ran_poisson(r, recrate) : 0u;
             if (!nbreaks)
-                return {};
+                return;
 
-            std::vector<double> pos;
             pos.reserve(nbreaks + 1);
             for (unsigned i = 0; i < nbreaks; ++i)
                 {
@@ -53,6 +58,13 @@ namespace fwdpp
             std::sort(pos.begin(), pos.end());
             // Note: this is required for all vectors of breakpoints!
             pos.emplace_back(std::numeric_limits<double>::max());
+        }
+
+        std::vector<double>
+        operator()() const
+        {
+            std::vector<double> pos;
+            (*this)(pos);
             return pos;
         }
     };
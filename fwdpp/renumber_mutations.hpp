@@ -0,0 +1,238 @@
+#ifndef FWDPP_RENUMBER_MUTATIONS_HPP__
+#define FWDPP_RENUMBER_MUTATIONS_HPP__
+
+#include <cstddef>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <unordered_map>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/chunked_key_container.hpp>
+#include <fwdpp/compressed_key_container.hpp>
+#include <fwdpp/type_traits.hpp>
+#include <fwdpp/internal/common_variant_bits.hpp>
+#include <fwdpp/internal/mutation_columns.hpp>
+#include <fwdpp/internal/gamete_fingerprint.hpp>
+
+namespace fwdpp
+{
+    /// Value of new_keys[k] for a mutation that was dropped by
+    /// fwdpp::renumber_mutations
+    constexpr std::size_t dropped_mutation_key
+        = std::numeric_limits<std::size_t>::max();
+
+    namespace fwdpp_internal
+    {
+        template <typename key_container> struct mutation_key_remapper
+        // Replace each key k by new_keys[k]
+        {
+            const std::vector<std::size_t> &new_keys;
+            explicit mutation_key_remapper(const std::vector<std::size_t> &n)
+                : new_keys(n)
+            {
+            }
+            void
+            operator()(key_container &keys) const
+            {
+                for (auto &k : keys)
+                    {
+                        k = new_keys[k];
+                    }
+            }
+        };
+
+        template <std::size_t chunk_size>
+        struct mutation_key_remapper<chunked_key_container<chunk_size>>
+        // Each shared block is remapped once, and the result is shared
+        // by all of the gametes that shared the original block.
+        {
+            using block_type =
+                typename chunked_key_container<chunk_size>::block_type;
+            using block_pointer =
+                typename chunked_key_container<chunk_size>::block_pointer;
+            const std::vector<std::size_t> &new_keys;
+            std::unordered_map<const void *, block_pointer> remapped;
+            explicit mutation_key_remapper(const std::vector<std::size_t> &n)
+                : new_keys(n), remapped{}
+            {
+            }
+            void
+            operator()(chunked_key_container<chunk_size> &keys)
+            {
+                chunked_key_container<chunk_size> rv;
+                rv.reserve(keys.size());
+                for (const auto &b : keys.blocks())
+                    {
+                        auto &r = remapped[b.get()];
+                        if (!r)
+                            {
+                                r = std::make_shared<block_type>(*b);
+                                for (auto &k : *r)
+                                    {
+                                        k = new_keys[k];
+                                    }
+                            }
+                        rv.append_block(r);
+                    }
+                keys.swap(rv);
+            }
+        };
+    }
+
+    namespace fwdpp_internal
+    {
+        template <>
+        struct mutation_key_remapper<compressed_key_container>
+        // Keys are decoded, replaced, and encoded again
+        {
+            const std::vector<std::size_t> &new_keys;
+            compressed_key_container buffer;
+            explicit mutation_key_remapper(const std::vector<std::size_t> &n)
+                : new_keys(n), buffer{}
+            {
+            }
+            void
+            operator()(compressed_key_container &keys)
+            {
+                buffer.clear();
+                for (const auto k : keys)
+                    {
+                        buffer.push_back(
+                            static_cast<compressed_key_container::value_type>(
+                                new_keys[k]));
+                    }
+                keys.swap(buffer);
+            }
+        };
+    }
+
+    template <typename gcont_t, typename mcont_t>
+    void
+    renumber_mutations(gcont_t &gametes, mcont_t &mutations,
+                       std::vector<uint_t> &mcounts,
+                       std::vector<std::size_t> &new_keys)
+    /*!
+      \brief Renumber mutations so that the order of their keys is
+      the order of their positions.
+
+      Mutation keys are handed out in the order in which slots are
+      recycled, meaning that the position-sorted keys of a gamete point
+      all over \a mutations and \a mcounts.  After this function is
+      called:
+
+      1. \a mutations only contains the mutations found in extant
+      gametes, sorted by position.  Mutations at the same position keep
+      their relative order.
+      2. \a mcounts is permuted in the same way, and has the same size
+      as \a mutations.
+      3. The keys of every extant gamete refer to the new locations of
+      its mutations.  Extinct gametes are left without mutations.
+
+      Thus, fwdpp_internal::process_gametes, the merging of gametes
+      during recombination, and fitness calculations access memory in
+      nearly sequential order.
+
+      On return, new_keys[k] is the new key of the mutation whose key
+      was k, or fwdpp::dropped_mutation_key.  Any other container of
+      mutation keys must be updated using \a new_keys.  Mutation
+      positions are not changed, and so the lookup tables used by the
+      sugar layer remain valid.  The columns of a
+      fwdpp::common_variant_table are renumbered in the same way.
+
+      \note The same container of mutations may be shared by all loci
+      of a multi-locus simulation.
+    */
+    {
+        static_assert(
+            typename traits::is_mutation<typename mcont_t::value_type>::type(),
+            "mutation_type must be derived from fwdpp::mutation_base");
+        // Mark the mutations present in extant gametes
+        new_keys.assign(mutations.size(), dropped_mutation_key);
+        std::vector<std::size_t> order;
+        for (const auto &g : gametes)
+            {
+                if (g.n)
+                    {
+                        for (const auto k : g.mutations)
+                            {
+                                new_keys[k] = 0;
+                            }
+                        for (const auto k : g.smutations)
+                            {
+                                new_keys[k] = 0;
+                            }
+                    }
+            }
+        fwdpp_internal::mark_common_variant_keys(gametes, new_keys);
+        for (std::size_t k = 0; k < new_keys.size(); ++k)
+            {
+                if (new_keys[k] != dropped_mutation_key)
+                    {
+                        order.push_back(k);
+                    }
+            }
+        std::stable_sort(order.begin(), order.end(),
+                         [&mutations](const std::size_t a,
+                                      const std::size_t b) {
+                             return fwdpp_internal::mutation_position(
+                                        mutations, a)
+                                    < fwdpp_internal::mutation_position(
+                                          mutations, b);
+                         });
+
+        mcont_t renumbered;
+        renumbered.reserve(order.size());
+        std::vector<uint_t> renumbered_counts(order.size(), 0);
+        for (std::size_t i = 0; i < order.size(); ++i)
+            {
+                const auto k = order[i];
+                new_keys[k] = i;
+                renumbered.emplace_back(std::move(mutations[k]));
+                if (k < mcounts.size())
+                    {
+                        renumbered_counts[i] = mcounts[k];
+                    }
+            }
+        mutations.swap(renumbered);
+        mcounts.swap(renumbered_counts);
+
+        fwdpp_internal::mutation_key_remapper<
+            typename gcont_t::value_type::mutation_container>
+            remap(new_keys);
+        for (auto &g : gametes)
+            {
+                if (g.n)
+                    {
+                        remap(g.mutations);
+                        remap(g.smutations);
+                    }
+                else
+                    {
+                        // The keys of an extinct gamete may refer to
+                        // dropped mutations.
+                        g.mutations.clear();
+                        g.smutations.clear();
+                    }
+                fwdpp_internal::update_fingerprint(g);
+            }
+        fwdpp_internal::remap_common_variant_keys(gametes, new_keys);
+    }
+
+    template <typename gcont_t, typename mcont_t>
+    void
+    renumber_mutations(gcont_t &gametes, mcont_t &mutations,
+                       std::vector<uint_t> &mcounts)
+    /*!
+      \brief Renumber mutations so that the order of their keys is
+      the order of their positions.
+
+      See the other overload for details.
+    */
+    {
+        std::vector<std::size_t> new_keys;
+        renumber_mutations(gametes, mutations, mcounts, new_keys);
+    }
+}
+
+#endif
@@ -5,6 +5,9 @@
 #include <vector>
 #include <fwdpp/fwd_functional.hpp>
 #include <fwdpp/insertion_policies.hpp>
+#include <fwdpp/parent_sampler.hpp>
+#include <fwdpp/generation_workspace.hpp>
+#include <fwdpp/multilocus_genotype_matrix.hpp>
 namespace fwdpp
 {
     /*! \brief Sample the next generation of dipliods in an individual-based
@@ -25,6 +28,16 @@ namespace fwdpp
       \param f Probability that a mating is a selfing event
       \param mp Policy determining how whether or not to remove fixed variants
       from the gametes.
+      \param nthreads Number of threads used to calculate fitnesses and to
+      generate offspring gametes.  When greater than one, \a ff must be safe
+      to call concurrently.  Random numbers are still drawn, and \a mmodel
+      and \a rec_pol are still called, by the calling thread and in the same
+      order as for a single thread.  Only fitness calculations and the
+      assembly of offspring gametes are done in parallel, meaning the
+      offspring do not depend on \a nthreads.
+      \param sampler Used to sample parents proportional to their fitnesses.
+      If nullptr, a gsl_ran_discrete_t is built each generation.  See
+      fwdpp::parent_sampler.
       \param gpolicy_mut Policy determining how new gametes are added to
       population after a mutation event
 
@@ -45,7 +58,8 @@ namespace fwdpp
               template <typename, typename> class gamete_cont_type,
               template <typename, typename> class mutation_cont_type,
               template <typename, typename> class diploid_vector_type,
-              typename mutation_removal_policy = std::true_type>
+              typename mutation_removal_policy = std::true_type,
+              typename parent_sampler_t = parent_sampler>
     double sample_diploid(
         const gsl_rng *r,
         gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
@@ -59,7 +73,8 @@ namespace fwdpp
         typename gamete_type::mutation_container &neutral,
         typename gamete_type::mutation_container &selected,
         const double f = 0.,
-        const mutation_removal_policy mp = mutation_removal_policy());
+        const mutation_removal_policy mp = mutation_removal_policy(),
+        const unsigned nthreads = 1, parent_sampler_t *sampler = nullptr);
 
     /*! \brief Sample the next generation of dipliods in an individual-based
       simulation.  Changing population size case.
@@ -80,6 +95,16 @@ namespace fwdpp
       \param f Probability that a mating is a selfing event
       \param mp Policy determining how whether or not to remove fixed variants
       from the gametes.
+      \param nthreads Number of threads used to calculate fitnesses and to
+      generate offspring gametes.  When greater than one, \a ff must be safe
+      to call concurrently.  Random numbers are still drawn, and \a mmodel
+      and \a rec_pol are still called, by the calling thread and in the same
+      order as for a single thread.  Only fitness calculations and the
+      assembly of offspring gametes are done in parallel, meaning the
+      offspring do not depend on \a nthreads.
+      \param sampler Used to sample parents proportional to their fitnesses.
+      If nullptr, a gsl_ran_discrete_t is built each generation.  See
+      fwdpp::parent_sampler.
       \param gpolicy_mut Policy determining how new gametes are added to
       population after a mutation event
 
@@ -98,7 +123,8 @@ namespace fwdpp
               template <typename, typename> class gamete_cont_type,
               template <typename, typename> class mutation_cont_type,
               template <typename, typename> class diploid_vector_type,
-              typename mutation_removal_policy = std::true_type>
+              typename mutation_removal_policy = std::true_type,
+              typename parent_sampler_t = parent_sampler>
     double sample_diploid(
         const gsl_rng *r,
         gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
@@ -113,7 +139,8 @@ namespace fwdpp
         typename gamete_type::mutation_container &neutral,
         typename gamete_type::mutation_container &selected,
         const double f = 0.,
-        const mutation_removal_policy mp = mutation_removal_policy());
+        const mutation_removal_policy mp = mutation_removal_policy(),
+        const unsigned nthreads = 1, parent_sampler_t *sampler = nullptr);
 
     /*! \brief Evolve a metapopulation where demes are not changing size.  For
       individual-based sims.
@@ -145,6 +172,12 @@ namespace fwdpp
       is returned.
       \param f Probability that a mating is a selfing event.  This is an array,
       with 1 f per deme.
+      \param nthreads Number of threads used to calculate fitnesses within
+      each deme.  When greater than one, the elements of \a ffs must be safe
+      to call concurrently.
+      \param samplers Either nullptr, in which case a gsl_ran_discrete_t is
+      built for each deme each generation, or an array with one
+      fwdpp::parent_sampler (or compatible type) per deme.
 
       \note diploids will be updated to reflect the new diploid genotypes
       post-sampling (the descedants).  Gametes will be changed by mutation,
@@ -166,7 +199,8 @@ namespace fwdpp
               template <typename, typename> class mutation_cont_type,
               template <typename, typename> class diploid_vector_type,
               template <typename, typename> class metapop_diploid_vector_type,
-              typename mutation_removal_policy = std::true_type>
+              typename mutation_removal_policy = std::true_type,
+              typename parent_sampler_t = parent_sampler>
     std::vector<double> sample_diploid(
         const gsl_rng *r,
         gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
@@ -183,7 +217,8 @@ namespace fwdpp
         typename gamete_type::mutation_container &neutral,
         typename gamete_type::mutation_container &selected,
         const double *f = nullptr,
-        const mutation_removal_policy &mp = mutation_removal_policy());
+        const mutation_removal_policy &mp = mutation_removal_policy(),
+        const unsigned nthreads = 1, parent_sampler_t *samplers = nullptr);
 
     /*! \brief Evolve a metapopulation where demes may be changing size.  For
       individual-based sims.
@@ -217,6 +252,12 @@ namespace fwdpp
       is returned.
       \param f Probability that a mating is a selfing event.  This is an array,
       with 1 f per deme.
+      \param nthreads Number of threads used to calculate fitnesses within
+      each deme.  When greater than one, the elements of \a ffs must be safe
+      to call concurrently.
+      \param samplers Either nullptr, in which case a gsl_ran_discrete_t is
+      built for each deme each generation, or an array with one
+      fwdpp::parent_sampler (or compatible type) per deme.
 
       \note diploids will be updated to reflect the new diploid genotypes
       post-sampling (the descedants).  Gametes will be changed by mutation,
@@ -236,7 +277,8 @@ namespace fwdpp
               template <typename, typename> class mutation_cont_type,
               template <typename, typename> class diploid_vector_type,
               template <typename, typename> class metapop_diploid_vector_type,
-              typename mutation_removal_policy = std::true_type>
+              typename mutation_removal_policy = std::true_type,
+              typename parent_sampler_t = parent_sampler>
     std::vector<double> sample_diploid(
         const gsl_rng *r,
         gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
@@ -254,9 +296,19 @@ namespace fwdpp
         typename gamete_type::mutation_container &neutral,
         typename gamete_type::mutation_container &selected,
         const double *f = nullptr,
-        const mutation_removal_policy &mp = mutation_removal_policy());
+        const mutation_removal_policy &mp = mutation_removal_policy(),
+        const unsigned nthreads = 1, parent_sampler_t *samplers = nullptr);
 
     /*! \brief Single deme, multilocus model, changing population size
+
+      \note When \a nthreads is greater than one, fitnesses are calculated
+      in parallel and \a ff must be safe to call concurrently.
+      \note If \a sampler is not nullptr, it is used to sample parents
+      instead of a gsl_ran_discrete_t.  See fwdpp::parent_sampler.
+      \note \a interlocus_rec is a vector of callbacks, as returned by
+      fwdpp::make_binomial_interlocus_rec, or a fwdpp::interlocus_map.
+      The same holds for the other multilocus versions of this
+      function.
      */
     template <
         typename diploid_geno_t, typename gamete_type,
@@ -266,11 +318,13 @@ namespace fwdpp
         typename locus_vector_type_allocator,
         typename diploid_fitness_function, typename mutation_model_container,
         typename recombination_policy_container,
+        typename interlocus_recombination,
         template <typename, typename> class gamete_cont_type,
         template <typename, typename> class mutation_cont_type,
         template <typename, typename> class diploid_vector_type,
         template <typename, typename> class locus_vector_type,
-        typename mutation_removal_policy = std::true_type>
+        typename mutation_removal_policy = std::true_type,
+        typename parent_sampler_t = parent_sampler>
     double sample_diploid(
         const gsl_rng *r,
         gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
@@ -283,14 +337,20 @@ namespace fwdpp
         const uint_t &N_next, const double *mu,
         const mutation_model_container &mmodel,
         const recombination_policy_container &rec_policies,
-		const std::vector<std::function<unsigned(void)>> & interlocus_rec,
+        const interlocus_recombination &interlocus_rec,
         const diploid_fitness_function &ff,
         typename gamete_type::mutation_container &neutral,
         typename gamete_type::mutation_container &selected,
         const double &f = 0,
-        const mutation_removal_policy &mp = mutation_removal_policy());
+        const mutation_removal_policy &mp = mutation_removal_policy(),
+        const unsigned nthreads = 1, parent_sampler_t *sampler = nullptr);
 
     /*! \brief Single deme, multilocus model, constant population size
+
+      \note When \a nthreads is greater than one, fitnesses are calculated
+      in parallel and \a ff must be safe to call concurrently.
+      \note If \a sampler is not nullptr, it is used to sample parents
+      instead of a gsl_ran_discrete_t.  See fwdpp::parent_sampler.
       \example diploid_ind_2locus.cc
     */
     // single deme, constant N
@@ -302,11 +362,13 @@ namespace fwdpp
         typename locus_vector_type_allocator,
         typename diploid_fitness_function, typename mutation_model_container,
         typename recombination_policy_container,
+        typename interlocus_recombination,
         template <typename, typename> class gamete_cont_type,
         template <typename, typename> class mutation_cont_type,
         template <typename, typename> class diploid_vector_type,
         template <typename, typename> class locus_vector_type,
-        typename mutation_removal_policy = std::true_type>
+        typename mutation_removal_policy = std::true_type,
+        typename parent_sampler_t = parent_sampler>
     double sample_diploid(
         const gsl_rng *r,
         gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
@@ -318,11 +380,369 @@ namespace fwdpp
         std::vector<uint_t> &mcounts, const uint_t &N, const double *mu,
         const mutation_model_container &mmodel,
         const recombination_policy_container &rec_policies,
-		const std::vector<std::function<unsigned(void)>> & interlocus_rec,
+        const interlocus_recombination &interlocus_rec,
+        const diploid_fitness_function &ff,
+        typename gamete_type::mutation_container &neutral,
+        typename gamete_type::mutation_container &selected,
+        const double &f = 0,
+        const mutation_removal_policy &mp = mutation_removal_policy(),
+        const unsigned nthreads = 1, parent_sampler_t *sampler = nullptr);
+
+    /*! \brief Single deme, multilocus model, changing population size,
+      with genotypes stored in a fwdpp::multilocus_genotype_matrix.
+
+      The same as the version taking a vector of vectors of genotypes.
+     */
+    template <typename diploid_geno_t, typename gamete_type,
+              typename gamete_cont_type_allocator, typename mutation_type,
+              typename mutation_cont_type_allocator,
+              typename diploid_fitness_function,
+              typename mutation_model_container,
+              typename recombination_policy_container,
+              typename interlocus_recombination,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              typename mutation_removal_policy = std::true_type,
+              typename parent_sampler_t = parent_sampler>
+    double sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        multilocus_genotype_matrix<diploid_geno_t> &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N_curr,
+        const uint_t &N_next, const double *mu,
+        const mutation_model_container &mmodel,
+        const recombination_policy_container &rec_policies,
+        const interlocus_recombination &interlocus_rec,
         const diploid_fitness_function &ff,
         typename gamete_type::mutation_container &neutral,
         typename gamete_type::mutation_container &selected,
         const double &f = 0,
+        const mutation_removal_policy &mp = mutation_removal_policy(),
+        const unsigned nthreads = 1, parent_sampler_t *sampler = nullptr);
+
+    /*! \brief Single deme, multilocus model, constant population size,
+      with genotypes stored in a fwdpp::multilocus_genotype_matrix.
+     */
+    template <typename diploid_geno_t, typename gamete_type,
+              typename gamete_cont_type_allocator, typename mutation_type,
+              typename mutation_cont_type_allocator,
+              typename diploid_fitness_function,
+              typename mutation_model_container,
+              typename recombination_policy_container,
+              typename interlocus_recombination,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              typename mutation_removal_policy = std::true_type,
+              typename parent_sampler_t = parent_sampler>
+    double sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        multilocus_genotype_matrix<diploid_geno_t> &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N, const double *mu,
+        const mutation_model_container &mmodel,
+        const recombination_policy_container &rec_policies,
+        const interlocus_recombination &interlocus_rec,
+        const diploid_fitness_function &ff,
+        typename gamete_type::mutation_container &neutral,
+        typename gamete_type::mutation_container &selected,
+        const double &f = 0,
+        const mutation_removal_policy &mp = mutation_removal_policy(),
+        const unsigned nthreads = 1, parent_sampler_t *sampler = nullptr);
+
+    /*! \brief Sample the next generation of diploids in an individual-based
+      simulation, reusing memory held by a fwdpp::generation_workspace.
+      Changing population size case.
+
+      The parameters are the same as for the version taking \a neutral
+      and \a selected, which are replaced by \a workspace.  The number of
+      threads is workspace.nthreads, and the threads are kept in
+      workspace.workers from one call to the next.  Parents are sampled
+      using workspace.samplers unless workspace.use_parent_sampler is
+      false.
+
+      \note The offspring are written into workspace.offspring, which is
+      then swapped with \a diploids.  Thus, the diploid passed to \a mmodel
+      and \a rec_pol while generating an offspring does not hold a copy of a
+      parent, as it does when no workspace is used.
+      \return The mean fitness of the parental generation
+    */
+    template <typename gamete_type, typename gamete_cont_type_allocator,
+              typename mutation_type, typename mutation_cont_type_allocator,
+              typename diploid_geno_t, typename diploid_vector_type_allocator,
+              typename diploid_fitness_function, typename mutation_model,
+              typename recombination_policy,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              template <typename, typename> class diploid_vector_type,
+              typename mutation_removal_policy = std::true_type>
+    double sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        diploid_vector_type<diploid_geno_t, diploid_vector_type_allocator>
+            &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N_curr,
+        const uint_t &N_next, const double &mu, const mutation_model &mmodel,
+        const recombination_policy &rec_pol,
+        const diploid_fitness_function &ff,
+        generation_workspace<diploid_vector_type<diploid_geno_t,
+                                                 diploid_vector_type_allocator>,
+                             typename gamete_type::mutation_container>
+            &workspace,
+        const double f = 0.,
+        const mutation_removal_policy mp = mutation_removal_policy());
+
+    /*! \brief Sample the next generation of diploids in an individual-based
+      simulation, reusing memory held by a fwdpp::generation_workspace.
+      Constant population size case.
+    */
+    template <typename gamete_type, typename gamete_cont_type_allocator,
+              typename mutation_type, typename mutation_cont_type_allocator,
+              typename diploid_geno_t, typename diploid_vector_type_allocator,
+              typename diploid_fitness_function, typename mutation_model,
+              typename recombination_policy,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              template <typename, typename> class diploid_vector_type,
+              typename mutation_removal_policy = std::true_type>
+    double sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        diploid_vector_type<diploid_geno_t, diploid_vector_type_allocator>
+            &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N_curr, const double &mu,
+        const mutation_model &mmodel, const recombination_policy &rec_pol,
+        const diploid_fitness_function &ff,
+        generation_workspace<diploid_vector_type<diploid_geno_t,
+                                                 diploid_vector_type_allocator>,
+                             typename gamete_type::mutation_container>
+            &workspace,
+        const double f = 0.,
+        const mutation_removal_policy mp = mutation_removal_policy());
+
+    /*! \brief Evolve a metapopulation, reusing memory held by a
+      fwdpp::generation_workspace.  Demes may change size.
+
+      The parameters are the same as for the version taking \a neutral
+      and \a selected, which are replaced by \a workspace.
+      workspace.samplers holds one sampler per deme.
+    */
+    template <typename gamete_type, typename mutation_type,
+              typename metapop_diploid_vector_type_allocator,
+              typename gamete_cont_type_allocator,
+              typename mutation_cont_type_allocator, typename diploid_geno_t,
+              typename diploid_vector_type_allocator,
+              typename diploid_fitness_function_container,
+              typename mutation_model, typename recombination_policy,
+              typename migration_policy,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              template <typename, typename> class diploid_vector_type,
+              template <typename, typename> class metapop_diploid_vector_type,
+              typename mutation_removal_policy = std::true_type>
+    std::vector<double> sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        metapop_diploid_vector_type<diploid_vector_type<diploid_geno_t,
+                                                        diploid_vector_type_allocator>,
+                                    metapop_diploid_vector_type_allocator>
+            &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t *N_curr,
+        const uint_t *N_next, const double &mu, const mutation_model &mmodel,
+        const recombination_policy &rec_pol,
+        const diploid_fitness_function_container &ffs,
+        const migration_policy &mig,
+        generation_workspace<
+            metapop_diploid_vector_type<diploid_vector_type<diploid_geno_t,
+                                                            diploid_vector_type_allocator>,
+                                        metapop_diploid_vector_type_allocator>,
+            typename gamete_type::mutation_container> &workspace,
+        const double *f = nullptr,
+        const mutation_removal_policy &mp = mutation_removal_policy());
+
+    /*! \brief Evolve a metapopulation, reusing memory held by a
+      fwdpp::generation_workspace.  Demes do not change size.
+    */
+    template <typename gamete_type, typename mutation_type,
+              typename metapop_diploid_vector_type_allocator,
+              typename gamete_cont_type_allocator,
+              typename mutation_cont_type_allocator, typename diploid_geno_t,
+              typename diploid_vector_type_allocator,
+              typename diploid_fitness_function_container,
+              typename mutation_model, typename recombination_policy,
+              typename migration_policy,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              template <typename, typename> class diploid_vector_type,
+              template <typename, typename> class metapop_diploid_vector_type,
+              typename mutation_removal_policy = std::true_type>
+    std::vector<double> sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        metapop_diploid_vector_type<diploid_vector_type<diploid_geno_t,
+                                                        diploid_vector_type_allocator>,
+                                    metapop_diploid_vector_type_allocator>
+            &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t *N_curr, const double &mu,
+        const mutation_model &mmodel, const recombination_policy &rec_pol,
+        const diploid_fitness_function_container &ffs,
+        const migration_policy &mig,
+        generation_workspace<
+            metapop_diploid_vector_type<diploid_vector_type<diploid_geno_t,
+                                                            diploid_vector_type_allocator>,
+                                        metapop_diploid_vector_type_allocator>,
+            typename gamete_type::mutation_container> &workspace,
+        const double *f = nullptr,
+        const mutation_removal_policy &mp = mutation_removal_policy());
+
+    /*! \brief Single deme, multilocus model, changing population size,
+      reusing memory held by a fwdpp::generation_workspace.
+     */
+    template <
+        typename diploid_geno_t, typename gamete_type,
+        typename gamete_cont_type_allocator, typename mutation_type,
+        typename mutation_cont_type_allocator,
+        typename diploid_vector_type_allocator,
+        typename locus_vector_type_allocator,
+        typename diploid_fitness_function, typename mutation_model_container,
+        typename recombination_policy_container,
+        typename interlocus_recombination,
+        template <typename, typename> class gamete_cont_type,
+        template <typename, typename> class mutation_cont_type,
+        template <typename, typename> class diploid_vector_type,
+        template <typename, typename> class locus_vector_type,
+        typename mutation_removal_policy = std::true_type>
+    double sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        diploid_vector_type<locus_vector_type<diploid_geno_t,
+                                              locus_vector_type_allocator>,
+                            diploid_vector_type_allocator> &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N_curr,
+        const uint_t &N_next, const double *mu,
+        const mutation_model_container &mmodel,
+        const recombination_policy_container &rec_policies,
+        const interlocus_recombination &interlocus_rec,
+        const diploid_fitness_function &ff,
+        generation_workspace<
+            diploid_vector_type<locus_vector_type<diploid_geno_t,
+                                                  locus_vector_type_allocator>,
+                                diploid_vector_type_allocator>,
+            typename gamete_type::mutation_container> &workspace,
+        const double &f = 0,
+        const mutation_removal_policy &mp = mutation_removal_policy());
+
+    /*! \brief Single deme, multilocus model, constant population size,
+      reusing memory held by a fwdpp::generation_workspace.
+     */
+    template <
+        typename diploid_geno_t, typename gamete_type,
+        typename gamete_cont_type_allocator, typename mutation_type,
+        typename mutation_cont_type_allocator,
+        typename diploid_vector_type_allocator,
+        typename locus_vector_type_allocator,
+        typename diploid_fitness_function, typename mutation_model_container,
+        typename recombination_policy_container,
+        typename interlocus_recombination,
+        template <typename, typename> class gamete_cont_type,
+        template <typename, typename> class mutation_cont_type,
+        template <typename, typename> class diploid_vector_type,
+        template <typename, typename> class locus_vector_type,
+        typename mutation_removal_policy = std::true_type>
+    double sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        diploid_vector_type<locus_vector_type<diploid_geno_t,
+                                              locus_vector_type_allocator>,
+                            diploid_vector_type_allocator> &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N, const double *mu,
+        const mutation_model_container &mmodel,
+        const recombination_policy_container &rec_policies,
+        const interlocus_recombination &interlocus_rec,
+        const diploid_fitness_function &ff,
+        generation_workspace<
+            diploid_vector_type<locus_vector_type<diploid_geno_t,
+                                                  locus_vector_type_allocator>,
+                                diploid_vector_type_allocator>,
+            typename gamete_type::mutation_container> &workspace,
+        const double &f = 0,
+        const mutation_removal_policy &mp = mutation_removal_policy());
+    /*! \brief Single deme, multilocus model, changing population size,
+      with genotypes stored in a fwdpp::multilocus_genotype_matrix,
+      reusing memory held by a fwdpp::generation_workspace.
+     */
+    template <typename diploid_geno_t, typename gamete_type,
+              typename gamete_cont_type_allocator, typename mutation_type,
+              typename mutation_cont_type_allocator,
+              typename diploid_fitness_function,
+              typename mutation_model_container,
+              typename recombination_policy_container,
+              typename interlocus_recombination,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              typename mutation_removal_policy = std::true_type>
+    double sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        multilocus_genotype_matrix<diploid_geno_t> &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N_curr,
+        const uint_t &N_next, const double *mu,
+        const mutation_model_container &mmodel,
+        const recombination_policy_container &rec_policies,
+        const interlocus_recombination &interlocus_rec,
+        const diploid_fitness_function &ff,
+        generation_workspace<multilocus_genotype_matrix<diploid_geno_t>,
+                             typename gamete_type::mutation_container>
+            &workspace,
+        const double &f = 0,
+        const mutation_removal_policy &mp = mutation_removal_policy());
+
+    /*! \brief Single deme, multilocus model, constant population size,
+      with genotypes stored in a fwdpp::multilocus_genotype_matrix,
+      reusing memory held by a fwdpp::generation_workspace.
+     */
+    template <typename diploid_geno_t, typename gamete_type,
+              typename gamete_cont_type_allocator, typename mutation_type,
+              typename mutation_cont_type_allocator,
+              typename diploid_fitness_function,
+              typename mutation_model_container,
+              typename recombination_policy_container,
+              typename interlocus_recombination,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              typename mutation_removal_policy = std::true_type>
+    double sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        multilocus_genotype_matrix<diploid_geno_t> &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N, const double *mu,
+        const mutation_model_container &mmodel,
+        const recombination_policy_container &rec_policies,
+        const interlocus_recombination &interlocus_rec,
+        const diploid_fitness_function &ff,
+        generation_workspace<multilocus_genotype_matrix<diploid_geno_t>,
+                             typename gamete_type::mutation_container>
+            &workspace,
+        const double &f = 0,
         const mutation_removal_policy &mp = mutation_removal_policy());
 }
 
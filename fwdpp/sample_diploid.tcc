@@ -16,6 +16,7 @@
 #include <fwdpp/internal/gamete_cleaner.hpp>
 #include <fwdpp/internal/multilocus_rec.hpp>
 #include <fwdpp/internal/sample_diploid_helpers.hpp>
+#include <fwdpp/internal/generate_offspring.hpp>
 
 namespace fwdpp
 {
@@ -28,7 +29,7 @@ namespace fwdpp
               template <typename, typename> class gamete_cont_type,
               template <typename, typename> class mutation_cont_type,
               template <typename, typename> class diploid_vector_type,
-              typename mutation_removal_policy>
+              typename mutation_removal_policy, typename parent_sampler_t>
     double
     sample_diploid(
         const gsl_rng *r,
@@ -42,12 +43,13 @@ namespace fwdpp
         const diploid_fitness_function &ff,
         typename gamete_type::mutation_container &neutral,
         typename gamete_type::mutation_container &selected, const double f,
-        const mutation_removal_policy mp)
+        const mutation_removal_policy mp, const unsigned nthreads,
+        parent_sampler_t *sampler)
     {
         // run changing N version with N_next == N_curr
         return sample_diploid(r, gametes, diploids, mutations, mcounts, N_curr,
                               N_curr, mu, mmodel, rec_pol, ff, neutral,
-                              selected, f, mp);
+                              selected, f, mp, nthreads, sampler);
     }
 
     // single deme, N changing
@@ -59,7 +61,7 @@ namespace fwdpp
               template <typename, typename> class gamete_cont_type,
               template <typename, typename> class mutation_cont_type,
               template <typename, typename> class diploid_vector_type,
-              typename mutation_removal_policy>
+              typename mutation_removal_policy, typename parent_sampler_t>
     double
     sample_diploid(
         const gsl_rng *r,
@@ -74,7 +76,8 @@ namespace fwdpp
         const diploid_fitness_function &ff,
         typename gamete_type::mutation_container &neutral,
         typename gamete_type::mutation_container &selected, const double f,
-        const mutation_removal_policy mp)
+        const mutation_removal_policy mp, const unsigned nthreads,
+        parent_sampler_t *sampler)
     {
         /*
           The main part of fwdpp does not throw exceptions.
@@ -104,13 +107,13 @@ namespace fwdpp
           The library
           uses these extinct objects to 'recycle' them into new objects.  The
           function calls
-          below create FIFO queues of where extinct objects are.  These queues
-          are passed to
+          below fill stacks of the indexes of extinct objects.  These
+          "recycling bins" are passed to
           mutation and recombination functions and used to decide if recyling
           is possible or
           if a new object needs to be 'emplace-back'-ed into a container.
 
-          The type of the FIFO queue is abstracted with the name
+          The type of the bins is abstracted with the name
           fwdpp::fwdpp_internal::recycling_bin_t,
           which is a C++11 template alias.
 
@@ -118,38 +121,31 @@ namespace fwdpp
           fwdpp/internal/recycling.hpp
         */
         auto mut_recycling_bin = fwdpp_internal::make_mut_queue(mcounts);
-        auto gam_recycling_bin = fwdpp_internal::make_gamete_queue(gametes);
+        fwdpp_internal::recycling_bin_t<std::size_t> gam_recycling_bin;
+
+        /*
+          Set the count of each gamete to 0.  The counts are
+          re-calculated as offspring are generated below.  The extinct
+          gametes are added to the recycling bin in the same sweep.
+        */
+        fwdpp_internal::zero_gamete_counts(gametes, gam_recycling_bin);
 
         // Calculate fitness for each diploid:
 
-        // create a vector to store fitnesses:
+        /*
+          ff is a "fitness function", which returns a double.  For
+          examples, see fwdpp::multiplicative_diploid, which is a
+          "standard" type of fitness function used in population genetics.
+          "Standard" types of models are defined in
+          fwdpp/fitness_models.hpp.
+
+          When nthreads > 1, fitnesses are calculated in parallel.
+          The implementation is in
+          fwdpp/internal/sample_diploid_helpers.hpp
+         */
         std::vector<double> fitnesses(diploids.size());
-        double wbar = 0.; // pop'n mean fitness
-        for (uint_t i = 0; i < N_curr; ++i)
-            {
-                /*
-                  Set the count of each gamete to 0.
-
-                  Yes, in the case of > 1 diploid having the exact same gamete
-                  index,
-                  this is done multiple times.
-                */
-                gametes[diploids[i].first].n = gametes[diploids[i].second].n
-                    = 0;
-                /*
-                  Assign fitness to the i-th individual.
-
-                  ff is a "fitness function", which returns a double.  For
-                  examples, see
-                  fwdpp::multiplicative_diploid, which is a "standard" type of
-                  fitness function
-                  used in population genetics.  "Standard" types of models are
-                  defined in
-                  fwdpp/fitness_models.hpp.
-                 */
-                fitnesses[i] = ff(diploids[i], gametes, mutations);
-                wbar += fitnesses[i];
-            }
+        double wbar = fwdpp_internal::fill_fitnesses(
+            diploids, gametes, mutations, ff, fitnesses.data(), nthreads);
         wbar /= double(diploids.size());
 #ifndef NDEBUG
         for (const auto &g : gametes)
@@ -159,13 +155,12 @@ namespace fwdpp
         /*
           This is a lookup table for rapid sampling of diploids proportional to
           their fitnesses.
-          This is a unique_ptr wrapper around an object from the GNU Scientific
-          Library.  A custom deleter
-          is required to make this work, which is why there is no cleanup call
-          down below.
+          If sampler is nullptr, this is a unique_ptr wrapper around an object
+          from the GNU Scientific Library.  Otherwise, sampler is updated
+          using the current fitnesses.  See fwdpp/parent_sampler.hpp.
         */
-        fwdpp_internal::gsl_ran_discrete_t_ptr lookup(
-            gsl_ran_discrete_preproc(N_curr, fitnesses.data()));
+        fwdpp_internal::parent_lookup<parent_sampler_t> lookup(
+            sampler, fitnesses.data(), N_curr);
         const auto parents(diploids); // Copy the parents, which is trivally
         // fast for the vast majority of use
         // cases.
@@ -177,43 +172,21 @@ namespace fwdpp
             }
         assert(diploids.size() == N_next);
 
-        // Fill in the next generation!
-        for (auto &dip : diploids)
-            {
-                // Choose parent 1 based on fitness
-                auto p1 = gsl_ran_discrete(r, lookup.get());
-                // If inbred (w/probability f2), parent2 = parent1, else choose
-                // again based on fitness
-                auto p2 = (f == 1. || (f > 0. && gsl_rng_uniform(r) < f))
-                              ? p1
-                              : gsl_ran_discrete(r, lookup.get());
-                assert(p1 < parents.size());
-                assert(p2 < parents.size());
-                /*
-                  These are the gametes from each parent.
-                  This is a trivial assignment if keys.
-                */
-                auto p1g1 = parents[p1].first;
-                auto p1g2 = parents[p1].second;
-                auto p2g1 = parents[p2].first;
-                auto p2g2 = parents[p2].second;
-
-                /*
-                  The offspring will inherit some manipulation of p1g1 and
-                  p1g2.
-                  The next two lines do "Mendel".
-                */
-                if (gsl_rng_uniform(r) < 0.5)
-                    std::swap(p1g1, p1g2);
-                if (gsl_rng_uniform(r) < 0.5)
-                    std::swap(p2g1, p2g2);
-
-                mutate_recombine_update(
-                    r, gametes, mutations,
-                    std::make_tuple(p1g1, p1g2, p2g1, p2g2), rec_pol, mmodel,
-                    mu, gam_recycling_bin, mut_recycling_bin, dip, neutral,
-                    selected);
-            }
+        /*
+          Generate the offspring.  When nthreads > 1, the offspring
+          gametes are assembled by nthreads threads.  The details
+          are in fwdpp/internal/generate_offspring.hpp and
+          fwdpp/internal/threaded_offspring.hpp.
+        */
+        fwdpp_internal::offspring_batch batch;
+        std::vector<fwdpp_internal::offspring_scratch<
+            typename gamete_type::mutation_container>>
+            scratch;
+        reproduction_buffers buffers;
+        fwdpp_internal::generate_offspring(
+            r, parents, diploids, lookup, f, gametes, mutations, mu, mmodel,
+            rec_pol, gam_recycling_bin, mut_recycling_bin, neutral, selected,
+            buffers, batch, scratch, nthreads, false);
         assert(check_sum(gametes, 2 * N_next));
 #ifndef NDEBUG
         for (const auto &dip : diploids)
@@ -249,11 +222,15 @@ namespace fwdpp
           for vectorizing such cases.  I've experimented with CPU intrinsics to
           attempt memory prefetches,
           but never saw any performance improvement, and the code got complex,
-          and possibly less portable.
+          and possibly less portable.  Prefetching via __builtin_prefetch
+          may be enabled at compile time (see
+          fwdpp/internal/prefetch.hpp), and when nthreads > 1 the gametes
+          are counted by several threads.
 
           The implementation is in fwdpp/internal/sample_diploid_helpers.hpp
          */
-        fwdpp_internal::process_gametes(gametes, mutations, mcounts);
+        fwdpp_internal::process_gametes(gametes, mutations, mcounts,
+                                        nthreads);
         assert(mcounts.size() == mutations.size());
 #ifndef NDEBUG
         for (const auto &mc : mcounts)
@@ -285,7 +262,7 @@ namespace fwdpp
           and selected)  will be removed from all gametes.
         */
         fwdpp_internal::gamete_cleaner(gametes, mutations, mcounts, 2 * N_next,
-                                       mp);
+                                       mp, nthreads);
         return wbar;
     }
 
@@ -303,7 +280,7 @@ namespace fwdpp
         template <typename, typename> class mutation_cont_type,
         template <typename, typename> class diploid_vector_type,
         template <typename, typename> class metapop_diploid_vector_type,
-        typename mutation_removal_policy>
+        typename mutation_removal_policy, typename parent_sampler_t>
     std::vector<double>
     sample_diploid(
         const gsl_rng *r,
@@ -320,12 +297,13 @@ namespace fwdpp
         const migration_policy &mig,
         typename gamete_type::mutation_container &neutral,
         typename gamete_type::mutation_container &selected, const double *f,
-        const mutation_removal_policy &mp)
+        const mutation_removal_policy &mp, const unsigned nthreads,
+        parent_sampler_t *samplers)
     {
         // run changing-N version with no change in N
         return sample_diploid(r, metapop, diploids, mutations, mcounts, N_curr,
                               N_curr, mu, mmodel, rec_pol, ffs, mig, neutral,
-                              selected, f, mp);
+                              selected, f, mp, nthreads, samplers);
     }
 
     // Metapopulation version of sample_diploid for individual-based
@@ -342,7 +320,7 @@ namespace fwdpp
         template <typename, typename> class mutation_cont_type,
         template <typename, typename> class diploid_vector_type,
         template <typename, typename> class metapop_diploid_vector_type,
-        typename mutation_removal_policy>
+        typename mutation_removal_policy, typename parent_sampler_t>
     std::vector<double>
     sample_diploid(
         const gsl_rng *r,
@@ -360,37 +338,36 @@ namespace fwdpp
         const migration_policy &mig,
         typename gamete_type::mutation_container &neutral,
         typename gamete_type::mutation_container &selected, const double *f,
-        const mutation_removal_policy &mp)
+        const mutation_removal_policy &mp, const unsigned nthreads,
+        parent_sampler_t *samplers)
     {
         // get the fitnesses for each diploid in each deme and make the lookup
         // table of parental fitnesses
-        using lookup_t = fwdpp_internal::gsl_ran_discrete_t_ptr;
+        using lookup_t = fwdpp_internal::parent_lookup<parent_sampler_t>;
         std::vector<lookup_t> lookups;
         std::vector<double> wbars(diploids.size(), 0);
         auto mut_recycling_bin = fwdpp_internal::make_mut_queue(mcounts);
-        auto gamete_recycling_bin = fwdpp_internal::make_gamete_queue(gametes);
-
-        // get max N
-        auto mN = (!diploids.empty())
-                      ? *std::max_element(N_curr, N_curr + diploids.size())
-                      : 0;
-
-        std::vector<double> fitnesses(mN);
-        std::size_t popi = 0;
+        fwdpp_internal::recycling_bin_t<std::size_t> gamete_recycling_bin;
+        fwdpp_internal::zero_gamete_counts(gametes, gamete_recycling_bin);
+        /*
+          A parent_sampler may keep a pointer to the fitnesses, so
+          each deme gets its own range of this vector.
+        */
+        std::vector<double> fitnesses(
+            std::accumulate(N_curr, N_curr + diploids.size(), std::size_t(0)));
+        std::size_t popi = 0, offset = 0;
+        lookups.reserve(diploids.size());
         for (const auto &dipvec :
              diploids) // go over each container of diploids...
             {
-                std::vector<double>::size_type i = 0;
-                for (const auto &dip : dipvec) //...and each diploid
-                    {
-                        fitnesses[i] = ffs[popi](dip, gametes, mutations);
-                        wbars[popi] += fitnesses[i];
-                        gametes[dip.first].n = gametes[dip.second].n = 0;
-                        ++i;
-                    }
+                wbars[popi] = fwdpp_internal::fill_fitnesses(
+                    dipvec, gametes, mutations, ffs[popi],
+                    fitnesses.data() + offset, nthreads);
                 wbars[popi] /= double(dipvec.size());
-                lookups.emplace_back(lookup_t(gsl_ran_discrete_preproc(
-                    dipvec.size(), fitnesses.data())));
+                lookups.emplace_back(
+                    (samplers == nullptr) ? nullptr : samplers + popi,
+                    fitnesses.data() + offset, dipvec.size());
+                offset += dipvec.size();
                 ++popi;
             }
 
@@ -398,7 +375,7 @@ namespace fwdpp
         // copy diploids into temporary parents
         const auto parents(diploids);
 
-        // Update the diploids, one deme at a time
+        // Change the deme sizes
         for (popi = 0; popi < diploids.size(); ++popi)
             {
                 auto demesize = *(N_next + popi);
@@ -406,75 +383,181 @@ namespace fwdpp
                     {
                         diploids[popi].resize(demesize);
                     }
-                for (auto &dip : diploids[popi])
-                    {
-                        /* Figure out if parent 1 is migrant or not.
-
-                           A migration policy takes the current deme (popindex)
-                           as
-                           an argument.  It returns popindex if there is no
-                           migration,
-                           else it returns the index of the deme of a migrant
-                           parent
-                        */
-                        auto deme_p1 = mig(popi);
-                        decltype(deme_p1) deme_p2 = popi;
-
-                        // Figure out who the parents are
-                        auto p1 = gsl_ran_discrete(r, lookups[deme_p1].get()),
-                             p2 = p1;
-
-                        /*
-                          If the individual is not inbred, then we pick a
-                          deme from the migration policy for parent 2
-                        */
-                        if (f != nullptr
-                            && (*(f + popi) == 1.
-                                || (*(f + popi) > 0.
-                                    && gsl_rng_uniform(r)
-                                           < *(f + popi)))) // individual is
-                            // inbred
-                            {
-                                p2 = p1;
-                            }
-                        else
-                            {
-                                // apply migration policy to figure out
-                                // parental deme for parent #2
-                                deme_p2 = mig(popi);
-                                p2 = gsl_ran_discrete(r,
-                                                      lookups[deme_p2].get());
-                            }
-
-                        auto p1g1 = parents[deme_p1][p1].first;
-                        auto p1g2 = parents[deme_p1][p1].second;
-                        auto p2g1 = parents[deme_p2][p2].first;
-                        auto p2g2 = parents[deme_p2][p2].second;
-
-                        if (gsl_rng_uniform(r) < 0.5)
-                            std::swap(p1g1, p1g2);
-                        if (gsl_rng_uniform(r) < 0.5)
-                            std::swap(p2g1, p2g2);
-
-                        mutate_recombine_update(
-                            r, gametes, mutations,
-                            std::make_tuple(p1g1, p1g2, p2g1, p2g2), rec_pol,
-                            mmodel, mu, gamete_recycling_bin,
-                            mut_recycling_bin, dip, neutral, selected);
-                    }
             }
-        fwdpp_internal::process_gametes(gametes, mutations, mcounts);
+        reproduction_buffers buffers;
+        fwdpp_internal::generate_metapop_offspring(
+            r, parents, diploids, lookups, mig, f, gametes, mutations, mu,
+            mmodel, rec_pol, gamete_recycling_bin, mut_recycling_bin, neutral,
+            selected, buffers);
+        fwdpp_internal::process_gametes(gametes, mutations, mcounts,
+                                        nthreads);
         assert(mcounts.size() == mutations.size());
         fwdpp_internal::gamete_cleaner(
             gametes, mutations, mcounts,
             2 * std::accumulate(N_next, N_next + diploids.size(), uint_t(0)),
-            mp);
+            mp, nthreads);
         assert(check_sum(
             gametes,
             2 * std::accumulate(N_next, N_next + diploids.size(), uint_t(0))));
         return wbars;
     }
 
+    namespace fwdpp_internal
+    {
+        template <typename gcont_t, typename dipvector_t, typename mcont_t,
+                  typename diploid_fitness_function,
+                  typename mutation_model_container,
+                  typename recombination_policy_container,
+                  typename interlocus_recombination,
+                  typename mutation_removal_policy, typename parent_sampler_t>
+        double
+        sample_diploid_multilocus(
+            const gsl_rng *r, gcont_t &gametes, dipvector_t &diploids,
+            mcont_t &mutations, std::vector<uint_t> &mcounts,
+            const uint_t N_curr, const uint_t N_next, const double *mu,
+            const mutation_model_container &mmodel,
+            const recombination_policy_container &rec_policies,
+            const interlocus_recombination &interlocus_rec,
+            const diploid_fitness_function &ff,
+            typename gcont_t::value_type::mutation_container &neutral,
+            typename gcont_t::value_type::mutation_container &selected,
+            const double f, const mutation_removal_policy &mp,
+            const unsigned nthreads, parent_sampler_t *sampler)
+        /*!
+          Multi-locus API, single deme.  \a diploids is a container of
+          containers of genotypes, or a fwdpp::multilocus_genotype_matrix.
+        */
+        {
+            assert(popdata_sane_multilocus(diploids, gametes, mutations,
+                                           mcounts));
+            assert(mcounts.size() == mutations.size());
+            assert(diploids.size() == N_curr);
+            // Vector of parental fitnesses
+            std::vector<double> fitnesses(N_curr);
+            auto mut_recycling_bin = make_mut_queue(mcounts);
+            // set parental gamete counts to 0 for each locus, and collect
+            // the extinct gametes
+            recycling_bin_t<std::size_t> gamete_recycling_bin;
+            zero_gamete_counts(gametes, gamete_recycling_bin);
+            // Calculate the fitness of each parent
+            double wbar = fill_fitnesses(diploids, gametes, mutations, ff,
+                                         fitnesses.data(), nthreads);
+            wbar /= double(diploids.size());
+#ifndef NDEBUG
+            /*
+              If we are debugging, let's make sure that every gamete has
+              been set to n = 0.
+              Rationale for check:  if we are failing to update data types
+              properly, then it is possible that the "gamete pool"
+              contains items not carried by any diploids.
+              If so, this assertion will fail.
+            */
+            for (const auto &g : gametes)
+                assert(!g.n);
+#endif
+
+            parent_lookup<parent_sampler_t> lookup(sampler, fitnesses.data(),
+                                                   fitnesses.size());
+
+            const auto parents(diploids); // Copy the parents.  Exact copy of
+            // diploids--same fitnesses, etc.
+
+            // Change the population size.  New diploids are resized to the
+            // number of loci by generate_multilocus_offspring.
+            if (diploids.size() != N_next)
+                {
+                    diploids.resize(N_next);
+                }
+
+            assert(diploids.size() == N_next);
+
+            reproduction_buffers buffers;
+            generate_multilocus_offspring(
+                r, parents, diploids, lookup, f, gametes, mutations, mu,
+                mmodel, rec_policies, interlocus_rec, gamete_recycling_bin,
+                mut_recycling_bin, neutral, selected, buffers);
+            process_gametes(gametes, mutations, mcounts, nthreads);
+            gamete_cleaner(gametes, mutations, mcounts, 2 * N_next, mp,
+                           std::true_type(), nthreads);
+            assert(popdata_sane_multilocus(diploids, gametes, mutations,
+                                           mcounts));
+            return wbar;
+        }
+
+        template <typename gcont_t, typename dipvector_t, typename mcont_t,
+                  typename diploid_fitness_function,
+                  typename mutation_model_container,
+                  typename recombination_policy_container,
+                  typename interlocus_recombination,
+                  typename mutation_removal_policy>
+        double
+        sample_diploid_multilocus(
+            const gsl_rng *r, gcont_t &gametes, dipvector_t &diploids,
+            mcont_t &mutations, std::vector<uint_t> &mcounts,
+            const uint_t N_curr, const uint_t N_next, const double *mu,
+            const mutation_model_container &mmodel,
+            const recombination_policy_container &rec_policies,
+            const interlocus_recombination &interlocus_rec,
+            const diploid_fitness_function &ff,
+            generation_workspace<dipvector_t,
+                                 typename gcont_t::value_type::
+                                     mutation_container> &workspace,
+            const double f, const mutation_removal_policy &mp)
+        /// Multi-locus API, single deme, with workspace
+        {
+            assert(popdata_sane_multilocus(diploids, gametes, mutations,
+                                           mcounts));
+            assert(mcounts.size() == mutations.size());
+            assert(diploids.size() == N_curr);
+            worker_pool_scope pool_scope(workspace.workers);
+            renumber_mutations_periodically(workspace, gametes, mutations,
+                                            mcounts);
+            update_common_variants_periodically(workspace, gametes, mutations,
+                                                mcounts, 2 * N_curr);
+            retire_extinct_gametes(workspace, gametes);
+            fill_mutation_recycling_bin(workspace, mcounts);
+            auto gamete_recycling_bin
+                = make_gamete_recycling_bin(workspace, gametes, false);
+            zero_gamete_counts(gametes, workspace.gamete_recycling_bin);
+            workspace.fitnesses.resize(N_curr);
+            double wbar = fill_fitnesses(diploids, gametes, mutations, ff,
+                                         workspace.fitnesses.data(),
+                                         workspace.nthreads);
+            wbar /= double(diploids.size());
+
+            if (workspace.samplers.empty())
+                {
+                    workspace.samplers.resize(1);
+                }
+            parent_lookup<parent_sampler> lookup(
+                workspace.use_parent_sampler ? &workspace.samplers[0]
+                                             : nullptr,
+                workspace.fitnesses.data(), N_curr);
+
+            resize_multilocus_diploids(
+                workspace.offspring, N_next,
+                diploids.empty() ? 0 : diploids[0].size());
+            generate_multilocus_offspring(
+                r, diploids, workspace.offspring, lookup, f, gametes,
+                mutations, mu, mmodel, rec_policies, interlocus_rec,
+                gamete_recycling_bin, workspace.mutation_recycling_bin,
+                workspace.neutral, workspace.selected, workspace.buffers);
+            diploids.swap(workspace.offspring);
+            merge_batched_offspring_gametes(workspace, gametes, diploids,
+                                            false);
+
+            count_mutations(workspace, gametes, mutations, mcounts);
+            gamete_cleaner(gametes, mutations, mcounts, 2 * N_next, mp,
+                           std::true_type(), workspace.nthreads);
+            remove_fixation_counts(workspace, mutations, 2 * N_next, mp);
+            merge_duplicate_gametes_periodically(workspace, gametes,
+                                                 diploids);
+            assert(popdata_sane_multilocus(diploids, gametes, mutations,
+                                           mcounts));
+            return wbar;
+        }
+    }
+
     // Multi-locus API
     // single deme, N changing
     template <
@@ -485,11 +568,12 @@ namespace fwdpp
         typename locus_vector_type_allocator,
         typename diploid_fitness_function, typename mutation_model_container,
         typename recombination_policy_container,
+        typename interlocus_recombination,
         template <typename, typename> class gamete_cont_type,
         template <typename, typename> class mutation_cont_type,
         template <typename, typename> class diploid_vector_type,
         template <typename, typename> class locus_vector_type,
-        typename mutation_removal_policy>
+        typename mutation_removal_policy, typename parent_sampler_t>
     double
     sample_diploid(
         const gsl_rng *r,
@@ -503,86 +587,405 @@ namespace fwdpp
         const uint_t &N_next, const double *mu,
         const mutation_model_container &mmodel,
         const recombination_policy_container &rec_policies,
-        const std::vector<std::function<unsigned(void)>> &interlocus_rec,
+        const interlocus_recombination &interlocus_rec,
+        const diploid_fitness_function &ff,
+        typename gamete_type::mutation_container &neutral,
+        typename gamete_type::mutation_container &selected, const double &f,
+        const mutation_removal_policy &mp, const unsigned nthreads,
+        parent_sampler_t *sampler)
+    {
+        return fwdpp_internal::sample_diploid_multilocus(
+            r, gametes, diploids, mutations, mcounts, N_curr, N_next, mu,
+            mmodel, rec_policies, interlocus_rec, ff, neutral, selected, f, mp,
+            nthreads, sampler);
+    }
+
+    // single deme, constant N
+    template <
+        typename diploid_geno_t, typename gamete_type,
+        typename gamete_cont_type_allocator, typename mutation_type,
+        typename mutation_cont_type_allocator,
+        typename diploid_vector_type_allocator,
+        typename locus_vector_type_allocator,
+        typename diploid_fitness_function, typename mutation_model_container,
+        typename recombination_policy_container,
+        typename interlocus_recombination,
+        template <typename, typename> class gamete_cont_type,
+        template <typename, typename> class mutation_cont_type,
+        template <typename, typename> class diploid_vector_type,
+        template <typename, typename> class locus_vector_type,
+        typename mutation_removal_policy, typename parent_sampler_t>
+    double
+    sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        diploid_vector_type<locus_vector_type<diploid_geno_t,
+                                              locus_vector_type_allocator>,
+                            diploid_vector_type_allocator> &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N, const double *mu,
+        const mutation_model_container &mmodel,
+        const recombination_policy_container &rec_policies,
+        const interlocus_recombination &interlocus_rec,
+        const diploid_fitness_function &ff,
+        typename gamete_type::mutation_container &neutral,
+        typename gamete_type::mutation_container &selected, const double &f,
+        const mutation_removal_policy &mp, const unsigned nthreads,
+        parent_sampler_t *sampler)
+    {
+        return sample_diploid(r, gametes, diploids, mutations, mcounts, N, N,
+                              mu, mmodel, rec_policies, interlocus_rec, ff,
+                              neutral, selected, f, mp, nthreads, sampler);
+    }
+
+    // Multi-locus API, single deme, N changing, genotype matrix
+    template <typename diploid_geno_t, typename gamete_type,
+              typename gamete_cont_type_allocator, typename mutation_type,
+              typename mutation_cont_type_allocator,
+              typename diploid_fitness_function,
+              typename mutation_model_container,
+              typename recombination_policy_container,
+              typename interlocus_recombination,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              typename mutation_removal_policy,
+              typename parent_sampler_t>
+    double
+    sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        multilocus_genotype_matrix<diploid_geno_t> &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N_curr,
+        const uint_t &N_next, const double *mu,
+        const mutation_model_container &mmodel,
+        const recombination_policy_container &rec_policies,
+        const interlocus_recombination &interlocus_rec,
+        const diploid_fitness_function &ff,
+        typename gamete_type::mutation_container &neutral,
+        typename gamete_type::mutation_container &selected, const double &f,
+        const mutation_removal_policy &mp, const unsigned nthreads,
+        parent_sampler_t *sampler)
+    {
+        return fwdpp_internal::sample_diploid_multilocus(
+            r, gametes, diploids, mutations, mcounts, N_curr, N_next, mu,
+            mmodel, rec_policies, interlocus_rec, ff, neutral, selected, f, mp,
+            nthreads, sampler);
+    }
+
+    // Multi-locus API, single deme, constant N, genotype matrix
+    template <typename diploid_geno_t, typename gamete_type,
+              typename gamete_cont_type_allocator, typename mutation_type,
+              typename mutation_cont_type_allocator,
+              typename diploid_fitness_function,
+              typename mutation_model_container,
+              typename recombination_policy_container,
+              typename interlocus_recombination,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              typename mutation_removal_policy,
+              typename parent_sampler_t>
+    double
+    sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        multilocus_genotype_matrix<diploid_geno_t> &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N, const double *mu,
+        const mutation_model_container &mmodel,
+        const recombination_policy_container &rec_policies,
+        const interlocus_recombination &interlocus_rec,
         const diploid_fitness_function &ff,
         typename gamete_type::mutation_container &neutral,
         typename gamete_type::mutation_container &selected, const double &f,
-        const mutation_removal_policy &mp)
+        const mutation_removal_policy &mp, const unsigned nthreads,
+        parent_sampler_t *sampler)
     {
-        assert(popdata_sane_multilocus(diploids, gametes, mutations, mcounts));
+        return fwdpp_internal::sample_diploid_multilocus(
+            r, gametes, diploids, mutations, mcounts, N, N, mu, mmodel,
+            rec_policies, interlocus_rec, ff, neutral, selected, f, mp,
+            nthreads, sampler);
+    }
+
+    // single deme, N changing, with workspace
+    template <typename gamete_type, typename gamete_cont_type_allocator,
+              typename mutation_type, typename mutation_cont_type_allocator,
+              typename diploid_geno_t, typename diploid_vector_type_allocator,
+              typename diploid_fitness_function, typename mutation_model,
+              typename recombination_policy,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              template <typename, typename> class diploid_vector_type,
+              typename mutation_removal_policy>
+    double
+    sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        diploid_vector_type<diploid_geno_t, diploid_vector_type_allocator>
+            &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N_curr,
+        const uint_t &N_next, const double &mu, const mutation_model &mmodel,
+        const recombination_policy &rec_pol,
+        const diploid_fitness_function &ff,
+        generation_workspace<diploid_vector_type<diploid_geno_t,
+                                                 diploid_vector_type_allocator>,
+                             typename gamete_type::mutation_container>
+            &workspace,
+        const double f, const mutation_removal_policy mp)
+    {
+        assert(popdata_sane(diploids, gametes, mutations, mcounts));
         assert(mcounts.size() == mutations.size());
-        assert(diploids.size() == N_curr);
-        // Vector of parental fitnesses
-        std::vector<double> fitnesses(N_curr);
-        double wbar = 0.;
-        auto mut_recycling_bin = fwdpp_internal::make_mut_queue(mcounts);
-        auto gamete_recycling_bin = fwdpp_internal::make_gamete_queue(gametes);
-        // Go over parents
-        for (uint_t i = 0; i < N_curr; ++i)
+        assert(N_curr == diploids.size());
+
+        // Same steps as the version not taking a workspace, using the
+        // memory and threads held by the workspace.
+        fwdpp_internal::worker_pool_scope pool_scope(workspace.workers);
+        fwdpp_internal::renumber_mutations_periodically(workspace, gametes,
+                                                        mutations, mcounts);
+        fwdpp_internal::update_common_variants_periodically(
+            workspace, gametes, mutations, mcounts, 2 * N_curr);
+        fwdpp_internal::retire_extinct_gametes(workspace, gametes);
+        fwdpp_internal::fill_mutation_recycling_bin(workspace, mcounts);
+        const bool batched
+            = (workspace.nthreads > 1 || workspace.sort_offspring);
+        auto gamete_recycling_bin = fwdpp_internal::make_gamete_recycling_bin(
+            workspace, gametes, batched);
+        if (workspace.use_fitness_cache)
             {
-                // set parental gamete counts to 0 for each locus
-                for (auto locus : diploids[i])
-                    {
-                        gametes[locus.first].n = gametes[locus.second].n = 0;
-                    }
-                // Calculate the fitness of this parent
-                fitnesses[i] = ff(diploids[i], gametes, mutations);
-                // increment pop. mean fitness
-                wbar += fitnesses[i];
+                // The extinct gametes may be recycled below
+                workspace.cache.invalidate_extinct(gametes);
             }
+        fwdpp_internal::zero_gamete_counts(gametes,
+                                           workspace.gamete_recycling_bin);
+        workspace.fitnesses.resize(diploids.size());
+        double wbar
+            = (workspace.use_fitness_cache)
+                  ? workspace.cache.fill(diploids, gametes, mutations, ff,
+                                         workspace.fitnesses.data(),
+                                         workspace.nthreads)
+                  : fwdpp_internal::fill_fitnesses(
+                        diploids, gametes, mutations, ff,
+                        workspace.fitnesses.data(), workspace.nthreads);
         wbar /= double(diploids.size());
-#ifndef NDEBUG
-        /*
-          If we are debugging, let's make sure that every gamete has been set
-          to n = 0.
-          Rationale for check:  if we are failing to update data types
-          properly, then
-          it is possible that the "gamete pool" contains items not carried by
-          any diploids.
-          If so, this assertion will fail.
-        */
-        for (const auto &g : gametes)
-            assert(!g.n);
-#endif
 
-        fwdpp_internal::gsl_ran_discrete_t_ptr lookup(
-            gsl_ran_discrete_preproc(fitnesses.size(), fitnesses.data()));
+        if (workspace.samplers.empty())
+            {
+                workspace.samplers.resize(1);
+            }
+        fwdpp_internal::parent_lookup<parent_sampler> lookup(
+            workspace.use_parent_sampler ? &workspace.samplers[0] : nullptr,
+            workspace.fitnesses.data(), N_curr);
 
-        const auto parents(diploids); // Copy the parents.  Exact copy of
-        // diploids--same fitnesses, etc.
+        // The parents stay where they are, and the offspring are written
+        // into the other buffer.
+        workspace.offspring.resize(N_next);
+        fwdpp_internal::generate_offspring(
+            r, diploids, workspace.offspring, lookup, f, gametes, mutations,
+            mu, mmodel, rec_pol, gamete_recycling_bin,
+            workspace.mutation_recycling_bin, workspace.neutral,
+            workspace.selected, workspace.buffers, workspace.batch,
+            workspace.scratch, workspace.nthreads, workspace.sort_offspring);
+        diploids.swap(workspace.offspring);
+        fwdpp_internal::merge_batched_offspring_gametes(workspace, gametes,
+                                                        diploids, batched);
+        assert(check_sum(gametes, 2 * N_next));
 
-        // Change the population size and reset dptr to avoid iterator
-        // invalidation
-        if (diploids.size() != N_next)
+        fwdpp_internal::count_mutations(workspace, gametes, mutations,
+                                        mcounts);
+        assert(mcounts.size() == mutations.size());
+        assert(popdata_sane(diploids, gametes, mutations, mcounts));
+        fwdpp_internal::gamete_cleaner(gametes, mutations, mcounts, 2 * N_next,
+                                       mp, workspace.nthreads);
+        fwdpp_internal::remove_fixation_counts(workspace, mutations,
+                                               2 * N_next, mp);
+        fwdpp_internal::merge_duplicate_gametes_periodically(
+            workspace, gametes, diploids);
+        return wbar;
+    }
+
+    // single deme, constant N, with workspace
+    template <typename gamete_type, typename gamete_cont_type_allocator,
+              typename mutation_type, typename mutation_cont_type_allocator,
+              typename diploid_geno_t, typename diploid_vector_type_allocator,
+              typename diploid_fitness_function, typename mutation_model,
+              typename recombination_policy,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              template <typename, typename> class diploid_vector_type,
+              typename mutation_removal_policy>
+    double
+    sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        diploid_vector_type<diploid_geno_t, diploid_vector_type_allocator>
+            &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N_curr, const double &mu,
+        const mutation_model &mmodel, const recombination_policy &rec_pol,
+        const diploid_fitness_function &ff,
+        generation_workspace<diploid_vector_type<diploid_geno_t,
+                                                 diploid_vector_type_allocator>,
+                             typename gamete_type::mutation_container>
+            &workspace,
+        const double f, const mutation_removal_policy mp)
+    {
+        return sample_diploid(r, gametes, diploids, mutations, mcounts, N_curr,
+                              N_curr, mu, mmodel, rec_pol, ff, workspace, f,
+                              mp);
+    }
+
+    // Metapopulation, changing N, with workspace
+    template <
+        typename gamete_type, typename mutation_type,
+        typename metapop_diploid_vector_type_allocator,
+        typename gamete_cont_type_allocator,
+        typename mutation_cont_type_allocator, typename diploid_geno_t,
+        typename diploid_vector_type_allocator,
+        typename diploid_fitness_function_container, typename mutation_model,
+        typename recombination_policy, typename migration_policy,
+        template <typename, typename> class gamete_cont_type,
+        template <typename, typename> class mutation_cont_type,
+        template <typename, typename> class diploid_vector_type,
+        template <typename, typename> class metapop_diploid_vector_type,
+        typename mutation_removal_policy>
+    std::vector<double>
+    sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        metapop_diploid_vector_type<diploid_vector_type<diploid_geno_t,
+                                                        diploid_vector_type_allocator>,
+                                    metapop_diploid_vector_type_allocator>
+            &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t *N_curr,
+        const uint_t *N_next, const double &mu, const mutation_model &mmodel,
+        const recombination_policy &rec_pol,
+        const diploid_fitness_function_container &ffs,
+        const migration_policy &mig,
+        generation_workspace<
+            metapop_diploid_vector_type<diploid_vector_type<diploid_geno_t,
+                                                            diploid_vector_type_allocator>,
+                                        metapop_diploid_vector_type_allocator>,
+            typename gamete_type::mutation_container> &workspace,
+        const double *f, const mutation_removal_policy &mp)
+    {
+        using lookup_t = fwdpp_internal::parent_lookup<parent_sampler>;
+        const auto ndemes = diploids.size();
+        std::vector<lookup_t> lookups;
+        std::vector<double> wbars(ndemes, 0);
+        fwdpp_internal::worker_pool_scope pool_scope(workspace.workers);
+        fwdpp_internal::renumber_mutations_periodically(workspace, gametes,
+                                                        mutations, mcounts);
+        fwdpp_internal::update_common_variants_periodically(
+            workspace, gametes, mutations, mcounts,
+            2 * std::accumulate(N_curr, N_curr + ndemes, uint_t(0)));
+        fwdpp_internal::retire_extinct_gametes(workspace, gametes);
+        fwdpp_internal::fill_mutation_recycling_bin(workspace, mcounts);
+        auto gamete_recycling_bin = fwdpp_internal::make_gamete_recycling_bin(
+            workspace, gametes, false);
+        fwdpp_internal::zero_gamete_counts(gametes,
+                                           workspace.gamete_recycling_bin);
+
+        // Each deme gets its own range of the fitness buffer
+        workspace.fitnesses.resize(
+            std::accumulate(N_curr, N_curr + ndemes, std::size_t(0)));
+        if (workspace.samplers.size() < ndemes)
             {
-                diploids.resize(N_next);
+                workspace.samplers.resize(ndemes);
+            }
+        std::size_t offset = 0;
+        lookups.reserve(ndemes);
+        for (std::size_t popi = 0; popi < ndemes; ++popi)
+            {
+                wbars[popi] = fwdpp_internal::fill_fitnesses(
+                    diploids[popi], gametes, mutations, ffs[popi],
+                    workspace.fitnesses.data() + offset, workspace.nthreads);
+                wbars[popi] /= double(diploids[popi].size());
+                lookups.emplace_back(workspace.use_parent_sampler
+                                         ? &workspace.samplers[popi]
+                                         : nullptr,
+                                     workspace.fitnesses.data() + offset,
+                                     diploids[popi].size());
+                offset += diploids[popi].size();
             }
 
-        assert(diploids.size() == N_next);
-
-        for (auto &dip : diploids)
+        workspace.offspring.resize(ndemes);
+        for (std::size_t popi = 0; popi < ndemes; ++popi)
             {
-                auto p1 = gsl_ran_discrete(r, lookup.get());
-                assert(p1 < N_curr);
-                auto p2 = (f == 1. || (f > 0. && gsl_rng_uniform(r) < f))
-                              ? p1
-                              : gsl_ran_discrete(r, lookup.get());
-                assert(p2 < N_curr);
-                dip = fwdpp_internal::multilocus_rec_mut(
-                    r, parents[p1], parents[p2], mut_recycling_bin,
-                    gamete_recycling_bin, rec_policies, interlocus_rec,
-                    ((gsl_rng_uniform(r) < 0.5) ? 1 : 0),
-                    ((gsl_rng_uniform(r) < 0.5) ? 1 : 0), gametes, mutations,
-                    neutral, selected, mu, mmodel);
+                workspace.offspring[popi].resize(*(N_next + popi));
             }
-        fwdpp_internal::process_gametes(gametes, mutations, mcounts);
-        fwdpp_internal::gamete_cleaner(gametes, mutations, mcounts, 2 * N_next,
-                                       mp, std::true_type());
-        assert(popdata_sane_multilocus(diploids, gametes, mutations, mcounts));
-        return wbar;
+        fwdpp_internal::generate_metapop_offspring(
+            r, diploids, workspace.offspring, lookups, mig, f, gametes,
+            mutations, mu, mmodel, rec_pol, gamete_recycling_bin,
+            workspace.mutation_recycling_bin, workspace.neutral,
+            workspace.selected, workspace.buffers);
+        diploids.swap(workspace.offspring);
+        fwdpp_internal::merge_batched_offspring_gametes(workspace, gametes,
+                                                        diploids, false);
+
+        const auto twoN
+            = 2 * std::accumulate(N_next, N_next + ndemes, uint_t(0));
+        fwdpp_internal::count_mutations(workspace, gametes, mutations,
+                                        mcounts);
+        assert(mcounts.size() == mutations.size());
+        fwdpp_internal::gamete_cleaner(gametes, mutations, mcounts, twoN, mp,
+                                       workspace.nthreads);
+        fwdpp_internal::remove_fixation_counts(workspace, mutations, twoN,
+                                               mp);
+        fwdpp_internal::merge_duplicate_gametes_periodically(
+            workspace, gametes, diploids);
+        assert(check_sum(gametes, twoN));
+        return wbars;
     }
 
-    // single deme, constant N
+    // Metapopulation, constant N, with workspace
+    template <
+        typename gamete_type, typename mutation_type,
+        typename metapop_diploid_vector_type_allocator,
+        typename gamete_cont_type_allocator,
+        typename mutation_cont_type_allocator, typename diploid_geno_t,
+        typename diploid_vector_type_allocator,
+        typename diploid_fitness_function_container, typename mutation_model,
+        typename recombination_policy, typename migration_policy,
+        template <typename, typename> class gamete_cont_type,
+        template <typename, typename> class mutation_cont_type,
+        template <typename, typename> class diploid_vector_type,
+        template <typename, typename> class metapop_diploid_vector_type,
+        typename mutation_removal_policy>
+    std::vector<double>
+    sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        metapop_diploid_vector_type<diploid_vector_type<diploid_geno_t,
+                                                        diploid_vector_type_allocator>,
+                                    metapop_diploid_vector_type_allocator>
+            &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t *N_curr, const double &mu,
+        const mutation_model &mmodel, const recombination_policy &rec_pol,
+        const diploid_fitness_function_container &ffs,
+        const migration_policy &mig,
+        generation_workspace<
+            metapop_diploid_vector_type<diploid_vector_type<diploid_geno_t,
+                                                            diploid_vector_type_allocator>,
+                                        metapop_diploid_vector_type_allocator>,
+            typename gamete_type::mutation_container> &workspace,
+        const double *f, const mutation_removal_policy &mp)
+    {
+        return sample_diploid(r, gametes, diploids, mutations, mcounts, N_curr,
+                              N_curr, mu, mmodel, rec_pol, ffs, mig,
+                              workspace, f, mp);
+    }
+
+    // Multi-locus API, single deme, N changing, with workspace
     template <
         typename diploid_geno_t, typename gamete_type,
         typename gamete_cont_type_allocator, typename mutation_type,
@@ -591,6 +994,49 @@ namespace fwdpp
         typename locus_vector_type_allocator,
         typename diploid_fitness_function, typename mutation_model_container,
         typename recombination_policy_container,
+        typename interlocus_recombination,
+        template <typename, typename> class gamete_cont_type,
+        template <typename, typename> class mutation_cont_type,
+        template <typename, typename> class diploid_vector_type,
+        template <typename, typename> class locus_vector_type,
+        typename mutation_removal_policy>
+    double
+    sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        diploid_vector_type<locus_vector_type<diploid_geno_t,
+                                              locus_vector_type_allocator>,
+                            diploid_vector_type_allocator> &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N_curr,
+        const uint_t &N_next, const double *mu,
+        const mutation_model_container &mmodel,
+        const recombination_policy_container &rec_policies,
+        const interlocus_recombination &interlocus_rec,
+        const diploid_fitness_function &ff,
+        generation_workspace<
+            diploid_vector_type<locus_vector_type<diploid_geno_t,
+                                                  locus_vector_type_allocator>,
+                                diploid_vector_type_allocator>,
+            typename gamete_type::mutation_container> &workspace,
+        const double &f, const mutation_removal_policy &mp)
+    {
+        return fwdpp_internal::sample_diploid_multilocus(
+            r, gametes, diploids, mutations, mcounts, N_curr, N_next, mu,
+            mmodel, rec_policies, interlocus_rec, ff, workspace, f, mp);
+    }
+
+    // Multi-locus API, single deme, constant N, with workspace
+    template <
+        typename diploid_geno_t, typename gamete_type,
+        typename gamete_cont_type_allocator, typename mutation_type,
+        typename mutation_cont_type_allocator,
+        typename diploid_vector_type_allocator,
+        typename locus_vector_type_allocator,
+        typename diploid_fitness_function, typename mutation_model_container,
+        typename recombination_policy_container,
+        typename interlocus_recombination,
         template <typename, typename> class gamete_cont_type,
         template <typename, typename> class mutation_cont_type,
         template <typename, typename> class diploid_vector_type,
@@ -608,15 +1054,87 @@ namespace fwdpp
         std::vector<uint_t> &mcounts, const uint_t &N, const double *mu,
         const mutation_model_container &mmodel,
         const recombination_policy_container &rec_policies,
-        const std::vector<std::function<unsigned(void)>> &interlocus_rec,
+        const interlocus_recombination &interlocus_rec,
         const diploid_fitness_function &ff,
-        typename gamete_type::mutation_container &neutral,
-        typename gamete_type::mutation_container &selected, const double &f,
-        const mutation_removal_policy &mp)
+        generation_workspace<
+            diploid_vector_type<locus_vector_type<diploid_geno_t,
+                                                  locus_vector_type_allocator>,
+                                diploid_vector_type_allocator>,
+            typename gamete_type::mutation_container> &workspace,
+        const double &f, const mutation_removal_policy &mp)
     {
         return sample_diploid(r, gametes, diploids, mutations, mcounts, N, N,
                               mu, mmodel, rec_policies, interlocus_rec, ff,
-                              neutral, selected, f, mp);
+                              workspace, f, mp);
+    }
+
+    // Multi-locus API, single deme, N changing, genotype matrix, with
+    // workspace
+    template <typename diploid_geno_t, typename gamete_type,
+              typename gamete_cont_type_allocator, typename mutation_type,
+              typename mutation_cont_type_allocator,
+              typename diploid_fitness_function,
+              typename mutation_model_container,
+              typename recombination_policy_container,
+              typename interlocus_recombination,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              typename mutation_removal_policy>
+    double
+    sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        multilocus_genotype_matrix<diploid_geno_t> &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N_curr,
+        const uint_t &N_next, const double *mu,
+        const mutation_model_container &mmodel,
+        const recombination_policy_container &rec_policies,
+        const interlocus_recombination &interlocus_rec,
+        const diploid_fitness_function &ff,
+        generation_workspace<multilocus_genotype_matrix<diploid_geno_t>,
+                             typename gamete_type::mutation_container>
+            &workspace,
+        const double &f, const mutation_removal_policy &mp)
+    {
+        return fwdpp_internal::sample_diploid_multilocus(
+            r, gametes, diploids, mutations, mcounts, N_curr, N_next, mu,
+            mmodel, rec_policies, interlocus_rec, ff, workspace, f, mp);
+    }
+
+    // Multi-locus API, single deme, constant N, genotype matrix, with
+    // workspace
+    template <typename diploid_geno_t, typename gamete_type,
+              typename gamete_cont_type_allocator, typename mutation_type,
+              typename mutation_cont_type_allocator,
+              typename diploid_fitness_function,
+              typename mutation_model_container,
+              typename recombination_policy_container,
+              typename interlocus_recombination,
+              template <typename, typename> class gamete_cont_type,
+              template <typename, typename> class mutation_cont_type,
+              typename mutation_removal_policy>
+    double
+    sample_diploid(
+        const gsl_rng *r,
+        gamete_cont_type<gamete_type, gamete_cont_type_allocator> &gametes,
+        multilocus_genotype_matrix<diploid_geno_t> &diploids,
+        mutation_cont_type<mutation_type, mutation_cont_type_allocator>
+            &mutations,
+        std::vector<uint_t> &mcounts, const uint_t &N, const double *mu,
+        const mutation_model_container &mmodel,
+        const recombination_policy_container &rec_policies,
+        const interlocus_recombination &interlocus_rec,
+        const diploid_fitness_function &ff,
+        generation_workspace<multilocus_genotype_matrix<diploid_geno_t>,
+                             typename gamete_type::mutation_container>
+            &workspace,
+        const double &f, const mutation_removal_policy &mp)
+    {
+        return fwdpp_internal::sample_diploid_multilocus(
+            r, gametes, diploids, mutations, mcounts, N, N, mu, mmodel,
+            rec_policies, interlocus_rec, ff, workspace, f, mp);
     }
 }
 
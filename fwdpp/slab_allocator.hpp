@@ -0,0 +1,697 @@
+/*!
+  \file slab_allocator.hpp
+
+  \brief A pool allocator for the mutation keys of gametes.
+*/
+#ifndef FWDPP_SLAB_ALLOCATOR_HPP__
+#define FWDPP_SLAB_ALLOCATOR_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/tags/tags.hpp>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+namespace fwdpp
+{
+    class slab_thread_cache;
+
+    struct slab_allocator_stats
+    /*!
+      \brief Statistics of a fwdpp::slab_arena
+
+      \ingroup basicTypes
+    */
+    {
+        //! Number of blocks handed out, including large blocks
+        std::uint64_t allocations;
+        //! Number of blocks returned, including large blocks
+        std::uint64_t deallocations;
+        //! Number of requests too large for a size class
+        std::uint64_t large_allocations;
+        //! Number of requests served from a free list
+        std::uint64_t reused;
+        //! Bytes in blocks that are in use, rounded up to size classes
+        std::size_t bytes_in_use;
+        //! Bytes held in slabs
+        std::size_t bytes_reserved;
+        //! Number of slabs
+        std::size_t slabs;
+        //! Number of slabs for which huge pages were requested
+        std::size_t huge_page_slabs;
+    };
+
+    class slab_arena
+    /*!
+      \brief Size-class slabs holding the buffers of mutation key
+      containers.
+
+      A request of n bytes is rounded up to the next size class, which
+      are the powers of two from min_block_size to max_block_size.
+      Blocks of each class are cut from large slabs, and freed blocks
+      are kept in a free list per class for reuse by the next request
+      of the same class.  Memory is only returned to the system when
+      the arena is destroyed.  Requests larger than max_block_size go
+      to operator new.
+
+      A population reuses the same few buffer sizes from one generation
+      to the next, as gametes are recycled and their containers grow.
+      Those requests are then served from free lists without calling
+      malloc and without fragmenting the heap, which is what linking to
+      tcmalloc or jemalloc otherwise achieves.
+
+      On Linux, slabs may be backed by transparent huge pages.  See
+      set_huge_pages.
+
+      The arena may be used by several threads, and each call to
+      allocate and deallocate takes a lock.  fwdpp::slab_allocator does
+      not call them directly, but goes through a fwdpp::slab_thread_cache
+      per thread, which only takes the lock to move blocks in batches.
+      \ingroup basicTypes
+    */
+    {
+      public:
+        //! Smallest size class, in bytes
+        static constexpr std::size_t min_block_size = 16;
+        //! Number of size classes
+        static constexpr std::size_t nclasses = 13;
+        //! Largest size class, in bytes
+        static constexpr std::size_t max_block_size = min_block_size
+                                                      << (nclasses - 1);
+        //! Size of a huge page on x86-64 and arm64 Linux
+        static constexpr std::size_t huge_page_size = std::size_t(1) << 21;
+
+      private:
+        friend class slab_thread_cache;
+
+        struct free_block
+        {
+            free_block *next;
+        };
+
+        struct thread_counters
+        // Statistics of a slab_thread_cache.  Only written by the thread
+        // owning the cache, and read by stats().
+        {
+            std::atomic<std::uint64_t> allocations, deallocations,
+                large_allocations, reused;
+            // May wrap around if blocks are freed by another thread
+            std::atomic<std::size_t> bytes_in_use;
+            thread_counters()
+                : allocations{ 0 }, deallocations{ 0 },
+                  large_allocations{ 0 }, reused{ 0 }, bytes_in_use{ 0 }
+            {
+            }
+        };
+
+        struct slab
+        {
+            void *memory;
+            bool aligned;
+        };
+
+        mutable std::mutex mutex;
+        free_block *free_lists[nclasses];
+        std::vector<slab> slabs;
+        // The unused part of the last slab
+        char *next_byte, *last_byte;
+        std::size_t slab_size;
+        bool huge_pages;
+        slab_allocator_stats statistics;
+        std::vector<const thread_counters *> caches;
+
+        static std::size_t
+        size_class(const std::size_t bytes) noexcept
+        {
+            std::size_t c = 0;
+            while ((min_block_size << c) < bytes)
+                {
+                    ++c;
+                }
+            return c;
+        }
+
+        void
+        add_slab()
+        {
+            slab s{ nullptr, false };
+#if defined(__unix__) || defined(__APPLE__)
+            if (huge_pages)
+                {
+                    if (posix_memalign(&s.memory, huge_page_size, slab_size)
+                        == 0)
+                        {
+                            s.aligned = true;
+#if defined(MADV_HUGEPAGE)
+                            if (madvise(s.memory, slab_size, MADV_HUGEPAGE)
+                                == 0)
+                                {
+                                    ++statistics.huge_page_slabs;
+                                }
+#endif
+                        }
+                    else
+                        {
+                            s.memory = nullptr;
+                        }
+                }
+#endif
+            if (s.memory == nullptr)
+                {
+                    s.memory = ::operator new(slab_size);
+                }
+            slabs.push_back(s);
+            next_byte = static_cast<char *>(s.memory);
+            last_byte = next_byte + slab_size;
+            ++statistics.slabs;
+            statistics.bytes_reserved += slab_size;
+        }
+
+        void *
+        carve(const std::size_t block_size)
+        // Cut a new block from the last slab.  The lock must be held.
+        {
+            if (next_byte == nullptr
+                || std::size_t(last_byte - next_byte) < block_size)
+                {
+                    // The rest of the slab, if any, is left unused.
+                    add_slab();
+                }
+            void *p = next_byte;
+            next_byte += block_size;
+            return p;
+        }
+
+        std::size_t
+        take_blocks(const std::size_t c, const std::size_t n,
+                    free_block *&head, bool &fresh)
+        // Move up to n blocks of class c to the list head.  They are
+        // taken from the free list if it is not empty, and otherwise n
+        // new blocks are cut, in which case fresh is set.  Returns the
+        // number of blocks.
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::size_t k = 0;
+            fresh = (free_lists[c] == nullptr);
+            if (!fresh)
+                {
+                    head = free_lists[c];
+                    auto tail = head;
+                    for (k = 1; k < n && tail->next != nullptr; ++k)
+                        {
+                            tail = tail->next;
+                        }
+                    free_lists[c] = tail->next;
+                    tail->next = nullptr;
+                    return k;
+                }
+            const auto block_size = min_block_size << c;
+            free_block *first = nullptr, **tail = &first;
+            for (; k < n; ++k)
+                {
+                    *tail = static_cast<free_block *>(carve(block_size));
+                    (*tail)->next = nullptr;
+                    tail = &(*tail)->next;
+                }
+            head = first;
+            return k;
+        }
+
+        void
+        return_blocks(const std::size_t c, free_block *head,
+                      free_block *tail) noexcept
+        // Put the list from head to tail back on the free list of class c
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tail->next = free_lists[c];
+            free_lists[c] = head;
+        }
+
+        void
+        add_cache(const thread_counters *counters)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            caches.push_back(counters);
+        }
+
+        void
+        remove_cache(const thread_counters *counters) noexcept
+        // Keep the statistics of a cache that is destroyed
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            add_counters(statistics, *counters);
+            caches.erase(std::find(caches.begin(), caches.end(), counters));
+        }
+
+        static void
+        add_counters(slab_allocator_stats &s,
+                     const thread_counters &counters) noexcept
+        {
+            s.allocations
+                += counters.allocations.load(std::memory_order_relaxed);
+            s.deallocations
+                += counters.deallocations.load(std::memory_order_relaxed);
+            s.large_allocations
+                += counters.large_allocations.load(std::memory_order_relaxed);
+            s.reused += counters.reused.load(std::memory_order_relaxed);
+            s.bytes_in_use
+                += counters.bytes_in_use.load(std::memory_order_relaxed);
+        }
+
+        static void
+        free_slab(const slab &s) noexcept
+        {
+            if (s.aligned)
+                {
+                    std::free(s.memory);
+                }
+            else
+                {
+                    ::operator delete(s.memory);
+                }
+        }
+
+      public:
+        explicit slab_arena(const std::size_t slab_size_ = huge_page_size,
+                            const bool huge_pages_ = false)
+            /*!
+              \param slab_size_ Bytes per slab, which is rounded up to a
+              multiple of max_block_size
+              \param huge_pages_ See set_huge_pages
+            */
+            : mutex{}, slabs{}, next_byte(nullptr), last_byte(nullptr),
+              slab_size(((slab_size_ + max_block_size - 1) / max_block_size)
+                        * max_block_size),
+              huge_pages(huge_pages_), statistics{}, caches{}
+        {
+            for (auto &f : free_lists)
+                {
+                    f = nullptr;
+                }
+        }
+
+        slab_arena(const slab_arena &) = delete;
+        slab_arena &operator=(const slab_arena &) = delete;
+
+        ~slab_arena()
+        /// Frees all slabs, and so must outlive the blocks and the
+        /// fwdpp::slab_thread_cache objects using it.
+        {
+            for (const auto &s : slabs)
+                {
+                    free_slab(s);
+                }
+        }
+
+        void *
+        allocate(const std::size_t bytes)
+        {
+            if (bytes > max_block_size)
+                {
+                    void *p = ::operator new(bytes);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++statistics.allocations;
+                    ++statistics.large_allocations;
+                    statistics.bytes_in_use += bytes;
+                    return p;
+                }
+            const auto c = size_class(bytes);
+            const auto block_size = min_block_size << c;
+            std::lock_guard<std::mutex> lock(mutex);
+            ++statistics.allocations;
+            statistics.bytes_in_use += block_size;
+            if (free_lists[c] != nullptr)
+                {
+                    auto b = free_lists[c];
+                    free_lists[c] = b->next;
+                    ++statistics.reused;
+                    return b;
+                }
+            return carve(block_size);
+        }
+
+        void
+        deallocate(void *p, const std::size_t bytes) noexcept
+        /// \a bytes must be the same as passed to allocate
+        {
+            if (p == nullptr)
+                {
+                    return;
+                }
+            if (bytes > max_block_size)
+                {
+                    ::operator delete(p);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++statistics.deallocations;
+                    statistics.bytes_in_use -= bytes;
+                    return;
+                }
+            const auto c = size_class(bytes);
+            auto b = static_cast<free_block *>(p);
+            std::lock_guard<std::mutex> lock(mutex);
+            b->next = free_lists[c];
+            free_lists[c] = b;
+            ++statistics.deallocations;
+            statistics.bytes_in_use -= (min_block_size << c);
+        }
+
+        void
+        set_huge_pages(const bool h)
+        /*!
+          If true, new slabs are aligned to huge_page_size, and the
+          kernel is asked to back them by transparent huge pages
+          (madvise with MADV_HUGEPAGE), which reduces TLB misses when
+          many gametes are visited.  Ignored where not supported.
+          slab_allocator_stats::huge_page_slabs counts successful
+          requests.
+        */
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            huge_pages = h;
+        }
+
+        slab_allocator_stats
+        stats() const
+        /// Includes the blocks handed out by fwdpp::slab_thread_cache
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto rv = statistics;
+            for (auto c : caches)
+                {
+                    add_counters(rv, *c);
+                }
+            return rv;
+        }
+    };
+
+    class slab_thread_cache
+    /*!
+      \brief Free lists of one thread in front of a fwdpp::slab_arena
+
+      Blocks are handed out from, and freed to, free lists private to
+      the cache, so that threads allocating gametes at the same time do
+      not wait for each other.  An empty list is refilled with a batch
+      of blocks from the arena, and a list that has grown to two
+      batches gives one batch back, taking the lock of the arena once
+      per batch.  A batch holds batch_bytes, or one block of the
+      largest classes.  All blocks are given back when the cache is
+      destroyed.
+
+      A cache must only be used by the thread that created it.  Blocks
+      may be freed to a cache other than the one that handed them out.
+      fwdpp::slab_allocator uses one cache per thread, see
+      fwdpp::this_thread_slab_cache.
+      \ingroup basicTypes
+    */
+    {
+      public:
+        //! Bytes moved from or to the arena at a time, per size class
+        static constexpr std::size_t batch_bytes = std::size_t(1) << 15;
+
+      private:
+        using free_block = slab_arena::free_block;
+
+        struct free_list
+        {
+            free_block *head;
+            std::size_t n;
+            // The number of blocks at the end of the list that were cut
+            // from a slab and never handed out
+            std::size_t nfresh;
+        };
+
+        slab_arena &arena;
+        free_list lists[slab_arena::nclasses];
+        slab_arena::thread_counters counters;
+
+        static void
+        bump(std::atomic<std::uint64_t> &c, const std::uint64_t n) noexcept
+        // Only the owning thread writes, so no atomic add is needed
+        {
+            c.store(c.load(std::memory_order_relaxed) + n,
+                    std::memory_order_relaxed);
+        }
+
+        static void
+        bump(std::atomic<std::size_t> &c, const std::size_t n,
+             const bool add) noexcept
+        {
+            const auto v = c.load(std::memory_order_relaxed);
+            c.store(add ? v + n : v - n, std::memory_order_relaxed);
+        }
+
+        static std::size_t
+        batch_size(const std::size_t c) noexcept
+        {
+            return std::max(batch_bytes / (slab_arena::min_block_size << c),
+                            std::size_t(1));
+        }
+
+        void
+        give_back(const std::size_t c, const std::size_t n) noexcept
+        // Give the first n blocks of list c back to the arena
+        {
+            auto &l = lists[c];
+            auto tail = l.head;
+            for (std::size_t i = 1; i < n; ++i)
+                {
+                    tail = tail->next;
+                }
+            auto head = l.head;
+            l.head = tail->next;
+            l.n -= n;
+            l.nfresh = std::min(l.nfresh, l.n);
+            arena.return_blocks(c, head, tail);
+        }
+
+      public:
+        explicit slab_thread_cache(slab_arena &arena_)
+            : arena(arena_), counters{}
+        {
+            for (auto &l : lists)
+                {
+                    l.head = nullptr;
+                    l.n = l.nfresh = 0;
+                }
+            arena.add_cache(&counters);
+        }
+
+        slab_thread_cache(const slab_thread_cache &) = delete;
+        slab_thread_cache &operator=(const slab_thread_cache &) = delete;
+
+        ~slab_thread_cache()
+        {
+            for (std::size_t c = 0; c < slab_arena::nclasses; ++c)
+                {
+                    if (lists[c].n)
+                        {
+                            give_back(c, lists[c].n);
+                        }
+                }
+            arena.remove_cache(&counters);
+        }
+
+        void *
+        allocate(const std::size_t bytes)
+        /// Same as slab_arena::allocate
+        {
+            if (bytes > slab_arena::max_block_size)
+                {
+                    void *p = ::operator new(bytes);
+                    bump(counters.allocations, 1);
+                    bump(counters.large_allocations, 1);
+                    bump(counters.bytes_in_use, bytes, true);
+                    return p;
+                }
+            const auto c = slab_arena::size_class(bytes);
+            auto &l = lists[c];
+            if (l.head == nullptr)
+                {
+                    bool fresh;
+                    l.n = arena.take_blocks(c, batch_size(c), l.head, fresh);
+                    l.nfresh = fresh ? l.n : 0;
+                }
+            auto b = l.head;
+            l.head = b->next;
+            // Fresh blocks are at the end of the list
+            if (l.n-- == l.nfresh)
+                {
+                    --l.nfresh;
+                }
+            else
+                {
+                    bump(counters.reused, 1);
+                }
+            bump(counters.allocations, 1);
+            bump(counters.bytes_in_use, slab_arena::min_block_size << c,
+                 true);
+            return b;
+        }
+
+        void
+        deallocate(void *p, const std::size_t bytes) noexcept
+        /// Same as slab_arena::deallocate
+        {
+            if (p == nullptr)
+                {
+                    return;
+                }
+            bump(counters.deallocations, 1);
+            if (bytes > slab_arena::max_block_size)
+                {
+                    ::operator delete(p);
+                    bump(counters.bytes_in_use, bytes, false);
+                    return;
+                }
+            const auto c = slab_arena::size_class(bytes);
+            bump(counters.bytes_in_use, slab_arena::min_block_size << c,
+                 false);
+            auto &l = lists[c];
+            auto b = static_cast<free_block *>(p);
+            b->next = l.head;
+            l.head = b;
+            const auto batch = batch_size(c);
+            if (++l.n >= 2 * batch)
+                {
+                    give_back(c, batch);
+                }
+        }
+    };
+
+    inline slab_arena &
+    default_slab_arena()
+    /*!
+      \brief The arena used by fwdpp::slab_allocator.
+
+      The arena is never destroyed, so that containers with static
+      storage duration may free their buffers at exit.
+      \ingroup basicTypes
+    */
+    {
+        static slab_arena *arena = new slab_arena();
+        return *arena;
+    }
+
+    inline slab_allocator_stats
+    slab_allocator_statistics()
+    /// Statistics of fwdpp::default_slab_arena
+    {
+        return default_slab_arena().stats();
+    }
+
+    inline slab_thread_cache *
+    this_thread_slab_cache()
+    /*!
+      \brief The fwdpp::slab_thread_cache of the calling thread, in front
+      of fwdpp::default_slab_arena.
+
+      The cache is created on first use and destroyed when the thread
+      exits.  Returns nullptr once it is destroyed, after which the
+      thread must use the arena directly.
+      \ingroup basicTypes
+    */
+    {
+        // Trivially destructible, and so still valid while objects with
+        // static storage duration are destroyed
+        static thread_local bool destroyed = false;
+        struct owned_cache
+        {
+            slab_thread_cache cache;
+            owned_cache() : cache(default_slab_arena()) {}
+            ~owned_cache() { destroyed = true; }
+        };
+        if (destroyed)
+            {
+                return nullptr;
+            }
+        static thread_local owned_cache owned;
+        return &owned.cache;
+    }
+
+    template <typename T> struct slab_allocator
+    /*!
+      \brief An allocator taking memory from fwdpp::default_slab_arena,
+      through the fwdpp::slab_thread_cache of the calling thread.
+
+      See fwdpp::slab_mutation_container and fwdpp::slab_gamete.
+      \ingroup basicTypes
+    */
+    {
+        using value_type = T;
+
+        slab_allocator() noexcept {}
+        template <typename U>
+        slab_allocator(const slab_allocator<U> &) noexcept
+        {
+        }
+
+        T *
+        allocate(const std::size_t n)
+        {
+            if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+                {
+                    throw std::bad_alloc();
+                }
+            auto cache = this_thread_slab_cache();
+            return static_cast<T *>(
+                cache ? cache->allocate(n * sizeof(T))
+                      : default_slab_arena().allocate(n * sizeof(T)));
+        }
+
+        void
+        deallocate(T *p, const std::size_t n) noexcept
+        {
+            auto cache = this_thread_slab_cache();
+            if (cache)
+                {
+                    cache->deallocate(p, n * sizeof(T));
+                }
+            else
+                {
+                    default_slab_arena().deallocate(p, n * sizeof(T));
+                }
+        }
+    };
+
+    template <typename T, typename U>
+    inline bool
+    operator==(const slab_allocator<T> &, const slab_allocator<U> &) noexcept
+    {
+        return true;
+    }
+
+    template <typename T, typename U>
+    inline bool
+    operator!=(const slab_allocator<T> &, const slab_allocator<U> &) noexcept
+    {
+        return false;
+    }
+
+    //! Mutation keys whose buffers come from fwdpp::default_slab_arena
+    using slab_mutation_container = std::vector<uint_t, slab_allocator<uint_t>>;
+
+    /*!
+      \brief A gamete whose keys are held in buffers taken from
+      fwdpp::default_slab_arena.
+
+      Otherwise the same as fwdpp::gamete.  The sugar population types
+      take the gamete type as a template parameter, for example
+      fwdpp::singlepop<fwdpp::popgenmut, std::pair<std::size_t,
+      std::size_t>, fwdpp::slab_gamete<>>.
+      \ingroup basicTypes
+    */
+    template <typename TAG = tags::standard_gamete>
+    using slab_gamete = gamete_base<TAG, slab_mutation_container>;
+}
+
+#endif
@@ -0,0 +1,305 @@
+/*!
+  \file soa_mutation_vector.hpp
+
+  \brief A container of mutations holding positions in a separate column.
+*/
+#ifndef FWDPP_SOA_MUTATION_VECTOR_HPP__
+#define FWDPP_SOA_MUTATION_VECTOR_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <fwdpp/type_traits.hpp>
+#include <fwdpp/internal/mutation_columns.hpp>
+
+namespace fwdpp
+{
+    namespace fwdpp_internal
+    {
+        template <typename mutation_type>
+        inline double
+        scalar_effect_size(const mutation_type &, std::false_type) noexcept
+        {
+            return 0.;
+        }
+
+        template <typename mutation_type>
+        inline double
+        scalar_effect_size(const mutation_type &m, std::true_type) noexcept
+        {
+            return static_cast<double>(m.s);
+        }
+
+        template <typename mutation_type, typename = void>
+        struct has_scalar_effect_size : std::false_type
+        {
+        };
+
+        template <typename mutation_type>
+        struct has_scalar_effect_size<
+            mutation_type,
+            typename std::enable_if<std::is_arithmetic<decltype(
+                std::declval<const mutation_type &>().s)>::value>::type>
+            : std::true_type
+        {
+        };
+
+        template <typename mutation_type>
+        inline double
+        scalar_effect_size(const mutation_type &m) noexcept
+        /// m.s if it is a number, and 0 otherwise
+        {
+            return scalar_effect_size(
+                m, has_scalar_effect_size<mutation_type>());
+        }
+    }
+
+    template <typename mutation_type,
+              typename allocator = std::allocator<mutation_type>>
+    class soa_mutation_vector
+    /*!
+      \brief A container of mutations keeping positions, neutrality
+      flags and effect sizes in separate, contiguous columns.
+
+      The merging of keys during recombination, the insertion of new
+      mutations and the fitness models compare mutation positions many
+      times per offspring.  In a std::vector of mutation objects, each
+      of those comparisons reads a whole record, which holds a virtual
+      table pointer and all other fields of the mutation.  This
+      container additionally keeps mutations[k].pos in
+      positions()[k], and the library reads positions and neutrality
+      from those columns instead.  See
+      fwdpp_internal::mutation_position.
+
+      The records are still stored, and element access returns a const
+      reference to them, so that mutation models, fitness policies and
+      fwdpp_internal::recycle_mutation_helper work unchanged.  Because
+      the columns must stay in sync with the records, elements are only
+      modified through set(), push_back() and emplace_back().
+
+      The effect size column holds mutation_type::s if that is a
+      number, and zero otherwise.  \a allocator is the allocator of
+      the records, so that the container has the same template
+      parameters as std::vector.
+
+      This container may be used in place of std::vector for the
+      mutations passed to fwdpp::sample_diploid and the functions it
+      calls, including as the mutation container of
+      fwdpp::sugar::singlepop.  The outcome of a simulation does not
+      change.
+      \ingroup basicTypes
+    */
+    {
+        static_assert(traits::is_mutation<mutation_type>::value,
+                      "mutation_type must be derived from "
+                      "fwdpp::mutation_base");
+
+      public:
+        using value_type = mutation_type;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using const_reference = const value_type &;
+        using reference = const_reference;
+        using allocator_type = allocator;
+        using record_container = std::vector<value_type, allocator>;
+        using const_iterator = typename record_container::const_iterator;
+        using iterator = const_iterator;
+        //! Type of the column of positions
+        using position_column_type = std::vector<double>;
+
+      private:
+        record_container mrecords;
+        position_column_type pos;
+        std::vector<std::uint8_t> neutral;
+        std::vector<double> esize;
+
+        void
+        append_columns(const value_type &m)
+        {
+            pos.push_back(m.pos);
+            neutral.push_back(m.neutral);
+            esize.push_back(fwdpp_internal::scalar_effect_size(m));
+        }
+
+      public:
+        soa_mutation_vector() : mrecords{}, pos{}, neutral{}, esize{} {}
+
+        explicit soa_mutation_vector(record_container records)
+            : mrecords(std::move(records)), pos{}, neutral{}, esize{}
+        {
+            reserve(mrecords.size());
+            for (const auto &m : mrecords)
+                {
+                    append_columns(m);
+                }
+        }
+
+        size_type
+        size() const noexcept
+        {
+            return mrecords.size();
+        }
+
+        bool
+        empty() const noexcept
+        {
+            return mrecords.empty();
+        }
+
+        void
+        reserve(const size_type n)
+        {
+            mrecords.reserve(n);
+            pos.reserve(n);
+            neutral.reserve(n);
+            esize.reserve(n);
+        }
+
+        void
+        clear() noexcept
+        {
+            mrecords.clear();
+            pos.clear();
+            neutral.clear();
+            esize.clear();
+        }
+
+        void
+        swap(soa_mutation_vector &rhs) noexcept
+        {
+            mrecords.swap(rhs.mrecords);
+            pos.swap(rhs.pos);
+            neutral.swap(rhs.neutral);
+            esize.swap(rhs.esize);
+        }
+
+        const_reference operator[](const size_type i) const noexcept
+        {
+            return mrecords[i];
+        }
+
+        const_reference
+        front() const noexcept
+        {
+            return mrecords.front();
+        }
+
+        const_reference
+        back() const noexcept
+        {
+            return mrecords.back();
+        }
+
+        const_iterator
+        begin() const noexcept
+        {
+            return mrecords.begin();
+        }
+
+        const_iterator
+        end() const noexcept
+        {
+            return mrecords.end();
+        }
+
+        const_iterator
+        cbegin() const noexcept
+        {
+            return mrecords.cbegin();
+        }
+
+        const_iterator
+        cend() const noexcept
+        {
+            return mrecords.cend();
+        }
+
+        void
+        push_back(const value_type &m)
+        {
+            append_columns(m);
+            mrecords.push_back(m);
+        }
+
+        void
+        push_back(value_type &&m)
+        {
+            append_columns(m);
+            mrecords.push_back(std::move(m));
+        }
+
+        template <typename... Args>
+        void
+        emplace_back(Args &&... args)
+        {
+            mrecords.emplace_back(std::forward<Args>(args)...);
+            append_columns(mrecords.back());
+        }
+
+        void
+        set(const size_type i, value_type m)
+        /// Replace element \a i by \a m
+        {
+            pos[i] = m.pos;
+            neutral[i] = m.neutral;
+            esize[i] = fwdpp_internal::scalar_effect_size(m);
+            mrecords[i] = std::move(m);
+        }
+
+        double
+        position(const size_type i) const noexcept
+        /// Same as (*this)[i].pos
+        {
+            return pos[i];
+        }
+
+        bool
+        is_neutral(const size_type i) const noexcept
+        /// Same as (*this)[i].neutral
+        {
+            return neutral[i];
+        }
+
+        double
+        effect_size(const size_type i) const noexcept
+        /// Same as (*this)[i].s for mutation types with a numeric s
+        {
+            return esize[i];
+        }
+
+        const position_column_type &
+        positions() const noexcept
+        {
+            return pos;
+        }
+
+        const std::vector<std::uint8_t> &
+        neutral_flags() const noexcept
+        {
+            return neutral;
+        }
+
+        const std::vector<double> &
+        effect_sizes() const noexcept
+        {
+            return esize;
+        }
+
+        const record_container &
+        records() const noexcept
+        {
+            return mrecords;
+        }
+
+        bool
+        operator==(const soa_mutation_vector &rhs) const
+        {
+            return mrecords == rhs.mrecords;
+        }
+    };
+}
+
+#endif
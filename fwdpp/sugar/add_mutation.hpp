@@ -14,6 +14,7 @@
 #include <vector>
 #include <unordered_map>
 #include <fwdpp/internal/recycling.hpp>
+#include <fwdpp/internal/gamete_fingerprint.hpp>
 #include <fwdpp/sugar/poptypes/tags.hpp>
 
 namespace fwdpp
@@ -92,6 +93,9 @@ namespace fwdpp
                              const std::vector<std::size_t> &mindexes,
                              const map_t &gams)
         {
+            // Extinct mutations may be reused by get_mut_index, and so
+            // the bin filled by fwdpp::update_mutations is out of date.
+            p.workspace.mutation_recycling_bin_filled = false;
             auto gam_recycling_bin
                 = fwdpp_internal::make_gamete_queue(p.gametes);
             // Function object for calls to upper bound
@@ -132,6 +136,10 @@ namespace fwdpp
                     // get new gamete
                     auto new_gamete_key = fwdpp_internal::recycle_gamete(
                         p.gametes, gam_recycling_bin, n, s);
+                    fwdpp_internal::update_cached_value(
+                        p.gametes[new_gamete_key], p.mutations);
+                    fwdpp_internal::update_fingerprint(
+                        p.gametes[new_gamete_key]);
                     // update gamete count
                     p.gametes[gi.first].n
                         -= decltype(p.gametes[gi.first].n)(gi.second.size());
@@ -10,6 +10,7 @@
 #include <cassert>
 #include <exception>
 #include <fwdpp/debug.hpp>
+#include <fwdpp/internal/haplotype_value_cache.hpp>
 
 namespace fwdpp
 {
@@ -102,6 +103,7 @@ namespace fwdpp
                                     p.mutations, pos, mindex, g.smutations,
                                     g.mutations);
                             }
+                        fwdpp_internal::update_cached_value(g, p.mutations);
                         assert(gamete_data_sane(g, p.mutations, p.mcounts));
                     }
             }
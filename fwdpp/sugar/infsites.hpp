@@ -67,8 +67,8 @@ namespace fwdpp
         template <typename queue_t, typename mcont_t, typename lookup_table_t,
                   typename position_t, typename sdist_t, typename hdist_t>
         inline
-            typename std::enable_if<std::is_same<typename mcont_t::value_type,
-                                                 popgenmut>::value,
+            typename std::enable_if<traits::is_popgenmut<
+                                        typename mcont_t::value_type>::value,
                                     std::size_t>::type
             operator()(queue_t &recycling_bin, mcont_t &mutations,
                        const gsl_rng *r, lookup_table_t &lookup,
@@ -78,9 +78,10 @@ namespace fwdpp
                        const position_t &posmaker, const sdist_t &smaker,
                        const hdist_t &hmaker) const
         {
-            static_assert(std::is_same<typename mcont_t::value_type,
-                                       fwdpp::popgenmut>::value,
-                          "mcont_t::value_type must be fwdpp::popgenmut");
+            static_assert(
+                traits::is_popgenmut<typename mcont_t::value_type>::value,
+                "mcont_t::value_type must be fwdpp::popgenmut or "
+                "fwdpp::compact_popgenmut");
             // Establish position of new mutation
             auto pos = this->generate_mut_pos(posmaker, lookup);
             bool selected
@@ -123,8 +124,8 @@ namespace fwdpp
                   typename nposition_t, typename sposition_t, typename sdist_t,
                   typename hdist_t>
         inline
-            typename std::enable_if<std::is_same<typename mcont_t::value_type,
-                                                 popgenmut>::value,
+            typename std::enable_if<traits::is_popgenmut<
+                                        typename mcont_t::value_type>::value,
                                     std::size_t>::type
             operator()(queue_t &recycling_bin, mcont_t &mutations,
                        const gsl_rng *r, lookup_table_t &lookup,
@@ -183,8 +184,8 @@ namespace fwdpp
                   typename nposition_t, typename sposition_t, typename sdist_t,
                   typename hdist_t>
         inline
-            typename std::enable_if<std::is_same<typename mcont_t::value_type,
-                                                 popgenmut>::value,
+            typename std::enable_if<traits::is_popgenmut<
+                                        typename mcont_t::value_type>::value,
                                     std::size_t>::type
             operator()(queue_t &recycling_bin, mcont_t &mutations,
                        const gsl_rng *r, lookup_table_t &lookup,
@@ -225,8 +226,8 @@ namespace fwdpp
         template <typename queue_t, typename mcont_t, typename lookup_table_t,
                   typename position_t, typename sdist_t, typename hdist_t>
         inline
-            typename std::enable_if<std::is_same<typename mcont_t::value_type,
-                                                 popgenmut>::value,
+            typename std::enable_if<traits::is_popgenmut<
+                                        typename mcont_t::value_type>::value,
                                     std::size_t>::type
             operator()(queue_t &recycling_bin, mcont_t &mutations,
                        const gsl_rng *r, lookup_table_t &lookup,
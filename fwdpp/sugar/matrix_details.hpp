@@ -137,7 +137,7 @@ namespace fwdpp
             using gamete_t = typename gcont_t::value_type;
             for (auto &&ind : individuals)
                 {
-                    auto &dip = diploids[ind];
+                    const auto &dip = diploids[ind];
                     for (auto &&locus : dip)
                         {
                             if (include_neutral)
@@ -380,7 +380,7 @@ namespace fwdpp
                             throw std::out_of_range(
                                 "individual index out of range");
                         }
-                    auto &dip = pop.diploids[ind];
+                    const auto &dip = pop.diploids[ind];
                     for (auto &&locus : dip)
                         {
                             update_row_common(pop.gametes[locus.first],
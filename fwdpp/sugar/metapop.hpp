@@ -3,6 +3,7 @@
 
 #include <fwdpp/sugar/poptypes/metapop.hpp>
 #include <fwdpp/fwd_functional.hpp>
+#include <fwdpp/slab_allocator.hpp>
 #include <vector>
 #include <unordered_set>
 
@@ -10,12 +11,16 @@ namespace fwdpp
 {
     /*!
       \brief Single locus metapopulation simulation object
+
+      Use fwdpp::slab_gamete<> as gamete_t to take the buffers of
+      mutation keys from fwdpp::default_slab_arena.
       \ingroup sugar
     */
     template <typename mtype,
-              typename diploid_t = std::pair<std::size_t, std::size_t>>
+              typename diploid_t = std::pair<std::size_t, std::size_t>,
+              typename gamete_t = gamete>
     using metapop
-        = sugar::metapop<mtype, std::vector<mtype>, std::vector<gamete>,
+        = sugar::metapop<mtype, std::vector<mtype>, std::vector<gamete_t>,
                          std::vector<diploid_t>,
                          std::vector<std::vector<diploid_t>>,
                          std::vector<mtype>, std::vector<uint_t>,
@@ -5,21 +5,47 @@
 #include <unordered_set>
 #include <fwdpp/sugar/poptypes/multiloc.hpp>
 #include <fwdpp/fwd_functional.hpp>
+#include <fwdpp/slab_allocator.hpp>
 
 namespace fwdpp
 {
     /*!
       \brief Single population, multilocus simulation.
       See @ref md_md_sugar for rationale, etc.
+
+      Use fwdpp::slab_gamete<> as gamete_t to take the buffers of
+      mutation keys from fwdpp::default_slab_arena.
       \ingroup sugar
     */
     template <typename mtype,
-              typename diploid_t = std::pair<std::size_t, std::size_t>>
+              typename diploid_t = std::pair<std::size_t, std::size_t>,
+              typename gamete_t = gamete>
     using multiloc
-        = sugar::multiloc<mtype, std::vector<mtype>, std::vector<gamete>,
+        = sugar::multiloc<mtype, std::vector<mtype>, std::vector<gamete_t>,
                           std::vector<std::vector<diploid_t>>,
                           std::vector<mtype>, std::vector<uint_t>,
                           std::unordered_set<double, std::hash<double>,
                                              fwdpp::equal_eps>>;
+
+    /*!
+      \brief Single population, multilocus simulation, with the
+      genotypes of all diploids stored in one
+      fwdpp::multilocus_genotype_matrix.
+
+      The same as fwdpp::multiloc, except that the element type of
+      diploids is a fwdpp::multilocus_genotype_row.  Fitness functions
+      must therefore accept any container of genotypes, and loops over
+      diploids must not use auto &.
+      \ingroup sugar
+    */
+    template <typename mtype,
+              typename diploid_t = std::pair<std::size_t, std::size_t>,
+              typename gamete_t = gamete>
+    using flat_multiloc
+        = sugar::multiloc<mtype, std::vector<mtype>, std::vector<gamete_t>,
+                          multilocus_genotype_matrix<diploid_t>,
+                          std::vector<mtype>, std::vector<uint_t>,
+                          std::unordered_set<double, std::hash<double>,
+                                             fwdpp::equal_eps>>;
 }
 #endif
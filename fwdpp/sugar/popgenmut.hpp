@@ -7,6 +7,7 @@
 #include <fwdpp/io/mutation.hpp>
 #include <limits>
 #include <tuple>
+#include <type_traits>
 
 namespace fwdpp
 {
@@ -68,6 +69,63 @@ namespace fwdpp
         }
     };
 
+    struct compact_popgenmut : public compact_mutation_base
+    /*!
+      \brief Same as fwdpp::popgenmut, without a virtual table pointer.
+
+      Without the virtual table pointer, the object is 32 bytes instead
+      of 40 on 64-bit systems.  Serialized in the same format as
+      fwdpp::popgenmut.
+
+      \ingroup sugar
+     */
+    {
+        //! The generation when the mutation arose
+        uint_t g;
+        //! Selection coefficient
+        double s;
+        //! Dominance of the mutation
+        double h;
+        //! Alias for tuple type that can be used for object construction
+        using constructor_tuple = popgenmut::constructor_tuple;
+
+        compact_popgenmut(const double &__pos, const double &__s,
+                          const double &__h, const unsigned &__g,
+                          const std::uint16_t x = 0) noexcept
+            : compact_mutation_base(__pos, (__s == 0.) ? true : false, x),
+              g(__g), s(__s), h(__h)
+        {
+        }
+
+        compact_popgenmut(constructor_tuple t) noexcept
+            : compact_mutation_base(std::get<0>(t),
+                                    (std::get<1>(t) == 0.) ? true : false,
+                                    std::get<4>(t)),
+              g(std::get<3>(t)), s(std::get<1>(t)), h(std::get<2>(t))
+        {
+        }
+
+        bool
+        operator==(const compact_popgenmut &rhs) const
+        {
+            return std::tie(this->g, this->s, this->h)
+                       == std::tie(rhs.g, rhs.s, rhs.h)
+                   && is_equal(rhs);
+        }
+    };
+
+    namespace traits
+    {
+        //! True for fwdpp::popgenmut and fwdpp::compact_popgenmut
+        template <typename T>
+        struct is_popgenmut
+            : std::integral_constant<
+                  bool, std::is_same<T, popgenmut>::value
+                            || std::is_same<T, compact_popgenmut>::value>
+        {
+        };
+    }
+
     namespace io
     {
         template <> struct serialize_mutation<popgenmut>
@@ -109,6 +167,45 @@ namespace fwdpp
                 return popgenmut(pos, s, h, g, xtra);
             }
         };
+
+        template <> struct serialize_mutation<compact_popgenmut>
+        /// Specialization for fwdpp::compact_popgenmut
+        {
+            io::scalar_writer writer;
+            serialize_mutation<compact_popgenmut>() : writer{} {}
+            template <typename streamtype>
+            inline void
+            operator()(streamtype &buffer, const compact_popgenmut &m) const
+            {
+                writer(buffer, &m.g);
+                writer(buffer, &m.pos);
+                writer(buffer, &m.s);
+                writer(buffer, &m.h);
+                writer(buffer, &m.xtra);
+            }
+        };
+
+        template <> struct deserialize_mutation<compact_popgenmut>
+        /// Specialization for fwdpp::compact_popgenmut
+        {
+            io::scalar_reader reader;
+            deserialize_mutation<compact_popgenmut>() : reader{} {}
+            template <typename streamtype>
+            inline compact_popgenmut
+            operator()(streamtype &buffer) const
+            {
+                uint_t g;
+                double pos, s, h;
+                decltype(compact_popgenmut::xtra) xtra;
+                reader(buffer, &g);
+                reader(buffer, &pos);
+                reader(buffer, &s);
+                reader(buffer, &h);
+                reader(buffer, &xtra);
+
+                return compact_popgenmut(pos, s, h, g, xtra);
+            }
+        };
     }
 }
 #endif
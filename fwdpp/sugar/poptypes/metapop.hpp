@@ -87,6 +87,14 @@ namespace fwdpp
                 typename popbase_t::lookup_table_t>;
             //! Container of diploids
             vdipvector_t diploids;
+            /*!
+              Memory reused by fwdpp::sample_diploid between generations.
+              Not part of the state of the population, meaning that it is
+              ignored by operator== and by serialization.
+            */
+            generation_workspace<
+                vdipvector_t, typename popbase_t::gamete_t::mutation_container>
+                workspace;
 
             //! Construct with a cont of deme sizes
             explicit metapop(
@@ -173,6 +181,7 @@ namespace fwdpp
             clear()
             {
                 diploids.clear();
+                workspace.clear();
                 popbase_t::clear_containers();
             }
         };
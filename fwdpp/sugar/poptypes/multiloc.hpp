@@ -7,6 +7,7 @@
 #include <fwdpp/forward_types.hpp>
 #include <fwdpp/sugar/poptypes/tags.hpp>
 #include <fwdpp/sugar/poptypes/popbase.hpp>
+#include <fwdpp/multilocus_genotype_matrix.hpp>
 
 namespace fwdpp
 {
@@ -18,6 +19,9 @@ namespace fwdpp
 
           All that is missing is the mutation_type and the container types.
 
+          \a dipvector is a container of containers of genotypes, or a
+          fwdpp::multilocus_genotype_matrix.
+
           See @ref md_md_sugar for rationale, etc.
 
           \ingroup sugar
@@ -68,6 +72,15 @@ namespace fwdpp
 
             //! Container of individuals
             typename popbase_t::dipvector_t diploids;
+            /*!
+              Memory reused by fwdpp::sample_diploid between generations.
+              Not part of the state of the population, meaning that it is
+              ignored by operator== and by serialization.
+            */
+            generation_workspace<
+                typename popbase_t::dipvector_t,
+                typename popbase_t::gamete_t::mutation_container>
+                workspace;
 
             /*! The positional boundaries of each locus/region,
              *  expressed as half-open intervals [min,max).
@@ -87,12 +100,11 @@ namespace fwdpp
                     reserve_size
                 = 100)
                 : popbase_t(__nloci * __N, reserve_size), N(__N),
-                  diploids(__N, typename popbase_t::diploid_t(
-                                    __nloci,
-                                    typename popbase_t::diploid_t::value_type(
-                                        0, 0))),
-                  locus_boundaries(locus_boundaries_)
+                  diploids(), locus_boundaries(locus_boundaries_)
             {
+                // All genotypes are (0,0)
+                fwdpp_internal::resize_multilocus_diploids(diploids, __N,
+                                                           __nloci);
             }
 
             template <typename diploids_input, typename gametes_input,
@@ -122,6 +134,7 @@ namespace fwdpp
             clear()
             {
                 diploids.clear();
+                workspace.clear();
                 locus_boundaries.clear();
                 popbase_t::clear_containers();
             }
@@ -5,6 +5,7 @@
 #include <vector>
 #include <exception>
 #include <fwdpp/type_traits.hpp>
+#include <fwdpp/generation_workspace.hpp>
 #include <fwdpp/internal/sample_diploid_helpers.hpp>
 
 namespace fwdpp
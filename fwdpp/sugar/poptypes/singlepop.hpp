@@ -65,6 +65,15 @@ namespace fwdpp
 
             //! Container of diploids
             typename popbase_t::dipvector_t diploids;
+            /*!
+              Memory reused by fwdpp::sample_diploid between generations.
+              Not part of the state of the population, meaning that it is
+              ignored by operator== and by serialization.
+            */
+            generation_workspace<
+                typename popbase_t::dipvector_t,
+                typename popbase_t::gamete_t::mutation_container>
+                workspace;
 
             //! Constructor
             explicit singlepop(
@@ -104,6 +113,7 @@ namespace fwdpp
             clear()
             {
                 diploids.clear();
+                workspace.clear();
                 popbase_t::clear_containers();
             }
         };
@@ -5,18 +5,23 @@
 #include <vector>
 #include <unordered_set>
 #include <fwdpp/fwd_functional.hpp>
+#include <fwdpp/slab_allocator.hpp>
 #include <fwdpp/sugar/poptypes/singlepop.hpp>
 
 namespace fwdpp
 {
     /*!
       \brief Single locus, single population object
+
+      Use fwdpp::slab_gamete<> as gamete_t to take the buffers of
+      mutation keys from fwdpp::default_slab_arena.
       \ingroup sugar
     */
     template <typename mtype,
-              typename diploid_t = std::pair<std::size_t, std::size_t>>
+              typename diploid_t = std::pair<std::size_t, std::size_t>,
+              typename gamete_t = gamete>
     using singlepop
-        = sugar::singlepop<mtype, std::vector<mtype>, std::vector<gamete>,
+        = sugar::singlepop<mtype, std::vector<mtype>, std::vector<gamete_t>,
                            std::vector<diploid_t>, std::vector<mtype>,
                            std::vector<uint_t>,
                            std::unordered_set<double, std::hash<double>,
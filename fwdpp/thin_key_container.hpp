@@ -0,0 +1,317 @@
+/*!
+  \file thin_key_container.hpp
+
+  \brief A container of mutation keys the size of one pointer.
+*/
+#ifndef FWDPP_THIN_KEY_CONTAINER_HPP__
+#define FWDPP_THIN_KEY_CONTAINER_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <cassert>
+#include <fwdpp/forward_types.hpp>
+#include <fwdpp/tags/tags.hpp>
+
+namespace fwdpp
+{
+    class thin_key_container
+    /*!
+      \brief A container of mutation keys holding a single pointer.
+
+      The size, the capacity and the keys are stored in one heap block,
+      so that an empty container takes the space of a null pointer,
+      compared to three pointers for std::vector.  Otherwise, this
+      container behaves like std::vector<std::uint32_t>, and its
+      iterators are pointers.
+
+      A gamete keeps its neutral and its selected keys in two
+      containers of the same type.  In simulations where most gametes
+      carry no neutral mutations, such as simulations of selected
+      mutations only, one of the two is almost always empty.  See
+      fwdpp::compact_selected_gamete.
+      \ingroup basicTypes
+    */
+    {
+      public:
+        using value_type = std::uint32_t;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type &;
+        using const_reference = const value_type &;
+        using pointer = value_type *;
+        using const_pointer = const value_type *;
+        using iterator = value_type *;
+        using const_iterator = const value_type *;
+
+      private:
+        struct header
+        {
+            std::uint32_t size, capacity;
+        };
+        static_assert(sizeof(header) % sizeof(value_type) == 0,
+                      "keys must follow the header without padding");
+        header *block;
+
+        static header *
+        allocate_block(const size_type capacity)
+        {
+            auto h = static_cast<header *>(::operator new(
+                sizeof(header) + capacity * sizeof(value_type)));
+            h->size = 0;
+            h->capacity = static_cast<std::uint32_t>(capacity);
+            return h;
+        }
+
+        void
+        grow(const size_type n)
+        // Make room for at least n keys
+        {
+            const size_type c = capacity();
+            if (n <= c)
+                {
+                    return;
+                }
+            auto h = allocate_block(std::max(n, 2 * c));
+            h->size = static_cast<std::uint32_t>(size());
+            std::copy(begin(), end(), reinterpret_cast<value_type *>(h + 1));
+            ::operator delete(block);
+            block = h;
+        }
+
+      public:
+        thin_key_container() noexcept : block(nullptr) {}
+
+        thin_key_container(std::initializer_list<value_type> keys)
+            : block(nullptr)
+        {
+            insert(end(), keys.begin(), keys.end());
+        }
+
+        template <typename input_iterator>
+        thin_key_container(input_iterator first, input_iterator last)
+            : block(nullptr)
+        {
+            insert(end(), first, last);
+        }
+
+        thin_key_container(const thin_key_container &rhs) : block(nullptr)
+        {
+            if (!rhs.empty())
+                {
+                    block = allocate_block(rhs.size());
+                    block->size = static_cast<std::uint32_t>(rhs.size());
+                    std::copy(rhs.begin(), rhs.end(), begin());
+                }
+        }
+
+        thin_key_container(thin_key_container &&rhs) noexcept
+            : block(rhs.block)
+        {
+            rhs.block = nullptr;
+        }
+
+        thin_key_container &
+        operator=(const thin_key_container &rhs)
+        {
+            if (this != &rhs)
+                {
+                    clear();
+                    insert(end(), rhs.begin(), rhs.end());
+                }
+            return *this;
+        }
+
+        thin_key_container &
+        operator=(thin_key_container &&rhs) noexcept
+        {
+            swap(rhs);
+            return *this;
+        }
+
+        ~thin_key_container() { ::operator delete(block); }
+
+        size_type
+        size() const noexcept
+        {
+            return (block) ? block->size : 0;
+        }
+
+        size_type
+        capacity() const noexcept
+        {
+            return (block) ? block->capacity : 0;
+        }
+
+        bool
+        empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        pointer
+        data() noexcept
+        {
+            return (block) ? reinterpret_cast<pointer>(block + 1) : nullptr;
+        }
+
+        const_pointer
+        data() const noexcept
+        {
+            return (block) ? reinterpret_cast<const_pointer>(block + 1)
+                           : nullptr;
+        }
+
+        iterator
+        begin() noexcept
+        {
+            return data();
+        }
+
+        iterator
+        end() noexcept
+        {
+            return data() + size();
+        }
+
+        const_iterator
+        begin() const noexcept
+        {
+            return data();
+        }
+
+        const_iterator
+        end() const noexcept
+        {
+            return data() + size();
+        }
+
+        const_iterator
+        cbegin() const noexcept
+        {
+            return begin();
+        }
+
+        const_iterator
+        cend() const noexcept
+        {
+            return end();
+        }
+
+        reference operator[](const size_type i) noexcept
+        {
+            return data()[i];
+        }
+
+        const_reference operator[](const size_type i) const noexcept
+        {
+            return data()[i];
+        }
+
+        const_reference
+        front() const noexcept
+        {
+            return *begin();
+        }
+
+        const_reference
+        back() const noexcept
+        {
+            return *(end() - 1);
+        }
+
+        void
+        reserve(const size_type n)
+        {
+            grow(n);
+        }
+
+        void
+        clear() noexcept
+        /// Keeps the capacity, as std::vector does
+        {
+            if (block)
+                {
+                    block->size = 0;
+                }
+        }
+
+        void
+        swap(thin_key_container &rhs) noexcept
+        {
+            std::swap(block, rhs.block);
+        }
+
+        void
+        push_back(const value_type key)
+        {
+            grow(size() + 1);
+            data()[block->size++] = key;
+        }
+
+        template <typename input_iterator>
+        iterator
+        insert(const_iterator pos, input_iterator first, input_iterator last)
+        /// Insert the keys [first, last), which must not refer to
+        /// this container, before pos
+        {
+            const auto offset = pos - cbegin();
+            const auto n = static_cast<size_type>(std::distance(first, last));
+            if (n == 0)
+                {
+                    return begin() + offset;
+                }
+            assert(size() + n <= UINT32_MAX);
+            grow(size() + n);
+            auto p = begin() + offset;
+            std::copy_backward(p, end(), end() + n);
+            std::copy(first, last, p);
+            block->size += static_cast<std::uint32_t>(n);
+            return p;
+        }
+
+        iterator
+        erase(const_iterator first, const_iterator last) noexcept
+        {
+            auto p = begin() + (first - cbegin());
+            if (first != last)
+                {
+                    std::copy(last, cend(), p);
+                    block->size -= static_cast<std::uint32_t>(last - first);
+                }
+            return p;
+        }
+
+        bool
+        operator==(const thin_key_container &rhs) const noexcept
+        {
+            return size() == rhs.size()
+                   && std::equal(begin(), end(), rhs.begin());
+        }
+
+        bool
+        operator!=(const thin_key_container &rhs) const noexcept
+        {
+            return !(*this == rhs);
+        }
+    };
+
+    /*!
+      \brief A compact gamete whose key containers are each the size of
+      one pointer.
+
+      Intended for simulations in which gametes carry few or no neutral
+      mutations.  See fwdpp::thin_key_container and
+      fwdpp::compact_gamete_base.
+      \ingroup basicTypes
+    */
+    template <typename TAG = tags::standard_gamete>
+    using compact_selected_gamete
+        = compact_gamete_base<TAG, thin_key_container>;
+}
+
+#endif
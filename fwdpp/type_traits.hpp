@@ -22,12 +22,16 @@ namespace fwdpp
         //! Convenience wrapper for fwdpp::traits::is_gamete<T>::type.
         template <typename T> using is_gamete_t = typename is_gamete<T>::type;
 
-        //! Wraps a static constant allowing a test that T is a mutation
+        //! Wraps a static constant allowing a test that T is a mutation,
+        //! which is derived from fwdpp::mutation_base or
+        //! fwdpp::compact_mutation_base
         template <typename T>
         struct is_mutation
-            : std::integral_constant<bool,
-                                     std::is_base_of<fwdpp::mutation_base,
-                                                     T>::value>
+            : std::integral_constant<
+                  bool,
+                  std::is_base_of<fwdpp::mutation_base, T>::value
+                      || std::is_base_of<fwdpp::compact_mutation_base,
+                                         T>::value>
         {
         };
 
@@ -17,6 +17,92 @@
 
 namespace fwdpp
 {
+    namespace fwdpp_internal
+    {
+        struct ignore_extinct_mutations
+        {
+            inline void operator()(const std::size_t) const noexcept {}
+        };
+
+        template <typename workspace_t> struct fill_workspace_recycling_bin
+        /*!
+          Collects the keys of extinct mutations in
+          workspace.mutation_recycling_bin on behalf of
+          fwdpp::update_mutations, so that fwdpp::sample_diploid need
+          not look for them again.
+        */
+        {
+            workspace_t &workspace;
+            explicit fill_workspace_recycling_bin(workspace_t &w)
+                : workspace(w)
+            {
+                workspace.mutation_recycling_bin.clear();
+            }
+            ~fill_workspace_recycling_bin()
+            {
+                workspace.mutation_recycling_bin_filled = true;
+            }
+            inline void
+            operator()(const std::size_t i) const
+            {
+                workspace.mutation_recycling_bin.push(i);
+            }
+        };
+
+        template <typename mcont_t, typename mutation_lookup_table,
+                  typename extinct_function>
+        void
+        remove_fixed_and_lost(const mcont_t &mutations,
+                              mutation_lookup_table &lookup,
+                              std::vector<uint_t> &mcounts, const unsigned twoN,
+                              const extinct_function &extinct)
+        {
+            for (std::size_t i = 0; i < mcounts.size(); ++i)
+                {
+                    assert(mcounts[i] <= twoN);
+                    if (mcounts[i] == twoN || !mcounts[i])
+                        {
+                            lookup.erase(mutations[i].pos);
+                            mcounts[i] = 0;
+                            extinct(i);
+                        }
+                }
+        }
+
+        template <typename mcont_t, typename fixation_container_t,
+                  typename fixation_time_container_t,
+                  typename mutation_lookup_table, typename fixation_predicate,
+                  typename extinct_function>
+        void
+        record_fixations(const mcont_t &mutations,
+                         fixation_container_t &fixations,
+                         fixation_time_container_t &fixation_times,
+                         mutation_lookup_table &lookup,
+                         std::vector<uint_t> &mcounts,
+                         const unsigned &generation, const unsigned &twoN,
+                         const fixation_predicate &is_fixation,
+                         const extinct_function &extinct)
+        {
+            for (unsigned i = 0; i < mcounts.size(); ++i)
+                {
+                    assert(mcounts[i] <= twoN);
+                    if (mcounts[i] == twoN && is_fixation(mutations[i]))
+                        {
+                            fixations.push_back(mutations[i]);
+                            fixation_times.push_back(generation);
+                            mcounts[i] = 0; // set count to zero to mark
+                                            // mutation as "recyclable"
+                            lookup.erase(mutations[i].pos);
+                        }
+                    if (!mcounts[i])
+                        {
+                            lookup.erase(mutations[i].pos);
+                            extinct(i);
+                        }
+                }
+        }
+    }
+
     /*!
       Label all extinct and fixed variants for recycling
 
@@ -31,15 +117,34 @@ namespace fwdpp
             typename traits::is_mutation<typename mcont_t::value_type>::type(),
             "mutation_type must be derived from fwdpp::mutation_base");
         assert(mcounts.size() == mutations.size());
-        for (std::size_t i = 0; i < mcounts.size(); ++i)
-            {
-                assert(mcounts[i] <= twoN);
-                if (mcounts[i] == twoN || !mcounts[i])
-                    {
-                        lookup.erase(mutations[i].pos);
-                        mcounts[i] = 0;
-                    }
-            }
+        fwdpp_internal::remove_fixed_and_lost(
+            mutations, lookup, mcounts, twoN,
+            fwdpp_internal::ignore_extinct_mutations());
+    }
+
+    /*!
+      Label all extinct and fixed variants for recycling, and fill the
+      mutation recycling bin of a fwdpp::generation_workspace with
+      them.  The next call to fwdpp::sample_diploid taking the workspace
+      then does not need to look for extinct mutations.
+
+      \note: lookup must be compatible with lookup->erase(lookup->find(double))
+    */
+    template <typename mcont_t, typename mutation_lookup_table,
+              typename workspace_t>
+    void
+    update_mutations(mcont_t &mutations, mutation_lookup_table &lookup,
+                     std::vector<uint_t> &mcounts, const unsigned twoN,
+                     workspace_t &workspace)
+    {
+        static_assert(
+            typename traits::is_mutation<typename mcont_t::value_type>::type(),
+            "mutation_type must be derived from fwdpp::mutation_base");
+        assert(mcounts.size() == mutations.size());
+        fwdpp_internal::remove_fixed_and_lost(
+            mutations, lookup, mcounts, twoN,
+            fwdpp_internal::fill_workspace_recycling_bin<workspace_t>(
+                workspace));
     }
 
     /*!
@@ -87,20 +192,39 @@ namespace fwdpp
             typename traits::is_mutation<typename mcont_t::value_type>::type(),
             "mutation_type must be derived from fwdpp::mutation_base");
         assert(mcounts.size() == mutations.size());
-        for (unsigned i = 0; i < mcounts.size(); ++i)
-            {
-                assert(mcounts[i] <= twoN);
-                if (mcounts[i] == twoN)
-                    {
-                        fixations.push_back(mutations[i]);
-                        fixation_times.push_back(generation);
-                        mcounts[i] = 0; // set count to zero to mark mutation
-                                        // as "recyclable"
-                        lookup.erase(mutations[i].pos);
-                    }
-                if (!mcounts[i])
-                    lookup.erase(mutations[i].pos);
-            }
+        fwdpp_internal::record_fixations(
+            mutations, fixations, fixation_times, lookup, mcounts, generation,
+            twoN, [](const typename mcont_t::value_type &) { return true; },
+            fwdpp_internal::ignore_extinct_mutations());
+    }
+
+    /*!
+      Same as above, and fill the mutation recycling bin of a
+      fwdpp::generation_workspace with the extinct mutations, including
+      the fixations.  The next call to fwdpp::sample_diploid taking the
+      workspace then does not need to look for extinct mutations.
+
+      \note: lookup must be compatible with lookup->erase(lookup->find(double))
+    */
+    template <typename mcont_t, typename fixation_container_t,
+              typename fixation_time_container_t,
+              typename mutation_lookup_table, typename workspace_t>
+    void
+    update_mutations(mcont_t &mutations, fixation_container_t &fixations,
+                     fixation_time_container_t &fixation_times,
+                     mutation_lookup_table &lookup,
+                     std::vector<uint_t> &mcounts, const unsigned &generation,
+                     const unsigned &twoN, workspace_t &workspace)
+    {
+        static_assert(
+            typename traits::is_mutation<typename mcont_t::value_type>::type(),
+            "mutation_type must be derived from fwdpp::mutation_base");
+        assert(mcounts.size() == mutations.size());
+        fwdpp_internal::record_fixations(
+            mutations, fixations, fixation_times, lookup, mcounts, generation,
+            twoN, [](const typename mcont_t::value_type &) { return true; },
+            fwdpp_internal::fill_workspace_recycling_bin<workspace_t>(
+                workspace));
     }
 
     /*!
@@ -124,20 +248,40 @@ namespace fwdpp
             typename traits::is_mutation<typename mcont_t::value_type>::type(),
             "mutation_type must be derived from fwdpp::mutation_base");
         assert(mcounts.size() == mutations.size());
-        for (unsigned i = 0; i < mcounts.size(); ++i)
-            {
-                assert(mcounts[i] <= twoN);
-                if (mutations[i].neutral && mcounts[i] == twoN)
-                    {
-                        fixations.push_back(mutations[i]);
-                        fixation_times.push_back(generation);
-                        mcounts[i] = 0; // set count to zero to mark mutation
-                                        // as "recyclable"
-                        lookup.erase(mutations[i].pos);
-                    }
-                if (!mcounts[i])
-                    lookup.erase(mutations[i].pos);
-            }
+        fwdpp_internal::record_fixations(
+            mutations, fixations, fixation_times, lookup, mcounts, generation,
+            twoN,
+            [](const typename mcont_t::value_type &m) { return m.neutral; },
+            fwdpp_internal::ignore_extinct_mutations());
+    }
+
+    /*!
+      Same as above, and fill the mutation recycling bin of a
+      fwdpp::generation_workspace with the extinct mutations.
+
+      \note: lookup must be compatible with lookup->erase(lookup->find(double))
+    */
+    template <typename mcont_t, typename fixation_container_t,
+              typename fixation_time_container_t,
+              typename mutation_lookup_table, typename workspace_t>
+    void
+    update_mutations_n(mcont_t &mutations, fixation_container_t &fixations,
+                       fixation_time_container_t &fixation_times,
+                       mutation_lookup_table &lookup,
+                       std::vector<uint_t> &mcounts,
+                       const unsigned &generation, const unsigned &twoN,
+                       workspace_t &workspace)
+    {
+        static_assert(
+            typename traits::is_mutation<typename mcont_t::value_type>::type(),
+            "mutation_type must be derived from fwdpp::mutation_base");
+        assert(mcounts.size() == mutations.size());
+        fwdpp_internal::record_fixations(
+            mutations, fixations, fixation_times, lookup, mcounts, generation,
+            twoN,
+            [](const typename mcont_t::value_type &m) { return m.neutral; },
+            fwdpp_internal::fill_workspace_recycling_bin<workspace_t>(
+                workspace));
     }
 }
 #endif /* _UTIL_HPP_ */
@@ -66,7 +66,7 @@ struct metapop_popgenmut_custom_fixture
     }
 };
 
-class multiloc_popgenmut_fixture
+template <typename poptype_t> class basic_multiloc_popgenmut_fixture
 {
   private:
     std::vector<fwdpp::extensions::discrete_mut_model>
@@ -121,22 +121,26 @@ class multiloc_popgenmut_fixture
     }
 
   public:
-    using poptype = fwdpp::multiloc<fwdpp::popgenmut>;
+    using poptype = poptype_t;
     using rng_t = fwdpp::GSLrng_t<fwdpp::GSL_RNG_TAUS2>;
-    using mutmodel = std::function<std::size_t(std::queue<std::size_t> &,
-                                               poptype::mcont_t &)>;
+    using mutmodel = std::function<std::size_t(
+        fwdpp::traits::recycling_bin_t<typename poptype::mcont_t> &,
+        typename poptype::mcont_t &)>;
     using recmodel = std::function<std::vector<double>()>;
     // Fitness function
     struct multilocus_additive
     {
       public:
         using result_type = double;
+        // diploid_t is a std::vector of genotypes, or a row of a
+        // fwdpp::multilocus_genotype_matrix
+        template <typename diploid_t>
         inline double
-        operator()(const poptype::dipvector_t::value_type &diploid,
-                   const poptype::gcont_t &gametes,
-                   const poptype::mcont_t &mutations) const
+        operator()(const diploid_t &diploid,
+                   const typename poptype::gcont_t &gametes,
+                   const typename poptype::mcont_t &mutations) const
         {
-            using dip_t = poptype::dipvector_t::value_type::value_type;
+            using dip_t = typename diploid_t::value_type;
             return std::max(
                 0., 1. + std::accumulate(
                              diploid.begin(), diploid.end(), 0.,
@@ -157,7 +161,7 @@ class multiloc_popgenmut_fixture
     std::vector<recmodel> recmodels;
     std::vector<fwdpp::extensions::discrete_mut_model> vdmm;
     std::vector<fwdpp::extensions::discrete_rec_model> vdrm;
-    multiloc_popgenmut_fixture(const unsigned seed = 0)
+    basic_multiloc_popgenmut_fixture(const unsigned seed = 0)
         /*! N=1000, 4 loci */
         : pop(poptype(1000, 4)),
           generation(0),
@@ -205,4 +209,10 @@ class multiloc_popgenmut_fixture
     }
 };
 
+using multiloc_popgenmut_fixture
+    = basic_multiloc_popgenmut_fixture<fwdpp::multiloc<fwdpp::popgenmut>>;
+//! Genotypes stored in a fwdpp::multilocus_genotype_matrix
+using flat_multiloc_popgenmut_fixture = basic_multiloc_popgenmut_fixture<
+    fwdpp::flat_multiloc<fwdpp::popgenmut>>;
+
 #endif
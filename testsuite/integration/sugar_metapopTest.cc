@@ -81,6 +81,36 @@ BOOST_AUTO_TEST_CASE(metapop_sugar_test4)
     BOOST_CHECK_EQUAL(pop == pop2, false);
 }
 
+BOOST_AUTO_TEST_CASE(metapop_sugar_threaded_fitness)
+{
+    // Calculating fitnesses on several threads
+    // must not change the population
+    simulate_metapop(pop, 10);
+    metapop_popgenmut_fixture::poptype pop2{ 1000, 1000 };
+    simulate_metapop(pop2, 10, 4);
+    BOOST_CHECK_EQUAL(pop == pop2, true);
+}
+
+BOOST_AUTO_TEST_CASE(metapop_sugar_workspace)
+{
+    simulate_metapop(pop, 10);
+    metapop_popgenmut_fixture::poptype pop2{ 1000, 1000 };
+    pop2.workspace.use_parent_sampler = false;
+    simulate_metapop_workspace(pop2, 10);
+    BOOST_CHECK_EQUAL(pop == pop2, true);
+    BOOST_CHECK_EQUAL(pop2.workspace.samplers.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(metapop_sugar_incremental_mutation_counts)
+{
+    simulate_metapop(pop, 10);
+    metapop_popgenmut_fixture::poptype pop2{ 1000, 1000 };
+    pop2.workspace.use_parent_sampler = false;
+    pop2.workspace.incremental_mutation_counts = true;
+    simulate_metapop_workspace(pop2, 10);
+    BOOST_CHECK_EQUAL(pop == pop2, true);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 /*
@@ -5,6 +5,7 @@
 */
 #include <unistd.h>
 #include <config.h>
+#include <cmath>
 #include <iostream>
 #include <functional>
 #include <algorithm>
@@ -14,6 +15,7 @@
 #include <fwdpp/sugar/GSLrng_t.hpp>
 #include <fwdpp/sugar/multiloc.hpp>
 #include <fwdpp/sugar/infsites.hpp>
+#include <fwdpp/sugar/sampling.hpp>
 #include <fwdpp/io/serialize_population.hpp>
 #include "../fixtures/sugar_fixtures.hpp"
 #include "../util/quick_evolve_sugar.hpp"
@@ -62,3 +64,215 @@ BOOST_AUTO_TEST_CASE(multiloc_sugar_test4)
     poptype pop2 = std::move(f.pop);
     BOOST_CHECK_EQUAL(f.pop == pop2, false);
 }
+
+BOOST_AUTO_TEST_CASE(multiloc_sugar_threaded_fitness)
+{
+    // Calculating fitnesses on several threads
+    // must not change the population
+    multiloc_popgenmut_fixture f, f2;
+    simulate_mlocuspop(f.pop, f.rng, f.mutmodels, f.recmodels,
+                       multiloc_popgenmut_fixture::multilocus_additive(), f.mu,
+                       f.rbw, f.generation);
+    simulate_mlocuspop(f2.pop, f2.rng, f2.mutmodels, f2.recmodels,
+                       multiloc_popgenmut_fixture::multilocus_additive(),
+                       f2.mu, f2.rbw, f2.generation, 10, 4);
+    BOOST_CHECK_EQUAL(f.pop == f2.pop, true);
+}
+
+BOOST_AUTO_TEST_CASE(multiloc_sugar_workspace)
+{
+    multiloc_popgenmut_fixture f, f2;
+    simulate_mlocuspop(f.pop, f.rng, f.mutmodels, f.recmodels,
+                       multiloc_popgenmut_fixture::multilocus_additive(), f.mu,
+                       f.rbw, f.generation);
+    f2.pop.workspace.use_parent_sampler = false;
+    simulate_mlocuspop_workspace(
+        f2.pop, f2.rng, f2.mutmodels, f2.recmodels,
+        multiloc_popgenmut_fixture::multilocus_additive(), f2.mu, f2.rbw,
+        f2.generation);
+    BOOST_CHECK_EQUAL(f.pop == f2.pop, true);
+}
+
+BOOST_AUTO_TEST_CASE(multiloc_sugar_incremental_mutation_counts)
+{
+    multiloc_popgenmut_fixture f, f2;
+    simulate_mlocuspop(f.pop, f.rng, f.mutmodels, f.recmodels,
+                       multiloc_popgenmut_fixture::multilocus_additive(), f.mu,
+                       f.rbw, f.generation);
+    f2.pop.workspace.use_parent_sampler = false;
+    f2.pop.workspace.incremental_mutation_counts = true;
+    simulate_mlocuspop_workspace(
+        f2.pop, f2.rng, f2.mutmodels, f2.recmodels,
+        multiloc_popgenmut_fixture::multilocus_additive(), f2.mu, f2.rbw,
+        f2.generation);
+    BOOST_CHECK_EQUAL(f.pop == f2.pop, true);
+}
+
+BOOST_AUTO_TEST_CASE(multiloc_sugar_hash_cons_gametes)
+{
+    // Hash-consing gametes changes gamete keys but not the haplotypes
+    multiloc_popgenmut_fixture f, f2;
+    simulate_mlocuspop_workspace(
+        f.pop, f.rng, f.mutmodels, f.recmodels,
+        multiloc_popgenmut_fixture::multilocus_additive(), f.mu, f.rbw,
+        f.generation);
+    f2.pop.workspace.hash_cons_gametes = true;
+    f2.pop.workspace.merge_duplicate_gametes_interval = 3;
+    simulate_mlocuspop_workspace(
+        f2.pop, f2.rng, f2.mutmodels, f2.recmodels,
+        multiloc_popgenmut_fixture::multilocus_additive(), f2.mu, f2.rbw,
+        f2.generation);
+    BOOST_REQUIRE_EQUAL(f.pop.diploids.size(), f2.pop.diploids.size());
+    BOOST_CHECK(f.pop.mutations == f2.pop.mutations);
+    BOOST_CHECK(f.pop.mcounts == f2.pop.mcounts);
+    for (std::size_t i = 0; i < f.pop.diploids.size(); ++i)
+        {
+            for (std::size_t j = 0; j < f.pop.diploids[i].size(); ++j)
+                {
+                    const auto &d1 = f.pop.diploids[i][j];
+                    const auto &d2 = f2.pop.diploids[i][j];
+                    BOOST_REQUIRE(f.pop.gametes[d1.first].mutations
+                                  == f2.pop.gametes[d2.first].mutations);
+                    BOOST_REQUIRE(f.pop.gametes[d1.first].smutations
+                                  == f2.pop.gametes[d2.first].smutations);
+                    BOOST_REQUIRE(f.pop.gametes[d1.second].mutations
+                                  == f2.pop.gametes[d2.second].mutations);
+                    BOOST_REQUIRE(f.pop.gametes[d1.second].smutations
+                                  == f2.pop.gametes[d2.second].smutations);
+                }
+        }
+    // Offspring gametes that copy a parent re-use its gamete, so the
+    // index may have nothing to merge.  Hash-consing must not leave
+    // more extant gametes than were stored without it.
+    const auto extant = [](const decltype(f.pop.gametes) &gametes) {
+        return std::count_if(
+            gametes.begin(), gametes.end(),
+            [](const decltype(f.pop.gametes)::value_type &g) {
+                return g.n > 0;
+            });
+    };
+    BOOST_CHECK(extant(f2.pop.gametes) <= extant(f.pop.gametes));
+}
+
+namespace
+{
+    template <typename poptype>
+    void
+    check_same_population(const multiloc_popgenmut_fixture::poptype &pop,
+                          const poptype &flat)
+    {
+        BOOST_CHECK(pop.mutations == flat.mutations);
+        BOOST_CHECK(pop.mcounts == flat.mcounts);
+        BOOST_CHECK(pop.gametes == flat.gametes);
+        BOOST_CHECK(pop.fixations == flat.fixations);
+        BOOST_CHECK(typename poptype::dipvector_t(pop.diploids)
+                    == flat.diploids);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(multiloc_sugar_genotype_matrix)
+{
+    // Storing genotypes in one matrix does not change the simulation
+    multiloc_popgenmut_fixture f;
+    flat_multiloc_popgenmut_fixture f2;
+    simulate_mlocuspop(f.pop, f.rng, f.mutmodels, f.recmodels,
+                       multiloc_popgenmut_fixture::multilocus_additive(), f.mu,
+                       f.rbw, f.generation);
+    simulate_mlocuspop(f2.pop, f2.rng, f2.mutmodels, f2.recmodels,
+                       flat_multiloc_popgenmut_fixture::multilocus_additive(),
+                       f2.mu, f2.rbw, f2.generation);
+    BOOST_REQUIRE_EQUAL(f2.pop.diploids.nloci(), 4);
+    check_same_population(f.pop, f2.pop);
+
+    // Samples are the same
+    auto s = fwdpp::sample(f.rng.get(), f.pop, 20, false);
+    auto s2 = fwdpp::sample(f2.rng.get(), f2.pop, 20, false);
+    BOOST_CHECK(s == s2);
+}
+
+BOOST_AUTO_TEST_CASE(multiloc_sugar_genotype_matrix_workspace)
+{
+    multiloc_popgenmut_fixture f;
+    flat_multiloc_popgenmut_fixture f2;
+    simulate_mlocuspop_workspace(
+        f.pop, f.rng, f.mutmodels, f.recmodels,
+        multiloc_popgenmut_fixture::multilocus_additive(), f.mu, f.rbw,
+        f.generation);
+    simulate_mlocuspop_workspace(
+        f2.pop, f2.rng, f2.mutmodels, f2.recmodels,
+        flat_multiloc_popgenmut_fixture::multilocus_additive(), f2.mu,
+        f2.rbw, f2.generation);
+    check_same_population(f.pop, f2.pop);
+}
+
+BOOST_AUTO_TEST_CASE(multiloc_sugar_genotype_matrix_serialization)
+{
+    multiloc_popgenmut_fixture f;
+    flat_multiloc_popgenmut_fixture f2;
+    simulate_mlocuspop(f.pop, f.rng, f.mutmodels, f.recmodels,
+                       multiloc_popgenmut_fixture::multilocus_additive(), f.mu,
+                       f.rbw, f.generation);
+    simulate_mlocuspop(f2.pop, f2.rng, f2.mutmodels, f2.recmodels,
+                       flat_multiloc_popgenmut_fixture::multilocus_additive(),
+                       f2.mu, f2.rbw, f2.generation);
+    // Both layouts write the same file
+    std::stringstream buffer, buffer2;
+    fwdpp::io::serialize_population(buffer, f.pop);
+    fwdpp::io::serialize_population(buffer2, f2.pop);
+    BOOST_CHECK(buffer.str() == buffer2.str());
+
+    flat_multiloc_popgenmut_fixture::poptype pop2(0, 0);
+    fwdpp::io::deserialize_population(buffer, pop2);
+    BOOST_CHECK_EQUAL(f2.pop == pop2, true);
+    check_same_population(f.pop, pop2);
+}
+
+namespace
+{
+    template <typename fixture_t>
+    void
+    simulate_with_interlocus_map(fixture_t &f, const bool workspace)
+    {
+        auto interlocus_rec = fwdpp::make_binomial_interlocus_map(
+            f.rbw.data(), f.rbw.size());
+        for (; f.generation < 10; ++f.generation)
+            {
+                double wbar
+                    = workspace
+                          ? fwdpp::sample_diploid(
+                                f.rng.get(), f.pop.gametes, f.pop.diploids,
+                                f.pop.mutations, f.pop.mcounts, 1000, &f.mu[0],
+                                f.mutmodels, f.recmodels, interlocus_rec,
+                                typename fixture_t::multilocus_additive(),
+                                f.pop.workspace)
+                          : fwdpp::sample_diploid(
+                                f.rng.get(), f.pop.gametes, f.pop.diploids,
+                                f.pop.mutations, f.pop.mcounts, 1000, &f.mu[0],
+                                f.mutmodels, f.recmodels, interlocus_rec,
+                                typename fixture_t::multilocus_additive(),
+                                f.pop.neutral, f.pop.selected);
+                BOOST_REQUIRE(std::isfinite(wbar));
+                BOOST_REQUIRE(fwdpp::popdata_sane_multilocus(
+                    f.pop.diploids, f.pop.gametes, f.pop.mutations,
+                    f.pop.mcounts));
+                fwdpp::update_mutations(f.pop.mutations, f.pop.fixations,
+                                        f.pop.fixation_times,
+                                        f.pop.mut_lookup, f.pop.mcounts,
+                                        f.generation, 2000);
+            }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(multiloc_sugar_interlocus_map)
+{
+    // fwdpp::interlocus_map may be used with either genotype layout,
+    // with or without a workspace
+    for (auto workspace : { false, true })
+        {
+            multiloc_popgenmut_fixture f;
+            flat_multiloc_popgenmut_fixture f2;
+            simulate_with_interlocus_map(f, workspace);
+            simulate_with_interlocus_map(f2, workspace);
+            check_same_population(f.pop, f2.pop);
+        }
+}
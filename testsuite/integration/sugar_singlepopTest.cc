@@ -4,8 +4,12 @@
   \brief Testing fwdpp::singlepop
 */
 #include <config.h>
+#include <algorithm>
 #include <boost/test/unit_test.hpp>
 #include <fwdpp/io/serialize_population.hpp>
+#include <fwdpp/thin_key_container.hpp>
+#include <fwdpp/fingerprinted_gamete.hpp>
+#include <fwdpp/sugar/sampling.hpp>
 #include "../fixtures/sugar_fixtures.hpp"
 #include "../util/quick_evolve_sugar.hpp"
 
@@ -40,6 +44,463 @@ BOOST_AUTO_TEST_CASE(singlepop_sugar_test4)
     BOOST_CHECK_EQUAL(pop == pop2, false);
 }
 
+BOOST_AUTO_TEST_CASE(singlepop_sugar_threaded_offspring)
+{
+    // Generating offspring on several threads
+    // must give the same population as one thread
+    simulate_singlepop(pop, 100, 1000);
+    for (unsigned nthreads : { 2u, 3u, 8u })
+        {
+            singlepop_popgenmut_fixture::poptype pop2(1000);
+            simulate_singlepop_threaded(pop2, nthreads, 100, 1000);
+            BOOST_CHECK_EQUAL(pop == pop2, true);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(singlepop_sugar_parent_sampler)
+{
+    fwdpp::parent_sampler sampler;
+    simulate_singlepop_threaded(pop, 1, 100, 1000, &sampler);
+    BOOST_CHECK_EQUAL(fwdpp::popdata_sane(pop.diploids, pop.gametes,
+                                          pop.mutations, pop.mcounts),
+                      true);
+    // Selection is weak, so max(w)/mean(w) is close to one
+    BOOST_CHECK(sampler.current_engine()
+                == fwdpp::parent_sampler::engine::stochastic_acceptance);
+    singlepop_popgenmut_fixture::poptype pop2(1000);
+    fwdpp::parent_sampler sampler2;
+    simulate_singlepop_threaded(pop2, 4, 100, 1000, &sampler2);
+    BOOST_CHECK_EQUAL(pop == pop2, true);
+}
+
+BOOST_AUTO_TEST_CASE(singlepop_sugar_workspace)
+{
+    // Without a parent_sampler, using the workspace
+    // must give the same population as not using it,
+    // for any number of threads.
+    simulate_singlepop(pop, 100, 1000);
+    for (unsigned nthreads : { 1u, 3u })
+        {
+            singlepop_popgenmut_fixture::poptype pop2(1000);
+            pop2.workspace.use_parent_sampler = false;
+            pop2.workspace.nthreads = nthreads;
+            simulate_singlepop_workspace(pop2, 100, 1000);
+            BOOST_CHECK_EQUAL(pop == pop2, true);
+            // The threads are started once and kept by the workspace
+            BOOST_CHECK_EQUAL(pop2.workspace.workers.size(), nthreads - 1);
+        }
+    // Changing population size
+    singlepop_popgenmut_fixture::poptype pop3(1000), pop4(1000);
+    simulate_singlepop(pop3, 10, 1500);
+    pop4.workspace.use_parent_sampler = false;
+    simulate_singlepop_workspace(pop4, 10, 1500);
+    BOOST_CHECK_EQUAL(pop3 == pop4, true);
+    BOOST_CHECK_EQUAL(pop4.diploids.size(), 1500);
+    // Default: parents are sampled using workspace.samplers
+    singlepop_popgenmut_fixture::poptype pop5(1000);
+    simulate_singlepop_workspace(pop5, 100, 1000);
+    BOOST_CHECK_EQUAL(fwdpp::popdata_sane(pop5.diploids, pop5.gametes,
+                                          pop5.mutations, pop5.mcounts),
+                      true);
+    BOOST_CHECK_EQUAL(pop5.workspace.samplers.size(), 1);
+    // The buffers of each offspring are kept from one generation to the
+    // next
+    BOOST_CHECK(pop5.workspace.buffers.breakpoints.capacity() > 0);
+    BOOST_CHECK(pop5.workspace.buffers.new_mutations.capacity() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(singlepop_sugar_fitness_cache)
+{
+    // Looking up fitnesses must not change the population
+    simulate_singlepop(pop, 100, 1000);
+    for (unsigned nthreads : { 1u, 3u })
+        {
+            singlepop_popgenmut_fixture::poptype pop2(1000);
+            pop2.workspace.use_parent_sampler = false;
+            pop2.workspace.use_fitness_cache = true;
+            pop2.workspace.nthreads = nthreads;
+            simulate_singlepop_workspace(pop2, 100, 1000);
+            BOOST_CHECK_EQUAL(pop == pop2, true);
+            BOOST_CHECK(pop2.workspace.cache.hits() > 0);
+            BOOST_CHECK(pop2.workspace.cache.skipped() > 0);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(singlepop_sugar_sorted_offspring)
+{
+    // Assembling offspring in order of parental gametes
+    // must not change the population
+    simulate_singlepop(pop, 100, 1000);
+    for (unsigned nthreads : { 1u, 4u })
+        {
+            singlepop_popgenmut_fixture::poptype pop2(1000);
+            pop2.workspace.use_parent_sampler = false;
+            pop2.workspace.sort_offspring = true;
+            pop2.workspace.nthreads = nthreads;
+            simulate_singlepop_workspace(pop2, 100, 1000);
+            BOOST_CHECK_EQUAL(pop == pop2, true);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(singlepop_sugar_incremental_mutation_counts)
+{
+    // Maintaining mutation counts incrementally must not change the
+    // population, including when fixations are removed.
+    singlepop_popgenmut_fixture::poptype pop1(100);
+    simulate_singlepop(pop1, 1000, 100);
+    BOOST_REQUIRE(!pop1.fixations.empty());
+    for (unsigned nthreads : { 1u, 3u })
+        {
+            singlepop_popgenmut_fixture::poptype pop2(100);
+            pop2.workspace.use_parent_sampler = false;
+            pop2.workspace.incremental_mutation_counts = true;
+            pop2.workspace.nthreads = nthreads;
+            simulate_singlepop_workspace(pop2, 1000, 100);
+            BOOST_CHECK_EQUAL(pop1 == pop2, true);
+            BOOST_CHECK_EQUAL(pop2.workspace.mutation_counts.rescans(), 1);
+        }
+    // Changing population size
+    singlepop_popgenmut_fixture::poptype pop3(1000), pop4(1000);
+    simulate_singlepop(pop3, 10, 1500);
+    pop4.workspace.use_parent_sampler = false;
+    pop4.workspace.incremental_mutation_counts = true;
+    simulate_singlepop_workspace(pop4, 10, 1500);
+    BOOST_CHECK_EQUAL(pop3 == pop4, true);
+}
+
+namespace
+{
+    template <typename poptype>
+    std::vector<std::vector<double>>
+    diploid_positions(const poptype &pop)
+    // Mutation positions carried by each diploid, which do not
+    // depend on mutation keys
+    {
+        std::vector<std::vector<double>> rv;
+        for (const auto &dip : pop.diploids)
+            {
+                rv.emplace_back();
+                for (auto g : { dip.first, dip.second })
+                    {
+                        for (auto k : pop.gametes[g].mutations)
+                            {
+                                rv.back().push_back(pop.mutations[k].pos);
+                            }
+                        for (auto k : pop.gametes[g].smutations)
+                            {
+                                rv.back().push_back(pop.mutations[k].pos);
+                            }
+                    }
+            }
+        return rv;
+    }
+
+    template <typename poptype>
+    std::vector<std::pair<double, fwdpp::uint_t>>
+    segregating_counts(const poptype &pop)
+    {
+        std::vector<std::pair<double, fwdpp::uint_t>> rv;
+        for (std::size_t i = 0; i < pop.mcounts.size(); ++i)
+            {
+                if (pop.mcounts[i])
+                    {
+                        rv.emplace_back(pop.mutations[i].pos, pop.mcounts[i]);
+                    }
+            }
+        std::sort(rv.begin(), rv.end());
+        return rv;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(singlepop_sugar_renumber_mutations)
+{
+    // Renumbering mutations changes keys but not the population
+    singlepop_popgenmut_fixture::poptype pop1(100), pop2(100);
+    simulate_singlepop_workspace(pop1, 1000, 100);
+    pop2.workspace.renumber_mutations_interval = 7;
+    simulate_singlepop_workspace(pop2, 1000, 100);
+    BOOST_REQUIRE(!pop1.fixations.empty());
+    BOOST_CHECK(pop1.mutations.size() != pop2.mutations.size());
+    BOOST_CHECK(diploid_positions(pop1) == diploid_positions(pop2));
+    BOOST_CHECK(segregating_counts(pop1) == segregating_counts(pop2));
+    BOOST_CHECK_EQUAL(pop1.fixations.size(), pop2.fixations.size());
+    fwdpp::renumber_mutations(pop2.gametes, pop2.mutations, pop2.mcounts);
+    BOOST_CHECK(std::is_sorted(
+        pop2.mutations.begin(), pop2.mutations.end(),
+        [](const fwdpp::popgenmut &a, const fwdpp::popgenmut &b) {
+            return a.pos < b.pos;
+        }));
+    BOOST_CHECK(diploid_positions(pop1) == diploid_positions(pop2));
+    auto mcounts = pop2.mcounts;
+    fwdpp::fwdpp_internal::process_gametes(pop2.gametes, pop2.mutations,
+                                           mcounts);
+    BOOST_CHECK(mcounts == pop2.mcounts);
+}
+
+BOOST_AUTO_TEST_CASE(singlepop_sugar_hash_cons_gametes)
+{
+    // Hash-consing gametes changes gamete keys but not the population
+    singlepop_popgenmut_fixture::poptype pop1(100);
+    simulate_singlepop_workspace(pop1, 1000, 100);
+    for (unsigned nthreads : { 1u, 3u })
+        {
+            singlepop_popgenmut_fixture::poptype pop2(100);
+            pop2.workspace.nthreads = nthreads;
+            pop2.workspace.hash_cons_gametes = true;
+            pop2.workspace.merge_duplicate_gametes_interval = 1;
+            simulate_singlepop_workspace(pop2, 1000, 100);
+            BOOST_CHECK(diploid_positions(pop1) == diploid_positions(pop2));
+            BOOST_CHECK(segregating_counts(pop1) == segregating_counts(pop2));
+            BOOST_CHECK(pop2.workspace.gamete_index.merged() > 0);
+            // No two extant gametes are identical
+            BOOST_CHECK_EQUAL(
+                fwdpp::merge_duplicate_gametes(pop2.gametes, pop2.diploids),
+                0);
+            BOOST_CHECK(
+                fwdpp::popdata_sane(pop2.diploids, pop2.gametes,
+                                    pop2.mutations, pop2.mcounts));
+        }
+}
+
+namespace
+{
+    template <typename poptype1, typename poptype2>
+    bool
+    same_extant_gametes(const poptype1 &pop1, const poptype2 &pop2)
+    // Gametes of different types have the same counts and keys
+    {
+        if (pop1.gametes.size() != pop2.gametes.size())
+            {
+                return false;
+            }
+        for (std::size_t i = 0; i < pop1.gametes.size(); ++i)
+            {
+                const auto &g1 = pop1.gametes[i];
+                const auto &g2 = pop2.gametes[i];
+                if (g1.n != g2.n)
+                    {
+                        return false;
+                    }
+                if (g1.n
+                    && (g1.mutations.size() != g2.mutations.size()
+                        || g1.smutations.size() != g2.smutations.size()
+                        || !std::equal(g1.mutations.begin(),
+                                       g1.mutations.end(),
+                                       g2.mutations.begin())
+                        || !std::equal(g1.smutations.begin(),
+                                       g1.smutations.end(),
+                                       g2.smutations.begin())))
+                    {
+                        return false;
+                    }
+            }
+        return true;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(singlepop_sugar_chunked_gametes)
+{
+    // Gametes storing keys in shared blocks evolve exactly
+    // like fwdpp::gamete
+    using chunked_poptype = fwdpp::sugar::singlepop<
+        fwdpp::popgenmut, std::vector<fwdpp::popgenmut>,
+        std::vector<fwdpp::chunked_gamete<16>>,
+        std::vector<std::pair<std::size_t, std::size_t>>,
+        std::vector<fwdpp::popgenmut>, std::vector<fwdpp::uint_t>,
+        std::unordered_set<double, std::hash<double>, fwdpp::equal_eps>>;
+    simulate_singlepop_workspace(pop, 1000, 100);
+    for (unsigned nthreads : { 1u, 3u })
+        {
+            chunked_poptype pop2(100);
+            pop2.workspace.nthreads = nthreads;
+            pop2.workspace.renumber_mutations_interval = 7;
+            singlepop_popgenmut_fixture::poptype pop3(100);
+            pop3.workspace.nthreads = nthreads;
+            pop3.workspace.renumber_mutations_interval = 7;
+            simulate_singlepop_workspace(pop2, 1000, 100);
+            simulate_singlepop_workspace(pop3, 1000, 100);
+            BOOST_CHECK(diploid_positions(pop) == diploid_positions(pop2));
+            BOOST_CHECK(segregating_counts(pop) == segregating_counts(pop2));
+            BOOST_REQUIRE(pop2.mutations == pop3.mutations);
+            BOOST_REQUIRE(pop2.diploids == pop3.diploids);
+            BOOST_REQUIRE(same_extant_gametes(pop2, pop3));
+            BOOST_CHECK(
+                fwdpp::popdata_sane(pop2.diploids, pop2.gametes,
+                                    pop2.mutations, pop2.mcounts));
+        }
+}
+
+BOOST_AUTO_TEST_CASE(singlepop_sugar_compressed_gametes)
+{
+    // Gametes storing compressed keys evolve exactly like
+    // fwdpp::gamete, and are serialized in the same format
+    using compressed_poptype = fwdpp::sugar::singlepop<
+        fwdpp::popgenmut, std::vector<fwdpp::popgenmut>,
+        std::vector<fwdpp::compressed_gamete<>>,
+        std::vector<std::pair<std::size_t, std::size_t>>,
+        std::vector<fwdpp::popgenmut>, std::vector<fwdpp::uint_t>,
+        std::unordered_set<double, std::hash<double>, fwdpp::equal_eps>>;
+    for (unsigned nthreads : { 1u, 3u })
+        {
+            compressed_poptype pop2(100);
+            pop2.workspace.nthreads = nthreads;
+            pop2.workspace.renumber_mutations_interval = 5;
+            singlepop_popgenmut_fixture::poptype pop3(100);
+            pop3.workspace.nthreads = nthreads;
+            pop3.workspace.renumber_mutations_interval = 5;
+            simulate_singlepop_workspace(pop2, 1000, 100);
+            simulate_singlepop_workspace(pop3, 1000, 100);
+            BOOST_REQUIRE(pop2.mutations == pop3.mutations);
+            BOOST_REQUIRE(pop2.mcounts == pop3.mcounts);
+            BOOST_REQUIRE(pop2.diploids == pop3.diploids);
+            BOOST_REQUIRE(same_extant_gametes(pop2, pop3));
+            std::ostringstream o2, o3;
+            fwdpp::io::serialize_population(o2, pop2);
+            fwdpp::io::serialize_population(o3, pop3);
+            BOOST_CHECK(o2.str() == o3.str());
+            compressed_poptype pop4(0);
+            std::istringstream i3(o3.str());
+            fwdpp::io::deserialize_population(i3, pop4);
+            BOOST_CHECK(pop4 == pop2);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(singlepop_sugar_common_variant_gametes)
+{
+    // Gametes storing common neutral mutations as bits evolve
+    // exactly like fwdpp::gamete
+    using common_variant_poptype = fwdpp::sugar::singlepop<
+        fwdpp::popgenmut, std::vector<fwdpp::popgenmut>,
+        std::vector<fwdpp::common_variant_gamete<>>,
+        std::vector<std::pair<std::size_t, std::size_t>>,
+        std::vector<fwdpp::popgenmut>, std::vector<fwdpp::uint_t>,
+        std::unordered_set<double, std::hash<double>, fwdpp::equal_eps>>;
+    simulate_singlepop_workspace(pop, 1000, 100);
+    BOOST_REQUIRE(!pop.fixations.empty());
+    for (unsigned nthreads : { 1u, 3u })
+        {
+            common_variant_poptype pop2(100);
+            pop2.workspace.nthreads = nthreads;
+            pop2.workspace.common_variants_interval = 5;
+            pop2.workspace.common_variant_frequency = 0.2;
+            pop2.workspace.renumber_mutations_interval = 7;
+            simulate_singlepop_workspace(pop2, 1000, 100);
+            const auto table = fwdpp::fwdpp_internal::
+                extant_common_variant_table(pop2.gametes);
+            BOOST_REQUIRE(table);
+            BOOST_CHECK(table->size() > 0);
+            auto mcounts = pop2.mcounts;
+            fwdpp::fwdpp_internal::process_gametes(
+                pop2.gametes, pop2.mutations, mcounts);
+            BOOST_CHECK(mcounts == pop2.mcounts);
+            fwdpp::expand_common_variants(pop2.gametes, pop2.mutations);
+            BOOST_CHECK(diploid_positions(pop) == diploid_positions(pop2));
+            BOOST_CHECK(segregating_counts(pop) == segregating_counts(pop2));
+            BOOST_CHECK_EQUAL(pop.fixations.size(), pop2.fixations.size());
+            BOOST_CHECK(
+                fwdpp::popdata_sane(pop2.diploids, pop2.gametes,
+                                    pop2.mutations, pop2.mcounts));
+        }
+}
+
+BOOST_AUTO_TEST_CASE(singlepop_sugar_slab_gametes)
+{
+    // Gametes whose keys are held by fwdpp::slab_allocator evolve
+    // exactly like fwdpp::gamete
+    using slab_poptype
+        = fwdpp::singlepop<fwdpp::popgenmut,
+                           std::pair<std::size_t, std::size_t>,
+                           fwdpp::slab_gamete<>>;
+    simulate_singlepop_workspace(pop, 1000, 100);
+    const auto before = fwdpp::slab_allocator_statistics();
+    slab_poptype pop2(100);
+    simulate_singlepop_workspace(pop2, 1000, 100);
+    BOOST_REQUIRE(pop.mutations == pop2.mutations);
+    BOOST_REQUIRE(pop.mcounts == pop2.mcounts);
+    BOOST_REQUIRE(pop.diploids == pop2.diploids);
+    BOOST_REQUIRE(same_extant_gametes(pop, pop2));
+    const auto after = fwdpp::slab_allocator_statistics();
+    BOOST_CHECK(after.allocations > before.allocations);
+    BOOST_CHECK(after.reused > before.reused);
+    BOOST_CHECK(after.bytes_in_use > before.bytes_in_use);
+}
+
+BOOST_AUTO_TEST_CASE(singlepop_sugar_fingerprinted_gametes)
+{
+    // Gametes storing fingerprints evolve exactly like fwdpp::gamete,
+    // and their fingerprints are kept up to date
+    using fingerprinted_poptype
+        = fwdpp::singlepop<fwdpp::popgenmut,
+                           std::pair<std::size_t, std::size_t>,
+                           fwdpp::fingerprinted_gamete<>>;
+    simulate_singlepop_workspace(pop, 1000, 100);
+    fingerprinted_poptype pop2(100);
+    simulate_singlepop_workspace(pop2, 1000, 100);
+    BOOST_REQUIRE(pop.mutations == pop2.mutations);
+    BOOST_REQUIRE(pop.mcounts == pop2.mcounts);
+    BOOST_REQUIRE(pop.diploids == pop2.diploids);
+    BOOST_REQUIRE(same_extant_gametes(pop, pop2));
+    for (const auto &g : pop2.gametes)
+        {
+            if (g.n)
+                {
+                    BOOST_REQUIRE_EQUAL(g.fingerprint,
+                                        g.calculate_fingerprint());
+                }
+        }
+    BOOST_CHECK_EQUAL(fwdpp::population_checksum(pop.gametes),
+                      fwdpp::population_checksum(pop2.gametes));
+
+    std::stringstream buffer;
+    fwdpp::io::serialize_population(buffer, pop2);
+    fingerprinted_poptype pop3(0);
+    fwdpp::io::deserialize_population(buffer, pop3);
+    BOOST_CHECK_EQUAL(fwdpp::population_checksum(pop3.gametes),
+                      fwdpp::population_checksum(pop2.gametes));
+}
+
+BOOST_AUTO_TEST_CASE(singlepop_sugar_compact_types)
+{
+    // Mutations and gametes without virtual functions evolve exactly
+    // like fwdpp::popgenmut and fwdpp::gamete, are sampled in the same
+    // way, and are serialized in the same format
+    using compact_poptype = fwdpp::sugar::singlepop<
+        fwdpp::compact_popgenmut, std::vector<fwdpp::compact_popgenmut>,
+        std::vector<fwdpp::compact_selected_gamete<>>,
+        std::vector<std::pair<std::size_t, std::size_t>>,
+        std::vector<fwdpp::compact_popgenmut>, std::vector<fwdpp::uint_t>,
+        std::unordered_set<double, std::hash<double>, fwdpp::equal_eps>>;
+    simulate_singlepop_workspace(pop, 1000, 100);
+    compact_poptype pop2(100);
+    simulate_singlepop_workspace(pop2, 1000, 100);
+    BOOST_REQUIRE_EQUAL(pop.mutations.size(), pop2.mutations.size());
+    for (std::size_t i = 0; i < pop.mutations.size(); ++i)
+        {
+            const auto &m = pop.mutations[i];
+            const auto &cm = pop2.mutations[i];
+            BOOST_REQUIRE(fwdpp::compact_popgenmut(m.pos, m.s, m.h, m.g,
+                                                   m.xtra)
+                          == cm);
+        }
+    BOOST_REQUIRE(pop.mcounts == pop2.mcounts);
+    BOOST_REQUIRE(pop.diploids == pop2.diploids);
+    BOOST_REQUIRE(same_extant_gametes(pop, pop2));
+    BOOST_CHECK(!pop.fixations.empty());
+
+    fwdpp::GSLrng_t<fwdpp::GSL_RNG_TAUS2> rng1(42u), rng2(42u);
+    BOOST_CHECK(fwdpp::sample(rng1.get(), pop, 20, true)
+                == fwdpp::sample(rng2.get(), pop2, 20, true));
+
+    std::ostringstream o1, o2;
+    fwdpp::io::serialize_population(o1, pop);
+    fwdpp::io::serialize_population(o2, pop2);
+    BOOST_CHECK(o1.str() == o2.str());
+    compact_poptype pop3(0);
+    std::istringstream i1(o1.str());
+    fwdpp::io::deserialize_population(i1, pop3);
+    BOOST_CHECK(pop3 == pop2);
+}
+
 // Test ability to serialize at different popsizes
 
 BOOST_AUTO_TEST_CASE(singlepop_serialize_smallN)
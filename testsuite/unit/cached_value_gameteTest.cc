@@ -0,0 +1,312 @@
+/*!
+  \file cached_value_gameteTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::cached_value_gamete
+*/
+#include <config.h>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/cached_value_gamete.hpp>
+#include <fwdpp/sugar/popgenmut.hpp>
+#include <fwdpp/sugar/singlepop.hpp>
+#include <testsuite/util/quick_evolve_sugar.hpp>
+#include "../fixtures/fwdpp_fixtures.hpp"
+
+namespace
+{
+    using additive_gamete
+        = fwdpp::cached_value_gamete<fwdpp::additive_haplotype_value>;
+    using multiplicative_gamete
+        = fwdpp::cached_value_gamete<fwdpp::multiplicative_haplotype_value>;
+    using effect_size_gamete
+        = fwdpp::cached_value_gamete<fwdpp::effect_size_sum_haplotype_value>;
+
+    template <typename gamete_t>
+    fwdpp::gamete
+    as_gamete(const gamete_t &g)
+    {
+        return fwdpp::gamete(g.n, g.mutations, g.smutations);
+    }
+
+    double
+    sum_s(const fwdpp::gamete &g, const mcont_t &mutations)
+    {
+        double rv = 0.;
+        for (auto k : g.smutations)
+            {
+                rv += mutations[k].s;
+            }
+        return rv;
+    }
+
+    double
+    sum_hap(const double a, const double b)
+    {
+        return a + b;
+    }
+}
+
+struct cached_value_gamete_fixture
+{
+    mcont_t mutations;
+    std::vector<multiplicative_gamete> gametes;
+    multiplicative_gamete::mutation_container neutral, selected;
+    fwdpp::fwdpp_internal::recycling_bin_t<std::size_t> gamete_recycling_bin;
+    cached_value_gamete_fixture()
+        : mutations{}, gametes{}, neutral{}, selected{},
+          gamete_recycling_bin{}
+    {
+        // Mutations sorted by position.  Mutation 2 is neutral.
+        mutations.emplace_back(mtype(0.1, -0.1, 0.25));
+        mutations.emplace_back(mtype(0.2, 0.05, 1.));
+        mutations.emplace_back(mtype(0.3, 0., 1.));
+        mutations.emplace_back(mtype(0.4, -0.2, 0.5));
+        gametes.emplace_back(1);
+        gametes.emplace_back(1);
+        gametes[1].smutations = { 0, 3 };
+        gametes[1].update_cached_value(mutations);
+        gametes.emplace_back(1);
+        gametes[2].smutations = { 0, 1 };
+        gametes[2].update_cached_value(mutations);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(cached_value_gameteTest, cached_value_gamete_fixture)
+
+BOOST_AUTO_TEST_CASE(test_construction)
+{
+    BOOST_CHECK(fwdpp::traits::is_gamete<multiplicative_gamete>::value);
+    multiplicative_gamete g(1);
+    BOOST_CHECK(g.cache_valid);
+    BOOST_CHECK_EQUAL(g.cached_value, 1.);
+    multiplicative_gamete::mutation_container n, s{ 1 };
+    multiplicative_gamete g2(1, n, s);
+    BOOST_CHECK(!g2.cache_valid);
+    BOOST_CHECK_CLOSE(g2.haplotype_value(mutations), 1.05, 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(test_mutate_recombine_no_recombination)
+{
+    // Add mutations 1 and 2 to gamete 1.  The value is derived
+    // from that of gamete 1.
+    auto g = fwdpp::mutate_recombine(std::vector<fwdpp::uint_t>{ 1, 2 }, {},
+                                     1, 0, gametes, mutations,
+                                     gamete_recycling_bin, neutral, selected);
+    BOOST_REQUIRE_EQUAL(g, 3);
+    BOOST_REQUIRE(gametes[g].cache_valid);
+    BOOST_CHECK_CLOSE(gametes[g].cached_value,
+                      gametes[g].calculate_value(mutations), 1e-10);
+    BOOST_CHECK_CLOSE(gametes[g].cached_value,
+                      gametes[1].cached_value * 1.05, 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(test_mutate_recombine_recycled)
+{
+    gametes[0].n = 0;
+    gamete_recycling_bin.push(0);
+    // Crossover between positions 0.1 and 0.2 gives a copy of gamete 2,
+    // which is re-used.
+    auto g = fwdpp::mutate_recombine(
+        std::vector<fwdpp::uint_t>{},
+        { 0.15, std::numeric_limits<double>::max() }, 1, 2, gametes,
+        mutations, gamete_recycling_bin, neutral, selected);
+    BOOST_REQUIRE_EQUAL(g, 2);
+    BOOST_REQUIRE_EQUAL(gamete_recycling_bin.size(), 1);
+    // Crossover between positions 0.2 and 0.4
+    g = fwdpp::mutate_recombine(
+        std::vector<fwdpp::uint_t>{},
+        { 0.3, std::numeric_limits<double>::max() }, 1, 2, gametes,
+        mutations, gamete_recycling_bin, neutral, selected);
+    BOOST_REQUIRE_EQUAL(g, 0);
+    BOOST_REQUIRE(gametes[g].smutations
+                  == multiplicative_gamete::mutation_container({ 0 }));
+    BOOST_REQUIRE(gametes[g].cache_valid);
+    BOOST_CHECK_CLOSE(gametes[g].cached_value,
+                      gametes[g].calculate_value(mutations), 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(test_recycling_invalidates)
+{
+    gametes[1].n = 0;
+    gamete_recycling_bin.push(1);
+    selected = { 1 };
+    auto g = fwdpp::fwdpp_internal::recycle_gamete(
+        gametes, gamete_recycling_bin, neutral, selected);
+    BOOST_REQUIRE_EQUAL(g, 1);
+    BOOST_CHECK(!gametes[g].cache_valid);
+    BOOST_CHECK_CLOSE(gametes[g].haplotype_value(mutations), 1.05, 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(test_multiplicative)
+{
+    gametes.emplace_back(1);
+    gametes[3].smutations = { 1, 3 };
+    gametes[3].update_cached_value(mutations);
+    for (auto scaling : { 1., 2. })
+        {
+            fwdpp::multiplicative_diploid w(scaling);
+            for (std::size_t i = 0; i < gametes.size(); ++i)
+                {
+                    for (std::size_t j = 0; j < gametes.size(); ++j)
+                        {
+                            BOOST_CHECK_CLOSE(
+                                w(gametes[i], gametes[j], mutations),
+                                w(as_gamete(gametes[i]),
+                                  as_gamete(gametes[j]), mutations),
+                                1e-10);
+                        }
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_multiplicative_singular)
+// 1 + h*s = 0 at a homozygous site
+{
+    mutations.emplace_back(mtype(0.5, -1., 1.));
+    gametes[1].smutations.push_back(4);
+    gametes[1].update_cached_value(mutations);
+    BOOST_REQUIRE_EQUAL(gametes[1].cached_value, 0.);
+    fwdpp::multiplicative_diploid w{ 1., fwdpp::mtrait() };
+    BOOST_CHECK_EQUAL(w(gametes[1], gametes[1], mutations), -1.);
+    BOOST_CHECK_EQUAL(w(gametes[1], gametes[1], mutations),
+                      w(as_gamete(gametes[1]), as_gamete(gametes[1]),
+                        mutations));
+}
+
+BOOST_AUTO_TEST_CASE(test_keys_sharing_a_position)
+// Mutation 4 is at the position of mutation 1, and comes before it in
+// gamete 3.  Mutations 1 and 3 are homozygous in gametes 3 and 4.
+{
+    mutations.emplace_back(mtype(0.2, -0.3, 0.5));
+    gametes.emplace_back(1);
+    gametes[3].smutations = { 0, 4, 1, 3 };
+    gametes[3].update_cached_value(mutations);
+    gametes.emplace_back(1);
+    gametes[4].smutations = { 1, 3 };
+    gametes[4].update_cached_value(mutations);
+    for (auto order : { std::make_pair(3, 4), std::make_pair(4, 3) })
+        {
+            const auto &g1 = gametes[order.first], &g2 = gametes[order.second];
+            std::vector<double> homozygous;
+            fwdpp::fwdpp_internal::for_each_homozygous_site(
+                g1.smutations.cbegin(), g1.smutations.cend(),
+                g2.smutations.cbegin(), g2.smutations.cend(), mutations,
+                [&homozygous](const mtype &m) {
+                    homozygous.push_back(m.s);
+                });
+            BOOST_CHECK(homozygous == std::vector<double>({ 0.05, -0.2 }));
+            const double expected
+                = (1. - 0.1 * 0.25) * (1. - 0.3 * 0.5) * (1. + 2. * 0.05)
+                  * (1. - 2. * 0.2);
+            fwdpp::multiplicative_diploid w(2.);
+            BOOST_CHECK_CLOSE(w(as_gamete(g1), as_gamete(g2), mutations),
+                              expected, 1e-10);
+            BOOST_CHECK_CLOSE(w(g1, g2, mutations), expected, 1e-10);
+            std::vector<additive_gamete> agametes;
+            for (auto g : { &g1, &g2 })
+                {
+                    agametes.emplace_back(g->n, g->mutations,
+                                          g->smutations);
+                    agametes.back().update_cached_value(mutations);
+                }
+            fwdpp::additive_diploid a(2., fwdpp::atrait());
+            BOOST_CHECK_CLOSE(a(agametes[0], agametes[1], mutations),
+                              a(as_gamete(g1), as_gamete(g2), mutations),
+                              1e-10);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_additive)
+{
+    std::vector<additive_gamete> agametes;
+    for (auto &g : gametes)
+        {
+            agametes.emplace_back(g.n, g.mutations, g.smutations);
+            agametes.back().update_cached_value(mutations);
+        }
+    for (auto scaling : { 1., 2. })
+        {
+            fwdpp::additive_diploid w(scaling, fwdpp::atrait());
+            for (std::size_t i = 0; i < agametes.size(); ++i)
+                {
+                    for (std::size_t j = 0; j < agametes.size(); ++j)
+                        {
+                            BOOST_CHECK_CLOSE(
+                                w(agametes[i], agametes[j], mutations),
+                                w(as_gamete(agametes[i]),
+                                  as_gamete(agametes[j]), mutations),
+                                1e-10);
+                        }
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_haplotype_dependent)
+{
+    std::vector<effect_size_gamete> egametes;
+    for (auto &g : gametes)
+        {
+            egametes.emplace_back(g.n, g.mutations, g.smutations);
+            egametes.back().update_cached_value(mutations);
+        }
+    std::vector<std::pair<std::size_t, std::size_t>> diploids{ { 1, 2 } };
+    BOOST_CHECK_CLOSE(fwdpp::haplotype_dependent_trait_value()(
+                          diploids[0], egametes, mutations, sum_hap),
+                      fwdpp::haplotype_dependent_trait_value()(
+                          as_gamete(egametes[1]), as_gamete(egametes[2]),
+                          mutations, sum_s, sum_hap),
+                      1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(test_gamete_cleaner)
+// Removing a selected fixation updates the cached values
+{
+    std::vector<fwdpp::uint_t> mcounts{ 4, 0, 0, 2 };
+    gametes[0].n = 0;
+    gametes[1].n = 2;
+    gametes[2].n = 2;
+    fwdpp::fwdpp_internal::gamete_cleaner(gametes, mutations, mcounts, 4,
+                                          std::true_type());
+    BOOST_REQUIRE(gametes[1].smutations
+                  == multiplicative_gamete::mutation_container({ 3 }));
+    BOOST_CHECK(gametes[1].cache_valid);
+    BOOST_CHECK_CLOSE(gametes[1].cached_value, 0.9, 1e-10);
+    BOOST_CHECK_CLOSE(gametes[2].cached_value, 1.05, 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(test_simulation)
+// Cached values remain valid during a simulation
+{
+    using poptype = fwdpp::sugar::singlepop<
+        fwdpp::popgenmut, std::vector<fwdpp::popgenmut>,
+        std::vector<multiplicative_gamete>,
+        std::vector<std::pair<std::size_t, std::size_t>>,
+        std::vector<fwdpp::popgenmut>, std::vector<fwdpp::uint_t>,
+        std::unordered_set<double, std::hash<double>, fwdpp::equal_eps>>;
+    poptype pop(1000);
+    simulate_singlepop(pop, 100, 1000);
+    unsigned nselected = 0;
+    for (const auto &g : pop.gametes)
+        {
+            if (g.n)
+                {
+                    BOOST_REQUIRE(g.cache_valid);
+                    BOOST_REQUIRE_CLOSE(g.cached_value,
+                                        g.calculate_value(pop.mutations),
+                                        1e-10);
+                    nselected += g.smutations.size();
+                }
+        }
+    BOOST_CHECK(nselected > 0);
+    fwdpp::multiplicative_diploid w(2.);
+    for (const auto &dip : pop.diploids)
+        {
+            BOOST_REQUIRE_CLOSE(w(dip, pop.gametes, pop.mutations),
+                                w(as_gamete(pop.gametes[dip.first]),
+                                  as_gamete(pop.gametes[dip.second]),
+                                  pop.mutations),
+                                1e-10);
+        }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,233 @@
+/*!
+  \file chunked_key_containerTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::chunked_key_container and fwdpp::chunked_gamete
+*/
+#include <config.h>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/chunked_key_container.hpp>
+#include "../fixtures/fwdpp_fixtures.hpp"
+
+using keys_t = fwdpp::chunked_key_container<8>;
+using chunked_gamete_t = fwdpp::chunked_gamete<8>;
+
+namespace
+{
+    bool
+    blocks_are_compact(const keys_t &keys)
+    {
+        const auto &b = keys.blocks();
+        for (std::size_t i = 1; i < b.size(); ++i)
+            {
+                if (b[i - 1]->size() + b[i]->size() <= 8)
+                    {
+                        return false;
+                    }
+            }
+        return true;
+    }
+
+    std::size_t
+    shared_blocks(const keys_t &a, const keys_t &b)
+    {
+        std::size_t n = 0;
+        for (const auto &i : a.blocks())
+            {
+                n += std::count(b.blocks().begin(), b.blocks().end(), i);
+            }
+        return n;
+    }
+}
+
+struct chunked_gamete_fixture : public standard_empty_single_deme_fixture
+{
+    std::vector<chunked_gamete_t> chunked_gametes;
+    chunked_gamete_t::mutation_container chunked_neutral, chunked_selected;
+    fwdpp::fwdpp_internal::recycling_bin_t<std::size_t> gamete_recycling_bin;
+    chunked_gamete_fixture()
+        : chunked_gametes{}, chunked_neutral{}, chunked_selected{},
+          gamete_recycling_bin{}
+    {
+        // Mutation i is at position i/100, and every third one is
+        // selected.
+        for (unsigned i = 0; i < 100; ++i)
+            {
+                mutations.emplace_back(mtype(double(i) / 100.,
+                                             (i % 3 == 0) ? -0.1 : 0., 1));
+            }
+        gametes.emplace_back(1);
+        gametes.emplace_back(1);
+        for (unsigned i = 0; i < 100; ++i)
+            {
+                auto &g = gametes[(i % 2 == 0 || i % 5 == 0) ? 0 : 1];
+                if (mutations[i].neutral)
+                    {
+                        g.mutations.push_back(i);
+                    }
+                else
+                    {
+                        g.smutations.push_back(i);
+                    }
+            }
+        for (const auto &g : gametes)
+            {
+                chunked_gametes.emplace_back(g.n);
+                chunked_gametes.back().mutations.insert(
+                    chunked_gametes.back().mutations.end(),
+                    g.mutations.begin(), g.mutations.end());
+                chunked_gametes.back().smutations.insert(
+                    chunked_gametes.back().smutations.end(),
+                    g.smutations.begin(), g.smutations.end());
+            }
+    }
+
+    template <typename container>
+    bool
+    same_keys(const fwdpp::gamete &g, const container &keys, bool neutral)
+    {
+        const auto &k = (neutral) ? g.mutations : g.smutations;
+        return k.size() == keys.size()
+               && std::equal(k.begin(), k.end(), keys.begin());
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(chunked_key_containerTest, chunked_gamete_fixture)
+
+BOOST_AUTO_TEST_CASE(test_copy_on_write)
+{
+    keys_t a;
+    for (unsigned i = 0; i < 20; ++i)
+        {
+            a.push_back(i);
+        }
+    BOOST_REQUIRE_EQUAL(a.size(), 20);
+    BOOST_REQUIRE_EQUAL(a.blocks().size(), 3);
+    std::vector<fwdpp::uint_t> expected(20);
+    std::iota(expected.begin(), expected.end(), 0);
+    BOOST_REQUIRE(std::equal(a.begin(), a.end(), expected.begin()));
+    auto b(a);
+    BOOST_CHECK(a == b);
+    BOOST_CHECK_EQUAL(shared_blocks(a, b), 3);
+    // Appending to a copy does not change the original
+    b.push_back(20);
+    BOOST_CHECK(a != b);
+    BOOST_CHECK_EQUAL(a.size(), 20);
+    BOOST_CHECK_EQUAL(a.blocks().back()->size(), 4);
+    BOOST_CHECK_EQUAL(shared_blocks(a, b), 2);
+    BOOST_CHECK(std::equal(a.begin(), a.end(), b.begin()));
+}
+
+BOOST_AUTO_TEST_CASE(test_remove_if)
+{
+    keys_t a;
+    for (unsigned i = 0; i < 40; ++i)
+        {
+            a.push_back(i);
+        }
+    auto b(a);
+    b.remove_if([](const fwdpp::uint_t k) { return k == 3 || k == 17; });
+    BOOST_REQUIRE_EQUAL(b.size(), 38);
+    BOOST_CHECK(std::find(b.begin(), b.end(), 3) == b.end());
+    BOOST_CHECK(std::find(b.begin(), b.end(), 17) == b.end());
+    BOOST_CHECK(std::is_sorted(b.begin(), b.end()));
+    // Blocks without removed keys remain shared
+    BOOST_CHECK_EQUAL(shared_blocks(a, b), 3);
+    BOOST_CHECK(blocks_are_compact(b));
+}
+
+BOOST_AUTO_TEST_CASE(test_mutate_recombine)
+{
+    // New mutations, one of which is neutral
+    mutations.emplace_back(mtype(0.255, 0., 1));
+    mutations.emplace_back(mtype(0.505, -0.1, 1));
+    const std::vector<std::vector<fwdpp::uint_t>> new_mutations
+        = { {}, { 100 }, { 100, 101 } };
+    const double maxpos = std::numeric_limits<double>::max();
+    const std::vector<std::vector<double>> breakpoints
+        = { {},
+            { 0.5, maxpos },
+            { 0.3, maxpos },
+            { 0.055, 0.255, 0.256, 0.9, maxpos },
+            { -1., 0.01, 0.42, 0.505, 0.77, 0.771, 2., maxpos } };
+    for (const auto &nm : new_mutations)
+        {
+            for (const auto &bp : breakpoints)
+                {
+                    if (nm.empty() && bp.empty())
+                        {
+                            continue;
+                        }
+                    for (std::size_t p = 0; p < 2; ++p)
+                        {
+                            auto idx = fwdpp::mutate_recombine(
+                                nm, bp, p, 1 - p, gametes, mutations,
+                                gamete_recycling_bin, neutral, selected);
+                            auto cidx = fwdpp::mutate_recombine(
+                                nm, bp, p, 1 - p, chunked_gametes, mutations,
+                                gamete_recycling_bin, chunked_neutral,
+                                chunked_selected);
+                            BOOST_REQUIRE_EQUAL(idx, cidx);
+                            const auto &g = chunked_gametes[cidx];
+                            BOOST_REQUIRE(
+                                same_keys(gametes[idx], g.mutations, true));
+                            BOOST_REQUIRE(
+                                same_keys(gametes[idx], g.smutations, false));
+                            BOOST_REQUIRE(blocks_are_compact(g.mutations));
+                            BOOST_REQUIRE(blocks_are_compact(g.smutations));
+                        }
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_blocks_shared_with_parents)
+{
+    const std::vector<double> bp
+        = { 0.5, std::numeric_limits<double>::max() };
+    auto idx = fwdpp::mutate_recombine({}, bp, 0, 1, chunked_gametes,
+                                       mutations, gamete_recycling_bin,
+                                       chunked_neutral, chunked_selected);
+    BOOST_REQUIRE_EQUAL(idx, 2);
+    const auto &k = chunked_gametes[2].mutations;
+    // The offspring has the keys of gamete 0 before 0.5 and those of
+    // gamete 1 after it.  Only blocks that straddle 0.5 are copied.
+    const auto n0 = shared_blocks(k, chunked_gametes[0].mutations);
+    const auto n1 = shared_blocks(k, chunked_gametes[1].mutations);
+    BOOST_CHECK(n0 >= 2);
+    BOOST_CHECK(n1 >= 1);
+    BOOST_CHECK(n0 + n1 + 2 >= k.blocks().size());
+}
+
+BOOST_AUTO_TEST_CASE(test_process_gametes_and_cleaner)
+{
+    std::vector<fwdpp::uint_t> counts, chunked_counts;
+    fwdpp::fwdpp_internal::process_gametes(gametes, mutations, counts);
+    fwdpp::fwdpp_internal::process_gametes(chunked_gametes, mutations,
+                                           chunked_counts);
+    BOOST_REQUIRE(counts == chunked_counts);
+    // Pretend that some mutations in gamete 0 are fixed
+    for (auto k : { 4u, 10u, 30u, 35u })
+        {
+            counts[k] = chunked_counts[k] = 2;
+        }
+    fwdpp::fwdpp_internal::gamete_cleaner(gametes, mutations, counts, 2,
+                                          std::true_type());
+    fwdpp::fwdpp_internal::gamete_cleaner(chunked_gametes, mutations,
+                                          chunked_counts, 2,
+                                          std::true_type());
+    BOOST_REQUIRE_EQUAL(gametes[0].mutations.size()
+                            + gametes[0].smutations.size(),
+                        56);
+    for (std::size_t i = 0; i < gametes.size(); ++i)
+        {
+            BOOST_CHECK(
+                same_keys(gametes[i], chunked_gametes[i].mutations, true));
+            BOOST_CHECK(
+                same_keys(gametes[i], chunked_gametes[i].smutations, false));
+        }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,329 @@
+/*!
+  \file common_variant_gameteTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::common_variant_gamete
+*/
+#include <config.h>
+#include <limits>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/common_variant_gamete.hpp>
+#include <fwdpp/soa_mutation_vector.hpp>
+#include "../fixtures/fwdpp_fixtures.hpp"
+
+using common_variant_gamete_t = fwdpp::common_variant_gamete<>;
+
+struct common_variant_gamete_fixture
+    : public standard_empty_single_deme_fixture
+{
+    std::vector<common_variant_gamete_t> cv_gametes;
+    common_variant_gamete_t::mutation_container cv_neutral, cv_selected;
+    fwdpp::fwdpp_internal::recycling_bin_t<std::size_t> gamete_recycling_bin;
+    std::vector<fwdpp::uint_t> counts;
+    common_variant_gamete_fixture()
+        : cv_gametes{}, cv_neutral{}, cv_selected{}, gamete_recycling_bin{},
+          counts{}
+    {
+        // Mutation i is at position i/100, and every third one is
+        // selected.  Gamete g carries mutation i if g <= i % 4, so
+        // that the count of mutation i is 1 + i % 4.
+        for (unsigned i = 0; i < 100; ++i)
+            {
+                mutations.emplace_back(mtype(double(i) / 100.,
+                                             (i % 3 == 0) ? -0.1 : 0., 1));
+            }
+        for (unsigned g = 0; g < 4; ++g)
+            {
+                gametes.emplace_back(1);
+                for (unsigned i = 0; i < 100; ++i)
+                    {
+                        if (g <= i % 4)
+                            {
+                                if (mutations[i].neutral)
+                                    {
+                                        gametes[g].mutations.push_back(i);
+                                    }
+                                else
+                                    {
+                                        gametes[g].smutations.push_back(i);
+                                    }
+                            }
+                    }
+                cv_gametes.emplace_back(1u, gametes[g].mutations,
+                                        gametes[g].smutations);
+            }
+        fwdpp::fwdpp_internal::process_gametes(gametes, mutations, counts);
+    }
+
+    std::vector<fwdpp::uint_t>
+    all_neutral_keys(const common_variant_gamete_t &g)
+    {
+        std::vector<fwdpp::uint_t> rv(g.mutations.begin(),
+                                      g.mutations.end());
+        g.for_each_common_variant(
+            [&rv](const fwdpp::uint_t k) { rv.push_back(k); });
+        std::sort(rv.begin(), rv.end(),
+                  [this](const fwdpp::uint_t a, const fwdpp::uint_t b) {
+                      return mutations[a].pos < mutations[b].pos;
+                  });
+        return rv;
+    }
+
+    bool
+    same_mutations(const fwdpp::gamete &g, const common_variant_gamete_t &cg)
+    {
+        return g.mutations == all_neutral_keys(cg)
+               && g.smutations == cg.smutations;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(common_variant_gameteTest,
+                         common_variant_gamete_fixture)
+
+BOOST_AUTO_TEST_CASE(test_update_and_expand)
+{
+    // Neutral mutations in at least 3 of the 4 gametes
+    const auto ncommon
+        = fwdpp::update_common_variants(cv_gametes, mutations, counts, 3);
+    std::size_t expected = 0;
+    for (unsigned i = 0; i < 100; ++i)
+        {
+            expected += (mutations[i].neutral && i % 4 >= 2);
+        }
+    BOOST_REQUIRE_EQUAL(ncommon, expected);
+    const auto &table = *cv_gametes[0].common_variants;
+    BOOST_CHECK(std::is_sorted(table.positions.begin(),
+                               table.positions.end()));
+    for (std::size_t g = 0; g < 4; ++g)
+        {
+            BOOST_CHECK(cv_gametes[g].common_variants
+                        == cv_gametes[0].common_variants);
+            BOOST_CHECK(same_mutations(gametes[g], cv_gametes[g]));
+            BOOST_CHECK(cv_gametes[g].mutations.size()
+                        < gametes[g].mutations.size());
+            BOOST_CHECK(cv_gametes[g].smutations == gametes[g].smutations);
+        }
+    // Gamete 3 only carries mutations with i % 4 == 3, which are common
+    BOOST_CHECK(cv_gametes[3].mutations.empty());
+
+    std::vector<fwdpp::uint_t> cv_counts;
+    fwdpp::fwdpp_internal::process_gametes(cv_gametes, mutations, cv_counts);
+    BOOST_CHECK(cv_counts == counts);
+
+    // A higher threshold moves mutations back to the keys
+    BOOST_CHECK(fwdpp::update_common_variants(cv_gametes, mutations, counts,
+                                              4)
+                < ncommon);
+    for (std::size_t g = 0; g < 4; ++g)
+        {
+            BOOST_CHECK(same_mutations(gametes[g], cv_gametes[g]));
+        }
+
+    fwdpp::expand_common_variants(cv_gametes, mutations);
+    for (std::size_t g = 0; g < 4; ++g)
+        {
+            BOOST_CHECK(!cv_gametes[g].common_variants);
+            BOOST_CHECK(cv_gametes[g].mutations == gametes[g].mutations);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_mutate_recombine)
+{
+    fwdpp::update_common_variants(cv_gametes, mutations, counts, 2);
+    mutations.emplace_back(mtype(0.255, 0., 1));
+    mutations.emplace_back(mtype(0.505, -0.1, 1));
+    const std::vector<std::vector<fwdpp::uint_t>> new_mutations
+        = { {}, { 100 }, { 100, 101 } };
+    const double maxpos = std::numeric_limits<double>::max();
+    // Breakpoints in the middle of words, at positions of mutations,
+    // and after all mutations
+    const std::vector<std::vector<double>> breakpoints
+        = { {},
+            { 0.5, maxpos },
+            { 0.055, 0.255, 0.256, 0.9, maxpos },
+            { -1., 0.01, 0.42, 0.505, 0.77, 0.771, 2., maxpos },
+            { 0.1, 0.62 } };
+    for (const auto &nm : new_mutations)
+        {
+            for (const auto &bp : breakpoints)
+                {
+                    if (nm.empty() && bp.empty())
+                        {
+                            continue;
+                        }
+                    for (std::size_t p = 0; p < 4; ++p)
+                        {
+                            const auto q = (p + 1) % 4;
+                            auto idx = fwdpp::mutate_recombine(
+                                nm, bp, p, q, gametes, mutations,
+                                gamete_recycling_bin, neutral, selected);
+                            auto cidx = fwdpp::mutate_recombine(
+                                nm, bp, p, q, cv_gametes, mutations,
+                                gamete_recycling_bin, cv_neutral,
+                                cv_selected);
+                            BOOST_REQUIRE_EQUAL(idx, cidx);
+                            BOOST_REQUIRE(
+                                same_mutations(gametes[idx], cv_gametes[cidx]));
+                            // New mutations are stored as keys
+                            for (auto k : nm)
+                                {
+                                    if (mutations[k].neutral)
+                                        {
+                                            BOOST_REQUIRE(
+                                                std::find(
+                                                    cv_gametes[cidx]
+                                                        .mutations.begin(),
+                                                    cv_gametes[cidx]
+                                                        .mutations.end(),
+                                                    k)
+                                                != cv_gametes[cidx]
+                                                       .mutations.end());
+                                        }
+                                }
+                        }
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_gamete_cleaner)
+{
+    fwdpp::update_common_variants(cv_gametes, mutations, counts, 3);
+    // Mutations with i % 4 == 3 are fixed.  The neutral ones are
+    // stored as bits, and the selected ones as keys.
+    auto cv_counts = counts;
+    fwdpp::fwdpp_internal::gamete_cleaner(gametes, mutations, counts, 4,
+                                          std::true_type());
+    fwdpp::fwdpp_internal::gamete_cleaner(cv_gametes, mutations, cv_counts,
+                                          4, std::true_type());
+    BOOST_REQUIRE(cv_gametes[3].mutations.empty());
+    BOOST_REQUIRE(cv_gametes[3].smutations.empty());
+    for (std::size_t g = 0; g < 4; ++g)
+        {
+            BOOST_CHECK(same_mutations(gametes[g], cv_gametes[g]));
+        }
+    BOOST_CHECK_EQUAL(cv_gametes[3].common_variant_count(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_renumber_mutations)
+{
+    fwdpp::update_common_variants(cv_gametes, mutations, counts, 3);
+    // Shuffle the keys by renumbering in reverse order of position
+    auto cv_mutations = mutations;
+    auto cv_counts = counts;
+    for (auto &m : cv_mutations)
+        {
+            m.pos = 1. - m.pos;
+        }
+    fwdpp::renumber_mutations(cv_gametes, cv_mutations, cv_counts);
+    std::vector<fwdpp::uint_t> recounted;
+    fwdpp::fwdpp_internal::process_gametes(cv_gametes, cv_mutations,
+                                           recounted);
+    BOOST_CHECK(recounted == cv_counts);
+    for (std::size_t g = 0; g < 4; ++g)
+        {
+            std::vector<double> p1, p2;
+            for (auto k : gametes[g].mutations)
+                {
+                    p1.push_back(1. - mutations[k].pos);
+                }
+            cv_gametes[g].for_each_common_variant(
+                [&](const fwdpp::uint_t k) {
+                    p2.push_back(cv_mutations[k].pos);
+                });
+            for (auto k : cv_gametes[g].mutations)
+                {
+                    p2.push_back(cv_mutations[k].pos);
+                }
+            std::sort(p1.begin(), p1.end());
+            std::sort(p2.begin(), p2.end());
+            BOOST_CHECK(p1 == p2);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_equality_and_merging)
+{
+    fwdpp::update_common_variants(cv_gametes, mutations, counts, 3);
+    // Same keys, different common variants
+    auto g = cv_gametes[2];
+    g.common[0] ^= 1u;
+    BOOST_CHECK(!(g == cv_gametes[2]));
+    BOOST_CHECK(g.mutations == cv_gametes[2].mutations);
+    cv_gametes.push_back(g);
+    cv_gametes.push_back(cv_gametes[2]);
+    std::vector<std::pair<std::size_t, std::size_t>> diploids
+        = { { 2, 4 }, { 5, 3 } };
+    fwdpp::gamete_hash_index index;
+    BOOST_CHECK_EQUAL(
+        fwdpp::merge_duplicate_gametes(cv_gametes, diploids, index), 1);
+    BOOST_CHECK_EQUAL(cv_gametes[2].n, 2);
+    BOOST_CHECK_EQUAL(cv_gametes[4].n, 1);
+    BOOST_CHECK_EQUAL(cv_gametes[5].n, 0);
+    BOOST_CHECK_EQUAL(diploids[1].first, 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_column_counts)
+{
+    // Enough columns for more than one word
+    for (unsigned i = 100; i < 200; ++i)
+        {
+            mutations.emplace_back(mtype(double(i) / 100., 0., 1));
+            for (unsigned g = 0; g <= i % 4; ++g)
+                {
+                    cv_gametes[g].mutations.push_back(i);
+                }
+        }
+    fwdpp::fwdpp_internal::process_gametes(cv_gametes, mutations, counts);
+    fwdpp::update_common_variants(cv_gametes, mutations, counts, 2);
+    BOOST_REQUIRE(cv_gametes[0].common_variants->nwords() > 1);
+    // More than 64 gametes, with counts using many bits, some of them
+    // extinct, and one referring to another table
+    std::vector<common_variant_gamete_t> many;
+    for (unsigned i = 0; i < 150; ++i)
+        {
+            many.push_back(cv_gametes[(i * 7) % 4]);
+            many.back().n = (i % 5 == 0) ? 0 : i * i * 977u + (i << 20);
+        }
+    many[75].common_variants = std::make_shared<fwdpp::common_variant_table>(
+        *many[75].common_variants);
+    std::vector<fwdpp::uint_t> expected(mutations.size(), 0),
+        columns(mutations.size(), 0);
+    for (const auto &g : many)
+        {
+            if (g.n)
+                {
+                    g.add_common_variant_counts(g.n, expected.data());
+                }
+        }
+    fwdpp::fwdpp_internal::add_common_variant_column_counts(
+        many.cbegin(), many.cend(), columns.data());
+    BOOST_CHECK(columns == expected);
+    BOOST_CHECK(std::any_of(columns.begin(), columns.end(),
+                            [](const fwdpp::uint_t c) { return c > 0; }));
+}
+
+BOOST_AUTO_TEST_CASE(test_mutation_columns)
+{
+    // The same tables and gametes when positions are read from columns
+    fwdpp::soa_mutation_vector<mtype> columns;
+    for (const auto &m : mutations)
+        {
+            columns.push_back(m);
+        }
+    auto cv_gametes2 = cv_gametes;
+    fwdpp::update_common_variants(cv_gametes, mutations, counts, 3);
+    fwdpp::update_common_variants(cv_gametes2, columns, counts, 3);
+    BOOST_CHECK(cv_gametes[0].common_variants->keys
+                == cv_gametes2[0].common_variants->keys);
+    for (std::size_t g = 0; g < 4; ++g)
+        {
+            BOOST_CHECK(cv_gametes[g] == cv_gametes2[g]);
+        }
+    fwdpp::expand_common_variants(cv_gametes2, columns);
+    for (std::size_t g = 0; g < 4; ++g)
+        {
+            BOOST_CHECK(cv_gametes2[g].mutations == gametes[g].mutations);
+        }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
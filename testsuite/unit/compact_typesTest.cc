@@ -0,0 +1,99 @@
+/*!
+  \file compact_typesTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::compact_mutation_base, fwdpp::compact_gamete_base
+  and fwdpp::thin_key_container
+*/
+#include <config.h>
+#include <sstream>
+#include <type_traits>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/thin_key_container.hpp>
+#include <fwdpp/sugar/popgenmut.hpp>
+
+BOOST_AUTO_TEST_SUITE(compact_typesTest)
+
+BOOST_AUTO_TEST_CASE(test_traits_and_sizes)
+{
+    static_assert(fwdpp::traits::is_mutation<fwdpp::compact_mutation>::value,
+                  "compact_mutation must be a mutation");
+    static_assert(
+        fwdpp::traits::is_mutation<fwdpp::compact_popgenmut>::value,
+        "compact_popgenmut must be a mutation");
+    static_assert(fwdpp::traits::is_gamete<fwdpp::compact_gamete>::value,
+                  "compact_gamete must be a gamete");
+    static_assert(
+        fwdpp::traits::is_gamete<fwdpp::compact_selected_gamete<>>::value,
+        "compact_selected_gamete must be a gamete");
+    static_assert(!std::is_polymorphic<fwdpp::compact_popgenmut>::value,
+                  "compact_popgenmut must have no virtual functions");
+#if (defined __GNUG__ && __GNUC__ >= 5) || !defined __GNUG__                  \
+    || defined __clang__
+    static_assert(
+        std::is_trivially_copyable<fwdpp::compact_popgenmut>::value,
+        "compact_popgenmut must be trivially copyable");
+    static_assert(std::is_trivially_copyable<fwdpp::compact_mutation>::value,
+                  "compact_mutation must be trivially copyable");
+#endif
+    BOOST_CHECK(sizeof(fwdpp::compact_mutation) < sizeof(fwdpp::mutation));
+    BOOST_CHECK(sizeof(fwdpp::compact_popgenmut)
+                < sizeof(fwdpp::popgenmut));
+    BOOST_CHECK(sizeof(fwdpp::compact_gamete) < sizeof(fwdpp::gamete));
+    BOOST_CHECK(sizeof(fwdpp::compact_selected_gamete<>)
+                < sizeof(fwdpp::compact_gamete));
+    BOOST_CHECK_EQUAL(sizeof(fwdpp::thin_key_container), sizeof(void *));
+}
+
+BOOST_AUTO_TEST_CASE(test_compact_popgenmut_serialization)
+{
+    // Same format as fwdpp::popgenmut
+    fwdpp::popgenmut m(0.25, -0.1, 0.5, 3, 7);
+    fwdpp::compact_popgenmut cm(0.25, -0.1, 0.5, 3, 7);
+    std::ostringstream o1, o2;
+    fwdpp::io::serialize_mutation<fwdpp::popgenmut>()(o1, m);
+    fwdpp::io::serialize_mutation<fwdpp::compact_popgenmut>()(o2, cm);
+    BOOST_REQUIRE(o1.str() == o2.str());
+    std::istringstream i(o1.str());
+    auto cm2 = fwdpp::io::deserialize_mutation<fwdpp::compact_popgenmut>()(i);
+    BOOST_CHECK(cm2 == cm);
+    BOOST_CHECK(!cm2.neutral);
+}
+
+BOOST_AUTO_TEST_CASE(test_thin_key_container)
+{
+    fwdpp::thin_key_container keys;
+    BOOST_CHECK(keys.empty());
+    BOOST_CHECK(keys.begin() == keys.end());
+    keys.push_back(1);
+    keys.push_back(5);
+    const std::vector<fwdpp::uint_t> more = { 2, 3, 4 };
+    keys.insert(keys.begin() + 1, more.begin(), more.end());
+    const std::vector<fwdpp::uint_t> expected = { 1, 2, 3, 4, 5 };
+    BOOST_REQUIRE_EQUAL(keys.size(), expected.size());
+    BOOST_CHECK(std::equal(keys.begin(), keys.end(), expected.begin()));
+
+    auto copy(keys);
+    BOOST_CHECK(copy == keys);
+    copy.erase(
+        std::remove_if(copy.begin(), copy.end(),
+                       [](const fwdpp::uint_t k) { return k % 2 == 0; }),
+        copy.end());
+    BOOST_CHECK(copy == fwdpp::thin_key_container({ 1, 3, 5 }));
+    BOOST_CHECK(copy != keys);
+
+    auto moved(std::move(copy));
+    BOOST_CHECK(copy.empty());
+    BOOST_CHECK_EQUAL(moved.size(), 3);
+    moved.swap(keys);
+    BOOST_CHECK_EQUAL(keys.size(), 3);
+    BOOST_CHECK_EQUAL(moved.size(), 5);
+    const auto capacity = moved.capacity();
+    moved.clear();
+    BOOST_CHECK(moved.empty());
+    BOOST_CHECK_EQUAL(moved.capacity(), capacity);
+    keys = moved;
+    BOOST_CHECK(keys.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,194 @@
+/*!
+  \file compressed_key_containerTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::compressed_key_container and
+  fwdpp::compressed_gamete
+*/
+#include <config.h>
+#include <limits>
+#include <sstream>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/compressed_key_container.hpp>
+#include <fwdpp/io/gamete.hpp>
+#include "../fixtures/fwdpp_fixtures.hpp"
+
+using keys_t = fwdpp::compressed_key_container;
+using compressed_gamete_t = fwdpp::compressed_gamete<>;
+
+struct compressed_gamete_fixture : public standard_empty_single_deme_fixture
+{
+    std::vector<compressed_gamete_t> compressed_gametes;
+    compressed_gamete_t::mutation_container compressed_neutral,
+        compressed_selected;
+    fwdpp::fwdpp_internal::recycling_bin_t<std::size_t> gamete_recycling_bin;
+    compressed_gamete_fixture()
+        : compressed_gametes{}, compressed_neutral{}, compressed_selected{},
+          gamete_recycling_bin{}
+    {
+        // Mutation i is at position i/100, and every third one is
+        // selected.
+        for (unsigned i = 0; i < 100; ++i)
+            {
+                mutations.emplace_back(mtype(double(i) / 100.,
+                                             (i % 3 == 0) ? -0.1 : 0., 1));
+            }
+        gametes.emplace_back(1);
+        gametes.emplace_back(1);
+        for (unsigned i = 0; i < 100; ++i)
+            {
+                auto &g = gametes[(i % 2 == 0 || i % 5 == 0) ? 0 : 1];
+                if (mutations[i].neutral)
+                    {
+                        g.mutations.push_back(i);
+                    }
+                else
+                    {
+                        g.smutations.push_back(i);
+                    }
+            }
+        for (const auto &g : gametes)
+            {
+                compressed_gametes.emplace_back(g.n);
+                compressed_gametes.back().mutations.insert(
+                    compressed_gametes.back().mutations.end(),
+                    g.mutations.begin(), g.mutations.end());
+                compressed_gametes.back().smutations.insert(
+                    compressed_gametes.back().smutations.end(),
+                    g.smutations.begin(), g.smutations.end());
+            }
+    }
+
+    bool
+    same_keys(const fwdpp::gamete &g, const compressed_gamete_t &cg)
+    {
+        return g.mutations.size() == cg.mutations.size()
+               && g.smutations.size() == cg.smutations.size()
+               && std::equal(g.mutations.begin(), g.mutations.end(),
+                             cg.mutations.begin())
+               && std::equal(g.smutations.begin(), g.smutations.end(),
+                             cg.smutations.begin());
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(compressed_key_containerTest,
+                         compressed_gamete_fixture)
+
+BOOST_AUTO_TEST_CASE(test_encoding)
+{
+    // Differences of all signs and sizes
+    const fwdpp::uint_t maxkey = std::numeric_limits<fwdpp::uint_t>::max();
+    const std::vector<fwdpp::uint_t> keys
+        = { 0, 1, 5, 3, 127, 128, 16383, 16384, maxkey, 0, 2, maxkey - 1 };
+    keys_t c;
+    c.insert(c.end(), keys.begin(), keys.end());
+    BOOST_REQUIRE_EQUAL(c.size(), keys.size());
+    BOOST_REQUIRE(std::equal(keys.begin(), keys.end(), c.begin()));
+    BOOST_REQUIRE_EQUAL(std::distance(c.begin(), c.end()), keys.size());
+    auto c2(c);
+    BOOST_CHECK(c2 == c);
+    c2.push_back(7);
+    BOOST_CHECK(c2 != c);
+    // Moving leaves an empty container
+    auto c3(std::move(c2));
+    BOOST_CHECK(c2.empty());
+    BOOST_CHECK(c2.begin() == c2.end());
+    BOOST_CHECK_EQUAL(c3.size(), keys.size() + 1);
+    c3.remove_if([](const fwdpp::uint_t k) { return k < 10; });
+    std::vector<fwdpp::uint_t> expected;
+    std::copy_if(keys.begin(), keys.end(), std::back_inserter(expected),
+                 [](const fwdpp::uint_t k) { return k >= 10; });
+    BOOST_REQUIRE_EQUAL(c3.size(), expected.size());
+    BOOST_CHECK(std::equal(expected.begin(), expected.end(), c3.begin()));
+}
+
+BOOST_AUTO_TEST_CASE(test_encoded_size)
+{
+    // Keys in increasing order with small gaps, as after
+    // fwdpp::renumber_mutations, take one byte each instead of four
+    keys_t c;
+    for (fwdpp::uint_t k = 0; k < 10000; k += 3)
+        {
+            c.push_back(k);
+        }
+    BOOST_CHECK_EQUAL(c.encoded_size(), c.size());
+}
+
+BOOST_AUTO_TEST_CASE(test_mutate_recombine)
+{
+    mutations.emplace_back(mtype(0.255, 0., 1));
+    mutations.emplace_back(mtype(0.505, -0.1, 1));
+    const std::vector<std::vector<fwdpp::uint_t>> new_mutations
+        = { {}, { 100 }, { 100, 101 } };
+    const double maxpos = std::numeric_limits<double>::max();
+    const std::vector<std::vector<double>> breakpoints
+        = { {},
+            { 0.5, maxpos },
+            { 0.055, 0.255, 0.256, 0.9, maxpos },
+            { -1., 0.01, 0.42, 0.505, 0.77, 0.771, 2., maxpos } };
+    for (const auto &nm : new_mutations)
+        {
+            for (const auto &bp : breakpoints)
+                {
+                    if (nm.empty() && bp.empty())
+                        {
+                            continue;
+                        }
+                    for (std::size_t p = 0; p < 2; ++p)
+                        {
+                            auto idx = fwdpp::mutate_recombine(
+                                nm, bp, p, 1 - p, gametes, mutations,
+                                gamete_recycling_bin, neutral, selected);
+                            auto cidx = fwdpp::mutate_recombine(
+                                nm, bp, p, 1 - p, compressed_gametes,
+                                mutations, gamete_recycling_bin,
+                                compressed_neutral, compressed_selected);
+                            BOOST_REQUIRE_EQUAL(idx, cidx);
+                            BOOST_REQUIRE(same_keys(gametes[idx],
+                                                    compressed_gametes[cidx]));
+                        }
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_process_gametes_and_cleaner)
+{
+    std::vector<fwdpp::uint_t> counts, compressed_counts;
+    fwdpp::fwdpp_internal::process_gametes(gametes, mutations, counts);
+    fwdpp::fwdpp_internal::process_gametes(compressed_gametes, mutations,
+                                           compressed_counts);
+    BOOST_REQUIRE(counts == compressed_counts);
+    for (auto k : { 4u, 10u, 30u, 35u })
+        {
+            counts[k] = compressed_counts[k] = 2;
+        }
+    fwdpp::fwdpp_internal::gamete_cleaner(gametes, mutations, counts, 2,
+                                          std::true_type());
+    fwdpp::fwdpp_internal::gamete_cleaner(compressed_gametes, mutations,
+                                          compressed_counts, 2,
+                                          std::true_type());
+    for (std::size_t i = 0; i < gametes.size(); ++i)
+        {
+            BOOST_CHECK(same_keys(gametes[i], compressed_gametes[i]));
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_serialization)
+{
+    // The format does not depend on the key container
+    std::ostringstream o1, o2;
+    fwdpp::io::write_gametes(o1, gametes);
+    fwdpp::io::write_gametes(o2, compressed_gametes);
+    BOOST_REQUIRE(o1.str() == o2.str());
+    std::vector<compressed_gamete_t> g;
+    std::istringstream i(o1.str());
+    fwdpp::io::read_gametes(i, g);
+    BOOST_REQUIRE_EQUAL(g.size(), gametes.size());
+    for (std::size_t j = 0; j < g.size(); ++j)
+        {
+            BOOST_CHECK(same_keys(gametes[j], g[j]));
+        }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -108,6 +108,23 @@ BOOST_AUTO_TEST_CASE(discrete_rec_model_pass_as_fxn)
     f(drm);
 }
 
+BOOST_AUTO_TEST_CASE(discrete_rec_model_buffer)
+// Writing into a buffer gives the same breakpoints as returning them,
+// for the same seed
+{
+    extensions::discrete_rec_model drm(rng.get(), 5., { 0, 1 }, { 1, 2 },
+                                       { 1, 2 });
+    std::vector<double> buffer(10, -1.);
+    for (unsigned i = 0; i < 10; ++i)
+        {
+            gsl_rng_set(rng.get(), i);
+            auto x = drm();
+            gsl_rng_set(rng.get(), i);
+            drm(buffer);
+            BOOST_REQUIRE(x == buffer);
+        }
+}
+
 BOOST_AUTO_TEST_CASE(bound_drm_is_recmodel)
 {
     extensions::discrete_rec_model drm(rng.get(), 1e-3, { 0, 1 }, { 1, 2 },
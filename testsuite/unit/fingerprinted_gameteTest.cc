@@ -0,0 +1,190 @@
+/*!
+  \file fingerprinted_gameteTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::fingerprinted_gamete
+*/
+#include <config.h>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/fingerprinted_gamete.hpp>
+#include <fwdpp/sugar/GSLrng_t.hpp>
+
+namespace
+{
+    using gamete_t = fwdpp::fingerprinted_gamete<>;
+    const double maxpos = std::numeric_limits<double>::max();
+}
+
+struct fingerprinted_gamete_fixture
+{
+    std::vector<fwdpp::mutation> mutations;
+    std::vector<gamete_t> gametes;
+    gamete_t::mutation_container neutral, selected;
+    fwdpp::fwdpp_internal::recycling_bin_t<std::size_t> gamete_recycling_bin;
+    fingerprinted_gamete_fixture()
+        : mutations{}, gametes{}, neutral{}, selected{},
+          gamete_recycling_bin{}
+    {
+        // Positions 0.01, 0.02, ..., 0.99.  Every third mutation is
+        // selected.
+        for (unsigned i = 1; i < 100; ++i)
+            {
+                mutations.emplace_back(double(i) / 100.,
+                                       (i % 3 == 0) ? 0.1 : 0., 1.);
+            }
+    }
+
+    void
+    add_key(gamete_t &g, const fwdpp::uint_t k)
+    {
+        if (mutations[k].neutral)
+            {
+                g.mutations.push_back(k);
+            }
+        else
+            {
+                g.smutations.push_back(k);
+            }
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(fingerprinted_gameteTest,
+                         fingerprinted_gamete_fixture)
+
+BOOST_AUTO_TEST_CASE(test_construction)
+{
+    BOOST_CHECK(fwdpp::traits::is_gamete<gamete_t>::value);
+    gamete_t g(1);
+    BOOST_CHECK_EQUAL(g.fingerprint, 0);
+    gamete_t::mutation_container n{ 0, 1 }, s{ 2 };
+    gamete_t g2(1, n, s);
+    BOOST_CHECK_EQUAL(g2.fingerprint, g2.calculate_fingerprint());
+    BOOST_CHECK(g2.fingerprint != 0);
+    // The fingerprint does not depend on which container holds a key
+    gamete_t::mutation_container n3{ 0 }, s3{ 1, 2 };
+    gamete_t g3(1, n3, s3);
+    BOOST_CHECK_EQUAL(g3.fingerprint, g2.fingerprint);
+    BOOST_CHECK(!(g3 == g2));
+}
+
+BOOST_AUTO_TEST_CASE(test_equality)
+{
+    gamete_t::mutation_container n{ 0, 1 }, s{ 2 };
+    gamete_t g1(1, n, s), g2(3, n, s);
+    BOOST_CHECK(g1 == g2);
+    // A stale fingerprint makes gametes compare unequal
+    g2.fingerprint ^= 1;
+    BOOST_CHECK(!(g1 == g2));
+    g2.update_fingerprint();
+    BOOST_CHECK(g1 == g2);
+}
+
+BOOST_AUTO_TEST_CASE(test_mutate_recombine)
+// Fingerprints of new gametes are always those of their keys
+{
+    fwdpp::GSLrng_t<fwdpp::GSL_RNG_MT19937> r(42);
+    gametes.emplace_back(1);
+    gametes.emplace_back(1);
+    for (unsigned rep = 0; rep < 1000; ++rep)
+        {
+            gametes.erase(gametes.begin() + 2, gametes.end());
+            for (auto &g : gametes)
+                {
+                    g.mutations.clear();
+                    g.smutations.clear();
+                }
+            std::vector<fwdpp::uint_t> new_mutations;
+            // Mostly shared keys in even replicates, mostly private
+            // keys in odd replicates
+            const double pshared = (rep % 2 == 0) ? 0.5 : 0.05;
+            for (fwdpp::uint_t k = 0; k < mutations.size(); ++k)
+                {
+                    const double u = gsl_rng_uniform(r.get());
+                    if (u < pshared)
+                        {
+                            add_key(gametes[0], k);
+                            add_key(gametes[1], k);
+                        }
+                    else if (u < pshared + 0.1)
+                        {
+                            add_key(gametes[rep % 3 == 0], k);
+                        }
+                    else if (u < pshared + 0.12)
+                        {
+                            new_mutations.push_back(k);
+                        }
+                }
+            for (auto &g : gametes)
+                {
+                    g.update_fingerprint();
+                }
+            std::vector<double> breakpoints;
+            const unsigned nbreaks = gsl_rng_uniform_int(r.get(), 4);
+            for (unsigned i = 0; i < nbreaks; ++i)
+                {
+                    breakpoints.push_back(gsl_rng_uniform(r.get()));
+                }
+            std::sort(breakpoints.begin(), breakpoints.end());
+            if (!breakpoints.empty())
+                {
+                    breakpoints.push_back(maxpos);
+                }
+            const auto g = fwdpp::mutate_recombine(
+                new_mutations, breakpoints, 0, 1, gametes, mutations,
+                gamete_recycling_bin, neutral, selected);
+            BOOST_REQUIRE_EQUAL(gametes[g].fingerprint,
+                                gametes[g].calculate_fingerprint());
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_gamete_cleaner)
+{
+    gametes.emplace_back(1);
+    gametes.emplace_back(1);
+    gametes[0].mutations = { 0, 1, 3 };
+    gametes[0].smutations = { 2 };
+    gametes[1].mutations = { 0, 3 };
+    gametes[1].smutations = { 2, 5 };
+    for (auto &g : gametes)
+        {
+            g.update_fingerprint();
+        }
+    std::vector<fwdpp::uint_t> mcounts(mutations.size(), 0);
+    mcounts[0] = mcounts[2] = 2;
+    mcounts[1] = mcounts[3] = mcounts[5] = 1;
+    fwdpp::fwdpp_internal::gamete_cleaner(gametes, mutations, mcounts, 2,
+                                          std::true_type());
+    BOOST_CHECK(gametes[0].mutations
+                == gamete_t::mutation_container({ 1, 3 }));
+    for (const auto &g : gametes)
+        {
+            BOOST_CHECK(g.smutations.size() < 2);
+            BOOST_CHECK_EQUAL(g.fingerprint, g.calculate_fingerprint());
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_population_checksum)
+{
+    gamete_t::mutation_container n{ 0, 1 }, s{ 2 }, s2{ 5 }, empty;
+    gametes.emplace_back(2, n, s);
+    gametes.emplace_back(0, s, empty);
+    gametes.emplace_back(1, n, s2);
+    const auto c = fwdpp::population_checksum(gametes);
+    // Extinct gametes and the order of gametes do not matter
+    gametes[1].mutations = n;
+    gametes[1].update_fingerprint();
+    std::reverse(gametes.begin(), gametes.end());
+    BOOST_CHECK_EQUAL(fwdpp::population_checksum(gametes), c);
+    // fwdpp::gamete has the same checksum
+    std::vector<fwdpp::gamete> plain;
+    for (const auto &g : gametes)
+        {
+            plain.emplace_back(g.n, g.mutations, g.smutations);
+        }
+    BOOST_CHECK_EQUAL(fwdpp::population_checksum(plain), c);
+    gametes[0].n++;
+    BOOST_CHECK(fwdpp::population_checksum(gametes) != c);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
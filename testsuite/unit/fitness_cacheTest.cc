@@ -0,0 +1,126 @@
+/*!
+  \file fitness_cacheTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::fitness_cache
+*/
+#include <config.h>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/fitness_cache.hpp>
+#include "../fixtures/fwdpp_fixtures.hpp"
+
+namespace
+{
+    struct counting_fitness
+    // Multiplicative fitness, counting the number of calls
+    {
+        unsigned *ncalls;
+        template <typename diploid_t>
+        double
+        operator()(const diploid_t &dip, const gcont_t &gametes,
+                   const mcont_t &mutations) const
+        {
+            ++(*ncalls);
+            return fwdpp::multiplicative_diploid()(
+                gametes[dip.first], gametes[dip.second], mutations);
+        }
+    };
+}
+
+struct fitness_cache_fixture : public standard_empty_single_deme_fixture
+{
+    fwdpp::fitness_cache cache;
+    unsigned ncalls;
+    std::vector<double> fitnesses;
+    fitness_cache_fixture() : cache{}, ncalls(0), fitnesses{}
+    {
+        // Gamete 0 has no mutations, 1 and 2 carry a selected
+        // mutation each.
+        mutations.emplace_back(mtype(0.1, -0.1, 1));
+        mutations.emplace_back(mtype(0.2, -0.2, 1));
+        gametes.emplace_back(2);
+        gametes.emplace_back(4);
+        gametes[1].smutations.push_back(0);
+        gametes.emplace_back(4);
+        gametes[2].smutations.push_back(1);
+        diploids = { { 0, 0 }, { 1, 2 }, { 2, 1 }, { 1, 1 }, { 2, 2 } };
+        fitnesses.resize(diploids.size());
+    }
+
+    double
+    fill()
+    {
+        return cache.fill(diploids, gametes, mutations,
+                          counting_fitness{ &ncalls }, fitnesses.data(), 1);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(fitness_cacheTest, fitness_cache_fixture)
+
+BOOST_AUTO_TEST_CASE(test_fill)
+{
+    std::vector<double> expected(diploids.size());
+    double sum = 0.;
+    for (std::size_t i = 0; i < diploids.size(); ++i)
+        {
+            expected[i] = fwdpp::multiplicative_diploid()(
+                gametes[diploids[i].first], gametes[diploids[i].second],
+                mutations);
+            sum += expected[i];
+        }
+    BOOST_CHECK_EQUAL(fill(), sum);
+    BOOST_CHECK(fitnesses == expected);
+    // (1,2) and (2,1) are the same pair
+    BOOST_CHECK_EQUAL(ncalls, 4);
+    BOOST_CHECK_EQUAL(cache.hits(), 1);
+    BOOST_CHECK_EQUAL(cache.misses(), 4);
+    // Nothing to recalculate in the next generation
+    BOOST_CHECK_EQUAL(fill(), sum);
+    BOOST_CHECK(fitnesses == expected);
+    BOOST_CHECK_EQUAL(ncalls, 5); // The diploid with no selected mutations
+    BOOST_CHECK_EQUAL(cache.hits(), 5);
+    BOOST_CHECK_CLOSE(cache.hit_rate(), 0.5, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(test_skip_neutral)
+{
+    diploids.assign(10, std::make_pair(0, 0));
+    fitnesses.resize(diploids.size());
+    BOOST_CHECK_EQUAL(fill(), 10.);
+    BOOST_CHECK_EQUAL(ncalls, 1);
+    BOOST_CHECK_EQUAL(cache.skipped(), 9);
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_invalidate_recycled)
+{
+    fill();
+    BOOST_REQUIRE_EQUAL(ncalls, 4);
+    // Gamete 2 goes extinct and is recycled into a gamete
+    // with a different selected mutation.
+    diploids = { { 0, 0 }, { 1, 1 } };
+    gametes[2].n = 0;
+    cache.invalidate_extinct(gametes);
+    mutations.emplace_back(mtype(0.3, -0.5, 1));
+    gametes[2].smutations[0] = 2;
+    diploids.push_back(std::make_pair(1, 2));
+    fitnesses.resize(diploids.size());
+    fill();
+    BOOST_CHECK_EQUAL(ncalls, 6);
+    BOOST_CHECK_EQUAL(fitnesses[2], fwdpp::multiplicative_diploid()(
+                                        gametes[1], gametes[2], mutations));
+}
+
+BOOST_AUTO_TEST_CASE(test_invalidate_fixation_removal)
+{
+    fill();
+    BOOST_REQUIRE_EQUAL(ncalls, 4);
+    // Removing a selected mutation from a gamete
+    // means that its entries are invalid
+    gametes[1].smutations.clear();
+    fill();
+    // (1,2) is recalculated, and (1,1) now carries no selected mutations
+    BOOST_CHECK_EQUAL(ncalls, 6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
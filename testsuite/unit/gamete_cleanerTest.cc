@@ -73,4 +73,71 @@ BOOST_AUTO_TEST_CASE(test_remove_neutral)
     BOOST_REQUIRE_EQUAL(gametes[0].smutations.size(), 1);
 }
 
+BOOST_AUTO_TEST_CASE(test_threaded)
+// Threaded counting and cleaning give the same results as one thread
+{
+    // Mutations 0 and 1 are fixed, and mutation 3 is selected.
+    for (unsigned i = 0; i < 5; ++i)
+        {
+            mutations.emplace_back(mtype(i, (i == 3) ? -0.1 : 0., 1));
+        }
+    for (unsigned i = 0; i < 101; ++i)
+        {
+            gametes.emplace_back(i % 3);
+            gametes[i].mutations = { 0, 1 };
+            if (i % 2)
+                {
+                    gametes[i].mutations.push_back(2);
+                }
+            if (i % 5 == 0)
+                {
+                    gametes[i].smutations.push_back(3);
+                }
+            if (i % 4 == 0)
+                {
+                    gametes[i].mutations.push_back(4);
+                }
+        }
+    std::vector<fwdpp::uint_t> threaded_counts(2, 7);
+    std::vector<std::vector<fwdpp::uint_t>> partial_counts;
+    fwdpp::fwdpp_internal::process_gametes(gametes, mutations, mcounts);
+    const auto twoN = mcounts[0];
+    for (unsigned nthreads : { 2, 4, 200 })
+        {
+            fwdpp::fwdpp_internal::process_gametes(
+                gametes, mutations, threaded_counts, nthreads, partial_counts);
+            BOOST_REQUIRE(threaded_counts == mcounts);
+        }
+    BOOST_REQUIRE_EQUAL(mcounts[1], twoN);
+    auto serial = gametes;
+    fwdpp::fwdpp_internal::gamete_cleaner(serial, mutations, mcounts, twoN,
+                                          std::true_type());
+    fwdpp::fwdpp_internal::gamete_cleaner(gametes, mutations, mcounts, twoN,
+                                          std::true_type(), 4);
+    for (std::size_t i = 0; i < gametes.size(); ++i)
+        {
+            BOOST_REQUIRE(gametes[i].mutations == serial[i].mutations);
+            BOOST_REQUIRE(gametes[i].smutations == serial[i].smutations);
+            // Extinct gametes are not cleaned
+            const auto &keys = gametes[i].mutations;
+            BOOST_REQUIRE_EQUAL(gametes[i].n == 0,
+                                std::find(keys.begin(), keys.end(), 0)
+                                    != keys.end());
+        }
+    // Multi-locus version
+    serial = gametes;
+    mcounts[4] = twoN;
+    fwdpp::fwdpp_internal::gamete_cleaner(serial, mutations, mcounts, twoN,
+                                          fwdpp::remove_neutral(),
+                                          std::true_type());
+    fwdpp::fwdpp_internal::gamete_cleaner(gametes, mutations, mcounts, twoN,
+                                          fwdpp::remove_neutral(),
+                                          std::true_type(), 3);
+    for (std::size_t i = 0; i < gametes.size(); ++i)
+        {
+            BOOST_REQUIRE(gametes[i].mutations == serial[i].mutations);
+            BOOST_REQUIRE(gametes[i].smutations == serial[i].smutations);
+        }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,110 @@
+/*!
+  \file gamete_hash_indexTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::gamete_hash_index and
+  fwdpp::merge_duplicate_gametes
+*/
+#include <config.h>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/gamete_hash_index.hpp>
+#include "../fixtures/fwdpp_fixtures.hpp"
+
+struct gamete_hash_index_fixture : public standard_empty_single_deme_fixture
+{
+    fwdpp::gamete_hash_index index;
+    fwdpp::fwdpp_internal::recycling_bin_t<std::size_t> gamete_recycling_bin;
+    gamete_hash_index_fixture() : index{}, gamete_recycling_bin{}
+    {
+        for (double pos : { 0.1, 0.2, 0.3 })
+            {
+                mutations.emplace_back(mtype(pos, 0., 1));
+            }
+        // Gametes 1 and 3 are identical, and gamete 2 is extinct
+        gametes.emplace_back(1);
+        gametes[0].mutations = { 0 };
+        gametes.emplace_back(2);
+        gametes[1].mutations = { 0, 1 };
+        gametes.emplace_back(0);
+        gametes[2].mutations = { 2 };
+        gametes.emplace_back(1);
+        gametes[3].mutations = { 0, 1 };
+        diploids = { { 0, 1 }, { 1, 3 } };
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(gamete_hash_indexTest, gamete_hash_index_fixture)
+
+BOOST_AUTO_TEST_CASE(test_find)
+{
+    index.rebuild(gametes);
+    BOOST_CHECK_EQUAL(index.size(), 3);
+    fwdpp::gamete::mutation_container n{ 0, 1 }, s;
+    auto f = index.find(gametes, fwdpp::gamete_hash_index::hash(n, s), n, s);
+    BOOST_REQUIRE(f.first);
+    BOOST_CHECK(f.second == 1 || f.second == 3);
+    // Extinct gametes are not indexed
+    n = { 2 };
+    f = index.find(gametes, fwdpp::gamete_hash_index::hash(n, s), n, s);
+    BOOST_CHECK(!f.first);
+    // Neutral and selected keys are distinguished
+    f = index.find(gametes, fwdpp::gamete_hash_index::hash(s, n), s, n);
+    BOOST_CHECK(!f.first);
+}
+
+BOOST_AUTO_TEST_CASE(test_mutate_recombine)
+{
+    index.rebuild(gametes);
+    gamete_recycling_bin.push(2);
+    fwdpp::fwdpp_internal::hash_consing_recycling_bin<
+        fwdpp::fwdpp_internal::recycling_bin_t<std::size_t>>
+        bin(gamete_recycling_bin, &index);
+    // Adding mutation 1 to gamete 0 gives a copy of gamete 1 or 3
+    auto g = fwdpp::mutate_recombine(std::vector<fwdpp::uint_t>{ 1 }, {}, 0,
+                                     0, gametes, mutations, bin, neutral,
+                                     selected);
+    BOOST_CHECK(g == 1 || g == 3);
+    BOOST_CHECK_EQUAL(index.merged(), 1);
+    BOOST_CHECK_EQUAL(gamete_recycling_bin.size(), 1);
+    // A new haplotype is stored, and found the next time
+    for (unsigned i = 0; i < 2; ++i)
+        {
+            g = fwdpp::mutate_recombine(std::vector<fwdpp::uint_t>{ 2 }, {},
+                                        0, 0, gametes, mutations, bin, neutral,
+                                        selected);
+            BOOST_CHECK_EQUAL(g, 2);
+            BOOST_CHECK(gametes[2].mutations
+                        == fwdpp::gamete::mutation_container({ 0, 2 }));
+        }
+    BOOST_CHECK_EQUAL(index.merged(), 2);
+    BOOST_CHECK(gamete_recycling_bin.empty());
+    // Without an index, the recycling bin is used as normal
+    fwdpp::fwdpp_internal::hash_consing_recycling_bin<
+        fwdpp::fwdpp_internal::recycling_bin_t<std::size_t>>
+        plain(gamete_recycling_bin, nullptr);
+    g = fwdpp::mutate_recombine(std::vector<fwdpp::uint_t>{ 2 }, {}, 0, 0,
+                                gametes, mutations, plain, neutral, selected);
+    BOOST_CHECK_EQUAL(g, 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_merge_duplicate_gametes)
+{
+    BOOST_CHECK_EQUAL(fwdpp::merge_duplicate_gametes(gametes, diploids), 1);
+    BOOST_CHECK_EQUAL(gametes[1].n, 3);
+    BOOST_CHECK_EQUAL(gametes[3].n, 0);
+    BOOST_CHECK(diploids == dipvector_t({ { 0, 1 }, { 1, 1 } }));
+    BOOST_CHECK_EQUAL(fwdpp::merge_duplicate_gametes(gametes, diploids), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_merge_duplicate_gametes_nested)
+// Metapopulation and multi-locus diploids
+{
+    std::vector<dipvector_t> demes{ { { 0, 3 } }, { { 3, 1 } } };
+    BOOST_CHECK_EQUAL(fwdpp::merge_duplicate_gametes(gametes, demes, index),
+                      1);
+    BOOST_CHECK(demes[0] == dipvector_t({ { 0, 1 } }));
+    BOOST_CHECK(demes[1] == dipvector_t({ { 1, 1 } }));
+    BOOST_CHECK_EQUAL(index.size(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
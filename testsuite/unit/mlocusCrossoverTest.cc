@@ -14,6 +14,7 @@
 #include <fwdpp/diploid.hh>
 #include <boost/test/unit_test.hpp>
 #include <unistd.h>
+#include <algorithm>
 #include <iterator>
 #include <functional>
 #include <vector>
@@ -138,9 +139,11 @@ BOOST_AUTO_TEST_CASE(three_locus_test_1)
     };
 
     auto fake_mut_pol
-        = [](std::queue<std::size_t> &, decltype(mutations) &) { return 0; };
-    std::vector<std::function<std::size_t(std::queue<std::size_t> &,
-                                          decltype(mutations) &)>>
+        = [](fwdpp::traits::recycling_bin_t<decltype(mutations)> &,
+             decltype(mutations) &) { return 0; };
+    std::vector<std::function<std::size_t(
+        fwdpp::traits::recycling_bin_t<decltype(mutations)> &,
+        decltype(mutations) &)>>
         mutation_models(3, fake_mut_pol);
 
     double mu[3] = { 0.0, 0.0, 0.0 };
@@ -157,6 +160,121 @@ BOOST_AUTO_TEST_CASE(three_locus_test_1)
                       1.25);
 }
 
+BOOST_AUTO_TEST_CASE(three_locus_test_1_interlocus_map)
+// Same as three_locus_test_1, with a fwdpp::interlocus_map
+{
+    diploid_t diploid; // parent 1
+    setup3locus2(gametes, mutations, diploid);
+    std::vector<unsigned> mcounts(mutations.size(), 1);
+    diploid_t diploid2(diploid); // parent 2
+
+    // positions of x-overs within loci
+    auto MVAL = std::numeric_limits<double>::max();
+    std::vector<std::vector<double>> rec1{ std::vector<double>{ 0.3, MVAL },
+                                           std::vector<double>{ 0.55, 0.8,
+                                                                MVAL },
+                                           std::vector<double>{ 1.3, MVAL } };
+
+    // We use these to "fake" what we want to happen between loci.
+    std::vector<double> r_bw_loci = { 1., 0. };
+    std::vector<diploid_t> diploids({ diploid });
+
+    // auto gamete_lookup =
+    // fwdpp::fwdpp_internal::gamete_lookup_table(gametes,mutations);
+    auto mutation_recycling_bin
+        = fwdpp::fwdpp_internal::make_mut_queue(mcounts);
+    auto gamete_recycling_bin
+        = fwdpp::fwdpp_internal::make_gamete_queue(gametes);
+    gcont_t::value_type::mutation_container neutral,
+        selected; // req'd as of 0.3.3
+
+    std::vector<std::function<std::vector<double>(const gcont_t::value_type &,
+                                                  const gcont_t::value_type &,
+                                                  const mcont_t &)>>
+        recpols{
+            [&rec1](const gcont_t::value_type &, const gcont_t::value_type &,
+                    const mcont_t &) { return rec1[0]; },
+            [&rec1](const gcont_t::value_type &, const gcont_t::value_type &,
+                    const mcont_t &) { return rec1[1]; },
+            [&rec1](const gcont_t::value_type &, const gcont_t::value_type &,
+                    const mcont_t &) { return rec1[2]; }
+        };
+
+    auto interlocus_rec = fwdpp::make_binomial_interlocus_map(
+        r_bw_loci.data(), r_bw_loci.size());
+
+    auto fake_mut_pol
+        = [](fwdpp::traits::recycling_bin_t<decltype(mutations)> &,
+             decltype(mutations) &) { return 0; };
+    std::vector<std::function<std::size_t(
+        fwdpp::traits::recycling_bin_t<decltype(mutations)> &,
+        decltype(mutations) &)>>
+        mutation_models(3, fake_mut_pol);
+
+    double mu[3] = { 0.0, 0.0, 0.0 };
+
+    auto offspring = fwdpp::fwdpp_internal::multilocus_rec_mut(
+        r, diploid, diploid2, mutation_recycling_bin, gamete_recycling_bin,
+        recpols, interlocus_rec, 0, 0, gametes, mutations, neutral, selected,
+        &mu[0], mutation_models);
+
+    BOOST_CHECK_EQUAL(gametes[offspring[0].first].mutations.size(), 0);
+    BOOST_CHECK_EQUAL(gametes[offspring[1].first].mutations.size(), 0);
+    BOOST_CHECK_EQUAL(gametes[offspring[2].first].mutations.size(), 1);
+    BOOST_CHECK_EQUAL(mutations[gametes[offspring[2].first].mutations[0]].pos,
+                      1.25);
+}
+
+BOOST_AUTO_TEST_CASE(interlocus_map_poisson)
+{
+    std::vector<double> means{ 0.5, 0., 2. };
+    auto m = fwdpp::make_poisson_interlocus_map(means.data(), means.size());
+    BOOST_REQUIRE_EQUAL(m.nboundaries(), 3);
+    std::vector<std::size_t> boundaries;
+    std::vector<unsigned> counts(3, 0);
+    const unsigned nreps = 20000;
+    for (unsigned i = 0; i < nreps; ++i)
+        {
+            m(r, boundaries);
+            BOOST_REQUIRE(
+                std::is_sorted(boundaries.begin(), boundaries.end()));
+            for (auto b : boundaries)
+                {
+                    BOOST_REQUIRE(b < 3);
+                    ++counts[b];
+                }
+        }
+    BOOST_CHECK_CLOSE(double(counts[0]) / nreps, 0.5, 5.);
+    BOOST_CHECK_EQUAL(counts[1], 0);
+    BOOST_CHECK_CLOSE(double(counts[2]) / nreps, 2., 5.);
+}
+
+BOOST_AUTO_TEST_CASE(interlocus_map_binomial)
+{
+    std::vector<double> distances{ 0.5, 0., 1., 0.1 };
+    auto m = fwdpp::make_binomial_interlocus_map(distances.data(),
+                                                 distances.size());
+    std::vector<std::size_t> boundaries;
+    std::vector<unsigned> counts(4, 0);
+    const unsigned nreps = 20000;
+    for (unsigned i = 0; i < nreps; ++i)
+        {
+            m(r, boundaries);
+            // At most one crossover per boundary
+            BOOST_REQUIRE(std::adjacent_find(boundaries.begin(),
+                                             boundaries.end())
+                          == boundaries.end());
+            for (auto b : boundaries)
+                {
+                    ++counts[b];
+                }
+        }
+    BOOST_CHECK_CLOSE(double(counts[0]) / nreps, 0.5, 5.);
+    BOOST_CHECK_EQUAL(counts[1], 0);
+    BOOST_CHECK_EQUAL(counts[2], nreps);
+    BOOST_CHECK_CLOSE(double(counts[3]) / nreps, 0.1, 10.);
+}
+
 BOOST_AUTO_TEST_CASE(three_locus_test_2)
 {
     diploid_t diploid; // parent 1
@@ -202,9 +320,11 @@ BOOST_AUTO_TEST_CASE(three_locus_test_2)
     };
 
     auto fake_mut_pol
-        = [](std::queue<std::size_t> &, decltype(mutations) &) { return 0; };
-    std::vector<std::function<std::size_t(std::queue<std::size_t> &,
-                                          decltype(mutations) &)>>
+        = [](fwdpp::traits::recycling_bin_t<decltype(mutations)> &,
+             decltype(mutations) &) { return 0; };
+    std::vector<std::function<std::size_t(
+        fwdpp::traits::recycling_bin_t<decltype(mutations)> &,
+        decltype(mutations) &)>>
         mutation_models{ fake_mut_pol, fake_mut_pol };
 
     double mu[3] = { 0.0, 0.0, 0.0 };
@@ -269,9 +389,11 @@ BOOST_AUTO_TEST_CASE(three_locus_test_3)
         [&r_bw_loci]() { return static_cast<unsigned>(r_bw_loci[1]); }
     };
     auto fake_mut_pol
-        = [](std::queue<std::size_t> &, decltype(mutations) &) { return 0; };
-    std::vector<std::function<std::size_t(std::queue<std::size_t> &,
-                                          decltype(mutations) &)>>
+        = [](fwdpp::traits::recycling_bin_t<decltype(mutations)> &,
+             decltype(mutations) &) { return 0; };
+    std::vector<std::function<std::size_t(
+        fwdpp::traits::recycling_bin_t<decltype(mutations)> &,
+        decltype(mutations) &)>>
         mutation_models{ fake_mut_pol, fake_mut_pol };
 
     double mu[3] = { 0.0, 0.0, 0.0 };
@@ -335,9 +457,11 @@ BOOST_AUTO_TEST_CASE(three_locus_test_4)
         [&r_bw_loci]() { return static_cast<unsigned>(r_bw_loci[1]); }
     };
     auto fake_mut_pol
-        = [](std::queue<std::size_t> &, decltype(mutations) &) { return 0; };
-    std::vector<std::function<std::size_t(std::queue<std::size_t> &,
-                                          decltype(mutations) &)>>
+        = [](fwdpp::traits::recycling_bin_t<decltype(mutations)> &,
+             decltype(mutations) &) { return 0; };
+    std::vector<std::function<std::size_t(
+        fwdpp::traits::recycling_bin_t<decltype(mutations)> &,
+        decltype(mutations) &)>>
         mutation_models(3, fake_mut_pol);
 
     double mu[3] = { 0.0, 0.0, 0.0 };
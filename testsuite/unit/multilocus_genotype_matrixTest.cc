@@ -0,0 +1,131 @@
+/*!
+  \file multilocus_genotype_matrixTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::multilocus_genotype_matrix
+*/
+#include <config.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/multilocus_genotype_matrix.hpp>
+
+namespace
+{
+    using genotype_t = std::pair<std::size_t, std::size_t>;
+    using matrix_t = fwdpp::multilocus_genotype_matrix<genotype_t>;
+}
+
+BOOST_AUTO_TEST_SUITE(multilocus_genotype_matrixTest)
+
+BOOST_AUTO_TEST_CASE(test_construct)
+{
+    matrix_t m(5, 3);
+    BOOST_CHECK_EQUAL(m.size(), 5);
+    BOOST_CHECK_EQUAL(m.nloci(), 3);
+    for (const auto &dip : m)
+        {
+            BOOST_REQUIRE_EQUAL(dip.size(), 3);
+            for (const auto &g : dip)
+                {
+                    BOOST_CHECK(g == genotype_t(0, 0));
+                }
+        }
+    matrix_t empty;
+    BOOST_CHECK(empty.empty());
+    BOOST_CHECK(empty.begin() == empty.end());
+}
+
+BOOST_AUTO_TEST_CASE(test_rows_are_views)
+{
+    matrix_t m(4, 2);
+    // Writing through a row changes the matrix
+    for (auto &&dip : m)
+        {
+            dip[1].second = 7;
+        }
+    auto row = m[2];
+    row[0] = genotype_t(3, 4);
+    BOOST_CHECK(m[2][0] == genotype_t(3, 4));
+    BOOST_CHECK_EQUAL(m.data()[2 * 2].first, 3);
+    for (std::size_t i = 0; i < m.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(m[i][1].second, 7);
+        }
+    const matrix_t &cm = m;
+    BOOST_CHECK(cm[2] == m[2]);
+    BOOST_CHECK(cm[2] != m[3]);
+    BOOST_CHECK_EQUAL(cm.end() - cm.begin(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_from_vectors)
+{
+    std::vector<std::vector<genotype_t>> v(
+        3, std::vector<genotype_t>(2, genotype_t(1, 2)));
+    v[1][1] = genotype_t(5, 6);
+    matrix_t m(v);
+    BOOST_REQUIRE_EQUAL(m.size(), 3);
+    BOOST_REQUIRE_EQUAL(m.nloci(), 2);
+    for (std::size_t i = 0; i < v.size(); ++i)
+        {
+            for (std::size_t j = 0; j < v[i].size(); ++j)
+                {
+                    BOOST_CHECK(m[i][j] == v[i][j]);
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_resize)
+{
+    matrix_t m(2, 3, genotype_t(1, 1));
+    m.resize(4);
+    BOOST_REQUIRE_EQUAL(m.size(), 4);
+    BOOST_CHECK_EQUAL(m.nloci(), 3);
+    // Existing rows are kept and new rows are (0,0)
+    BOOST_CHECK(m[1][2] == genotype_t(1, 1));
+    BOOST_CHECK(m[3][2] == genotype_t(0, 0));
+    m.clear();
+    BOOST_CHECK(m.empty());
+    BOOST_CHECK_EQUAL(m.nloci(), 3);
+    fwdpp::fwdpp_internal::resize_multilocus_diploids(m, 6, 2);
+    BOOST_CHECK_EQUAL(m.size(), 6);
+    BOOST_CHECK_EQUAL(m.nloci(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_random_access)
+{
+    matrix_t m(5, 2);
+    for (std::size_t i = 0; i < m.size(); ++i)
+        {
+            m[i][0].first = i;
+        }
+    auto b = m.begin(), e = m.end();
+    BOOST_CHECK(b < e);
+    BOOST_CHECK(e > b);
+    BOOST_CHECK(b <= b);
+    BOOST_CHECK(b >= b);
+    BOOST_CHECK(!(e <= b));
+    BOOST_CHECK(2 + b == b + 2);
+    BOOST_CHECK_EQUAL((2 + b)[1][0].first, 3);
+    BOOST_CHECK_EQUAL(std::distance(b, e), 5);
+    // Rows are sorted by the first locus, so a binary search works
+    auto i = std::lower_bound(
+        m.cbegin(), m.cend(), 3,
+        [](const matrix_t::const_reference &row, const std::size_t key) {
+            return row[0].first < key;
+        });
+    BOOST_CHECK_EQUAL(i - m.cbegin(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_swap_and_compare)
+{
+    matrix_t a(2, 2, genotype_t(1, 1)), b(3, 1);
+    const matrix_t a2(a), b2(b);
+    BOOST_CHECK(a == a2);
+    BOOST_CHECK(!(a == b));
+    a.swap(b);
+    BOOST_CHECK(a == b2);
+    BOOST_CHECK(b == a2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,112 @@
+/*!
+  \file mutation_count_trackerTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::mutation_count_tracker
+*/
+#include <config.h>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/mutation_count_tracker.hpp>
+#include "../fixtures/fwdpp_fixtures.hpp"
+
+struct mutation_count_tracker_fixture : public standard_empty_single_deme_fixture
+{
+    fwdpp::mutation_count_tracker tracker;
+    mutation_count_tracker_fixture() : tracker{}
+    {
+        // Mutation 0 is neutral, 1 and 2 are selected
+        mutations.emplace_back(mtype(0.1, 0., 1));
+        mutations.emplace_back(mtype(0.2, -0.1, 1));
+        mutations.emplace_back(mtype(0.3, -0.2, 1));
+        gametes.emplace_back(1);
+        gametes[0].mutations.push_back(0);
+        gametes.emplace_back(2);
+        gametes[1].mutations.push_back(0);
+        gametes[1].smutations.push_back(1);
+        gametes.emplace_back(1);
+        gametes[2].smutations.push_back(2);
+    }
+
+    void
+    check_counts()
+    {
+        tracker.update(gametes, mutations, mcounts);
+        std::vector<fwdpp::uint_t> expected;
+        fwdpp::fwdpp_internal::process_gametes(gametes, mutations, expected);
+        BOOST_REQUIRE(mcounts == expected);
+        BOOST_REQUIRE(tracker.mutation_counts() == expected);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(mutation_count_trackerTest,
+                         mutation_count_tracker_fixture)
+
+BOOST_AUTO_TEST_CASE(test_count_changes)
+{
+    check_counts();
+    BOOST_CHECK_EQUAL(tracker.rescans(), 1);
+    const auto nkeys = tracker.keys_updated();
+    BOOST_CHECK_EQUAL(nkeys, 4);
+    // Only gamete 1 changes
+    gametes[1].n = 3;
+    check_counts();
+    BOOST_CHECK_EQUAL(tracker.rescans(), 1);
+    BOOST_CHECK_EQUAL(tracker.gametes_updated(), 1);
+    BOOST_CHECK_EQUAL(tracker.keys_updated(), nkeys + 2);
+    // A new gamete
+    mutations.emplace_back(mtype(0.4, 0., 1));
+    gametes.emplace_back(2);
+    gametes[3].mutations.push_back(3);
+    gametes[3].smutations.push_back(2);
+    check_counts();
+    BOOST_CHECK_EQUAL(tracker.rescans(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_recycled_gamete)
+{
+    check_counts();
+    // Gamete 0 goes extinct and is recycled into
+    // a gamete with different mutations.
+    gametes[0].n = 0;
+    tracker.retire_extinct(gametes);
+    gametes[0].mutations.clear();
+    gametes[0].smutations.push_back(1);
+    gametes[0].n = 4;
+    check_counts();
+    // Gamete 0 goes extinct without being recycled
+    gametes[0].n = 0;
+    check_counts();
+}
+
+BOOST_AUTO_TEST_CASE(test_remove_fixations)
+{
+    for (auto &g : gametes)
+        {
+            g.smutations.push_back(2);
+        }
+    gametes[2].smutations.pop_back();
+    check_counts();
+    BOOST_REQUIRE_EQUAL(mcounts[2], 4);
+    // Remove the fixation, as gamete_cleaner does
+    fwdpp::fwdpp_internal::gamete_cleaner(gametes, mutations, mcounts, 4,
+                                          std::true_type());
+    tracker.remove_fixations(mutations, 4, std::true_type());
+    // The user's counts still record the fixation
+    BOOST_CHECK_EQUAL(mcounts[2], 4);
+    BOOST_CHECK_EQUAL(tracker.mutation_counts()[2], 0);
+    gametes[1].n = 1;
+    gametes[2].n = 2;
+    check_counts();
+}
+
+BOOST_AUTO_TEST_CASE(test_reset)
+{
+    check_counts();
+    // Modifying an extant gamete requires a reset
+    gametes[1].smutations.push_back(2);
+    tracker.reset();
+    check_counts();
+    BOOST_CHECK_EQUAL(tracker.rescans(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,105 @@
+/*!
+  \file parent_samplerTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::parent_sampler
+*/
+#include <config.h>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/parent_sampler.hpp>
+#include <fwdpp/sugar/GSLrng_t.hpp>
+
+namespace
+{
+    std::vector<double>
+    sample_frequencies(const fwdpp::parent_sampler &s, const gsl_rng *r,
+                       const std::size_t n, const unsigned ndraws)
+    {
+        std::vector<double> freqs(n, 0.);
+        for (unsigned i = 0; i < ndraws; ++i)
+            {
+                auto p = s(r);
+                BOOST_REQUIRE(p < n);
+                freqs[p] += 1. / double(ndraws);
+            }
+        return freqs;
+    }
+}
+
+struct parent_sampler_fixture
+{
+    fwdpp::GSLrng_t<fwdpp::GSL_RNG_MT19937> rng;
+    parent_sampler_fixture() : rng(101) {}
+};
+
+BOOST_FIXTURE_TEST_SUITE(parent_samplerTest, parent_sampler_fixture)
+
+BOOST_AUTO_TEST_CASE(test_engine_choice)
+{
+    fwdpp::parent_sampler s;
+    std::vector<double> w(100, 1.);
+    s.update(w.data(), w.size());
+    BOOST_CHECK(s.current_engine()
+                == fwdpp::parent_sampler::engine::uniform);
+    // max/mean is close to 1
+    w[0] = 1.1;
+    s.update(w.data(), w.size());
+    BOOST_CHECK(s.current_engine()
+                == fwdpp::parent_sampler::engine::stochastic_acceptance);
+    // max/mean is close to 10
+    w[0] = 10.;
+    s.update(w.data(), w.size());
+    BOOST_CHECK(s.current_engine() == fwdpp::parent_sampler::engine::alias);
+}
+
+BOOST_AUTO_TEST_CASE(test_sampling_frequencies)
+{
+    const std::vector<double> w = { 0., 1., 2., 0.5, 4., 0., 2.5 };
+    const double wsum = 10.;
+    for (auto e : { fwdpp::parent_sampler::engine::stochastic_acceptance,
+                    fwdpp::parent_sampler::engine::alias })
+        {
+            fwdpp::parent_sampler s(e);
+            s.update(w.data(), w.size());
+            BOOST_REQUIRE(s.current_engine() == e);
+            auto freqs = sample_frequencies(s, rng.get(), w.size(), 100000);
+            for (std::size_t i = 0; i < w.size(); ++i)
+                {
+                    if (w[i] == 0.)
+                        {
+                            BOOST_CHECK_EQUAL(freqs[i], 0.);
+                        }
+                    else
+                        {
+                            BOOST_CHECK_CLOSE(freqs[i], w[i] / wsum, 5.);
+                        }
+                }
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_alias_table_reuse)
+// The alias table must be rebuilt correctly when the number of
+// parents changes between generations.
+{
+    fwdpp::parent_sampler s(fwdpp::parent_sampler::engine::alias);
+    std::vector<double> w(1000, 1.);
+    w[999] = 1000.;
+    s.update(w.data(), w.size());
+    w = { 3., 1. };
+    s.update(w.data(), w.size());
+    auto freqs = sample_frequencies(s, rng.get(), w.size(), 100000);
+    BOOST_CHECK_CLOSE(freqs[0], 0.75, 2.);
+    BOOST_CHECK_CLOSE(freqs[1], 0.25, 2.);
+}
+
+BOOST_AUTO_TEST_CASE(test_all_zero)
+// No information in the weights means uniform sampling
+{
+    fwdpp::parent_sampler s(fwdpp::parent_sampler::engine::alias);
+    std::vector<double> w(10, 0.);
+    s.update(w.data(), w.size());
+    BOOST_CHECK(s.current_engine()
+                == fwdpp::parent_sampler::engine::uniform);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
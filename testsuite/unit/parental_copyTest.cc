@@ -0,0 +1,247 @@
+/*!
+  \file parental_copyTest.cc
+  \ingroup unit
+  \brief Testing the re-use of parental gametes by fwdpp::mutate_recombine
+  when recombination gives a copy of a parent
+*/
+#include <config.h>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/compressed_key_container.hpp>
+#include <fwdpp/chunked_key_container.hpp>
+#include <fwdpp/sugar/GSLrng_t.hpp>
+#include <fwdpp/internal/recombination_common.hpp>
+#include <fwdpp/internal/parental_copy.hpp>
+
+namespace
+{
+    const double maxpos = std::numeric_limits<double>::max();
+}
+
+struct parental_copy_fixture
+{
+    std::vector<fwdpp::mutation> mutations;
+    std::vector<fwdpp::gamete> gametes;
+    fwdpp::gamete::mutation_container neutral, selected;
+    fwdpp::fwdpp_internal::recycling_bin_t<std::size_t> gamete_recycling_bin;
+    parental_copy_fixture()
+        : mutations{}, gametes{}, neutral{}, selected{},
+          gamete_recycling_bin{}
+    {
+        // Neutral mutations at 0.1, 0.2, ..., 0.9.
+        for (unsigned i = 1; i < 10; ++i)
+            {
+                mutations.emplace_back(double(i) / 10., 0., 1.);
+            }
+        // The gametes differ at positions 0.4 and 0.6 only
+        gametes.emplace_back(1);
+        gametes.emplace_back(1);
+        gametes[0].mutations = { 0, 3, 4, 8 };
+        gametes[1].mutations = { 0, 4, 5, 8 };
+        fwdpp::reset_recombination_statistics();
+    }
+
+    std::size_t
+    recombine(const std::vector<double> &breakpoints)
+    {
+        return fwdpp::mutate_recombine(std::vector<fwdpp::uint_t>{},
+                                       breakpoints, 0, 1, gametes, mutations,
+                                       gamete_recycling_bin, neutral,
+                                       selected);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(parental_copyTest, parental_copy_fixture)
+
+BOOST_AUTO_TEST_CASE(test_copies)
+{
+    // Breakpoints outside of [0.4, 0.6) give copies
+    BOOST_CHECK_EQUAL(recombine({ 0.1, maxpos }), 1);
+    BOOST_CHECK_EQUAL(recombine({ 0.1, 0.3, maxpos }), 0);
+    BOOST_CHECK_EQUAL(recombine({ 0.7, 0.8, 0.85, maxpos }), 0);
+    BOOST_CHECK_EQUAL(recombine({ 0.6, maxpos }), 0);
+    BOOST_CHECK_EQUAL(recombine({ 0.35, 0.7, maxpos }), 1);
+    BOOST_CHECK_EQUAL(gametes.size(), 2);
+    BOOST_CHECK_EQUAL(fwdpp::recombination_statistics().parental_copies, 5);
+}
+
+BOOST_AUTO_TEST_CASE(test_not_copies)
+{
+    // Mutation 3, at 0.4, from gamete 0, and mutation 5, at 0.6, from
+    // gamete 1
+    BOOST_CHECK_EQUAL(recombine({ 0.4, maxpos }), 2);
+    BOOST_CHECK(gametes[2].mutations
+                == fwdpp::gamete::mutation_container({ 0, 3, 4, 5, 8 }));
+    BOOST_CHECK_EQUAL(recombine({ 0.5, 0.55, 0.58, maxpos }), 3);
+    BOOST_CHECK(gametes[3].mutations
+                == fwdpp::gamete::mutation_container({ 0, 3, 4, 5, 8 }));
+    BOOST_CHECK_EQUAL(fwdpp::recombination_statistics().parental_copies, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_new_mutations)
+{
+    // New mutations always give a new gamete
+    const auto g = fwdpp::mutate_recombine(
+        std::vector<fwdpp::uint_t>{ 1 }, std::vector<double>{ 0.1, maxpos },
+        0, 1, gametes, mutations, gamete_recycling_bin, neutral, selected);
+    BOOST_CHECK_EQUAL(g, 2);
+    BOOST_CHECK(gametes[2].mutations
+                == fwdpp::gamete::mutation_container({ 0, 1, 4, 5, 8 }));
+    BOOST_CHECK_EQUAL(fwdpp::recombination_statistics().parental_copies, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_random_gametes)
+// The keys are always the same as those from a full merge
+{
+    fwdpp::GSLrng_t<fwdpp::GSL_RNG_MT19937> r(42);
+    gametes.clear();
+    for (unsigned i = 0; i < 2; ++i)
+        {
+            gametes.emplace_back(1);
+        }
+    unsigned ncopies = 0;
+    for (unsigned rep = 0; rep < 1000; ++rep)
+        {
+            gametes.erase(gametes.begin() + 2, gametes.end());
+            for (auto &g : gametes)
+                {
+                    g.mutations.clear();
+                    for (fwdpp::uint_t k = 0; k < mutations.size(); ++k)
+                        {
+                            // Mostly shared keys
+                            if ((k + rep) % 3 != 0
+                                || gsl_rng_uniform(r.get()) < 0.5)
+                                {
+                                    g.mutations.push_back(k);
+                                }
+                        }
+                }
+            std::vector<double> breakpoints;
+            const unsigned nbreaks = 1 + gsl_rng_uniform_int(r.get(), 3);
+            for (unsigned i = 0; i < nbreaks; ++i)
+                {
+                    breakpoints.push_back(gsl_rng_uniform(r.get()));
+                }
+            std::sort(breakpoints.begin(), breakpoints.end());
+            breakpoints.push_back(maxpos);
+
+            fwdpp::gamete::mutation_container expected_n, expected_s;
+            fwdpp::fwdpp_internal::recombine_gametes(
+                breakpoints, 0, 1, gametes, mutations, expected_n,
+                expected_s);
+            const auto g = recombine(breakpoints);
+            if (g < 2)
+                {
+                    ++ncopies;
+                }
+            BOOST_REQUIRE(gametes[g].mutations == expected_n);
+            BOOST_REQUIRE(gametes[g].smutations == expected_s);
+        }
+    BOOST_CHECK(ncopies > 0);
+    BOOST_CHECK_EQUAL(fwdpp::recombination_statistics().parental_copies,
+                      ncopies);
+}
+
+BOOST_AUTO_TEST_CASE(test_forward_iterator_span)
+// Containers with forward iterators give the same span as std::vector
+{
+    fwdpp::GSLrng_t<fwdpp::GSL_RNG_MT19937> r(101);
+    for (unsigned rep = 0; rep < 1000; ++rep)
+        {
+            std::vector<fwdpp::uint_t> k1, k2;
+            for (fwdpp::uint_t k = 0; k < mutations.size(); ++k)
+                {
+                    const double u = gsl_rng_uniform(r.get());
+                    if (u < 0.6)
+                        {
+                            k1.push_back(k);
+                            k2.push_back(k);
+                        }
+                    else if (u < 0.7)
+                        {
+                            k1.push_back(k);
+                        }
+                    else if (u < 0.8)
+                        {
+                            k2.push_back(k);
+                        }
+                }
+            fwdpp::compressed_key_container c1, c2;
+            c1.insert(c1.end(), k1.begin(), k1.end());
+            c2.insert(c2.end(), k2.begin(), k2.end());
+            fwdpp::fwdpp_internal::differing_span expected, span;
+            fwdpp::fwdpp_internal::update_differing_span(k1, k2, mutations,
+                                                         expected);
+            fwdpp::fwdpp_internal::update_differing_span(c1, c2, mutations,
+                                                         span);
+            BOOST_REQUIRE_EQUAL(span.first, expected.first);
+            BOOST_REQUIRE_EQUAL(span.last, expected.last);
+            BOOST_REQUIRE_EQUAL(span.nshared, expected.nshared);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_chunked_span)
+// Skipping shared blocks gives the same span as std::vector
+{
+    using chunked_t = fwdpp::chunked_key_container<4>;
+    fwdpp::GSLrng_t<fwdpp::GSL_RNG_MT19937> r(7);
+    for (unsigned i = 9; i < 100; ++i)
+        {
+            mutations.emplace_back(double(i) / 100., 0., 1.);
+        }
+    for (unsigned rep = 0; rep < 1000; ++rep)
+        {
+            std::vector<fwdpp::uint_t> k1;
+            for (fwdpp::uint_t k = 0; k < mutations.size(); ++k)
+                {
+                    if (gsl_rng_uniform(r.get()) < 0.5)
+                        {
+                            k1.push_back(k);
+                        }
+                }
+            std::sort(k1.begin(), k1.end(),
+                      [this](const fwdpp::uint_t a, const fwdpp::uint_t b) {
+                          return mutations[a].pos < mutations[b].pos;
+                      });
+            chunked_t c1;
+            c1.insert(c1.end(), k1.begin(), k1.end());
+            // Remove some keys.  Blocks without them remain shared.
+            chunked_t c2(c1);
+            const double premove = 0.05 * double(rep % 4);
+            std::vector<fwdpp::uint_t> removed;
+            for (auto k : k1)
+                {
+                    if (gsl_rng_uniform(r.get()) < premove)
+                        {
+                            removed.push_back(k);
+                        }
+                }
+            const auto is_removed = [&removed](const fwdpp::uint_t k) {
+                return std::find(removed.begin(), removed.end(), k)
+                       != removed.end();
+            };
+            c2.remove_if(is_removed);
+            std::vector<fwdpp::uint_t> k2(c2.begin(), c2.end());
+            if (rep % 5 == 0)
+                {
+                    // The same keys in blocks that are not shared
+                    c2 = chunked_t();
+                    c2.insert(c2.end(), k2.begin(), k2.end());
+                }
+            fwdpp::fwdpp_internal::differing_span expected, span;
+            fwdpp::fwdpp_internal::update_differing_span(k1, k2, mutations,
+                                                         expected);
+            fwdpp::fwdpp_internal::update_differing_span(c1, c2, mutations,
+                                                         span);
+            BOOST_REQUIRE_EQUAL(span.first, expected.first);
+            BOOST_REQUIRE_EQUAL(span.last, expected.last);
+            BOOST_REQUIRE_EQUAL(span.nshared, expected.nshared);
+            fwdpp::fwdpp_internal::differing_span reversed;
+            fwdpp::fwdpp_internal::update_differing_span(c2, c1, mutations,
+                                                         reversed);
+            BOOST_REQUIRE_EQUAL(reversed.first, expected.first);
+            BOOST_REQUIRE_EQUAL(reversed.last, expected.last);
+        }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
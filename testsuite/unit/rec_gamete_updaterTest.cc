@@ -0,0 +1,139 @@
+/*!
+  \file rec_gamete_updaterTest.cc
+  \ingroup unit
+  \brief Testing the merge kernel in fwdpp/internal/rec_gamete_updater.hpp
+*/
+#include <config.h>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/compressed_key_container.hpp>
+#include <fwdpp/soa_mutation_vector.hpp>
+#include <fwdpp/internal/rec_gamete_updater.hpp>
+
+namespace
+{
+    template <typename mcont_t>
+    mcont_t
+    make_mutations()
+    // Positions 0, 1, 1, 2, 3, 3, 3, 4, ... with keys in reverse order
+    // of position
+    {
+        std::vector<double> pos;
+        for (unsigned i = 0; i < 200; ++i)
+            {
+                pos.push_back(static_cast<double>(i / 2 + (i % 7 == 0)));
+            }
+        mcont_t mutations;
+        for (auto p = pos.rbegin(); p != pos.rend(); ++p)
+            {
+                mutations.emplace_back(*p, 0., true);
+            }
+        return mutations;
+    }
+
+    template <typename mcont_t>
+    std::vector<fwdpp::uint_t>
+    sorted_keys(const mcont_t &mutations)
+    {
+        std::vector<fwdpp::uint_t> keys;
+        for (fwdpp::uint_t k = 0; k < mutations.size(); ++k)
+            {
+                keys.push_back(k);
+            }
+        std::stable_sort(keys.begin(), keys.end(),
+                         [&mutations](const fwdpp::uint_t a,
+                                      const fwdpp::uint_t b) {
+                             return mutations[a].pos < mutations[b].pos;
+                         });
+        return keys;
+    }
+
+    template <typename mcont_t>
+    void
+    check_against_upper_bound(const mcont_t &mutations)
+    // Every starting point and value gives the same result as
+    // std::upper_bound
+    {
+        const auto keys = sorted_keys(mutations);
+        for (std::size_t first = 0; first <= keys.size(); ++first)
+            {
+                for (double val = -1.; val < 105.; val += 0.5)
+                    {
+                        const auto expected = std::upper_bound(
+                            keys.begin() + first, keys.end(), val,
+                            [&mutations](const double v,
+                                         const fwdpp::uint_t k) {
+                                return v < mutations[k].pos;
+                            });
+                        const auto x = fwdpp::fwdpp_internal::rec_update_itr(
+                            keys.begin() + first, keys.end(), mutations,
+                            val);
+                        BOOST_REQUIRE(x == expected);
+                        const auto y = fwdpp::fwdpp_internal::rec_update_itr(
+                            keys.begin() + first, keys.end(), mutations, val,
+                            false);
+                        BOOST_REQUIRE(y == expected);
+                    }
+            }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(rec_gamete_updaterTest)
+
+BOOST_AUTO_TEST_CASE(test_gallop_matches_upper_bound)
+{
+    check_against_upper_bound(make_mutations<std::vector<fwdpp::mutation>>());
+}
+
+BOOST_AUTO_TEST_CASE(test_gallop_matches_upper_bound_columns)
+{
+    check_against_upper_bound(
+        make_mutations<fwdpp::soa_mutation_vector<fwdpp::mutation>>());
+}
+
+BOOST_AUTO_TEST_CASE(test_forward_iterators)
+{
+    const auto mutations = make_mutations<std::vector<fwdpp::mutation>>();
+    const auto keys = sorted_keys(mutations);
+    fwdpp::compressed_key_container ckeys;
+    ckeys.insert(ckeys.end(), keys.begin(), keys.end());
+    for (double val = -1.; val < 105.; val += 0.5)
+        {
+            const auto x = fwdpp::fwdpp_internal::rec_update_itr(
+                keys.begin(), keys.end(), mutations, val);
+            const auto y = fwdpp::fwdpp_internal::rec_update_itr(
+                ckeys.begin(), ckeys.end(), mutations, val);
+            BOOST_REQUIRE_EQUAL(std::distance(keys.begin(), x),
+                                std::distance(ckeys.begin(), y));
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_rec_gam_updater)
+{
+    const auto mutations = make_mutations<std::vector<fwdpp::mutation>>();
+    const auto keys = sorted_keys(mutations);
+    std::vector<fwdpp::uint_t> out;
+    auto itr = keys.cbegin();
+    for (double val : { 3., 3., 10.5, 60., 1000. })
+        {
+            itr = fwdpp::fwdpp_internal::rec_gam_updater(itr, keys.cend(),
+                                                         mutations, out, val);
+            BOOST_REQUIRE(std::equal(out.begin(), out.end(), keys.begin()));
+            BOOST_REQUIRE_EQUAL(out.size(), itr - keys.cbegin());
+        }
+    BOOST_CHECK(out == keys);
+}
+
+BOOST_AUTO_TEST_CASE(test_choice_of_search)
+{
+    using fwdpp::fwdpp_internal::gallop_rec_update;
+    // One or two crossovers, plus the terminal breakpoint
+    BOOST_CHECK(!gallop_rec_update(100, 2));
+    BOOST_CHECK(!gallop_rec_update(100, 3));
+    BOOST_CHECK(gallop_rec_update(100, 20));
+    // Too many keys per breakpoint
+    BOOST_CHECK(!gallop_rec_update(100000, 20));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,61 @@
+/*!
+  \file renumber_mutationsTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::renumber_mutations
+*/
+#include <config.h>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include "../fixtures/fwdpp_fixtures.hpp"
+
+struct renumber_mutations_fixture : public standard_empty_single_deme_fixture
+{
+    renumber_mutations_fixture()
+    {
+        // Mutation 2 is only found in an extinct gamete,
+        // and mutation 4 is in no gamete.
+        for (double pos : { 0.5, 0.1, 0.7, 0.3, 0.9 })
+            {
+                mutations.emplace_back(mtype(pos, 0., 1));
+            }
+        mutations[3].s = -0.1;
+        mutations[3].neutral = false;
+        mcounts = { 3, 1, 0, 2, 0 };
+        gametes.emplace_back(1);
+        gametes[0].mutations = { 1, 0 };
+        gametes.emplace_back(0);
+        gametes[1].mutations = { 2 };
+        gametes.emplace_back(2);
+        gametes[2].mutations = { 0 };
+        gametes[2].smutations = { 3 };
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(renumber_mutationsTest, renumber_mutations_fixture)
+
+BOOST_AUTO_TEST_CASE(test_renumber)
+{
+    std::vector<std::size_t> new_keys;
+    fwdpp::renumber_mutations(gametes, mutations, mcounts, new_keys);
+    BOOST_REQUIRE_EQUAL(mutations.size(), 3);
+    BOOST_CHECK_EQUAL(mutations[0].pos, 0.1);
+    BOOST_CHECK_EQUAL(mutations[1].pos, 0.3);
+    BOOST_CHECK_EQUAL(mutations[2].pos, 0.5);
+    BOOST_CHECK(mcounts == std::vector<fwdpp::uint_t>({ 1, 2, 3 }));
+    BOOST_CHECK(new_keys
+                == std::vector<std::size_t>(
+                       { 2, 0, fwdpp::dropped_mutation_key, 1,
+                         fwdpp::dropped_mutation_key }));
+    BOOST_CHECK(gametes[0].mutations
+                == fwdpp::gamete::mutation_container({ 0, 2 }));
+    BOOST_CHECK(gametes[1].mutations.empty());
+    BOOST_CHECK(gametes[2].mutations
+                == fwdpp::gamete::mutation_container({ 2 }));
+    BOOST_CHECK(gametes[2].smutations
+                == fwdpp::gamete::mutation_container({ 1 }));
+    std::vector<fwdpp::uint_t> counts;
+    fwdpp::fwdpp_internal::process_gametes(gametes, mutations, counts);
+    BOOST_CHECK(counts == mcounts);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,182 @@
+/*!
+  \file slab_allocatorTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::slab_arena and fwdpp::slab_allocator
+*/
+#include <config.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/slab_allocator.hpp>
+#include <fwdpp/diploid.hh>
+
+BOOST_AUTO_TEST_SUITE(slab_allocatorTest)
+
+BOOST_AUTO_TEST_CASE(test_size_classes_and_reuse)
+{
+    fwdpp::slab_arena arena(1 << 16);
+    auto p1 = arena.allocate(1);
+    auto p2 = arena.allocate(17);
+    BOOST_REQUIRE(p1 != p2);
+    auto s = arena.stats();
+    BOOST_CHECK_EQUAL(s.allocations, 2);
+    BOOST_CHECK_EQUAL(s.bytes_in_use, 16 + 32);
+    BOOST_CHECK_EQUAL(s.slabs, 1);
+    // A freed block is reused by the next request of its size class
+    arena.deallocate(p2, 17);
+    auto p3 = arena.allocate(32);
+    BOOST_CHECK(p3 == p2);
+    BOOST_CHECK_EQUAL(arena.stats().reused, 1);
+    arena.deallocate(p1, 1);
+    arena.deallocate(p3, 32);
+    s = arena.stats();
+    BOOST_CHECK_EQUAL(s.deallocations, 3);
+    BOOST_CHECK_EQUAL(s.bytes_in_use, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_large_blocks_and_new_slabs)
+{
+    const std::size_t max_block_size = fwdpp::slab_arena::max_block_size;
+    fwdpp::slab_arena arena(max_block_size);
+    auto large = arena.allocate(max_block_size + 1);
+    BOOST_CHECK_EQUAL(arena.stats().large_allocations, 1);
+    BOOST_CHECK_EQUAL(arena.stats().slabs, 0);
+    // Each slab holds one block of the largest class
+    auto b1 = arena.allocate(max_block_size);
+    auto b2 = arena.allocate(max_block_size);
+    BOOST_CHECK_EQUAL(arena.stats().slabs, 2);
+    BOOST_CHECK_EQUAL(arena.stats().bytes_reserved, 2 * max_block_size);
+    arena.deallocate(large, max_block_size + 1);
+    arena.deallocate(b1, max_block_size);
+    arena.deallocate(b2, max_block_size);
+    BOOST_CHECK_EQUAL(arena.stats().bytes_in_use, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_huge_pages)
+{
+    // Whether huge pages are granted depends on the system, but the
+    // memory must be usable either way.
+    fwdpp::slab_arena arena(fwdpp::slab_arena::huge_page_size, true);
+    auto p = static_cast<char *>(arena.allocate(4096));
+    std::fill(p, p + 4096, 1);
+    BOOST_CHECK_EQUAL(arena.stats().slabs, 1);
+    BOOST_CHECK(arena.stats().huge_page_slabs <= 1);
+    arena.deallocate(p, 4096);
+}
+
+BOOST_AUTO_TEST_CASE(test_thread_cache)
+{
+    fwdpp::slab_arena arena(1 << 16);
+    void *p1, *p2;
+    {
+        fwdpp::slab_thread_cache cache(arena);
+        p1 = cache.allocate(16);
+        auto s = arena.stats();
+        BOOST_CHECK_EQUAL(s.allocations, 1);
+        BOOST_CHECK_EQUAL(s.reused, 0);
+        BOOST_CHECK_EQUAL(s.bytes_in_use, 16);
+        // A batch of blocks was cut for the cache
+        BOOST_CHECK_EQUAL(s.slabs, 1);
+        // A freed block is reused by the cache
+        cache.deallocate(p1, 16);
+        p2 = cache.allocate(16);
+        BOOST_CHECK(p2 == p1);
+        BOOST_CHECK_EQUAL(arena.stats().reused, 1);
+        // Blocks may be freed to the arena directly
+        arena.deallocate(p2, 16);
+        auto p3 = cache.allocate(1 << 20);
+        cache.deallocate(p3, 1 << 20);
+        s = arena.stats();
+        BOOST_CHECK_EQUAL(s.allocations, 3);
+        BOOST_CHECK_EQUAL(s.deallocations, 3);
+        BOOST_CHECK_EQUAL(s.large_allocations, 1);
+        BOOST_CHECK_EQUAL(s.bytes_in_use, 0);
+    }
+    // The statistics of the destroyed cache are kept, and its blocks
+    // are back in the arena.
+    auto s = arena.stats();
+    BOOST_CHECK_EQUAL(s.allocations, 3);
+    BOOST_CHECK_EQUAL(s.bytes_in_use, 0);
+    auto p4 = arena.allocate(16);
+    BOOST_CHECK_EQUAL(arena.stats().reused, 2);
+    BOOST_CHECK_EQUAL(arena.stats().slabs, 1);
+    arena.deallocate(p4, 16);
+}
+
+BOOST_AUTO_TEST_CASE(test_slab_gamete_threads)
+{
+    // Buffers allocated on one thread and freed on another
+    const auto before = fwdpp::slab_allocator_statistics();
+    std::vector<std::vector<fwdpp::slab_gamete<>>> gametes(4);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < gametes.size(); ++t)
+        {
+            threads.emplace_back([&gametes, t]() {
+                for (unsigned i = 0; i < 1000; ++i)
+                    {
+                        gametes[t].emplace_back(1);
+                        for (fwdpp::uint_t k = 0; k < i % 50; ++k)
+                            {
+                                gametes[t].back().mutations.push_back(k);
+                            }
+                    }
+            });
+        }
+    for (auto &t : threads)
+        {
+            t.join();
+        }
+    for (auto &g : gametes)
+        {
+            BOOST_REQUIRE_EQUAL(g.size(), 1000);
+            BOOST_REQUIRE_EQUAL(g.back().mutations.size(), 49);
+        }
+    auto after = fwdpp::slab_allocator_statistics();
+    BOOST_CHECK(after.bytes_in_use > before.bytes_in_use);
+    threads.clear();
+    for (unsigned t = 0; t < gametes.size(); ++t)
+        {
+            threads.emplace_back([&gametes, t]() {
+                gametes[(t + 1) % gametes.size()].clear();
+            });
+        }
+    for (auto &t : threads)
+        {
+            t.join();
+        }
+    after = fwdpp::slab_allocator_statistics();
+    BOOST_CHECK_EQUAL(after.allocations - before.allocations,
+                      after.deallocations - before.deallocations);
+    BOOST_CHECK_EQUAL(after.bytes_in_use, before.bytes_in_use);
+    BOOST_CHECK(after.reused > before.reused);
+}
+
+BOOST_AUTO_TEST_CASE(test_slab_gamete)
+{
+    const auto before = fwdpp::slab_allocator_statistics();
+    {
+        std::vector<fwdpp::slab_gamete<>> gametes;
+        for (unsigned i = 0; i < 100; ++i)
+            {
+                gametes.emplace_back(1);
+                for (fwdpp::uint_t k = 0; k < i; ++k)
+                    {
+                        gametes.back().mutations.push_back(k);
+                    }
+            }
+        auto copy(gametes);
+        BOOST_REQUIRE(copy == gametes);
+        gametes[0].mutations.swap(gametes[99].mutations);
+        BOOST_CHECK_EQUAL(gametes[0].mutations.size(), 99);
+        BOOST_CHECK(gametes[99].mutations.empty());
+    }
+    const auto after = fwdpp::slab_allocator_statistics();
+    BOOST_CHECK(after.allocations > before.allocations);
+    BOOST_CHECK_EQUAL(after.allocations - before.allocations,
+                      after.deallocations - before.deallocations);
+    BOOST_CHECK_EQUAL(after.bytes_in_use, before.bytes_in_use);
+    BOOST_CHECK(after.reused > before.reused);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
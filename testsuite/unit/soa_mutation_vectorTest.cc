@@ -0,0 +1,123 @@
+/*!
+  \file soa_mutation_vectorTest.cc
+  \ingroup unit
+  \brief Testing fwdpp::soa_mutation_vector
+*/
+#include <config.h>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/soa_mutation_vector.hpp>
+#include <fwdpp/sugar/popgenmut.hpp>
+#include <fwdpp/sugar/generalmut.hpp>
+#include <fwdpp/sugar/singlepop.hpp>
+#include <testsuite/util/quick_evolve_sugar.hpp>
+
+namespace
+{
+    using soa_t = fwdpp::soa_mutation_vector<fwdpp::popgenmut>;
+
+    template <typename mcont_t>
+    bool
+    columns_match(const mcont_t &mutations)
+    {
+        if (mutations.positions().size() != mutations.size()
+            || mutations.neutral_flags().size() != mutations.size()
+            || mutations.effect_sizes().size() != mutations.size())
+            {
+                return false;
+            }
+        for (std::size_t i = 0; i < mutations.size(); ++i)
+            {
+                if (mutations.position(i) != mutations[i].pos
+                    || mutations.is_neutral(i) != mutations[i].neutral
+                    || fwdpp::fwdpp_internal::mutation_position(mutations, i)
+                           != mutations[i].pos)
+                    {
+                        return false;
+                    }
+            }
+        return true;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(soa_mutation_vectorTest)
+
+BOOST_AUTO_TEST_CASE(test_columns)
+{
+    soa_t mutations;
+    mutations.emplace_back(0.5, 0., 1., 0, 0);
+    mutations.push_back(fwdpp::popgenmut(0.25, -0.1, 0.5, 1, 0));
+    BOOST_REQUIRE_EQUAL(mutations.size(), 2);
+    BOOST_CHECK(columns_match(mutations));
+    BOOST_CHECK(mutations.is_neutral(0));
+    BOOST_CHECK(!mutations.is_neutral(1));
+    BOOST_CHECK_EQUAL(mutations.effect_size(1), -0.1);
+
+    mutations.set(0, fwdpp::popgenmut(0.75, -0.2, 1., 2, 0));
+    BOOST_CHECK(columns_match(mutations));
+    BOOST_CHECK_EQUAL(mutations.position(0), 0.75);
+    BOOST_CHECK_EQUAL(mutations.effect_size(0), -0.2);
+    BOOST_CHECK_EQUAL(mutations[0].g, 2);
+
+    soa_t copy(mutations.records());
+    BOOST_CHECK(copy == mutations);
+    BOOST_CHECK(columns_match(copy));
+    copy.clear();
+    copy.swap(mutations);
+    BOOST_CHECK(mutations.empty());
+    BOOST_CHECK(mutations.positions().empty());
+    BOOST_CHECK(columns_match(copy));
+}
+
+BOOST_AUTO_TEST_CASE(test_non_scalar_effect_size)
+{
+    fwdpp::soa_mutation_vector<fwdpp::generalmut<2>> mutations;
+    fwdpp::generalmut<2>::array_t sh{
+        { std::make_tuple(0.1, 1.), std::make_tuple(0.2, 1.) }
+    };
+    mutations.emplace_back(sh, 0.5, 0);
+    BOOST_CHECK(columns_match(mutations));
+    BOOST_CHECK_EQUAL(mutations.effect_size(0), 0.);
+}
+
+BOOST_AUTO_TEST_CASE(test_recycle_mutation_helper)
+{
+    soa_t mutations;
+    fwdpp::fwdpp_internal::recycling_bin<std::size_t> bin;
+    BOOST_CHECK_EQUAL(fwdpp::fwdpp_internal::recycle_mutation_helper(
+                          bin, mutations, 0.1, 0., 1., 0, 0),
+                      0);
+    bin.push(0);
+    BOOST_CHECK_EQUAL(fwdpp::fwdpp_internal::recycle_mutation_helper(
+                          bin, mutations, 0.9, -0.1, 1., 1, 0),
+                      0);
+    BOOST_REQUIRE_EQUAL(mutations.size(), 1);
+    BOOST_CHECK_EQUAL(mutations.position(0), 0.9);
+    BOOST_CHECK(!mutations.is_neutral(0));
+}
+
+BOOST_AUTO_TEST_CASE(test_simulation)
+// The outcome is the same as for std::vector
+{
+    using lookup_t
+        = std::unordered_set<double, std::hash<double>, fwdpp::equal_eps>;
+    using dipvector_t = std::vector<std::pair<std::size_t, std::size_t>>;
+    using gcont_t = std::vector<fwdpp::gamete>;
+    using soa_poptype
+        = fwdpp::sugar::singlepop<fwdpp::popgenmut, soa_t, gcont_t,
+                                  dipvector_t, std::vector<fwdpp::popgenmut>,
+                                  std::vector<fwdpp::uint_t>, lookup_t>;
+    fwdpp::singlepop<fwdpp::popgenmut> pop(1000);
+    soa_poptype soa_pop(1000);
+    simulate_singlepop(pop, 100, 1000);
+    simulate_singlepop(soa_pop, 100, 1000);
+    BOOST_REQUIRE(!pop.mutations.empty());
+    BOOST_REQUIRE(pop.mutations == soa_pop.mutations.records());
+    BOOST_CHECK(columns_match(soa_pop.mutations));
+    BOOST_CHECK(pop.gametes == soa_pop.gametes);
+    BOOST_CHECK(pop.diploids == soa_pop.diploids);
+    BOOST_CHECK(pop.mcounts == soa_pop.mcounts);
+    BOOST_CHECK(pop.fixations == soa_pop.fixations);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
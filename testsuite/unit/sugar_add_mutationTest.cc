@@ -15,7 +15,31 @@
 // #include <fwdpp/sugar/infsites.hpp>
 // #include <fwdpp/sugar/serialization.hpp>
 #include <fwdpp/sugar/add_mutation.hpp>
+#include <fwdpp/renumber_mutations.hpp>
 #include <fwdpp/debug.hpp>
+#include <testsuite/util/quick_evolve_sugar.hpp>
+
+namespace
+{
+    template <typename poptype, typename rng_t>
+    void
+    evolve_with_workspace(poptype &pop, const rng_t &rng,
+                          const unsigned generation)
+    // One generation, passing pop.workspace to sample_diploid but not to
+    // update_mutations, which is called by the tests
+    {
+        fwdpp::sample_diploid(
+            rng.get(), pop.gametes, pop.diploids, pop.mutations, pop.mcounts,
+            pop.N, 0.005,
+            std::bind(fwdpp::infsites(), std::placeholders::_1,
+                      std::placeholders::_2, rng.get(),
+                      std::ref(pop.mut_lookup), generation, 0.0025, 0.0025,
+                      [&rng]() { return gsl_rng_uniform(rng.get()); },
+                      []() { return -0.01; }, []() { return 1.; }),
+            fwdpp::poisson_xover(rng.get(), 0.005, 0., 1.),
+            fwdpp::multiplicative_diploid(2.), pop.workspace);
+    }
+}
 /*
   First, unit tests for the addition of a single new mutation.
 
@@ -193,6 +217,37 @@ BOOST_AUTO_TEST_CASE(test_add_mutations_singlepop)
         }
 }
 
+BOOST_AUTO_TEST_CASE(test_add_mutation_with_filled_recycling_bin)
+// add_mutation reuses an extinct slot that is held by the recycling bin
+// filled by update_mutations.  The next generation must not overwrite it.
+{
+    simulate_singlepop_workspace(pop, 10, 1000);
+    BOOST_REQUIRE(pop.workspace.mutation_recycling_bin_filled);
+    const std::vector<std::size_t> bin(
+        pop.workspace.mutation_recycling_bin.begin(),
+        pop.workspace.mutation_recycling_bin.end());
+    const auto mindex
+        = fwdpp::add_mutation(pop, { 0, 1, 3 }, { 0, 1, 2 }, 2.0, 0.0, 1, 0);
+    BOOST_REQUIRE(std::find(bin.begin(), bin.end(), mindex) != bin.end());
+    BOOST_REQUIRE_EQUAL(pop.mcounts[mindex], 4);
+    evolve_with_workspace(pop, rng, 10);
+    BOOST_CHECK_EQUAL(pop.mutations[mindex].pos, 2.0);
+    BOOST_CHECK(fwdpp::popdata_sane(pop.diploids, pop.gametes, pop.mutations,
+                                    pop.mcounts));
+}
+
+BOOST_AUTO_TEST_CASE(test_renumber_mutations_with_filled_recycling_bin)
+// The keys in the recycling bin filled by update_mutations are stale
+// once mutations are renumbered.
+{
+    simulate_singlepop_workspace(pop, 10, 1000);
+    BOOST_REQUIRE(!pop.workspace.mutation_recycling_bin.empty());
+    fwdpp::renumber_mutations(pop.gametes, pop.mutations, pop.mcounts);
+    evolve_with_workspace(pop, rng, 10);
+    BOOST_CHECK(fwdpp::popdata_sane(pop.diploids, pop.gametes, pop.mutations,
+                                    pop.mcounts));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_FIXTURE_TEST_SUITE(test_add_mutation_metapop, metapop_popgenmut_fixture)
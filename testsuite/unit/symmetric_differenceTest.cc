@@ -0,0 +1,195 @@
+/*!
+  \file symmetric_differenceTest.cc
+  \ingroup unit
+  \brief Testing recombination over the symmetric difference of two
+  parental gametes in fwdpp::mutate_recombine
+*/
+#include <config.h>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <fwdpp/diploid.hh>
+#include <fwdpp/sugar/GSLrng_t.hpp>
+#include <fwdpp/internal/recombination_common.hpp>
+#include <fwdpp/internal/symmetric_difference.hpp>
+
+namespace
+{
+    const double maxpos = std::numeric_limits<double>::max();
+}
+
+struct symmetric_difference_fixture
+{
+    std::vector<fwdpp::mutation> mutations;
+    std::vector<fwdpp::gamete> gametes;
+    fwdpp::gamete::mutation_container neutral, selected;
+    fwdpp::fwdpp_internal::recycling_bin_t<std::size_t> gamete_recycling_bin;
+    symmetric_difference_fixture()
+        : mutations{}, gametes{}, neutral{}, selected{},
+          gamete_recycling_bin{}
+    {
+        // Positions 0.01, 0.02, ..., 0.99.  Every third mutation is
+        // selected.
+        for (unsigned i = 1; i < 100; ++i)
+            {
+                mutations.emplace_back(double(i) / 100.,
+                                       (i % 3 == 0) ? 0.1 : 0., 1.);
+            }
+        gametes.emplace_back(1);
+        gametes.emplace_back(1);
+        fwdpp::reset_recombination_statistics();
+    }
+
+    void
+    add_key(fwdpp::gamete &g, const fwdpp::uint_t k)
+    {
+        if (mutations[k].neutral)
+            {
+                g.mutations.push_back(k);
+            }
+        else
+            {
+                g.smutations.push_back(k);
+            }
+    }
+
+    fwdpp::gamete
+    expected_gamete(const std::vector<fwdpp::uint_t> &new_mutations,
+                    const std::vector<double> &breakpoints)
+    // The recombinant from a full merge at every breakpoint, with new
+    // mutations after parental keys at the same position
+    {
+        fwdpp::gamete g(1);
+        fwdpp::fwdpp_internal::recombine_gametes(breakpoints, 0, 1, gametes,
+                                                 mutations, g.mutations,
+                                                 g.smutations);
+        for (auto k : new_mutations)
+            {
+                auto &keys = mutations[k].neutral ? g.mutations : g.smutations;
+                keys.insert(std::upper_bound(keys.begin(), keys.end(),
+                                             mutations[k].pos,
+                                             [this](const double p,
+                                                    const fwdpp::uint_t j) {
+                                                 return p < mutations[j].pos;
+                                             }),
+                            k);
+            }
+        return g;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(symmetric_differenceTest,
+                         symmetric_difference_fixture)
+
+BOOST_AUTO_TEST_CASE(test_mostly_shared)
+{
+    for (fwdpp::uint_t k = 0; k < 60; ++k)
+        {
+            if (k != 30)
+                {
+                    add_key(gametes[0], k);
+                }
+            if (k != 20 && k != 40)
+                {
+                    add_key(gametes[1], k);
+                }
+        }
+    // Mutation 30 comes from gamete 1, mutations 20 and 40 from gamete 0
+    const std::vector<double> breakpoints{ 0.25, 0.35, maxpos };
+    const std::vector<fwdpp::uint_t> new_mutations{ 64, 69 };
+    const auto expected = expected_gamete(new_mutations, breakpoints);
+    const auto g = fwdpp::mutate_recombine(new_mutations, breakpoints, 0, 1,
+                                           gametes, mutations,
+                                           gamete_recycling_bin, neutral,
+                                           selected);
+    BOOST_REQUIRE_EQUAL(g, 2);
+    BOOST_CHECK(gametes[g].mutations == expected.mutations);
+    BOOST_CHECK(gametes[g].smutations == expected.smutations);
+    BOOST_CHECK_EQUAL(
+        fwdpp::recombination_statistics().symmetric_difference_merges, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_mostly_private)
+{
+    // No shared keys, so the breakpoint loop is used
+    for (fwdpp::uint_t k = 0; k < 60; ++k)
+        {
+            add_key(gametes[k % 2], k);
+        }
+    const std::vector<double> breakpoints{ 0.25, 0.35, maxpos };
+    const auto expected = expected_gamete({}, breakpoints);
+    const auto g = fwdpp::mutate_recombine({}, breakpoints, 0, 1, gametes,
+                                           mutations, gamete_recycling_bin,
+                                           neutral, selected);
+    BOOST_CHECK(gametes[g].mutations == expected.mutations);
+    BOOST_CHECK(gametes[g].smutations == expected.smutations);
+    BOOST_CHECK_EQUAL(
+        fwdpp::recombination_statistics().symmetric_difference_merges, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_tied_positions)
+{
+    // Different keys at the same position are left to the breakpoint
+    // loop
+    mutations[4].pos = mutations[3].pos;
+    const std::vector<fwdpp::uint_t> k1{ 0, 1, 3, 6 }, k2{ 0, 1, 4, 6 };
+    BOOST_CHECK(!fwdpp::fwdpp_internal::merge_symmetric_difference(
+        k1.cbegin(), k1.cend(), k2.cbegin(), k2.cend(),
+        std::vector<double>{ 0.5, maxpos }, std::vector<fwdpp::uint_t>{},
+        mutations, true, neutral));
+}
+
+BOOST_AUTO_TEST_CASE(test_random_gametes)
+// The keys are always the same as those from a full merge
+{
+    fwdpp::GSLrng_t<fwdpp::GSL_RNG_MT19937> r(42);
+    for (unsigned rep = 0; rep < 1000; ++rep)
+        {
+            gametes.erase(gametes.begin() + 2, gametes.end());
+            for (auto &g : gametes)
+                {
+                    g.mutations.clear();
+                    g.smutations.clear();
+                }
+            std::vector<fwdpp::uint_t> new_mutations;
+            for (fwdpp::uint_t k = 0; k < mutations.size(); ++k)
+                {
+                    const double u = gsl_rng_uniform(r.get());
+                    if (u < 0.5)
+                        {
+                            add_key(gametes[0], k);
+                            add_key(gametes[1], k);
+                        }
+                    else if (u < 0.55)
+                        {
+                            add_key(gametes[0], k);
+                        }
+                    else if (u < 0.6)
+                        {
+                            add_key(gametes[1], k);
+                        }
+                    else if (u < 0.62)
+                        {
+                            new_mutations.push_back(k);
+                        }
+                }
+            std::vector<double> breakpoints;
+            const unsigned nbreaks = 1 + gsl_rng_uniform_int(r.get(), 5);
+            for (unsigned i = 0; i < nbreaks; ++i)
+                {
+                    breakpoints.push_back(gsl_rng_uniform(r.get()));
+                }
+            std::sort(breakpoints.begin(), breakpoints.end());
+            breakpoints.push_back(maxpos);
+
+            const auto expected = expected_gamete(new_mutations, breakpoints);
+            const auto g = fwdpp::mutate_recombine(
+                new_mutations, breakpoints, 0, 1, gametes, mutations,
+                gamete_recycling_bin, neutral, selected);
+            BOOST_REQUIRE(gametes[g].mutations == expected.mutations);
+            BOOST_REQUIRE(gametes[g].smutations == expected.smutations);
+        }
+    BOOST_CHECK(fwdpp::recombination_statistics().symmetric_difference_merges
+                > 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,8 +5,10 @@
   policies accompanying this type.
 */
 
+#include <functional>
 #include <boost/test/unit_test.hpp>
 #include <fwdpp/general_rec_variation.hpp>
+#include <fwdpp/poisson_xover.hpp>
 #include <fwdpp/forward_types.hpp>
 #include <fwdpp/mutate_recombine.hpp>
 #include <config.h>
@@ -76,4 +78,72 @@ BOOST_AUTO_TEST_CASE(test_dispatch)
         std::cref(mutations));
 }
 
+BOOST_AUTO_TEST_CASE(test_writes_breakpoints)
+{
+    using fwdpp::fwdpp_internal::writes_breakpoints;
+    static_assert(writes_breakpoints<fwdpp::general_rec_variation>::value,
+                  "general_rec_variation must write into a buffer");
+    static_assert(writes_breakpoints<fwdpp::poisson_xover>::value,
+                  "poisson_xover must write into a buffer");
+    static_assert(
+        !writes_breakpoints<std::function<std::vector<double>()>>::value,
+        "a function returning breakpoints does not write into a buffer");
+    auto bound = std::bind(fwdpp::poisson_xover(r, 1., 0., 1.));
+    static_assert(!writes_breakpoints<decltype(bound)>::value,
+                  "std::bind ignores the buffer, so it must not be written "
+                  "into");
+}
+
+BOOST_AUTO_TEST_CASE(test_poisson_xover_buffer)
+// Writing into a buffer gives the same breakpoints as returning them,
+// for the same seed
+{
+    const fwdpp::poisson_xover px(r, 3., 0., 1.);
+    std::vector<double> buffer(10, -1.);
+    for (unsigned i = 0; i < 10; ++i)
+        {
+            gsl_rng_set(r, i);
+            auto x = px();
+            gsl_rng_set(r, i);
+            px(buffer);
+            BOOST_REQUIRE(x == buffer);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(test_buffered_dispatch)
+// The buffered overloads give the same breakpoints as the returning
+// overloads, and reuse the buffer
+{
+    recvar.recmap.push_back(fwdpp::poisson_interval(r, 3., 0., 1.));
+    std::vector<double> buffer(10, -1.);
+    const auto capacity = buffer.capacity();
+    for (unsigned i = 0; i < 10; ++i)
+        {
+            gsl_rng_set(r, i);
+            auto x = recvar();
+            gsl_rng_set(r, i);
+            fwdpp::dispatch_recombination_policy(
+                recvar, std::cref(diploid), std::cref(g), std::cref(g),
+                std::cref(mutations), buffer);
+            BOOST_REQUIRE(x == buffer);
+            BOOST_REQUIRE_EQUAL(buffer.capacity(), capacity);
+        }
+    // Policies that only return breakpoints go through an adapter
+    const std::function<std::vector<double>()> f
+        = fwdpp::poisson_xover(r, 3., 0., 1.);
+    for (unsigned i = 0; i < 10; ++i)
+        {
+            gsl_rng_set(r, i);
+            auto x = f();
+            gsl_rng_set(r, i);
+            fwdpp::dispatch_recombination_policy(
+                f, std::cref(diploid), std::cref(g), std::cref(g),
+                std::cref(mutations), buffer);
+            BOOST_REQUIRE(x == buffer);
+            gsl_rng_set(r, i);
+            fwdpp::poisson_xover(r, 3., 0., 1.)(buffer);
+            BOOST_REQUIRE(x == buffer);
+        }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -5,9 +5,11 @@
 */
 
 #include <config.h>
+#include <algorithm>
 #include <boost/test/unit_test.hpp>
 #include "../fixtures/fwdpp_fixtures.hpp"
 #include <fwdpp/util.hpp>
+#include <fwdpp/generation_workspace.hpp>
 
 /*
   A note on test names:
@@ -92,4 +94,36 @@ BOOST_FIXTURE_TEST_CASE(only_recycle_neutral_fixations,
     BOOST_REQUIRE_EQUAL(fixation_times[0], 2);
 }
 
+BOOST_FIXTURE_TEST_CASE(fill_workspace_recycling_bin,
+                        standard_empty_single_deme_fixture)
+{
+    fwdpp::uint_t N = 1000;
+    fwdpp::generation_workspace<dipvector_t> workspace;
+    // A stale entry, which is replaced
+    workspace.mutation_recycling_bin.push(7);
+    // Lost, fixed, segregating, and lost
+    for (auto c : { 0u, 2 * N, 1u, 0u })
+        {
+            mutations.emplace_back(0.1 * double(mutations.size() + 1), 0);
+            mut_lookup.insert(mutations.back().pos);
+            mcounts.emplace_back(c);
+        }
+    fwdpp::update_mutations(mutations, fixations, fixation_times, mut_lookup,
+                            mcounts, 2, 2 * N, workspace);
+    BOOST_REQUIRE_EQUAL(fixations.size(), 1);
+    BOOST_REQUIRE(workspace.mutation_recycling_bin_filled);
+    BOOST_REQUIRE_EQUAL(workspace.mutation_recycling_bin.size(), 3);
+    // The same bin as fwdpp::sample_diploid would otherwise fill, with
+    // the last index reused first
+    auto bin = fwdpp::fwdpp_internal::make_mut_queue(mcounts);
+    BOOST_CHECK(std::equal(bin.begin(), bin.end(),
+                           workspace.mutation_recycling_bin.begin()));
+    for (auto i : { 3u, 1u, 0u })
+        {
+            BOOST_CHECK_EQUAL(workspace.mutation_recycling_bin.top(), i);
+            workspace.mutation_recycling_bin.pop();
+        }
+    BOOST_CHECK(workspace.mutation_recycling_bin.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -20,10 +20,14 @@
 
 template <typename singlepop_object_t>
 void
-simulate_singlepop(singlepop_object_t &pop, const unsigned simlen = 10,
-                   const unsigned popsize = 5000)
+simulate_singlepop_threaded(singlepop_object_t &pop, const unsigned nthreads,
+                            const unsigned simlen = 10,
+                            const unsigned popsize = 5000,
+                            fwdpp::parent_sampler *sampler = nullptr)
 /*!
-  \brief Quick function for evolving a single-deme simulation
+  \brief Quick function for evolving a single-deme simulation,
+  generating offspring with \a nthreads threads and
+  sampling parents using \a sampler.
   \ingroup testing
   \note Do NOT call this function repeatedly on the same population.
  */
@@ -40,7 +44,8 @@ simulate_singlepop(singlepop_object_t &pop, const unsigned simlen = 10,
                           [&rng]() { return gsl_rng_uniform(rng.get()); },
                           []() { return -0.01; }, []() { return 1.; }),
                 fwdpp::poisson_xover(rng.get(), 0.005, 0., 1.),
-                fwdpp::multiplicative_diploid(2.), pop.neutral, pop.selected);
+                fwdpp::multiplicative_diploid(2.), pop.neutral, pop.selected,
+                0., std::true_type(), nthreads, sampler);
             if (!std::isfinite(wbar))
                 {
                     throw std::runtime_error("fitness not finite");
@@ -52,6 +57,56 @@ simulate_singlepop(singlepop_object_t &pop, const unsigned simlen = 10,
         }
 }
 
+template <typename singlepop_object_t>
+void
+simulate_singlepop_workspace(singlepop_object_t &pop,
+                             const unsigned simlen = 10,
+                             const unsigned popsize = 5000)
+/*!
+  \brief Same as simulate_singlepop_threaded, but passes pop.workspace
+  to fwdpp::sample_diploid.
+  \ingroup testing
+  \note Do NOT call this function repeatedly on the same population.
+ */
+{
+    fwdpp::GSLrng_t<fwdpp::GSL_RNG_TAUS2> rng(0u);
+    for (unsigned generation = 0; generation < simlen; ++generation)
+        {
+            double wbar = fwdpp::sample_diploid(
+                rng.get(), pop.gametes, pop.diploids, pop.mutations,
+                pop.mcounts, pop.N, popsize, 0.005,
+                std::bind(fwdpp::infsites(), std::placeholders::_1,
+                          std::placeholders::_2, rng.get(),
+                          std::ref(pop.mut_lookup), generation, 0.0025, 0.0025,
+                          [&rng]() { return gsl_rng_uniform(rng.get()); },
+                          []() { return -0.01; }, []() { return 1.; }),
+                fwdpp::poisson_xover(rng.get(), 0.005, 0., 1.),
+                fwdpp::multiplicative_diploid(2.), pop.workspace);
+            if (!std::isfinite(wbar))
+                {
+                    throw std::runtime_error("fitness not finite");
+                }
+            pop.N = popsize;
+            fwdpp::update_mutations(pop.mutations, pop.fixations,
+                                    pop.fixation_times, pop.mut_lookup,
+                                    pop.mcounts, generation, 2 * pop.N,
+                                    pop.workspace);
+        }
+}
+
+template <typename singlepop_object_t>
+void
+simulate_singlepop(singlepop_object_t &pop, const unsigned simlen = 10,
+                   const unsigned popsize = 5000)
+/*!
+  \brief Quick function for evolving a single-deme simulation
+  \ingroup testing
+  \note Do NOT call this function repeatedly on the same population.
+ */
+{
+    simulate_singlepop_threaded(pop, 1, simlen, popsize);
+}
+
 template <typename singlepop_object_t, typename rng_type>
 unsigned
 simulate_singlepop(singlepop_object_t &pop, const rng_type &rng,
@@ -119,7 +174,7 @@ simulate_mlocuspop(poptype &pop, const rng_type &rng,
                    const mmodel_vec &mutmodels, const recmodel_vec &recmodels,
                    const fitness_fxn &fitness, const std::vector<double> &mu,
                    const std::vector<double> &rbw, unsigned &generation,
-                   const unsigned simlen = 10)
+                   const unsigned simlen = 10, const unsigned nthreads = 1)
 /*!
   \brief Quick function for evolving a multilocus deme simulation
   \ingroup testing
@@ -134,7 +189,8 @@ simulate_mlocuspop(poptype &pop, const rng_type &rng,
             double wbar = fwdpp::sample_diploid(
                 rng.get(), pop.gametes, pop.diploids, pop.mutations,
                 pop.mcounts, 1000, &mu[0], mutmodels, recmodels,
-                interlocus_rec, fitness, pop.neutral, pop.selected);
+                interlocus_rec, fitness, pop.neutral, pop.selected, 0.,
+                std::true_type(), nthreads);
             if (!std::isfinite(wbar))
                 {
                     throw std::runtime_error("fitness not finite");
@@ -147,9 +203,48 @@ simulate_mlocuspop(poptype &pop, const rng_type &rng,
     return g + simlen;
 }
 
+template <typename poptype, typename rng_type, typename mmodel_vec,
+          typename recmodel_vec, typename fitness_fxn>
+inline unsigned
+simulate_mlocuspop_workspace(poptype &pop, const rng_type &rng,
+                             const mmodel_vec &mutmodels,
+                             const recmodel_vec &recmodels,
+                             const fitness_fxn &fitness,
+                             const std::vector<double> &mu,
+                             const std::vector<double> &rbw,
+                             unsigned &generation, const unsigned simlen = 10)
+/*!
+  \brief Same as simulate_mlocuspop, but passes pop.workspace
+  to fwdpp::sample_diploid.
+  \ingroup testing
+ */
+{
+    unsigned g = generation;
+    auto interlocus_rec = fwdpp::make_binomial_interlocus_rec(
+        rng.get(), rbw.data(), rbw.size());
+    for (; generation < g + simlen; ++generation)
+        {
+            double wbar = fwdpp::sample_diploid(
+                rng.get(), pop.gametes, pop.diploids, pop.mutations,
+                pop.mcounts, 1000, &mu[0], mutmodels, recmodels,
+                interlocus_rec, fitness, pop.workspace);
+            if (!std::isfinite(wbar))
+                {
+                    throw std::runtime_error("fitness not finite");
+                }
+            assert(check_sum(pop.gametes, 8000));
+            fwdpp::update_mutations(pop.mutations, pop.fixations,
+                                    pop.fixation_times, pop.mut_lookup,
+                                    pop.mcounts, generation, 2000,
+                                    pop.workspace);
+        }
+    return g + simlen;
+}
+
 template <typename metapop_object>
 void
-simulate_metapop(metapop_object &pop, const unsigned simlen = 10)
+simulate_metapop(metapop_object &pop, const unsigned simlen = 10,
+                 const unsigned nthreads = 1)
 {
     // Evolve for 10 generations
     std::vector<std::function<double(
@@ -170,7 +265,8 @@ simulate_metapop(metapop_object &pop, const unsigned simlen = 10)
                           []() { return 0.; }, []() { return 0.; }),
                 fwdpp::poisson_xover(rng.get(), 0.005, 0., 1.), fitness_funcs,
                 std::bind(migpop, std::placeholders::_1, rng.get(), 0.001),
-                pop.neutral, pop.selected);
+                pop.neutral, pop.selected, nullptr, std::true_type(),
+                nthreads);
             for (auto wbar_i : wbar)
                 {
                     if (!std::isfinite(wbar_i))
@@ -184,4 +280,46 @@ simulate_metapop(metapop_object &pop, const unsigned simlen = 10)
         }
 }
 
+template <typename metapop_object>
+void
+simulate_metapop_workspace(metapop_object &pop, const unsigned simlen = 10)
+/*!
+  \brief Same as simulate_metapop, but passes pop.workspace
+  to fwdpp::sample_diploid.
+  \ingroup testing
+ */
+{
+    std::vector<std::function<double(
+        const typename metapop_object::diploid_t &,
+        const typename metapop_object::gcont_t &,
+        const typename metapop_object::mcont_t &)>>
+        fitness_funcs(2, fwdpp::multiplicative_diploid(2.));
+    fwdpp::GSLrng_t<fwdpp::GSL_RNG_TAUS2> rng(0u);
+    for (unsigned generation = 0; generation < simlen; ++generation)
+        {
+            std::vector<double> wbar = fwdpp::sample_diploid(
+                rng.get(), pop.gametes, pop.diploids, pop.mutations,
+                pop.mcounts, &pop.Ns[0], 0.005,
+                std::bind(fwdpp::infsites(), std::placeholders::_1,
+                          std::placeholders::_2, rng.get(),
+                          std::ref(pop.mut_lookup), generation, 0.005, 0.,
+                          [&rng]() { return gsl_rng_uniform(rng.get()); },
+                          []() { return 0.; }, []() { return 0.; }),
+                fwdpp::poisson_xover(rng.get(), 0.005, 0., 1.), fitness_funcs,
+                std::bind(migpop, std::placeholders::_1, rng.get(), 0.001),
+                pop.workspace);
+            for (auto wbar_i : wbar)
+                {
+                    if (!std::isfinite(wbar_i))
+                        {
+                            throw std::runtime_error("fitness not finite");
+                        }
+                }
+            fwdpp::update_mutations(pop.mutations, pop.fixations,
+                                    pop.fixation_times, pop.mut_lookup,
+                                    pop.mcounts, generation, 4000,
+                                    pop.workspace);
+        }
+}
+
 #endif